@@ -0,0 +1,89 @@
+from __future__ import absolute_import
+# "from _MultiCoreSim import *" doesn't work here because symbols starting
+# with underscore would not be imported.
+from . import _MultiCoreSim
+g = globals()
+for k,v in _MultiCoreSim.__dict__.items():
+    g[k] = v
+del g, k, v, _MultiCoreSim
+
+
+# Sweep helpers. A simulation releases the GIL while it runs, but ns-3 has
+# one Simulator per process, so the simulations of one process take turns;
+# sweep() runs them in a pool of processes to use every core of the box.
+
+import xml.etree.ElementTree as _ET
+
+
+def config_from_file(path, bms_path=None):
+    """Loads a configuration file into an MCoreSimProjectXml."""
+    with open(path) as f:
+        return config_from_xml(f.read(), bms_path)
+
+
+def config_from_xml(xml_text, bms_path=None):
+    """Builds an MCoreSimProjectXml from the text of a configuration file."""
+    config = MCoreSimProjectXml()
+    if not config.LoadFromString(xml_text):
+        raise ValueError("cannot parse the simulation configuration")
+    if bms_path is not None:
+        config.SetBMsPath(bms_path)
+    return config
+
+
+def set_attributes(xml_text, path, **attributes):
+    """Returns xml_text with the attributes set on every element at path.
+
+    path is relative to the root element, "." being the root itself, e.g.
+    set_attributes(text, "privateCaches/privateCache", cacheSize=32768)
+    resizes every L1 and set_attributes(text, "DRAMCnfg", MEMChannels=2)
+    the memory.
+    """
+    root = _ET.fromstring(xml_text)
+    elements = [root] if path == "." else root.findall(path)
+    if not elements:
+        raise KeyError("no element %s in the configuration" % path)
+    for element in elements:
+        for name, value in attributes.items():
+            element.set(name, str(value))
+    return _ET.tostring(root, encoding="unicode")
+
+
+def run(config, cycles=None):
+    """Runs a simulation to the end of its traces, or for cycles bus cycles."""
+    sim = CacheSim(config)
+    if cycles is None:
+        sim.runToCompletion()
+    else:
+        sim.runFor(cycles)
+    return sim
+
+
+def stats_array(stats, names):
+    """The named statistics as a numpy array, NaN where a stat is missing."""
+    import numpy
+    return numpy.array([stats.get(name, float("nan")) for name in names], dtype=float)
+
+
+def _sweep_point(point):
+    xml_text, bms_path, names, cycles = point
+    sim = run(config_from_xml(xml_text, bms_path), cycles)
+    return [sim.stats().get(name, float("nan")) for name in names] + [float(sim.cycles())]
+
+
+def sweep(xml_texts, names, bms_path=None, cycles=None, processes=None):
+    """Simulates every configuration text, processes at a time.
+
+    Returns a numpy array with a row per configuration: the named stats,
+    then the number of bus cycles simulated.
+    """
+    import multiprocessing
+    import numpy
+    points = [(text, bms_path, list(names), cycles) for text in xml_texts]
+    pool = multiprocessing.Pool(processes)
+    try:
+        rows = pool.map(_sweep_point, points)
+    finally:
+        pool.close()
+        pool.join()
+    return numpy.array(rows, dtype=float).reshape(len(points), len(names) + 1)
@@ -0,0 +1,2 @@
+callback_classes = [
+]
@@ -0,0 +1,206 @@
+from pybindgen import Module, FileCodeSink, param, retval, cppclass, typehandlers
+
+
+import pybindgen.settings
+import warnings
+
+class ErrorHandler(pybindgen.settings.ErrorHandler):
+    def handle_error(self, wrapper, exception, traceback_):
+        warnings.warn("exception %r in wrapper %s" % (exception, wrapper))
+        return True
+pybindgen.settings.error_handler = ErrorHandler()
+
+
+import sys
+
+## The configuration classes live in the global namespace, the simulator in ns3
+def module_init():
+    root_module = Module('ns.MultiCoreSim', cpp_namespace='::')
+    return root_module
+
+def register_types(module):
+    root_module = module.get_root()
+    
+    ## exception [class]
+    module.add_exception('exception', foreign_cpp_namespace='std', message_rvalue='%(EXC)s.what()')
+    ## stdexcept: std::runtime_error [class], raised in Python as RuntimeError
+    module.add_exception('runtime_error', foreign_cpp_namespace='std', custom_name='RuntimeError', is_standard_error=True, message_rvalue='%(EXC)s.what()')
+    ## MCoreSimProjectXml.h (module 'MultiCoreSim'): MCoreSimProjectXml [class]
+    module.add_class('MCoreSimProjectXml')
+    ## StatsRegistry.h (module 'MultiCoreSim'): ns3::StatsRegistry [class]
+    module.add_class('StatsRegistry', foreign_cpp_namespace='ns3')
+    ## CacheSim.h (module 'MultiCoreSim'): ns3::CacheSimStats [class]
+    module.add_class('CacheSimStats', foreign_cpp_namespace='ns3')
+    ## CacheSim.h (module 'MultiCoreSim'): ns3::CacheSim [class]
+    module.add_class('CacheSim', foreign_cpp_namespace='ns3')
+    module.add_container('std::vector< std::string >', 'std::string', container_type='vector')
+    module.add_container('std::map< std::string, double >', ('std::string', 'double'), container_type='map')
+
+def register_methods(root_module):
+    register_MCoreSimProjectXml_methods(root_module, root_module['MCoreSimProjectXml'])
+    register_Ns3StatsRegistry_methods(root_module, root_module['ns3::StatsRegistry'])
+    register_Ns3CacheSimStats_methods(root_module, root_module['ns3::CacheSimStats'])
+    register_Ns3CacheSim_methods(root_module, root_module['ns3::CacheSim'])
+    return
+
+def register_MCoreSimProjectXml_methods(root_module, cls):
+    ## MCoreSimProjectXml.h (module 'MultiCoreSim'): MCoreSimProjectXml::MCoreSimProjectXml() [constructor]
+    cls.add_constructor([])
+    ## MCoreSimProjectXml.h (module 'MultiCoreSim'): MCoreSimProjectXml::MCoreSimProjectXml(MCoreSimProjectXml const & arg0) [constructor]
+    cls.add_constructor([param('MCoreSimProjectXml const &', 'arg0')])
+    ## MCoreSimProjectXml.h (module 'MultiCoreSim'): bool MCoreSimProjectXml::LoadFromString(std::string const & xmlText) [member function]
+    cls.add_method('LoadFromString', 
+                   'bool', 
+                   [param('std::string const &', 'xmlText')])
+    ## MCoreSimProjectXml.h (module 'MultiCoreSim'): std::string MCoreSimProjectXml::GetBMsPath() [member function]
+    cls.add_method('GetBMsPath', 
+                   'std::string', 
+                   [])
+    ## MCoreSimProjectXml.h (module 'MultiCoreSim'): void MCoreSimProjectXml::SetBMsPath(std::string fileName) [member function]
+    cls.add_method('SetBMsPath', 
+                   'void', 
+                   [param('std::string', 'fileName')])
+    ## MCoreSimProjectXml.h (module 'MultiCoreSim'): std::string MCoreSimProjectXml::GetOutputPath() [member function]
+    cls.add_method('GetOutputPath', 
+                   'std::string', 
+                   [])
+    ## MCoreSimProjectXml.h (module 'MultiCoreSim'): void MCoreSimProjectXml::SetOutputPath(std::string path) [member function]
+    cls.add_method('SetOutputPath', 
+                   'void', 
+                   [param('std::string', 'path')])
+    ## MCoreSimProjectXml.h (module 'MultiCoreSim'): void MCoreSimProjectXml::SetLogFileGenEnable(bool logFileGenEnable) [member function]
+    cls.add_method('SetLogFileGenEnable', 
+                   'void', 
+                   [param('bool', 'logFileGenEnable')])
+    ## MCoreSimProjectXml.h (module 'MultiCoreSim'): int MCoreSimProjectXml::GetBusClkInNanoSec() [member function]
+    cls.add_method('GetBusClkInNanoSec', 
+                   'int', 
+                   [])
+    ## MCoreSimProjectXml.h (module 'MultiCoreSim'): void MCoreSimProjectXml::SetBusClkInNanoSec(int busClkNanoSec) [member function]
+    cls.add_method('SetBusClkInNanoSec', 
+                   'void', 
+                   [param('int', 'busClkNanoSec')])
+    ## MCoreSimProjectXml.h (module 'MultiCoreSim'): int MCoreSimProjectXml::GetTotalTimeInSeconds() [member function]
+    cls.add_method('GetTotalTimeInSeconds', 
+                   'int', 
+                   [])
+    ## MCoreSimProjectXml.h (module 'MultiCoreSim'): void MCoreSimProjectXml::SetTotalTimeInSeconds(int totalTimeInSeconds) [member function]
+    cls.add_method('SetTotalTimeInSeconds', 
+                   'void', 
+                   [param('int', 'totalTimeInSeconds')])
+    ## MCoreSimProjectXml.h (module 'MultiCoreSim'): int MCoreSimProjectXml::GetRunTillSimEnd() [member function]
+    cls.add_method('GetRunTillSimEnd', 
+                   'int', 
+                   [])
+    ## MCoreSimProjectXml.h (module 'MultiCoreSim'): void MCoreSimProjectXml::SetNumberOfRuns(int numberOfRuns) [member function]
+    cls.add_method('SetNumberOfRuns', 
+                   'void', 
+                   [param('int', 'numberOfRuns')])
+    return
+
+def register_Ns3StatsRegistry_methods(root_module, cls):
+    ## StatsRegistry.h (module 'MultiCoreSim'): ns3::StatsRegistry::StatsRegistry() [constructor]
+    cls.add_constructor([])
+    ## StatsRegistry.h (module 'MultiCoreSim'): void ns3::StatsRegistry::clear() [member function]
+    cls.add_method('clear', 
+                   'void', 
+                   [])
+    ## StatsRegistry.h (module 'MultiCoreSim'): size_t ns3::StatsRegistry::size() const [member function]
+    cls.add_method('size', 
+                   'size_t', 
+                   [], 
+                   is_const=True)
+    return
+
+def register_Ns3CacheSimStats_methods(root_module, cls):
+    ## CacheSim.h (module 'MultiCoreSim'): ns3::CacheSimStats::CacheSimStats() [constructor]
+    cls.add_constructor([])
+    ## CacheSim.h (module 'MultiCoreSim'): ns3::CacheSimStats::CacheSimStats(ns3::CacheSimStats const & arg0) [constructor]
+    cls.add_constructor([param('ns3::CacheSimStats const &', 'arg0')])
+    ## CacheSim.h (module 'MultiCoreSim'): void ns3::CacheSimStats::read(ns3::StatsRegistry const & registry) [member function]
+    cls.add_method('read', 
+                   'void', 
+                   [param('ns3::StatsRegistry const &', 'registry')])
+    ## CacheSim.h (module 'MultiCoreSim'): bool ns3::CacheSimStats::has(std::string const & name) const [member function]
+    cls.add_method('has', 
+                   'bool', 
+                   [param('std::string const &', 'name')], 
+                   is_const=True)
+    ## CacheSim.h (module 'MultiCoreSim'): double ns3::CacheSimStats::get(std::string const & name, double fallback=0) const [member function]
+    cls.add_method('get', 
+                   'double', 
+                   [param('std::string const &', 'name'), param('double', 'fallback', default_value='0')], 
+                   is_const=True)
+    ## CacheSim.h (module 'MultiCoreSim'): std::vector<std::string> const & ns3::CacheSimStats::names() const [member function]
+    cls.add_method('names', 
+                   'std::vector< std::string >', 
+                   [], 
+                   is_const=True)
+    ## CacheSim.h (module 'MultiCoreSim'): std::map<std::string,double> const & ns3::CacheSimStats::values() const [member function]
+    cls.add_method('values', 
+                   'std::map< std::string, double >', 
+                   [], 
+                   is_const=True)
+    ## CacheSim.h (module 'MultiCoreSim'): size_t ns3::CacheSimStats::size() const [member function]
+    cls.add_method('size', 
+                   'size_t', 
+                   [], 
+                   is_const=True)
+    return
+
+def register_Ns3CacheSim_methods(root_module, cls):
+    ## A bad configuration or a busy simulator throws std::runtime_error, and
+    ## a bug in the model other std::exceptions; both are raised in Python
+    throws = [root_module['std::runtime_error'], root_module['std::exception']]
+    ## CacheSim.h (module 'MultiCoreSim'): ns3::CacheSim::CacheSim(char const * config_file_path, char const * bms_path, char const * output_path=NULL) [constructor]
+    cls.add_constructor([param('char const *', 'config_file_path'), param('char const *', 'bms_path'), param('char const *', 'output_path', default_value='NULL')], 
+                        throw=throws)
+    ## CacheSim.h (module 'MultiCoreSim'): ns3::CacheSim::CacheSim(MCoreSimProjectXml const & config) [constructor]
+    cls.add_constructor([param('MCoreSimProjectXml const &', 'config')], 
+                        throw=throws)
+    ## The simulation runs without the GIL, so other Python threads keep going
+    ## CacheSim.h (module 'MultiCoreSim'): bool ns3::CacheSim::runToCompletion() [member function]
+    cls.add_method('runToCompletion', 
+                   'bool', 
+                   [], 
+                   throw=throws, unblock_threads=True)
+    ## CacheSim.h (module 'MultiCoreSim'): bool ns3::CacheSim::runFor(uint64_t cycles) [member function]
+    cls.add_method('runFor', 
+                   'bool', 
+                   [param('uint64_t', 'cycles')], 
+                   throw=throws, unblock_threads=True)
+    ## CacheSim.h (module 'MultiCoreSim'): bool ns3::CacheSim::done() const [member function]
+    cls.add_method('done', 
+                   'bool', 
+                   [], 
+                   is_const=True)
+    ## CacheSim.h (module 'MultiCoreSim'): uint64_t ns3::CacheSim::cycles() const [member function]
+    cls.add_method('cycles', 
+                   'uint64_t', 
+                   [], 
+                   is_const=True)
+    ## CacheSim.h (module 'MultiCoreSim'): ns3::CacheSimStats const & ns3::CacheSim::stats() [member function]
+    cls.add_method('stats', 
+                   'ns3::CacheSimStats const &', 
+                   [])
+    ## CacheSim.h (module 'MultiCoreSim'): std::string ns3::CacheSim::report() const [member function]
+    cls.add_method('report', 
+                   'std::string', 
+                   [], 
+                   is_const=True)
+    return
+
+def register_functions(root_module):
+    module = root_module
+    return
+
+def main():
+    out = FileCodeSink(sys.stdout)
+    root_module = module_init()
+    register_types(root_module)
+    register_methods(root_module)
+    register_functions(root_module)
+    root_module.generate(out)
+
+if __name__ == '__main__':
+    main()
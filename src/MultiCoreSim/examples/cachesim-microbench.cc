@@ -0,0 +1,522 @@
+/*
+ * Microbenchmarks of the data structures on the simulator's hot path: the
+ * FR-FCFS buffers of the controllers, the cache arrays, the protocol FSM
+ * tables, the replacement policies, the CPU FIFOs and the latency logger.
+ *
+ * Every benchmark builds its state from scratch (seeded with --Seed) for
+ * each repetition, so runs are repeatable, and only the measured loop is
+ * timed. The loop count is calibrated until one repetition takes --MinTime
+ * seconds, or fixed with --Iterations. One row per benchmark and parameter
+ * goes to --Output (stdout by default) as CSV or, with --Format=json, JSON,
+ * with the min, median, mean and max nanoseconds per operation over the
+ * --Repeat repetitions; progress goes to stderr.
+ *
+ *   ./waf --run "cachesim-microbench --Format=json --Output=bench.json"
+ */
+
+#include "ns3/core-module.h"
+#include "FRFCFS_Buffer.h"
+#include "CacheDataHandler.h"
+#include "FSMReader.h"
+#include "LeastRecentlyUsed.h"
+#include "Random.h"
+#include "MemTemplate.h"
+#include "Logger.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <fstream>
+#include <functional>
+#include <iomanip>
+#include <iostream>
+#include <memory>
+#include <random>
+#include <sstream>
+#include <string>
+#include <vector>
+
+#include <unistd.h>
+
+using namespace ns3;
+using namespace std;
+
+NS_LOG_COMPONENT_DEFINE ("CacheSimMicrobench");
+
+typedef function<uint64_t (uint64_t)> BenchLoop;  // Runs n operations, returns a value depending on all of them
+
+struct MicroBench
+{
+  string name;
+  string param;
+  function<BenchLoop ()> make;  // Builds fresh state for one repetition and returns its loop
+};
+
+struct BenchResult
+{
+  string name;
+  string param;
+  uint64_t iterations;
+  vector<double> nsPerOp;       // One per repetition, sorted
+};
+
+static uint64_t g_seed = 1;
+static volatile uint64_t g_sink; // Keeps the compiler from dropping the loops' work
+
+/*
+ * FRFCFS_Buffer: a buffer holding depth-1 requests that never become ready
+ * (as when they wait on busy lines), so every getFirstReady of a request
+ * pushed at the back scans all of them, and every pushFront moves them all
+ */
+class FRFCFSOwner
+{
+public:
+  FRFCFS_State checkState (const Message &msg, FRFCFS_State)
+  {
+    return (msg.addr & 1) ? FRFCFS_State::NonReady : FRFCFS_State::Ready;
+  }
+};
+
+static BenchLoop MakeFRFCFS (int depth, bool front)
+{
+  shared_ptr<FRFCFSOwner> owner(new FRFCFSOwner());
+  shared_ptr<FRFCFS_Buffer<Message, FRFCFSOwner> > buffer(
+    new FRFCFS_Buffer<Message, FRFCFSOwner>(&FRFCFSOwner::checkState, owner.get()));
+  for (int i = 0; i < depth - 1; i++)
+    buffer->pushBack(Message(i, 2 * i + 1), FRFCFS_State::NonReady);
+
+  return [owner, buffer, front] (uint64_t n) {
+    uint64_t sum = 0;
+    Message msg;
+    for (uint64_t i = 0; i < n; i++)
+    {
+      Message req(i, i << 6);
+      if (front)
+        buffer->pushFront(req);
+      else
+        buffer->pushBack(req, FRFCFS_State::NonReady);
+      if (buffer->getFirstReady(&msg))
+        sum += msg.msg_id;
+    }
+    return sum;
+  };
+}
+
+/*
+ * CacheDataHandler: a cache of the given geometry with every line valid,
+ * looked up with a seeded mix of hits and misses
+ */
+class BenchDataHandler : public CacheDataHandler
+{
+public:
+  BenchDataHandler (CacheXml &cacheXml, ReplacementPolicy* policy)
+    : CacheDataHandler(cacheXml, policy) {}
+
+  using CacheDataHandler::findline;
+
+  virtual bool freeUpSpace (const Message &, CoherenceProtocolHandler *) { return false; }
+  virtual bool findSpace (uint64_t) { return false; }
+};
+
+static BenchLoop MakeCacheLookup (int cacheSize, int nways, int blockSize, bool bits)
+{
+  CacheXml cacheXml = CacheXml();
+  cacheXml.SetCacheSize(cacheSize);
+  cacheXml.SetNWays(nways);
+  cacheXml.SetBlockSize(blockSize);
+
+  shared_ptr<LeastRecentlyUsed> policy(new LeastRecentlyUsed(nways));
+  shared_ptr<BenchDataHandler> cache(new BenchDataHandler(cacheXml, policy.get()));
+  cache->initializeCacheStates(0);
+
+  uint64_t lines = cacheSize / blockSize;
+  for (uint64_t line = 0; line < lines; line++)
+  {
+    GenericCacheLine cacheLine(1, true, 0);
+    cache->writeCacheLine_bypassLatency(line * blockSize, &cacheLine);
+  }
+
+  // Half the addresses are resident, half map to the same sets with other tags
+  mt19937_64 rnd(g_seed);
+  shared_ptr<vector<uint64_t> > addrs(new vector<uint64_t>(4096));
+  for (uint64_t &addr : *addrs)
+    addr = (rnd() % (2 * lines)) * blockSize + rnd() % blockSize;
+
+  return [policy, cache, addrs, bits] (uint64_t n) {
+    uint64_t sum = 0;
+    uint64_t set;
+    int way;
+    GenericCacheLine line;
+    for (uint64_t i = 0; i < n; i++)
+    {
+      uint64_t addr = (*addrs)[i & 4095];
+      if (bits)
+        sum += cache->readLineBits(addr, &line) ? line.state : 0;
+      else if (cache->findline(addr, &set, &way))
+        sum += set + way;
+    }
+    return sum;
+  };
+}
+
+/*
+ * FSMReader: transitions of seeded (valid state, event) pairs of a protocol
+ */
+static BenchLoop MakeFSM (const string &fsmFile, bool stall)
+{
+  shared_ptr<FSMReader> fsm(FSMReader::create(fsmFile));
+
+  vector<int> states;
+  for (int s = 0; s < fsm->getStateCount(); s++)
+    if (fsm->isValidState(s))
+      states.push_back(s);
+
+  mt19937_64 rnd(g_seed);
+  shared_ptr<vector<pair<int, int> > > cells(new vector<pair<int, int> >(4096));
+  for (pair<int, int> &cell : *cells)
+    cell = make_pair(states[rnd() % states.size()], (int)(rnd() % fsm->getEventCount()));
+
+  return [fsm, cells, stall] (uint64_t n) {
+    uint64_t sum = 0;
+    for (uint64_t i = 0; i < n; i++)
+    {
+      const pair<int, int> &cell = (*cells)[i & 4095];
+      if (stall)
+        sum += fsm->isStall(cell.first, cell.second);
+      else
+        sum += fsm->getTransition(cell.first, cell.second).next_state;
+    }
+    return sum;
+  };
+}
+
+/*
+ * Replacement policies: accesses to seeded sets of a 1024-set cache, with
+ * every way of every set accessed once beforehand
+ */
+static BenchLoop MakePolicy (const string &policyName, int nways, bool candidate)
+{
+  const int sets = 1024;
+  shared_ptr<ReplacementPolicy> policy;
+  if (policyName == "LRU")
+    policy.reset(new LeastRecentlyUsed(nways));
+  else
+    policy.reset(new Random(nways));
+  srand(g_seed);
+
+  uint64_t cycle = 0;
+  for (int set = 0; set < sets; set++)
+    for (int way = 0; way < nways; way++)
+      policy->update(set, way, cycle++);
+
+  mt19937_64 rnd(g_seed);
+  shared_ptr<vector<pair<uint64_t, int> > > accesses(new vector<pair<uint64_t, int> >(4096));
+  for (pair<uint64_t, int> &access : *accesses)
+    access = make_pair(rnd() % sets, (int)(rnd() % nways));
+
+  return [policy, accesses, candidate, cycle] (uint64_t n) mutable {
+    uint64_t sum = 0;
+    int way;
+    for (uint64_t i = 0; i < n; i++)
+    {
+      const pair<uint64_t, int> &access = (*accesses)[i & 4095];
+      if (candidate)
+      {
+        policy->getReplacementCandidate(access.first, &way);
+        sum += way;
+      }
+      else
+        policy->update(access.first, access.second, cycle++);
+    }
+    return sum + cycle;
+  };
+}
+
+/*
+ * Message: copies, and the request/response round trip through a CpuFIFO
+ */
+static BenchLoop MakeMessageCopy (bool data)
+{
+  shared_ptr<Message> msg(new Message(1, 0x1000, 10, 0, 2));
+  msg->to.push_back(1);
+  if (data)
+  {
+    uint8_t bytes[8] = {1, 2, 3, 4, 5, 6, 7, 8};
+    msg->copy(bytes);
+  }
+
+  return [msg] (uint64_t n) {
+    uint64_t sum = 0;
+    for (uint64_t i = 0; i < n; i++)
+    {
+      msg->addr = i;
+      Message copy = *msg;
+      sum += copy.addr + (copy.data ? copy.data[i & 7] : 0);
+    }
+    return sum;
+  };
+}
+
+static BenchLoop MakeCpuFIFO (bool response)
+{
+  shared_ptr<CpuFIFO> fifo(new CpuFIFO(0, 16));
+
+  return [fifo, response] (uint64_t n) {
+    uint64_t sum = 0;
+    Message msg;
+    CpuFIFO::ReqMsg req = CpuFIFO::ReqMsg();
+    req.type = CpuFIFO::REQTYPE::READ;
+    for (uint64_t i = 0; i < n; i++)
+    {
+      if (response)
+      {
+        msg.msg_id = i;
+        msg.addr = i << 6;
+        fifo->pushMessage(msg, i);
+        sum += fifo->m_rxFIFO.GetFrontElement().cycle;
+        fifo->m_rxFIFO.PopElement();
+      }
+      else
+      {
+        req.msgId = i;
+        req.addr = i << 6;
+        fifo->m_txFIFO.InsertElement(req);
+        if (fifo->peekMessage(&msg))
+          sum += msg.addr;
+        fifo->popFrontMessage();
+      }
+    }
+    return sum;
+  };
+}
+
+/*
+ * Logger: the whole life of a request, from addRequest through every
+ * checkpoint to the response, which writes its row of the latency report
+ */
+static BenchLoop MakeLogger (const string &reportDir, int cores)
+{
+  Logger::reset();
+  Logger::getLogger()->registerReportPath(reportDir);
+
+  return [cores] (uint64_t n) {
+    Logger *logger = Logger::getLogger();
+    CpuFIFO::ReqMsg req = CpuFIFO::ReqMsg();
+    for (uint64_t i = 0; i < n; i++)
+    {
+      uint64_t core = i % cores;
+      logger->setClkCount(core, i);
+      req.msgId = i + 1;
+      req.addr = i << 6;
+      req.cycle = i;
+      req.fifoInserionCycle = i;
+      logger->addRequest(core, req);
+      logger->updateRequest(req.msgId, Logger::EntryId::CACHE_CHECKPOINT);
+      logger->updateRequest(req.msgId, Logger::EntryId::REQ_BUS_CHECKPOINT);
+      logger->updateRequest(req.msgId, Logger::EntryId::RESP_BUS_CHECKPOINT);
+      logger->updateRequest(req.msgId, Logger::EntryId::CPU_RX_CHECKPOINT);
+    }
+    return n;
+  };
+}
+
+static double TimeLoop (BenchLoop &loop, uint64_t n)
+{
+  chrono::steady_clock::time_point start = chrono::steady_clock::now();
+  g_sink += loop(n);
+  return chrono::duration<double>(chrono::steady_clock::now() - start).count();
+}
+
+static BenchResult Measure (const MicroBench &bench, double minTime, int repeat, uint64_t iterations)
+{
+  BenchResult result;
+  result.name = bench.name;
+  result.param = bench.param;
+
+  // Doubles the loop count until a repetition is long enough to time
+  if (iterations == 0)
+  {
+    BenchLoop loop = bench.make();
+    for (iterations = 1; TimeLoop(loop, iterations) < minTime && iterations < (1ULL << 40); iterations *= 2)
+      ;
+  }
+  result.iterations = iterations;
+
+  for (int r = 0; r < repeat; r++)
+  {
+    BenchLoop loop = bench.make();
+    result.nsPerOp.push_back(TimeLoop(loop, iterations) * 1e9 / iterations);
+  }
+  sort(result.nsPerOp.begin(), result.nsPerOp.end());
+  return result;
+}
+
+static vector<MicroBench> MakeBenchmarks (const string &fsmFile, const string &reportDir)
+{
+  vector<MicroBench> benches;
+
+  int depths[] = {1, 8, 64, 512};
+  for (int depth : depths)
+  {
+    benches.push_back({"frfcfs_pushBack_getFirstReady", "depth=" + to_string(depth),
+                       [depth] () { return MakeFRFCFS(depth, false); }});
+    benches.push_back({"frfcfs_pushFront_getFirstReady", "depth=" + to_string(depth),
+                       [depth] () { return MakeFRFCFS(depth, true); }});
+  }
+
+  // size, ways, block size
+  int geometries[][3] = {{32768, 1, 64}, {32768, 8, 64}, {262144, 16, 64}, {2097152, 16, 64}, {8388608, 32, 128}};
+  for (int *g : geometries)
+  {
+    int size = g[0], nways = g[1], block = g[2];
+    stringstream param;
+    param << "size=" << size << " ways=" << nways << " block=" << block;
+    benches.push_back({"cache_findline", param.str(),
+                       [size, nways, block] () { return MakeCacheLookup(size, nways, block, false); }});
+    benches.push_back({"cache_readLineBits", param.str(),
+                       [size, nways, block] () { return MakeCacheLookup(size, nways, block, true); }});
+  }
+
+  if (ifstream(fsmFile.c_str()).good() || FSMReader::findCompiledFSM(fsmFile) != NULL)
+  {
+    string fsmName = fsmFile.substr(fsmFile.find_last_of('/') + 1);
+    benches.push_back({"fsm_getTransition", "fsm=" + fsmName, [fsmFile] () { return MakeFSM(fsmFile, false); }});
+    benches.push_back({"fsm_isStall", "fsm=" + fsmName, [fsmFile] () { return MakeFSM(fsmFile, true); }});
+  }
+  else
+    cerr << "cachesim-microbench: no FSM " << fsmFile << ", skipping the fsm benchmarks" << endl;
+
+  string policies[] = {"LRU", "RANDOM"};
+  int ways[] = {4, 16};
+  for (const string &policy : policies)
+    for (int nways : ways)
+    {
+      string param = "ways=" + to_string(nways);
+      string name = (policy == "LRU") ? "lru" : "random";
+      if (policy == "LRU")
+        benches.push_back({name + "_update", param, [policy, nways] () { return MakePolicy(policy, nways, false); }});
+      benches.push_back({name + "_getReplacementCandidate", param,
+                         [policy, nways] () { return MakePolicy(policy, nways, true); }});
+    }
+
+  benches.push_back({"message_copy", "data=0", [] () { return MakeMessageCopy(false); }});
+  benches.push_back({"message_copy", "data=1", [] () { return MakeMessageCopy(true); }});
+  benches.push_back({"cpufifo_request_peek_pop", "", [] () { return MakeCpuFIFO(false); }});
+  benches.push_back({"cpufifo_response_push_pop", "", [] () { return MakeCpuFIFO(true); }});
+
+  int cores[] = {1, 8};
+  for (int n : cores)
+    benches.push_back({"logger_addRequest_updateRequest", "cores=" + to_string(n),
+                       [reportDir, n] () { return MakeLogger(reportDir, n); }});
+  return benches;
+}
+
+static string JsonString (const string &text)
+{
+  string quoted = "\"";
+  for (char c : text)
+    quoted += (c == '"' || c == '\\') ? string("\\") + c : string(1, c);
+  return quoted + "\"";
+}
+
+static void WriteResults (ostream &out, const string &format, const vector<BenchResult> &results,
+                          double minTime, int repeat)
+{
+  out << fixed << setprecision(3);
+  if (format == "json")
+  {
+    out << "{\"seed\": " << g_seed << ", \"min_time\": " << minTime << ", \"repeat\": " << repeat
+        << ", \"benchmarks\": [\n";
+    for (size_t i = 0; i < results.size(); i++)
+    {
+      const BenchResult &r = results[i];
+      double mean = 0;
+      for (double ns : r.nsPerOp)
+        mean += ns / r.nsPerOp.size();
+      out << "  {\"name\": " << JsonString(r.name) << ", \"param\": " << JsonString(r.param)
+          << ", \"iterations\": " << r.iterations << ", \"ns_per_op_min\": " << r.nsPerOp.front()
+          << ", \"ns_per_op_median\": " << r.nsPerOp[r.nsPerOp.size() / 2] << ", \"ns_per_op_mean\": " << mean
+          << ", \"ns_per_op_max\": " << r.nsPerOp.back() << "}" << ((i + 1 < results.size()) ? "," : "") << "\n";
+    }
+    out << "]}\n";
+    return;
+  }
+
+  out << "name,param,iterations,repeat,ns_per_op_min,ns_per_op_median,ns_per_op_mean,ns_per_op_max\n";
+  for (const BenchResult &r : results)
+  {
+    double mean = 0;
+    for (double ns : r.nsPerOp)
+      mean += ns / r.nsPerOp.size();
+    out << r.name << "," << r.param << "," << r.iterations << "," << r.nsPerOp.size() << "," << r.nsPerOp.front()
+        << "," << r.nsPerOp[r.nsPerOp.size() / 2] << "," << mean << "," << r.nsPerOp.back() << "\n";
+  }
+}
+
+int main (int argc, char *argv[])
+{
+  string Filter    = "";        // Only benchmarks whose name contains this
+  double MinTime   = 0.1;       // Seconds per repetition when calibrating
+  int Repeat       = 5;
+  uint64_t Iterations = 0;      // Operations per repetition, 0 = calibrate
+  string Format    = "csv";
+  string Output    = "";        // "" = stdout
+  char cwd[4096];
+  string FsmFile   = string(getcwd(cwd, sizeof(cwd)) ? cwd : ".") + "/Protocols_FSM/MSI_splitBus_snooping.csv";
+
+  CommandLine cmd;
+  cmd.AddValue("Filter", "run only the benchmarks whose name contains this", Filter);
+  cmd.AddValue("MinTime", "seconds a repetition takes when the loop count is calibrated", MinTime);
+  cmd.AddValue("Repeat", "repetitions of each benchmark", Repeat);
+  cmd.AddValue("Iterations", "operations per repetition (0 = calibrate with MinTime)", Iterations);
+  cmd.AddValue("Seed", "seed of the benchmarks' inputs", g_seed);
+  cmd.AddValue("Format", "output format, csv or json", Format);
+  cmd.AddValue("Output", "file of the results (default stdout)", Output);
+  cmd.AddValue("FsmFile", "protocol FSM of the fsm benchmarks", FsmFile);
+  cmd.Parse (argc, argv);
+
+  if (Format != "csv" && Format != "json")
+  {
+    cerr << "cachesim-microbench: unknown format " << Format << endl;
+    return 1;
+  }
+  Repeat = max(1, Repeat);
+
+  // The logger writes its latency report for real, to a scratch directory
+  char reportDir[] = "/tmp/cachesim-microbench.XXXXXX";
+  if (mkdtemp(reportDir) == NULL)
+  {
+    cerr << "cachesim-microbench: cannot create a scratch directory" << endl;
+    return 1;
+  }
+
+  vector<BenchResult> results;
+  for (const MicroBench &bench : MakeBenchmarks(FsmFile, reportDir))
+  {
+    if (bench.name.find(Filter) == string::npos)
+      continue;
+    results.push_back(Measure(bench, MinTime, Repeat, Iterations));
+    cerr << "cachesim-microbench: " << bench.name << " " << bench.param << ": "
+         << results.back().nsPerOp[results.back().nsPerOp.size() / 2] << " ns/op" << endl;
+  }
+
+  Logger::reset();
+  for (int core = 0; core < 8; core++)
+    unlink((string(reportDir) + "/LatencyReport_C" + to_string(core) + ".csv").c_str());
+  rmdir(reportDir);
+
+  if (Output.empty())
+    WriteResults(cout, Format, results, MinTime, Repeat);
+  else
+  {
+    ofstream out(Output.c_str());
+    WriteResults(out, Format, results, MinTime, Repeat);
+    if (!out)
+    {
+      cerr << "cachesim-microbench: cannot write " << Output << endl;
+      return 1;
+    }
+  }
+  return 0;
+}
@@ -0,0 +1,607 @@
+/*
+ * Design-space exploration driver. A sweep file names a base configuration
+ * and the parameters to vary,
+ *
+ *   <Sweep base="src/MultiCoreSim/test/base.xml" bmsPath="BMs/tests" outDir="sweep"
+ *          jobs="8" retries="1" timeout="0" keepLogs="0" cacheDir=".cachesim-cache">
+ *     <Param path="privateCaches/privateCache" attr="cacheSize" values="16384 32768 65536"/>
+ *     <Param path="privateCaches/privateCache" attr="nways"     values="2 4 8"/>
+ *     <Param path="."                          attr="CohProtocol" values="MSI MESI"/>
+ *   </Sweep>
+ *
+ * and every point of the parameters' cross product is simulated. A Param
+ * sets attr on every element at path (child element names separated by
+ * '/', "." for the root element of the configuration).
+ *
+ * Points run `jobs` at a time from a pool of threads. The ns-3 Simulator is
+ * one per process and a bad configuration can end the process, so each
+ * thread runs its point in a child process of this program: the points run
+ * in parallel, and a point that crashes, exits or exceeds `timeout` seconds
+ * is retried `retries` times and then reported as failed in the results,
+ * without stopping the sweep. The children map the trace files read-only,
+ * so all the points share one copy of each trace in memory.
+ *
+ * Each point writes its outputs (the cpu and controller traces, the
+ * newLogger latency reports and, with keepLogs, the simulator's output in
+ * sim.log) to a directory of its own, outDir/points/point_N, so parallel
+ * points never write the same file. Without keepLogs the directory is
+ * removed once the point is done.
+ *
+ * Results are memoized in cacheDir (a ResultCache; "" turns it off), keyed
+ * by the point's configuration, the traces, the protocol FSMs, the
+ * MultiCoreSim library and this executable, so rerunning a sweep or sweeps
+ * sharing points only simulate what has not been simulated yet. Two sweeps
+ * meeting on the same point simulate it once: the second waits for the
+ * first's result.
+ *
+ * The results of all points go to outDir/results.csv and outDir/results.json,
+ * one row (object) per point with its parameters, status and statistics.
+ */
+
+#include "ns3/core-module.h"
+#include "tinyxml.h"
+#include "MCoreSimProjectXml.h"
+#include "CacheSim.h"
+#include "ResultCache.h"
+
+#include <atomic>
+#include <chrono>
+#include <cmath>
+#include <cstring>
+#include <fstream>
+#include <iomanip>
+#include <iostream>
+#include <map>
+#include <mutex>
+#include <sstream>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include <dirent.h>
+#include <fcntl.h>
+#include <signal.h>
+#include <spawn.h>
+#include <sys/stat.h>
+#include <sys/wait.h>
+#include <unistd.h>
+
+extern char **environ;
+
+using namespace ns3;
+using namespace std;
+
+NS_LOG_COMPONENT_DEFINE ("CacheSimSweep");
+
+struct SweepParam
+{
+  string path;
+  string attr;
+  vector<string> values;
+};
+
+struct SweepPoint
+{
+  int index;
+  vector<string> values;       // One per SweepParam
+  string configFile;
+  string status;               // "ok" or "failed"
+  int attempts;                // 0 if the result came from the cache
+  bool cached;
+  double seconds;
+  string error;
+  uint64_t cycles;
+  vector<pair<string, double> > stats;
+};
+
+struct SweepCnfg
+{
+  string base;
+  string bmsPath;
+  string outDir;
+  int jobs;
+  int retries;
+  int timeout;                 // Seconds per attempt, 0 = no limit
+  bool keepLogs;
+  string cacheDir;             // "" = no result cache
+  vector<SweepParam> params;
+};
+
+/*
+ * Child side: simulate one point and write its statistics to resultFile,
+ * or why it could not be simulated to resultFile.error
+ */
+static int RunPoint (string pointFile, string bmsPath, string outPath, string resultFile)
+{
+  uint64_t cycles;
+  CacheSimStats stats;
+  try
+  {
+    CacheSim sim(pointFile.c_str(), bmsPath.c_str(), outPath.empty() ? NULL : outPath.c_str());
+    sim.runToCompletion();
+    cycles = sim.cycles();
+    stats = sim.stats();
+  }
+  catch (const exception &e)
+  {
+    cout << e.what() << endl;
+    ofstream error((resultFile + ".error").c_str());
+    error << e.what() << "\n";
+    return 3;
+  }
+
+  // Written to a temporary and renamed, so a result file is always complete
+  string tmpFile = resultFile + ".tmp";
+  ofstream result(tmpFile.c_str());
+  result << setprecision(17);
+  result << "cycles\t" << cycles << "\n";
+  for (const string &name : stats.names())
+    result << name << "\t" << stats.get(name) << "\n";
+  result.close();
+  if (!result || rename(tmpFile.c_str(), resultFile.c_str()) != 0)
+    return 2;
+  return 0;
+}
+
+static vector<string> SplitValues (const string &text)
+{
+  vector<string> values;
+  istringstream words(text);
+  string word;
+  while (words >> word)
+    values.push_back(word);
+  return values;
+}
+
+static bool LoadSweep (const string &sweepFile, SweepCnfg &cnfg)
+{
+  TiXmlDocument doc(sweepFile.c_str());
+  if (!doc.LoadFile())
+  {
+    cout << "cachesim-sweep: cannot read sweep file " << sweepFile << endl;
+    return false;
+  }
+  TiXmlElement* sweep = doc.FirstChildElement("Sweep");
+  if (sweep == NULL)
+  {
+    cout << "cachesim-sweep: " << sweepFile << " has no Sweep element" << endl;
+    return false;
+  }
+
+  // default values
+  cnfg.outDir   = "sweep";
+  cnfg.jobs     = max(1U, thread::hardware_concurrency());
+  cnfg.retries  = 1;
+  cnfg.timeout  = 0;
+  cnfg.cacheDir = ".cachesim-cache";
+  int keepLogs  = 0;
+
+  sweep->QueryStringAttribute("base"    , &cnfg.base   );
+  sweep->QueryStringAttribute("bmsPath" , &cnfg.bmsPath);
+  sweep->QueryStringAttribute("outDir"  , &cnfg.outDir );
+  sweep->QueryIntAttribute   ("jobs"    , &cnfg.jobs   );
+  sweep->QueryIntAttribute   ("retries" , &cnfg.retries);
+  sweep->QueryIntAttribute   ("timeout" , &cnfg.timeout);
+  sweep->QueryIntAttribute   ("keepLogs", &keepLogs    );
+  sweep->QueryStringAttribute("cacheDir", &cnfg.cacheDir);
+  cnfg.keepLogs = keepLogs != 0;
+
+  for (TiXmlElement* p = sweep->FirstChildElement("Param"); p; p = p->NextSiblingElement("Param"))
+  {
+    SweepParam param;
+    string values;
+    param.path = ".";
+    p->QueryStringAttribute("path"  , &param.path);
+    p->QueryStringAttribute("attr"  , &param.attr);
+    p->QueryStringAttribute("values", &values    );
+    param.values = SplitValues(values);
+    if (param.attr.empty() || param.values.empty())
+    {
+      cout << "cachesim-sweep: a Param needs attr and values" << endl;
+      return false;
+    }
+    cnfg.params.push_back(param);
+  }
+  return true;
+}
+
+// Every element at path below root; "." is root itself
+static vector<TiXmlElement*> FindElements (TiXmlElement* root, const string &path)
+{
+  vector<TiXmlElement*> found(1, root);
+  istringstream names(path);
+  string name;
+  while (getline(names, name, '/'))
+  {
+    if (name.empty() || name == ".")
+      continue;
+    vector<TiXmlElement*> children;
+    for (TiXmlElement* parent : found)
+      for (TiXmlElement* child = parent->FirstChildElement(name.c_str()); child; child = child->NextSiblingElement(name.c_str()))
+        children.push_back(child);
+    found = children;
+  }
+  return found;
+}
+
+// Writes the configuration of every point of the cross product
+static bool MakePoints (const SweepCnfg &cnfg, vector<SweepPoint> &points)
+{
+  size_t total = 1;
+  for (const SweepParam &param : cnfg.params)
+    total *= param.values.size();
+
+  mkdir((cnfg.outDir + "/points").c_str(), 0755);
+  for (size_t i = 0; i < total; i++)
+  {
+    TiXmlDocument doc(cnfg.base.c_str());
+    if (!doc.LoadFile() || doc.RootElement() == NULL)
+    {
+      cout << "cachesim-sweep: cannot read base configuration " << cnfg.base << endl;
+      return false;
+    }
+
+    SweepPoint point;
+    point.index = i;
+    size_t rest = i;
+    for (int p = cnfg.params.size() - 1; p >= 0; p--)
+    {
+      const SweepParam &param = cnfg.params[p];
+      const string &value = param.values[rest % param.values.size()];
+      rest /= param.values.size();
+
+      vector<TiXmlElement*> elements = FindElements(doc.RootElement(), param.path);
+      if (elements.empty())
+      {
+        cout << "cachesim-sweep: base configuration has no element " << param.path << endl;
+        return false;
+      }
+      for (TiXmlElement* element : elements)
+        element->SetAttribute(param.attr.c_str(), value.c_str());
+      point.values.insert(point.values.begin(), value);
+    }
+
+    stringstream configFile;
+    configFile << cnfg.outDir << "/points/point_" << i << ".xml";
+    point.configFile = configFile.str();
+    if (!doc.SaveFile(point.configFile.c_str()))
+    {
+      cout << "cachesim-sweep: cannot write " << point.configFile << endl;
+      return false;
+    }
+    point.status = "failed";
+    point.attempts = 0;
+    point.cached = false;
+    point.seconds = 0;
+    point.cycles = 0;
+    points.push_back(point);
+  }
+  return true;
+}
+
+static bool ReadResult (const string &resultFile, SweepPoint &point)
+{
+  ifstream result(resultFile.c_str());
+  if (!result.is_open())
+    return false;
+
+  point.stats.clear();
+  string line;
+  while (getline(result, line))
+  {
+    size_t tab = line.rfind('\t');
+    if (tab == string::npos)
+      continue;
+    string name = line.substr(0, tab);
+    double value = strtod(line.c_str() + tab + 1, NULL);
+    if (name == "cycles")
+      point.cycles = (uint64_t)value;
+    else
+      point.stats.push_back(make_pair(name, value));
+  }
+  return true;
+}
+
+/*
+ * Parent side: one attempt at a point in a child process. Returns an empty
+ * string on success, otherwise what went wrong.
+ */
+static string PointResultFile (const SweepCnfg &cnfg, const SweepPoint &point)
+{
+  stringstream resultFile;
+  resultFile << cnfg.outDir << "/points/point_" << point.index << ".result";
+  return resultFile.str();
+}
+
+// Removes dir and what is in it, one level of subdirectories deep
+static void RemoveOutputDir (const string &dir)
+{
+  DIR *entries = opendir(dir.c_str());
+  if (entries == NULL)
+    return;
+  while (struct dirent *entry = readdir(entries))
+  {
+    string name = entry->d_name;
+    if (name == "." || name == "..")
+      continue;
+    string path = dir + "/" + name;
+    struct stat info;
+    if (lstat(path.c_str(), &info) == 0 && S_ISDIR(info.st_mode))
+      RemoveOutputDir(path);
+    else
+      unlink(path.c_str());
+  }
+  closedir(entries);
+  rmdir(dir.c_str());
+}
+
+static string AttemptPoint (const string &self, const SweepCnfg &cnfg, SweepPoint &point)
+{
+  stringstream outPath;
+  outPath << cnfg.outDir << "/points/point_" << point.index;
+  string resultFile = PointResultFile(cnfg, point);
+  string logFile = cnfg.keepLogs ? outPath.str() + "/sim.log" : string("/dev/null");
+  string errorFile = resultFile + ".error";
+  unlink(resultFile.c_str());
+  unlink(errorFile.c_str());
+
+  // A fresh output directory per attempt, with the newLogger directory the
+  // latency reports are written to
+  RemoveOutputDir(outPath.str());
+  mkdir(outPath.str().c_str(), 0755);
+  mkdir((outPath.str() + "/newLogger").c_str(), 0755);
+
+  vector<string> args;
+  args.push_back(self);
+  args.push_back("--RunPoint=" + point.configFile);
+  args.push_back("--BMsPath=" + cnfg.bmsPath);
+  args.push_back("--OutPath=" + outPath.str());
+  args.push_back("--Result=" + resultFile);
+  vector<char*> argv;
+  for (string &arg : args)
+    argv.push_back(&arg[0]);
+  argv.push_back(NULL);
+
+  // The simulator is chatty; its output goes to the point's log
+  posix_spawn_file_actions_t actions;
+  posix_spawn_file_actions_init(&actions);
+  posix_spawn_file_actions_addopen(&actions, STDOUT_FILENO, logFile.c_str(), O_WRONLY | O_CREAT | O_TRUNC, 0644);
+  posix_spawn_file_actions_adddup2(&actions, STDOUT_FILENO, STDERR_FILENO);
+
+  pid_t pid;
+  int err = posix_spawn(&pid, self.c_str(), &actions, NULL, &argv[0], environ);
+  posix_spawn_file_actions_destroy(&actions);
+  if (err != 0)
+    return string("cannot start the simulation: ") + strerror(err);
+
+  chrono::steady_clock::time_point start = chrono::steady_clock::now();
+  int status = 0;
+  bool timedOut = false;
+  while (waitpid(pid, &status, WNOHANG) == 0)
+  {
+    if (cnfg.timeout > 0 && chrono::steady_clock::now() - start > chrono::seconds(cnfg.timeout))
+    {
+      kill(pid, SIGKILL);
+      waitpid(pid, &status, 0);
+      timedOut = true;
+      break;
+    }
+    this_thread::sleep_for(chrono::milliseconds(20));
+  }
+  point.seconds = chrono::duration<double>(chrono::steady_clock::now() - start).count();
+
+  stringstream error;
+  string reason;
+  ifstream reasonFile(errorFile.c_str());
+  if (timedOut)
+    error << "timed out after " << cnfg.timeout << " s";
+  else if (WIFSIGNALED(status))
+    error << "killed by signal " << WTERMSIG(status);
+  else if (reasonFile.is_open() && getline(reasonFile, reason) && !reason.empty())
+    error << reason;
+  else if (WIFEXITED(status) && WEXITSTATUS(status) != 0)
+    error << "exit status " << WEXITSTATUS(status);
+  else if (!ReadResult(resultFile, point))
+    error << "ended without results";
+
+  if (!cnfg.keepLogs)
+    RemoveOutputDir(outPath.str());
+  return error.str();
+}
+
+static string CsvField (const string &text)
+{
+  if (text.find_first_of(",\"\n") == string::npos)
+    return text;
+  string quoted = "\"";
+  for (char c : text)
+    quoted += (c == '"') ? string("\"\"") : string(1, c);
+  return quoted + "\"";
+}
+
+static string JsonString (const string &text)
+{
+  string quoted = "\"";
+  for (char c : text)
+  {
+    if (c == '"' || c == '\\')
+      quoted += string("\\") + c;
+    else if (c == '\n')
+      quoted += "\\n";
+    else if ((unsigned char)c < 0x20)
+      quoted += " ";
+    else
+      quoted += c;
+  }
+  return quoted + "\"";
+}
+
+static string JsonNumber (double value)
+{
+  if (!std::isfinite(value))
+    return "null";
+  stringstream number;
+  number << setprecision(17) << value;
+  return number.str();
+}
+
+static void WriteResults (const SweepCnfg &cnfg, const vector<SweepPoint> &points)
+{
+  // Columns for every stat any point has, in the order they were first seen
+  vector<string> names;
+  map<string, bool> seen;
+  for (const SweepPoint &point : points)
+    for (const pair<string, double> &stat : point.stats)
+      if (!seen[stat.first])
+      {
+        seen[stat.first] = true;
+        names.push_back(stat.first);
+      }
+
+  ofstream csv((cnfg.outDir + "/results.csv").c_str());
+  csv << "point,status,cached,attempts,seconds,error,cycles";
+  for (const SweepParam &param : cnfg.params)
+    csv << "," << CsvField(param.path + "@" + param.attr);
+  for (const string &name : names)
+    csv << "," << CsvField(name);
+  csv << "\n" << setprecision(17);
+  for (const SweepPoint &point : points)
+  {
+    map<string, double> stats(point.stats.begin(), point.stats.end());
+    csv << point.index << "," << point.status << "," << (point.cached ? 1 : 0) << "," << point.attempts << "," << point.seconds << ","
+        << CsvField(point.error) << ",";
+    if (point.status == "ok")
+      csv << point.cycles;
+    for (const string &value : point.values)
+      csv << "," << CsvField(value);
+    for (const string &name : names)
+    {
+      csv << ",";
+      if (stats.count(name))
+        csv << stats[name];
+    }
+    csv << "\n";
+  }
+
+  ofstream json((cnfg.outDir + "/results.json").c_str());
+  json << "[\n";
+  for (size_t i = 0; i < points.size(); i++)
+  {
+    const SweepPoint &point = points[i];
+    json << "  {\"point\": " << point.index << ", \"status\": " << JsonString(point.status)
+         << ", \"cached\": " << (point.cached ? "true" : "false")
+         << ", \"attempts\": " << point.attempts << ", \"seconds\": " << JsonNumber(point.seconds)
+         << ", \"error\": " << JsonString(point.error) << ", \"cycles\": " << point.cycles << ",\n   \"params\": {";
+    for (size_t p = 0; p < cnfg.params.size(); p++)
+      json << (p ? ", " : "") << JsonString(cnfg.params[p].path + "@" + cnfg.params[p].attr) << ": "
+           << JsonString(point.values[p]);
+    json << "},\n   \"stats\": {";
+    for (size_t s = 0; s < point.stats.size(); s++)
+      json << (s ? ", " : "") << JsonString(point.stats[s].first) << ": " << JsonNumber(point.stats[s].second);
+    json << "}}" << ((i + 1 < points.size()) ? "," : "") << "\n";
+  }
+  json << "]\n";
+}
+
+static string SelfPath (const char* argv0)
+{
+  char path[4096];
+  ssize_t length = readlink("/proc/self/exe", path, sizeof(path) - 1);
+  if (length <= 0)
+    return string(argv0);
+  path[length] = '\0';
+  return string(path);
+}
+
+int main (int argc, char *argv[])
+{
+  string SweepFile = "sweep.xml";    // Base configuration and parameter grid
+  string OutDir    = "";             // Overrides the sweep file's outDir
+  int Jobs         = 0;              // Overrides the sweep file's jobs
+
+  // Used by the sweep to run one point in a child process
+  string RunPointFile = "";
+  string BMsPath      = "";
+  string OutPath      = "";
+  string ResultFile   = "";
+
+  CommandLine cmd;
+  cmd.AddValue("SweepFile", "sweep file: base configuration and parameter grid", SweepFile);
+  cmd.AddValue("OutDir", "directory of the results (overrides outDir)", OutDir);
+  cmd.AddValue("Jobs", "points simulated at a time (overrides jobs)", Jobs);
+  cmd.AddValue("RunPoint", "internal: simulate this point configuration", RunPointFile);
+  cmd.AddValue("BMsPath", "internal: benchmark trace file(s) path of the point", BMsPath);
+  cmd.AddValue("OutPath", "internal: directory of the point's outputs", OutPath);
+  cmd.AddValue("Result", "internal: file for the point's statistics", ResultFile);
+  cmd.Parse (argc, argv);
+
+  if (!RunPointFile.empty())
+    return RunPoint(RunPointFile, BMsPath, OutPath, ResultFile);
+
+  SweepCnfg cnfg;
+  if (!LoadSweep(SweepFile, cnfg))
+    return 1;
+  if (!OutDir.empty())
+    cnfg.outDir = OutDir;
+  if (Jobs > 0)
+    cnfg.jobs = Jobs;
+  mkdir(cnfg.outDir.c_str(), 0755);
+
+  vector<SweepPoint> points;
+  if (!MakePoints(cnfg, points))
+    return 1;
+  cout << "cachesim-sweep: " << points.size() << " points, " << cnfg.jobs << " at a time" << endl;
+
+  string self = SelfPath(argv[0]);
+  char cwd[4096];
+  string fsmDir = string(getcwd(cwd, sizeof(cwd)) ? cwd : ".") + "/Protocols_FSM/";
+  ResultCache cache(cnfg.cacheDir);
+  atomic<size_t> next(0);
+  atomic<size_t> finished(0);
+  mutex printLock;
+  vector<thread> workers;
+  for (int j = 0; j < min(cnfg.jobs, (int)points.size()); j++)
+  {
+    workers.push_back(thread([&]() {
+      for (size_t i = next++; i < points.size(); i = next++)
+      {
+        SweepPoint &point = points[i];
+        string key = cnfg.cacheDir.empty() ? string("") : cache.Key(point.configFile, cnfg.bmsPath, fsmDir, self);
+        int keyLock = key.empty() ? -1 : cache.Lock(key);
+
+        if (keyLock >= 0 && cache.Fetch(key, PointResultFile(cnfg, point)) && ReadResult(PointResultFile(cnfg, point), point))
+          point.cached = true;
+        else
+        {
+          for (point.attempts = 1; point.attempts <= 1 + max(0, cnfg.retries); point.attempts++)
+          {
+            point.error = AttemptPoint(self, cnfg, point);
+            if (point.error.empty())
+              break;
+          }
+          point.attempts = min(point.attempts, 1 + max(0, cnfg.retries));
+          if (keyLock >= 0 && point.error.empty())
+            cache.Store(key, PointResultFile(cnfg, point));
+        }
+        cache.Unlock(keyLock);
+        point.status = point.error.empty() ? "ok" : "failed";
+
+        lock_guard<mutex> lock(printLock);
+        cout << "cachesim-sweep: point " << point.index << " " << point.status << (point.cached ? " (cached)" : "")
+             << (point.error.empty() ? "" : " (" + point.error + ")") << ", "
+             << ++finished << "/" << points.size() << " done" << endl;
+      }
+    }));
+  }
+  for (thread &worker : workers)
+    worker.join();
+
+  WriteResults(cnfg, points);
+
+  int failed = 0;
+  for (const SweepPoint &point : points)
+    failed += (point.status != "ok");
+  cout << "cachesim-sweep: " << (points.size() - failed) << " points done, " << failed << " failed; results in "
+       << cnfg.outDir << "/results.csv and results.json" << endl;
+  return (failed > 0) ? 1 : 0;
+}
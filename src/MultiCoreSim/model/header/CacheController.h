@@ -13,6 +13,7 @@
 #include "ns3/object.h"
 #include "ns3/core-module.h"
 #include "CommunicationInterface.h"
+#include "StatsRegistry.h"
 #include "CacheDataHandler.h"
 #include "CacheDataHandler_COTS.h"
 #include "CacheXml.h"
@@ -30,6 +31,7 @@
 #include <queue>
 #include <vector>
 #include <map>
+#include <unordered_map>
 
 namespace ns3
 {
@@ -61,9 +63,43 @@ namespace ns3
         std::map<uint64_t, Message> m_saved_requests_for_wb;
 
         std::vector<Message> m_data_access_buffer;
-        std::map<int, ControllerAction> m_data_access_action; // The map holds the action is required by the entry in m_data_array_queue (Key is the message id)
+        std::map<uint64_t, ControllerAction> m_data_access_action; // The map holds the action is required by the entry in m_data_array_queue (Key is the message id)
         Arbiter *m_data_access_arbiter;
 
+        // Non-blocking mode (CacheXml NonBlocking): a CPU request to a block that
+        // already misses joins that miss instead of stalling in m_processing_queue,
+        // and at most m_max_outstanding_misses blocks (CacheXml MSHRs) miss at once
+        bool m_non_blocking;
+        uint32_t m_max_outstanding_misses;
+
+        // Memory-level parallelism statistics
+        uint64_t m_primary_misses;
+        uint64_t m_secondary_misses;     // merged into an outstanding miss
+        uint64_t m_mshr_full_stalls;     // primary misses held back, all MSHRs busy
+        uint64_t m_miss_cycles;          // cycles with at least one outstanding miss
+        uint64_t m_outstanding_sum;      // outstanding misses summed over m_miss_cycles
+        uint32_t m_max_outstanding;
+
+        // Atomics (CpuFIFO RMW) enter the cache as stores, so the protocol
+        // brings the line in M; once done, the line is held for
+        // m_atomic_latency cycles, during which other cores' requests for it
+        // wait in m_processing_queue
+        struct AtomicLineStats
+        {
+            uint64_t atomics;
+            uint64_t misses;       // atomics that found the line not writable
+            uint64_t held_snoops;  // cycles other cores' requests waited on the hold
+        };
+
+        uint32_t m_atomic_latency;
+        std::unordered_map<uint64_t, uint64_t> m_atomics;      // msg_id -> arrival cycle
+        std::unordered_map<uint64_t, uint64_t> m_locked_lines; // line key -> first cycle after the hold
+        std::unordered_map<uint64_t, AtomicLineStats> m_atomic_lines;
+        uint64_t m_atomic_count;
+        uint64_t m_atomic_latency_sum;
+        uint64_t m_atomic_misses;
+        uint64_t m_held_snoops;
+
 
         virtual void cycleProcess();
         virtual void processLogic();
@@ -72,6 +108,12 @@ namespace ns3
 
         virtual uint64_t getAddressKey(uint64_t addr);
 
+        virtual bool mergeSecondaryMiss(const Message &msg);
+        virtual bool needsFreeMSHR(const Message &msg);
+        virtual void sampleOutstandingMisses();
+        virtual void completeAtomic(const Message &msg);
+        virtual bool isLineHeld(uint64_t addr);
+
         virtual void callActionFunction(ControllerAction);
 
         virtual void removePendingAndRespond(void *);
@@ -99,6 +141,10 @@ namespace ns3
         virtual void init();
         virtual void initializeCacheData(std::vector<std::string> &tracePaths);
         static void step(Ptr<CacheController> cache_controller);
+        virtual void printStats(std::ostream &out);
+        virtual void registerStats(StatsRegistry &stats);
+        // Sends whatever the controller still buffers once the cores are done, true when nothing is left
+        virtual bool flushWriteBacks() { return true; }
         //inline uint64_t getCacheCycle() { return m_cache_cycle; }
     };
 }
@@ -1,49 +1,54 @@
 /*
- * File  :      CacheControllerPEN.h
+ * File  :      CacheControllerPENDULUM.h
  * Author:      Safin Bayes
- * Email :      bayess@@mcmaster.ca
+ * Email :      bayess@mcmaster.ca
  *
  * Created On March 09, 2022
  */
 
-#ifndef _CacheControllerPEN_H
-#define _CacheControllerPEN_H
+#ifndef _CacheControllerPENDULUM_H
+#define _CacheControllerPENDULUM_H
 
 #include "CacheController.h"
-#include "TimerCache.h"
+#include "TimingWheel.h"
+
+#include <deque>
 
 namespace ns3
 {
+    /**
+     * brief Private cache controller of the PENDULUM protocol. Every line the
+     * FSM starts a timer for (RT action) gets a Timeout event m_timer_cycles
+     * later unless the FSM stops it first (Stop_T action). The timers live in a
+     * timing wheel, so a cycle only costs the number of lines that expire in it
+     * rather than a scan of the whole cache.
+     */
     class CacheControllerPENDULUM : public CacheController
     {
-        protected:
-            uint64_t timer_val;     // TODO: Should come from the user
-            int sharer_count;
-            uint32_t num_cacheLines; 
-            // TimerCache* m_cache_pendulum; 
-            std::vector<Message> self_msgs;
-            
-            virtual void calc_timeout();
-            virtual void callActionFunction(ControllerAction) override;      //Why no override
-            
-            virtual void timer_actions(void *);
-            virtual void add_sharer(void *);                  // For LLC
-            virtual void remove_sharer(void *);               // For LLC
-            
-            virtual void initializeCacheHandler(CacheXml &cacheXml) override;
-            
-            virtual void addRequests2ProcessingQueue(FRFCFS_Buffer<Message, CoherenceProtocolHandler> &) override;
-            virtual void updateCacheLine(void *) override;
-        
-        public:
-            static TypeId GetTypeId(void); // Override TypeId.
-
-            CacheControllerPENDULUM(CacheXml &cacheXml, string &fsm_path,
-                        CommunicationInterface* upper_interface, CommunicationInterface* lower_interface,
-                        bool cach2Cache, int sharedMemId, CohProtType pType);
-            ~CacheControllerPENDULUM();
+    protected:
+        uint64_t m_timer_cycles;
+        TimingWheel m_timers;                // keyed by getAddressKey(addr)
+        std::deque<Message> m_timeout_msgs;  // expired timers not yet in the processing queue
+        std::vector<uint64_t> m_expired;     // scratch buffer for TimingWheel::advance
+
+        uint64_t m_timeout_count;
+
+        virtual void callActionFunction(ControllerAction) override;
+        virtual void timerAction(void *);
+
+        virtual void addRequests2ProcessingQueue(FRFCFS_Buffer<Message, CoherenceProtocolHandler> &) override;
+
+    public:
+        static TypeId GetTypeId(void); // Override TypeId.
+
+        CacheControllerPENDULUM(CacheXml &cacheXml, string &fsm_path,
+                                CommunicationInterface *upper_interface, CommunicationInterface *lower_interface,
+                                bool cach2Cache, int sharedMemId, CohProtType pType);
+        ~CacheControllerPENDULUM();
 
+        virtual void printStats(std::ostream &out) override;
+        virtual void registerStats(StatsRegistry &stats) override;
     };
 }
 
-#endif /* _CacheController_H */
+#endif /* _CacheControllerPENDULUM_H */
@@ -0,0 +1,38 @@
+#ifndef _CacheControllerPENDULUM_LLC_H
+#define _CacheControllerPENDULUM_LLC_H
+
+#include "CacheController_End2End.h"
+
+#include <deque>
+#include <unordered_map>
+
+namespace ns3
+{
+    /**
+     * brief Shared cache controller of the PENDULUM protocol. It counts the
+     * private caches holding each line (IncrementSharer/DecrementSharer) and
+     * feeds the FSM a Sharers_0 event when the last one leaves.
+     */
+    class CacheControllerPENDULUM_LLC : public CacheController_End2End
+    {
+    protected:
+        std::unordered_map<uint64_t, int> m_sharer_count; // keyed by getAddressKey(addr), only lines with sharers
+        std::deque<Message> m_sharers_0_msgs;
+
+        virtual void callActionFunction(ControllerAction) override;
+        virtual void addSharer(void *);
+        virtual void removeSharer(void *);
+
+        virtual void addRequests2ProcessingQueue(FRFCFS_Buffer<Message, CoherenceProtocolHandler> &buf) override;
+
+    public:
+        static TypeId GetTypeId(void); // Override TypeId.
+
+        CacheControllerPENDULUM_LLC(CacheXml &cacheXml, string &fsm_path,
+                                    CommunicationInterface *upper_interface, CommunicationInterface *lower_interface,
+                                    bool cach2Cache, int sharedMemId, CohProtType pType, vector<int> *private_caches_id = NULL);
+        ~CacheControllerPENDULUM_LLC();
+    };
+}
+
+#endif /* _CacheControllerPENDULUM_LLC_H */
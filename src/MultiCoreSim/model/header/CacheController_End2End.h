@@ -11,6 +11,9 @@
 
 #include "CacheController.h"
 
+#include <deque>
+#include <map>
+
 namespace ns3
 {
     class CacheController_End2End : public CacheController
@@ -18,6 +21,64 @@ namespace ns3
     protected:
         int m_owner_of_latest_data;
 
+        // MemGuard-style bandwidth regulation of the requests this LLC sends to
+        // memory: every RegulationPeriod cycles a core may send MemBudget
+        // requests, the rest wait for the next period. Requests the budget
+        // allows leave while the memory interface has room, the others stay
+        // queued for the next cycle. Write-backs are not held.
+        struct CoreBudget
+        {
+            int budget;
+            int used;
+            std::deque<Message *> throttled;
+            uint64_t throttled_requests;
+            uint64_t throttled_cycles; // Cycles with at least one request held back
+        };
+
+        uint64_t m_regulation_period;
+        std::map<int, int> m_core_of_owner;  // Requesting cache id -> core id
+        std::map<int, CoreBudget> m_budgets; // core id -> budget
+
+        // Write-back buffer in front of memory (CacheXml WBBufferSize). Write-backs
+        // leave it one per cycle when the drain policy (WBDrainPolicy) allows:
+        // EAGER at once, WATERMARK in bursts from WBHighWatermark down to
+        // WBLowWatermark, IDLE only in cycles after no read went to memory.
+        // A write-back to a buffered line replaces its data, and a miss to a
+        // buffered line is served from the buffer. Once the cores are done the
+        // buffer drains whatever the policy (flushWriteBacks).
+        enum class WBDrainPolicy
+        {
+            EAGER,
+            WATERMARK,
+            IDLE
+        };
+
+        WBDrainPolicy m_wb_policy;
+        std::deque<Message> m_wb_buffer;
+        uint32_t m_wb_buffer_size;
+        uint32_t m_wb_high_watermark;
+        uint32_t m_wb_low_watermark;
+        bool m_wb_draining;
+        bool m_wb_flushing;
+        uint64_t m_last_mem_read_cycle;
+
+        uint64_t m_wb_sent;
+        uint64_t m_wb_coalesced;
+        uint64_t m_wb_forwarded;     // Misses served from the write-back buffer
+        uint64_t m_wb_forced;        // Write-backs sent early because the buffer was full
+        uint64_t m_wb_occupancy_sum; // Buffer occupancy summed over cycles
+
+        bool rollbackRequest(Message *msg);
+        bool throttleRequest(Message *msg);
+        void regulateBandwidth();
+        void sendMemoryRequest(Message *msg);
+        bool trySendMemoryRequest(Message *msg);
+        bool sendWriteBack(Message &msg);
+        void bufferWriteBack(const Message &msg);
+        void drainWriteBacks();
+
+        virtual void cycleProcess() override;
+
         virtual void addRequests2ProcessingQueue(FRFCFS_Buffer<Message, CoherenceProtocolHandler> &buf) override;
         
         virtual void callActionFunction(ControllerAction) override;
@@ -33,6 +94,12 @@ namespace ns3
                                 CommunicationInterface *upper_interface, CommunicationInterface *lower_interface,
                                 bool cach2Cache, int sharedMemId, CohProtType pType, vector<int> *private_caches_id = NULL);
         ~CacheController_End2End();
+
+        // Requests from cache owner_id count against core_id's budget (0 = unregulated)
+        void SetMemBudget(int owner_id, int core_id, int budget);
+        virtual void printStats(std::ostream &out) override;
+        virtual void registerStats(StatsRegistry &stats) override;
+        virtual bool flushWriteBacks() override;
     };
 }
 
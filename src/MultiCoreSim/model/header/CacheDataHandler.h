@@ -91,6 +91,11 @@ namespace ns3
 
         int findEmptyWay(uint64_t address);
 
+        inline uint64_t lineAddress(uint64_t address)
+        {
+            return address & ~((uint64_t)m_block_size - 1);
+        }
+
         uint64_t getEvictionCandidate(uint64_t address, GenericCacheLine *line);
         
         virtual void updateCycle(uint64_t cycle);
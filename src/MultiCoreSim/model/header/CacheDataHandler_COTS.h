@@ -29,8 +29,8 @@ namespace ns3
         std::map<uint64_t, std::pair<MSHRMetadata, GenericCacheLine>>
             m_miss_status_holding_regs; //MSHR
         std::map<uint64_t, GenericCacheLine> m_pending_write_back_regs; //PWB
-        uint64_t MSHR_max_size = 10;
-        uint64_t WB_max_size = 10;
+        uint64_t MSHR_max_size; // CacheXml MSHRs
+        uint64_t WB_max_size; // CacheXml WBBufferSize
 
         bool line_added2PWB;
         uint64_t address_of_recently_added2PWB;
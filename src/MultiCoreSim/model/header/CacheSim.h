@@ -12,23 +12,106 @@
 #include "ns3/tinyxml.h"
 #include "ns3/MCoreSimProjectXml.h"
 #include "ns3/MCoreSimProject.h"
+#include "ns3/StatsRegistry.h"
 
+#include <exception>
+#include <map>
+#include <mutex>
+#include <sstream>
+#include <string>
 #include <thread>
+#include <vector>
 
 namespace ns3
 {
+    /*
+     * The statistics of a run by name: a copy of the counters the components
+     * registered with the project's StatsRegistry, e.g. "Core 0 IPC" or
+     * "Memory channel 1 DRAM reads". Rates are in percent and latencies in
+     * cycles of the component's clock, as in the report.
+     */
+    class CacheSimStats
+    {
+    private:
+        std::map<std::string, double> m_values;
+        std::vector<std::string> m_order; // Names in the order they were registered
+
+    public:
+        void read(const StatsRegistry &registry);
+
+        bool has(const std::string &name) const { return m_values.count(name) > 0; }
+        double get(const std::string &name, double fallback = 0) const;
+        const std::vector<std::string> &names() const { return m_order; }
+        const std::map<std::string, double> &values() const { return m_values; }
+        size_t size() const { return m_order.size(); }
+    };
+
+    /*
+     * One simulation, embeddable in a larger program. A CacheSim is made
+     * from a configuration file or from an MCoreSimProjectXml built in
+     * memory (LoadFromString, then the setters), is run to the end of its
+     * traces or for a number of bus cycles at a time, and leaves its
+     * statistics in stats() and its end-of-run report in report() rather
+     * than only on cout. An invalid configuration makes the run throw
+     * std::runtime_error with the reason, and leaves the process and the
+     * simulator usable for the next CacheSim.
+     *
+     * ns-3 has one Simulator per process, so a CacheSim owns it from its
+     * first run until the run is over or the CacheSim is destroyed. Running
+     * another instance meanwhile, from any thread, throws
+     * std::runtime_error instead of waiting: the owner may be the caller
+     * itself, between two runFor() calls. Any number of instances can exist
+     * at once, and each one starts from a fresh simulator, so runs in one
+     * process give the same results as runs in separate processes.
+     */
     class CacheSim
     {
     private:
+        // The one ns-3 Simulator of the process is busy with some instance's run
+        static std::mutex s_simulator_lock;
+        static bool s_simulator_busy;
+        bool m_owns_simulator;
+
+        MCoreSimProjectXml m_config;
         std::thread* simulator_thread;
+        std::exception_ptr m_thread_error; // What ended the run() thread, rethrown by join()
         MCoreSimProject* project;
 
+        std::stringstream m_report;
+        CacheSimStats m_stats;
+        bool m_finished;
+        uint64_t m_cycles;
+
+        void acquireSimulator();
+        void releaseSimulator();
+        void start();
+        bool runUntil(uint64_t cycle);
+        void finish();
+        void abandon();
+
     public:
-        CacheSim(const char *config_file_path, const char *output_logs_path);
+        // Traces are read from bms_path; the run's own outputs go to output_path
+        // (and its newLogger directory) when given, else next to the traces
+        CacheSim(const char *config_file_path, const char *bms_path, const char *output_path = NULL);
+        CacheSim(const MCoreSimProjectXml &config);
         ~CacheSim();
 
+        // Runs to the end of the traces in a thread of its own. run() takes the
+        // simulator before it returns; join() rethrows what stopped the run.
         void run();
         void join();
+
+        // Run in the calling thread; both return true once the traces are done
+        // or the configured simulation time is up
+        bool runToCompletion();
+        bool runFor(uint64_t cycles);
+
+        bool done() const { return m_finished; }
+        uint64_t cycles() const;
+
+        // The final statistics once done, otherwise those of the current cycle
+        const CacheSimStats &stats();
+        std::string report() const { return m_report.str(); }
     };
 }
 
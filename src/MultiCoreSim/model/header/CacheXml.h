@@ -29,6 +29,27 @@ private:
   string m_replcPolicy;
   int m_cachePreload;
   int dataAccessLatency;
+  int m_pendulumTimer; // PENDULUM: cycles a line is kept before it times out
+  int m_nonBlocking;   // 1 = merge secondary misses and cap primary misses at m_mshrs
+  int m_mshrs;         // Outstanding misses (cache blocks) the cache can track
+  int m_robSize;       // 0 = use the project-wide ROBSize
+  int m_robRetireWidth; // 0 = use the project-wide ROBRetireWidth
+  int m_loadQueueSize;  // 0 = use the project-wide LoadQueueSize
+  int m_storeQueueSize; // 0 = use the project-wide StoreQueueSize
+  int m_lsqCachePorts;  // 0 = use the project-wide LSQCachePorts
+  int m_dispatchWidth;  // 0 = use the project-wide DispatchWidth
+  int m_threads;        // SMT hardware threads of the core
+  string m_fetchPolicy; // SMT fetch policy, "RR" or "ICOUNT"
+  int m_fetchBufferSize; // L1I only: instructions a thread can hold fetched but not dispatched
+  int m_memBudget;      // Memory requests the core may send per regulation period, 0 = unregulated
+  int m_regulationPeriod; // LLC only: MemGuard regulation period in LLC cycles, 0 = no regulation
+  int m_wbBufferSize;   // Write-back buffer entries (evicted dirty lines)
+  string m_wbDrainPolicy; // LLC only: when write-backs leave for memory, "EAGER", "WATERMARK" or "IDLE"
+  int m_wbHighWatermark; // WATERMARK: buffered write-backs that start a drain
+  int m_wbLowWatermark;  // WATERMARK: buffered write-backs that end it
+  int m_socket;          // NUMA socket of the core, -1 = cores are split evenly in cacheId order
+  int m_atomicLatency;   // L1 only: cycles an atomic keeps its line from other cores' snoops
+  int m_asid;            // Address space of the core's process, cores with the same ASID share page tables
   
 public:
 
@@ -112,6 +133,90 @@ public:
   int GetDataAccessLatency () {
     return dataAccessLatency;
   }
+
+  int GetPendulumTimer () {
+    return m_pendulumTimer;
+  }
+
+  bool GetNonBlocking () {
+    return m_nonBlocking != 0;
+  }
+
+  int GetMSHRs () {
+    return m_mshrs;
+  }
+
+  int GetROBSize () {
+    return m_robSize;
+  }
+
+  int GetROBRetireWidth () {
+    return m_robRetireWidth;
+  }
+
+  int GetLoadQueueSize () {
+    return m_loadQueueSize;
+  }
+
+  int GetStoreQueueSize () {
+    return m_storeQueueSize;
+  }
+
+  int GetLSQCachePorts () {
+    return m_lsqCachePorts;
+  }
+
+  int GetDispatchWidth () {
+    return m_dispatchWidth;
+  }
+
+  int GetThreads () {
+    return m_threads;
+  }
+
+  string GetFetchPolicy () {
+    return m_fetchPolicy;
+  }
+
+  int GetFetchBufferSize () {
+    return m_fetchBufferSize;
+  }
+
+  int GetMemBudget () {
+    return m_memBudget;
+  }
+
+  int GetRegulationPeriod () {
+    return m_regulationPeriod;
+  }
+
+  int GetWBBufferSize () {
+    return m_wbBufferSize;
+  }
+
+  string GetWBDrainPolicy () {
+    return m_wbDrainPolicy;
+  }
+
+  int GetSocket () {
+    return m_socket;
+  }
+
+  int GetAtomicLatency () {
+    return m_atomicLatency;
+  }
+
+  int GetASID () {
+    return m_asid;
+  }
+
+  int GetWBHighWatermark () {
+    return m_wbHighWatermark;
+  }
+
+  int GetWBLowWatermark () {
+    return m_wbLowWatermark;
+  }
   
   void LoadFromXml(TiXmlHandle root) {
 
@@ -130,6 +235,27 @@ public:
      m_nPendingReq     = 1;
      m_cachePreload    = 0;
      dataAccessLatency = 0;
+     m_pendulumTimer   = 100;
+     m_nonBlocking     = 0;
+     m_mshrs           = 10;
+     m_robSize         = 0;
+     m_robRetireWidth  = 0;
+     m_loadQueueSize   = 0;
+     m_storeQueueSize  = 0;
+     m_lsqCachePorts   = 0;
+     m_dispatchWidth   = 0;
+     m_threads         = 1;
+     m_fetchPolicy     = "RR";
+     m_fetchBufferSize = 16;
+     m_memBudget       = 0;
+     m_regulationPeriod = 0;
+     m_wbBufferSize    = 10;
+     m_wbDrainPolicy   = "EAGER";
+     m_wbHighWatermark = 8;
+     m_wbLowWatermark  = 2;
+     m_socket          = -1;
+     m_atomicLatency   = 2;
+     m_asid            = 0;
      
      TiXmlElement* CacheRootPtr = root.Element();
      CacheRootPtr->QueryIntAttribute   ("cacheId"          , &m_cacheId         );
@@ -146,6 +272,27 @@ public:
      CacheRootPtr->QueryIntAttribute   ("nways"            , &m_nways           );
      CacheRootPtr->QueryIntAttribute   ("CachePreLoad"     , &m_cachePreload    );
      CacheRootPtr->QueryIntAttribute   ("dataAccessLatency", &dataAccessLatency );
+     CacheRootPtr->QueryIntAttribute   ("PendulumTimer"    , &m_pendulumTimer   );
+     CacheRootPtr->QueryIntAttribute   ("NonBlocking"      , &m_nonBlocking     );
+     CacheRootPtr->QueryIntAttribute   ("MSHRs"            , &m_mshrs           );
+     CacheRootPtr->QueryIntAttribute   ("ROBSize"          , &m_robSize         );
+     CacheRootPtr->QueryIntAttribute   ("ROBRetireWidth"   , &m_robRetireWidth  );
+     CacheRootPtr->QueryIntAttribute   ("LoadQueueSize"    , &m_loadQueueSize   );
+     CacheRootPtr->QueryIntAttribute   ("StoreQueueSize"   , &m_storeQueueSize  );
+     CacheRootPtr->QueryIntAttribute   ("LSQCachePorts"    , &m_lsqCachePorts   );
+     CacheRootPtr->QueryIntAttribute   ("DispatchWidth"    , &m_dispatchWidth   );
+     CacheRootPtr->QueryIntAttribute   ("Threads"          , &m_threads         );
+     CacheRootPtr->QueryStringAttribute("FetchPolicy"      , &m_fetchPolicy     );
+     CacheRootPtr->QueryIntAttribute   ("FetchBufferSize"  , &m_fetchBufferSize );
+     CacheRootPtr->QueryIntAttribute   ("MemBudget"        , &m_memBudget       );
+     CacheRootPtr->QueryIntAttribute   ("RegulationPeriod" , &m_regulationPeriod);
+     CacheRootPtr->QueryIntAttribute   ("WBBufferSize"     , &m_wbBufferSize    );
+     CacheRootPtr->QueryStringAttribute("WBDrainPolicy"    , &m_wbDrainPolicy   );
+     CacheRootPtr->QueryIntAttribute   ("WBHighWatermark"  , &m_wbHighWatermark );
+     CacheRootPtr->QueryIntAttribute   ("WBLowWatermark"   , &m_wbLowWatermark  );
+     CacheRootPtr->QueryIntAttribute   ("Socket"           , &m_socket          );
+     CacheRootPtr->QueryIntAttribute   ("AtomicLatency"    , &m_atomicLatency   );
+     CacheRootPtr->QueryIntAttribute   ("ASID"             , &m_asid            );
   }
 
 };
@@ -0,0 +1,52 @@
+#ifndef _CompiledFSM_H
+#define _CompiledFSM_H
+
+namespace ns3
+{
+    /**
+ * brief CompiledFSM is the build-time form of a Protocols_FSM CSV file.
+ * utils/generate-fsm-tables.py emits one constexpr CompiledFSM per CSV into
+ * ns3/CompiledFSMTables.h, and FSMReader uses it for the CSV of that name
+ * unless a CSV with another content hash is present at the runtime path.
+ */
+
+    struct CompiledFSM
+    {
+        struct Id
+        {
+            const char *name;
+            int value;
+        };
+
+        struct StateInfo
+        {
+            bool stable;
+            bool is_data_valid;
+        };
+
+        struct Transition
+        {
+            int next_state;
+            int action_offset; // index of the first action in action_pool
+            int action_count;
+        };
+
+        const char *file_name; // CSV file name the table was generated from, e.g. "MSI_LLC.csv"
+        unsigned long long content_hash; // 64-bit FNV-1a of the CSV's bytes
+
+        int event_id_count;
+        const Id *event_ids;
+        int action_id_count;
+        const Id *action_ids;
+        int state_id_count;
+        const Id *state_ids;
+
+        int state_count;
+        int event_count;
+        const StateInfo *state_info;     // state_count entries
+        const Transition *transitions;   // state_count * event_count entries
+        const int *action_pool;
+    };
+}
+
+#endif /* _CompiledFSM_H */
@@ -13,67 +13,148 @@
 #include "ns3/ptr.h"
 #include "ns3/core-module.h"
 #include "MemTemplate.h"
+#include "TraceFile.h"
+#include "StatsRegistry.h"
 #include <string>
+#include <vector>
+#include <unordered_map>
+#include <algorithm>
 
 namespace ns3 {
 
 class CpuFIFO;
 class ROB;
 class LSQ;
+class MMU;
 
 /**
  * @brief CPU Core Generator with Out-of-Order execution support
+ *
+ * A core runs one or more hardware threads (SMT). Every thread reads its own
+ * trace and has its own ROB partition and LSQ; the threads share the dispatch
+ * width, the CpuFIFO and so the private cache behind it. The fetch policy picks
+ * the order in which threads get the dispatch slots of a cycle.
+ *
+ * When the core has an L1I, a fetch stage reads each thread's instruction
+ * addresses and requests their blocks from the L1I; an instruction can only be
+ * dispatched once it has been fetched.
+ *
+ * When virtual memory is enabled, the core's CpuFIFO leads to an MMU instead of
+ * the L1D; the core steps the MMU every cycle, after dispatch.
  */
 class CpuCoreGenerator : public ns3::Object {
+public:
+    enum class FetchPolicy {
+        RoundRobin,     // Threads take turns being first
+        ICount          // Thread with the fewest instructions in its ROB goes first
+    };
+
 private:
+    /**
+     * @brief State of one hardware thread
+     */
+    struct HwThread {
+        uint32_t id;                    // Thread index within the core
+        ROB* rob;                       // ROB partition of the thread
+        LSQ* lsq;                       // Load-store queue of the thread
+        std::string bmFileName;         // Benchmark trace filename
+        TraceReader bmTrace;            // Trace file, mapped and shared with other readers
+        uint32_t remaining_compute;     // Remaining compute instructions
+        bool newSampleRdy;              // memReq holds a trace line not dispatched yet
+        bool reqDone;                   // Trace processing complete
+        bool done;                      // All instructions of the thread completed
+        uint32_t sent_requests;         // In-flight requests
+        CpuFIFO::ReqMsg memReq;         // Current memory request
+        uint64_t reqCnt;                // Instructions dispatched
+        uint64_t respCnt;               // Instructions completed
+        uint64_t retired;               // Instructions retired by the ROB
+
+        // Fetch stage (only used when the core has an L1I)
+        std::string instFileName;       // Instruction-fetch trace filename
+        TraceReader instTrace;          // Instruction-fetch trace
+        uint32_t fetched;               // Instructions fetched, not dispatched yet
+        bool fetchLineValid;            // fetchLine holds the last block the L1I delivered
+        uint64_t fetchLine;             // Block the fetch stage reads instructions from
+        bool hasNextInst;               // nextInst was read from the trace but not fetched yet
+        uint64_t nextInst;              // Address of the next instruction to fetch
+        bool fetchPending;              // Waiting for the L1I
+        bool instDone;                  // Instruction-fetch trace exhausted, fetch no longer limits dispatch
+        uint64_t fetchRequests;         // Blocks requested from the L1I
+        uint64_t fetchStallCycles;      // Cycles the thread had work but nothing fetched
+    };
+
     // Core configuration
     uint32_t m_coreId;              // Core identifier
     double m_dt;                    // Clock period
     double m_clkSkew;               // Clock skew
     bool m_logFileGenEnable;        // Enable log file generation
-    
+
     // Pipeline components
-    CpuFIFO* m_cpuFIFO;            // Interface to memory system
-    ROB* m_rob;                     // Reorder buffer
-    LSQ* m_lsq;                     // Load-store queue
-    
+    CpuFIFO* m_cpuFIFO;            // Interface to memory system, shared by the threads
+    std::vector<HwThread*> m_threads; // Hardware threads
+    FetchPolicy m_fetch_policy;     // Dispatch priority between threads
+    uint32_t m_rr_next;             // Thread that goes first next cycle (RoundRobin)
+    std::unordered_map<uint64_t, uint32_t> m_thread_of; // msgId -> thread, memory requests in flight
+
+    // Instruction fetch
+    CpuFIFO* m_instFIFO;           // Interface to the L1I, NULL if fetch is not modelled
+    uint16_t m_instCacheId;         // Id of the L1I (owner of fetch requests)
+    int m_instBlockBits;            // log2 of the L1I block size
+    uint32_t m_fetch_buffer_size;   // Fetched instructions a thread can hold
+    std::unordered_map<uint64_t, uint32_t> m_fetch_thread_of; // msgId -> thread, fetches in flight
+
+    // Address translation, NULL if the core uses the trace addresses as physical
+    MMU* m_mmu;
+
     // Trace file handling
-    std::string m_bmFileName;       // Benchmark trace filename
     std::string m_cpuTraceFileName; // CPU trace output filename
     std::string m_ctrlsTraceFileName; // Controllers trace filename
-    std::ifstream m_bmTrace;        // Trace file stream
     std::ofstream m_cpuTrace;       // CPU trace output stream
     std::ofstream m_ctrlsTrace;     // Controllers trace stream
-    
+
     // Execution state
     uint64_t m_cpuCycle;            // Current CPU cycle
-    uint32_t m_remaining_compute;    // Remaining compute instructions
-    bool m_newSampleRdy;            // New trace line ready
-    bool m_cpuReqDone;              // Trace processing complete
     bool m_cpuCoreSimDone;          // Simulation complete
-    
+
     // Request tracking
-    uint32_t m_sent_requests;       // In-flight memory requests
-    uint32_t m_number_of_OoO_requests; // Maximum in-flight requests
-    CpuFIFO::ReqMsg m_cpuMemReq;    // Current memory request
+    uint32_t m_number_of_OoO_requests; // Maximum in-flight requests per thread
+    uint32_t m_dispatch_width;      // Instructions of each kind dispatched per cycle, all threads
     CpuFIFO::RespMsg m_cpuMemResp;  // Current memory response
-    uint32_t m_cpuReqCnt;           // Total requests processed
+    uint32_t m_cpuReqCnt;           // Total requests processed (next msgId)
     uint32_t m_cpuRespCnt;          // Total responses received
-    
+
     // Request timing
     bool m_prevReqFinish;           // Previous request complete
     uint64_t m_prevReqFinishCycle;  // Cycle previous request finished
     uint64_t m_prevReqArriveCycle;  // Cycle previous request arrived
 
+    HwThread* NewThread(uint32_t id);
+    void DeleteThreads();
+    void ProcessThreadTx(HwThread& thread, uint32_t& compute_budget, uint32_t& mem_budget);
+    bool ReadTraceLine(HwThread& thread);      // Parse the next trace line
+    bool DispatchMemReq(HwThread& thread);     // Allocate thread.memReq in the ROB and LSQ
+    void ProcessFetch();                       // Fetch stage of every thread
+    void FetchThread(HwThread& thread);
+    void ProcessFetchRx();                     // Blocks returned by the L1I
+
+    // Instructions the fetch stage lets the thread dispatch
+    inline uint32_t fetchedInsts(const HwThread& thread) const {
+        return (m_instFIFO && !thread.instDone) ? thread.fetched : UINT32_MAX;
+    }
+    inline void consumeFetched(HwThread& thread, uint32_t count) {
+        thread.fetched -= std::min(count, thread.fetched);
+    }
+
 public:
     static TypeId GetTypeId(void);  // Required by NS3
-    
+
     // Constructor/Destructor
     CpuCoreGenerator(CpuFIFO* associatedCpuFIFO);
     virtual ~CpuCoreGenerator();
-    
+
     // Configuration methods
-    void SetBmFileName(std::string bmFileName);
+    void SetThreads(int threads, FetchPolicy policy);
+    void SetBmFileName(std::string bmFileName, int thread = 0);
     void SetCpuTraceFile(std::string fileName);
     void SetCtrlsTraceFile(std::string fileName);
     void SetCoreId(int coreId);
@@ -81,35 +162,36 @@ public:
     void SetClkSkew(double clkSkew);
     void SetLogFileGenEnable(bool logFileGenEnable);
     void SetOutOfOrderStages(int stages);
-    
+    void SetROBConfig(int size, int retireWidth);
+    void SetLSQConfig(int loadQueueSize, int storeQueueSize, int cachePorts);
+    void SetDispatchWidth(int width);
+    void SetInstFetch(CpuFIFO* instFIFO, int instCacheId, int blockSize, int fetchBufferSize);
+    void SetInstFileName(std::string instFileName, int thread = 0);
+    void SetMMU(MMU* mmu);
+
     // Getters
     int GetCoreId();
     double GetDt();
     bool GetCpuSimDoneFlag();
-    
+    int GetThreads() { return m_threads.size(); }
+
     // Core functionality
     void init();
     void ProcessTxBuf();
     void ProcessRxBuf();
     static void Step(Ptr<CpuCoreGenerator> cpuCoreGenerator);
-    
-    // Pipeline component setters
-    void setROB(ROB* rob) { m_rob = rob; }
-    void setLSQ(LSQ* lsq) { m_lsq = lsq; }
-    void setCpuFIFO(CpuFIFO* fifo) { m_cpuFIFO = fifo; }
-    
-    // Called by ROB when an instruction is retired
-    void onInstructionRetired(const CpuFIFO::ReqMsg& request) {
-        m_sent_requests--;  // Decrement in-flight count
-        std::cout << "[CPU] Instruction " << request.msgId << " retired, in-flight: " 
-                  << m_sent_requests << "/" << m_number_of_OoO_requests << std::endl;
-    }
-    
-    void notifyRequestSentToCache() { 
-        m_sent_requests++;  // Track when request is actually sent to cache
-        std::cout << "[CPU] Request sent to cache, in-flight: " 
-                  << m_sent_requests << "/" << m_number_of_OoO_requests << std::endl;
-    }
+    void printStats(std::ostream &out);
+    void registerStats(StatsRegistry &stats);
+
+    // Called by a thread's ROB when instructions are retired (count > 1 for a run of compute instructions)
+    void onInstructionRetired(uint32_t thread, const CpuFIFO::ReqMsg& request, uint32_t count = 1);
+
+    // Called by a thread's LSQ when it sends a request to the cache
+    void notifyRequestSentToCache(uint32_t thread);
+
+    // Called by a thread's LSQ for a load store forwarding satisfied before it was sent,
+    // it completes without a cache response
+    void notifyLoadForwarded(uint32_t thread, uint64_t msgId);
 };
 
 } // namespace ns3
@@ -0,0 +1,153 @@
+#ifndef _DRAMCnfgXml_H
+#define _DRAMCnfgXml_H
+#include "tinyxml.h"
+#include <string>
+
+using namespace std;
+
+/*
+ * Organization, timing and scheduling parameters of the DRAM model
+ * (DRAMModel), read from the DRAMCnfg element. MEMMODLE="DDR3" or "DDR4"
+ * selects a timing preset (DDR3-1600 / DDR4-2400, one controller cycle per
+ * DRAM command clock); any timing attribute given in the XML overrides it.
+ * All timings are in memory-controller clock cycles.
+ */
+class DRAMCnfgXml {
+private:
+  // Organization
+  int    m_channels;
+  int    m_ranks;
+  int    m_banks;
+  int    m_rowBufferSize;   // Bytes per row (page)
+  string m_addrMapping;     // Fields from MSB to LSB: Ro Ra Ba Ch Co
+  string m_pagePolicy;      // OPEN or CLOSE
+  int    m_powerDownIdle;   // Idle cycles before a rank powers down, 0 = never
+
+  // Scheduler
+  int    m_readQueueSize;
+  int    m_writeQueueSize;
+  int    m_writeHighWatermark; // Start draining writes at this write queue occupancy
+  int    m_writeLowWatermark;  // Stop draining writes at this write queue occupancy
+
+  // Timing
+  int    m_tRCD;
+  int    m_tCAS;
+  int    m_tCWL;
+  int    m_tRP;
+  int    m_tRAS;
+  int    m_tRRD;
+  int    m_tFAW;
+  int    m_tWTR;
+  int    m_tRTW;            // Read to write turnaround on the channel's data bus
+  int    m_tWR;
+  int    m_tRTP;
+  int    m_tBURST;
+  int    m_tRFC;
+  int    m_tREFI;
+  int    m_tXP;             // Power-down exit
+
+  void SetTimingPreset (string standard) {
+     if (standard == "DDR4") {
+       // DDR4-2400R, 8Gb x8
+       m_tRCD = 16; m_tCAS = 16; m_tCWL = 12; m_tRP  = 16; m_tRAS   = 39;
+       m_tRRD = 6;  m_tFAW = 26; m_tWTR = 9;  m_tWR  = 18; m_tRTP   = 9;
+       m_tBURST = 4; m_tRFC = 420; m_tREFI = 9360; m_tXP = 8;  m_tRTW = 10;
+     }
+     else {
+       // DDR3-1600K, 4Gb x8
+       m_tRCD = 11; m_tCAS = 11; m_tCWL = 8;  m_tRP  = 11; m_tRAS   = 28;
+       m_tRRD = 5;  m_tFAW = 24; m_tWTR = 6;  m_tWR  = 12; m_tRTP   = 6;
+       m_tBURST = 4; m_tRFC = 208; m_tREFI = 6240; m_tXP = 5;  m_tRTW = 9;
+     }
+  }
+
+public:
+
+  int GetChannels ()           { return m_channels;           }
+  int GetRanks ()              { return m_ranks;              }
+  int GetBanks ()              { return m_banks;              }
+  int GetRowBufferSize ()      { return m_rowBufferSize;      }
+  string GetAddrMapping ()     { return m_addrMapping;        }
+  string GetPagePolicy ()      { return m_pagePolicy;         }
+  int GetPowerDownIdle ()      { return m_powerDownIdle;      }
+  int GetReadQueueSize ()      { return m_readQueueSize;      }
+  int GetWriteQueueSize ()     { return m_writeQueueSize;     }
+  int GetWriteHighWatermark () { return m_writeHighWatermark; }
+  int GetWriteLowWatermark ()  { return m_writeLowWatermark;  }
+
+  int GetTRCD ()   { return m_tRCD;   }
+  int GetTCAS ()   { return m_tCAS;   }
+  int GetTCWL ()   { return m_tCWL;   }
+  int GetTRP ()    { return m_tRP;    }
+  int GetTRAS ()   { return m_tRAS;   }
+  int GetTRRD ()   { return m_tRRD;   }
+  int GetTFAW ()   { return m_tFAW;   }
+  int GetTWTR ()   { return m_tWTR;   }
+  int GetTRTW ()   { return m_tRTW;   }
+  int GetTWR ()    { return m_tWR;    }
+  int GetTRTP ()   { return m_tRTP;   }
+  int GetTBURST () { return m_tBURST; }
+  int GetTRFC ()   { return m_tRFC;   }
+  int GetTREFI ()  { return m_tREFI;  }
+  int GetTXP ()    { return m_tXP;    }
+
+  // standard is the timing preset used when the element has no MEMMODLE
+  void LoadFromXml(TiXmlHandle root, string standard = "DDR3") {
+
+     // default values
+     m_channels           = 1;
+     m_ranks              = 1;
+     m_banks              = 8;
+     m_rowBufferSize      = 8192;
+     m_addrMapping        = "RoRaBaChCo";
+     m_pagePolicy         = "OPEN";
+     m_powerDownIdle      = 0;
+     m_readQueueSize      = 32;
+     m_writeQueueSize     = 32;
+     m_writeHighWatermark = 24;
+     m_writeLowWatermark  = 8;
+
+     TiXmlElement* DRAMCnfgRootPtr = root.Element();
+     if (DRAMCnfgRootPtr == NULL) {
+       SetTimingPreset(standard);
+       return;
+     }
+
+     DRAMCnfgRootPtr->QueryStringAttribute ("MEMMODLE"           , &standard             );
+     SetTimingPreset(standard);
+
+     DRAMCnfgRootPtr->QueryIntAttribute    ("Channels"           , &m_channels           );
+     DRAMCnfgRootPtr->QueryIntAttribute    ("Ranks"              , &m_ranks              );
+     DRAMCnfgRootPtr->QueryIntAttribute    ("Banks"              , &m_banks              );
+     DRAMCnfgRootPtr->QueryIntAttribute    ("RowBufferSize"      , &m_rowBufferSize      );
+     DRAMCnfgRootPtr->QueryStringAttribute ("AddrMapping"        , &m_addrMapping        );
+     DRAMCnfgRootPtr->QueryStringAttribute ("PagePolicy"         , &m_pagePolicy         );
+     DRAMCnfgRootPtr->QueryIntAttribute    ("PowerDownIdle"      , &m_powerDownIdle      );
+     DRAMCnfgRootPtr->QueryIntAttribute    ("ReadQueueSize"      , &m_readQueueSize      );
+     DRAMCnfgRootPtr->QueryIntAttribute    ("WriteQueueSize"     , &m_writeQueueSize     );
+     DRAMCnfgRootPtr->QueryIntAttribute    ("WriteHighWatermark" , &m_writeHighWatermark );
+     DRAMCnfgRootPtr->QueryIntAttribute    ("WriteLowWatermark"  , &m_writeLowWatermark  );
+
+     DRAMCnfgRootPtr->QueryIntAttribute    ("tRCD"               , &m_tRCD               );
+     DRAMCnfgRootPtr->QueryIntAttribute    ("tCAS"               , &m_tCAS               );
+     DRAMCnfgRootPtr->QueryIntAttribute    ("tCWL"               , &m_tCWL               );
+     DRAMCnfgRootPtr->QueryIntAttribute    ("tRP"                , &m_tRP                );
+     DRAMCnfgRootPtr->QueryIntAttribute    ("tRAS"               , &m_tRAS               );
+     DRAMCnfgRootPtr->QueryIntAttribute    ("tRRD"               , &m_tRRD               );
+     DRAMCnfgRootPtr->QueryIntAttribute    ("tFAW"               , &m_tFAW               );
+     DRAMCnfgRootPtr->QueryIntAttribute    ("tWTR"               , &m_tWTR               );
+     DRAMCnfgRootPtr->QueryIntAttribute    ("tRTW"               , &m_tRTW               );
+     DRAMCnfgRootPtr->QueryIntAttribute    ("tWR"                , &m_tWR                );
+     DRAMCnfgRootPtr->QueryIntAttribute    ("tRTP"               , &m_tRTP               );
+     DRAMCnfgRootPtr->QueryIntAttribute    ("tBURST"             , &m_tBURST             );
+     DRAMCnfgRootPtr->QueryIntAttribute    ("tRFC"               , &m_tRFC               );
+     DRAMCnfgRootPtr->QueryIntAttribute    ("tREFI"              , &m_tREFI              );
+     DRAMCnfgRootPtr->QueryIntAttribute    ("tXP"                , &m_tXP                );
+
+     // The default watermarks assume the default write queue size
+     m_writeHighWatermark = min(m_writeHighWatermark, m_writeQueueSize);
+     m_writeLowWatermark  = max(min(m_writeLowWatermark, m_writeHighWatermark - 1), 0);
+  }
+};
+
+#endif /* _DRAMCnfgXml_H */
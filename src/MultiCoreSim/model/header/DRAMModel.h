@@ -0,0 +1,149 @@
+#ifndef _DRAMModel_H
+#define _DRAMModel_H
+
+#include "MainMemoryController.h"
+#include "DRAMCnfgXml.h"
+
+#include <deque>
+#include <map>
+#include <unordered_map>
+#include <vector>
+#include <string>
+
+namespace ns3
+{
+    /*
+     * Cycle-level DRAM model behind the LLC: channels, ranks and banks with
+     * row-buffer state, DDR3/DDR4 command timing (tRCD, tCAS, tRP, tRAS, tRRD,
+     * tFAW, tWTR, tRTW, tWR, refresh, power-down exit), open or closed page policy,
+     * ranks that power down after PowerDownIdle idle cycles, and an FR-FCFS
+     * scheduler per channel with separate read and write queues. Writes are
+     * drained in bursts between the write-queue watermarks, and a write to a
+     * line already in the write queue replaces the queued data. One command
+     * is issued per channel per controller cycle.
+     *
+     * Memory backends "DDR3" and "DDR4". The organization and timing come
+     * from the DRAMCnfg element, or from the DRAMCnfg root element of the
+     * backend's parameter file when one is given.
+     */
+    class DRAMModel : public MainMemoryController
+    {
+    protected:
+        struct Request
+        {
+            Message msg;
+            bool is_write;
+            int channel;
+            int rank;
+            int bank;
+            uint64_t row;
+            uint64_t arrive_cycle;
+            bool activated; // The row had to be opened for this request (not a row hit)
+            uint64_t write_cycles_at_arrival; // Channel write_cycles when the request arrived
+        };
+
+        struct Bank
+        {
+            bool open;
+            uint64_t row;
+            uint64_t next_act; // Earliest cycle for each command to this bank
+            uint64_t next_pre;
+            uint64_t next_rd;
+            uint64_t next_wr;
+        };
+
+        struct Rank
+        {
+            std::vector<Bank> banks;
+            std::deque<uint64_t> act_window; // Cycles of the last four ACTs (tFAW)
+            uint64_t next_act;               // tRRD
+            uint64_t next_rd;                // tWTR after a write burst
+            uint64_t next_refresh;           // Next REF is due
+            uint64_t refresh_until;          // Rank is busy refreshing until this cycle
+            uint32_t queued;                 // Requests to the rank in the read and write queues
+            uint64_t last_activity;          // Cycle of the last command to the rank
+            bool powered_down;
+            uint64_t wake_until;             // Rank is leaving power-down until this cycle (tXP)
+        };
+
+        struct Channel
+        {
+            std::vector<Rank> ranks;
+            std::deque<Request> read_q;
+            std::deque<Request> write_q;
+            std::unordered_map<uint64_t, uint32_t> write_lines; // line -> writes to it in write_q
+            Message deferred;  // Request taken from the LLC while its queue was full
+            bool has_deferred;
+            bool draining;     // Serving writes until the low watermark is reached
+            uint64_t bus_free; // First cycle the data bus is free
+            uint64_t next_wr;  // tRTW after a read burst
+            uint64_t write_cycles; // Cycles the channel served writes while reads were queued
+        };
+
+        enum AddrField
+        {
+            FIELD_ROW = 0,
+            FIELD_RANK,
+            FIELD_BANK,
+            FIELD_CHANNEL,
+            FIELD_COLUMN
+        };
+
+        DRAMCnfgXml m_cnfg;
+        bool m_close_page;
+        int m_line_size;
+        int m_line_bits;
+
+        // Address mapping, fields from the LSB up with their widths in bits
+        std::vector<std::pair<AddrField, int>> m_addr_fields;
+
+        std::vector<Channel> m_channels;
+        std::multimap<uint64_t, Message> m_responses; // Read data by the cycle its burst ends
+
+        // Statistics
+        uint64_t m_row_hits;
+        uint64_t m_row_misses;    // Column commands that needed an ACT
+        uint64_t m_row_conflicts; // PREs issued to open another row
+        uint64_t m_fwd_reads;     // Reads served from the write queue
+        uint64_t m_refreshes;
+        uint64_t m_refresh_stall_cycles; // Rank cycles with queued requests spent refreshing
+        uint64_t m_power_downs;
+        uint64_t m_power_down_cycles;    // Rank cycles spent powered down
+        uint64_t m_read_latency;  // Sum over reads, arrival to end of burst
+        uint64_t m_coalesced_writes;       // Writes merged into a queued write to the same line
+        uint64_t m_write_induced_latency;  // Sum over reads of the cycles they waited behind writes
+        uint64_t m_max_write_induced_latency;
+
+        void parseAddrMapping(std::string mapping);
+        void decode(uint64_t addr, Request &req);
+        bool enqueue(const Message &msg);
+
+        void scheduleChannel(Channel &ch);
+        bool handleRefresh(Rank &rank);
+        void updatePowerState(Rank &rank);
+        inline bool rankReady(const Rank &rank) const
+        {
+            return !rank.powered_down && m_clk_cycle >= rank.refresh_until && m_clk_cycle >= rank.wake_until;
+        }
+        bool canActivate(Rank &rank, Bank &bank);
+        bool canIssueColumn(Channel &ch, Rank &rank, Bank &bank, bool is_write);
+        bool rowHasPendingHits(Channel &ch, const Request &req, int skip_index, bool in_write_q);
+        void activate(Rank &rank, Bank &bank, uint64_t row);
+        void precharge(Rank &rank, Bank &bank);
+        void issueColumn(Channel &ch, std::deque<Request> &q, int index, bool in_write_q);
+
+        virtual void processLogic();
+
+    public:
+        static TypeId GetTypeId(void); // Override TypeId.
+
+        DRAMModel(MCoreSimProjectXml &projectXml, CommunicationInterface *lower_interface, int llc_id,
+                  std::string standard = "DDR3", std::string param_file = "");
+        ~DRAMModel();
+
+        virtual void printStats(std::ostream &out);
+        virtual void registerStats(StatsRegistry &stats);
+    };
+}
+
+#endif /* _DRAMModel_H */
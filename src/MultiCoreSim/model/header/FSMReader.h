@@ -15,6 +15,9 @@
 #include <sstream>
 #include <map>
 #include <vector>
+#include <stdint.h>
+
+#include "CompiledFSM.h"
 
 #define EVENT_CSV_ID "EventNum"
 #define ACTION_CSV_ID "ActionNum"
@@ -26,21 +29,81 @@ namespace ns3
     /**
  * brief FSMReader parses the CSV files that contain finite state machine, and
  * also the class provides methods to perfrom the FSM transitions.
+ *
+ * The CSV is parsed once and compiled into a dense (state x event) table, so
+ * a transition lookup on the hot path is a single indexed load with no
+ * allocation and no string lookup. When the build generated the tables from
+ * Protocols_FSM (see CompiledFSM.h), create() uses the table of the
+ * protocol's CSV name and needs no CSV at runtime; a CSV present at the
+ * runtime path with other content overrides the table.
  */
 
     class FSMReader
     {
     public:
+        /**
+         * brief A read-only view over the actions of one transition. It points
+         * into the reader's action pool, so it stays valid as long as the reader.
+         */
+        class ActionList
+        {
+        public:
+            ActionList() : m_first(NULL), m_count(0) {}
+            ActionList(const int *first, int count) : m_first(first), m_count(count) {}
+
+            const int *begin() const { return m_first; }
+            const int *end() const { return m_first + m_count; }
+            int size() const { return m_count; }
+            bool empty() const { return m_count == 0; }
+            int operator[](int i) const { return m_first[i]; }
+
+            bool contains(int action) const
+            {
+                for (int i = 0; i < m_count; i++)
+                    if (m_first[i] == action)
+                        return true;
+                return false;
+            }
+
+        private:
+            const int *m_first;
+            int m_count;
+        };
+
+        struct Transition
+        {
+            int next_state;
+            ActionList actions;
+            uint64_t action_mask; // bit i is set if action i is in the list (actions < 64)
+            bool is_hit;
+            bool is_stall;
+        };
+
         FSMReader(const std::string &fsmPath);
+        FSMReader(const CompiledFSM &fsm);
+
+        // Returns a reader backed by the build-time table of the CSV at fsmPath
+        // if there is one (same name and content), otherwise parses the CSV.
+        static FSMReader *create(const std::string &fsmPath);
+        static const CompiledFSM *findCompiledFSM(const std::string &fsmPath);
 
         int getState(const std::string &state_name);
-        bool isValidState(int state);
-        bool isHit(int state, int Event);
-        bool isStall(int state, int Event);
-        bool isStable(int state);
+        // Return -1 if the CSV does not define the event/action, so optional
+        // transactions (e.g. Upgrade) can fall back to what older CSVs support.
+        int getEvent(const std::string &event_name) const;
+        int getAction(const std::string &action_name) const;
+        int getEventCount() const { return m_event_count; }
+        int getStateCount() const { return m_state_count; }
 
-        void getTransition(int current_state, int event, 
-                            int& out_next_state, std::vector<int>& out_actions);
+        inline bool isValidState(int state) const { return m_state_valid[state]; }
+        inline bool isStable(int state) const { return m_state_stable[state]; }
+        inline bool isHit(int state, int event) const { return getTransition(state, event).is_hit; }
+        inline bool isStall(int state, int event) const { return getTransition(state, event).is_stall; }
+
+        inline const Transition &getTransition(int current_state, int event) const
+        {
+            return m_table[current_state * m_event_count + event];
+        }
 
     private:
         class FSMState
@@ -48,29 +111,38 @@ namespace ns3
         public:
             bool is_data_valid;
             bool stable;
-            
+
             FSMState(const std::string &line,
-                     const std::map<std::string, int> &eventIds,
                      const std::map<std::string, int> &actionIds,
                      const std::map<std::string, int> &stateIds);
             int getNextState(int event);
             const std::vector<int>& getActions(int event);
         private:
-            //the transitions map uses keys to represent the event number and 
+            //the transitions map uses keys to represent the event number and
             //value to represent the next state number
             std::map<int, int> transitions;
-            //the actions map uses keys to represent the event number, and 
+            //the actions map uses keys to represent the event number, and
             //value is a vector of integers that represents the action(s) number
-            std::map<int, std::vector<int>> actions; 
+            std::map<int, std::vector<int>> actions;
         };
 
         std::map<std::string, int> m_eventIds;
         std::map<std::string, int> m_actionIds;
         std::map<std::string, int> m_stateIds;
-        std::vector<FSMState> m_states;
+
+        // Compiled form of the FSM, built once by compile()
+        int m_event_count;
+        int m_state_count;
+        std::vector<Transition> m_table;   // indexed by state * m_event_count + event
+        std::vector<int> m_action_pool;    // all transitions' actions, back to back (CSV only)
+        std::vector<bool> m_state_valid;
+        std::vector<bool> m_state_stable;
 
         void parseFile(std::ifstream &file, std::map<std::string, int> &ids);
         void parseFile(std::ifstream &file, std::vector<FSMState> &states);
+        void compile(std::vector<FSMState> &states);
+        void buildTable(const int *action_pool, const CompiledFSM::Transition *cells,
+                        const CompiledFSM::StateInfo *state_info);
     };
 }
 
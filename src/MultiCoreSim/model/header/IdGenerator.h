@@ -18,6 +18,11 @@ public:
         return reqId++;
     }
 
+    // Ids restart with every simulation run in the process
+    static void reset() {
+        reqId = 1;
+    }
+
 
 };
 
@@ -2,7 +2,11 @@
 #define LSQ_H
 
 #include "MemTemplate.h"
+#include "StatsRegistry.h"
 #include <vector>
+#include <deque>
+#include <set>
+#include <unordered_map>
 #include <iostream>
 #include <iomanip>
 
@@ -13,66 +17,124 @@ class CpuFIFO;
 
 /**
  * @brief Load Store Queue (LSQ) implementation for Out-of-Order execution
- * 
+ *
  * Requirements from 3.3:
- * - Fixed size (8 entries)
+ * - Fixed size (8 loads and 8 stores by default, configurable per core)
  * - Store-to-load forwarding
  * - Memory ordering
  * - Coordination with ROB
+ *
+ * Loads and stores are kept in separate queues. Entries are found by msgId,
+ * and stores are indexed by address, so forwarding, responses and retirement
+ * never scan the queues. Up to m_cache_ports requests go to the cache per cycle.
+ *
+ * An atomic RMW holds a store entry and is a full fence, like a LOCK-prefixed
+ * x86 instruction: it goes to the cache once every older load and store has
+ * left the LSQ, nothing younger goes until its response is back, and no load
+ * is forwarded from a store while an RMW is pending.
  */
 class LSQ {
 private:
-    static const uint32_t MAX_ENTRIES = 8;  // Maximum LSQ entries (3.3)
-    
+    static const uint32_t DEFAULT_LOAD_ENTRIES = 8;   // Default load queue entries (3.3)
+    static const uint32_t DEFAULT_STORE_ENTRIES = 8;  // Default store queue entries (3.3)
+    static const uint32_t DEFAULT_CACHE_PORTS = 1;    // Default requests sent to the cache per cycle
+
     struct LSQEntry {
         CpuFIFO::ReqMsg request;    // Memory request details
         bool ready;                  // True when operation complete (3.3)
         bool waitingForCache;        // True when waiting for cache response
         bool cache_ack;             // True when cache confirms write complete
         uint64_t allocate_cycle;    // Cycle when instruction was allocated
+        uint64_t sent_cycle;        // Cycle the request went to the cache
     };
-    
-    uint32_t m_num_entries;         // Current number of entries
-    std::vector<LSQEntry> m_lsq_q;  // Queue storing LSQ entries
+
+    uint32_t m_max_loads;           // Load queue capacity
+    uint32_t m_max_stores;          // Store queue capacity
+    uint32_t m_cache_ports;         // Requests sent to the cache per cycle
+    uint32_t m_num_loads;           // Current number of loads
+    uint32_t m_num_stores;          // Current number of stores
+
+    std::unordered_map<uint64_t, LSQEntry> m_entries;            // msgId -> entry
+    std::deque<uint64_t> m_load_q;                               // Loads not yet sent to the cache, program order
+    std::deque<uint64_t> m_store_q;                              // Stores not yet sent to the cache, program order
+    std::deque<uint64_t> m_rmw_q;                                // RMWs not yet completed, program order
+    std::set<uint64_t> m_order;                                  // msgIds of all entries; they grow in program order
+    std::unordered_map<uint64_t, uint32_t> m_store_addrs;        // addr -> stores to it in the LSQ
+    std::unordered_map<uint64_t, std::vector<uint64_t>> m_waiting_loads; // addr -> loads to it that are not ready
+    std::vector<uint64_t> m_completed;                           // Entries retire() removes
+    uint64_t m_last_allocated;                                   // msgId removeLastEntry() rolls back
+
     CpuFIFO* m_cpuFIFO;            // Interface to CPU FIFO
     ROB* m_rob;                     // Pointer to ROB for coordination
     uint64_t m_current_cycle;       // Current CPU cycle
+    bool m_debug;                   // Log every request, response and cycle
+
+    // Memory-ordering statistics
+    uint64_t m_fwd_hits;            // Loads served by store-to-load forwarding
+    uint64_t m_loads_sent;          // Loads sent to the cache
+    uint64_t m_stores_sent;         // Stores sent to the cache
+    uint64_t m_blocked_loads;       // Cycles a load was refused an entry, load queue full
+    uint64_t m_blocked_stores;      // Cycles a store or RMW was refused an entry, store queue full
+    uint64_t m_port_stalls;         // Cycles requests were left waiting for a port or FIFO slot
+    uint64_t m_blocked_load_cycle;  // Cycle last counted in m_blocked_loads
+    uint64_t m_blocked_store_cycle; // Cycle last counted in m_blocked_stores
+    uint64_t m_port_stall_cycle;    // Cycle last counted in m_port_stalls
+    uint64_t m_rmws_sent;           // RMWs sent to the cache
+    uint64_t m_rmw_latency;         // Sum over RMWs, sent to response
+    uint64_t m_rmw_drain_cycles;    // Sum over RMWs, allocation to sent (older accesses draining)
+    uint64_t m_fence_stalls;        // Cycles requests were held back by a pending RMW
+    uint64_t m_fence_stall_cycle;   // Cycle last counted in m_fence_stalls
+
+    uint64_t m_sent_cycle;          // Cycle m_sent_this_cycle refers to
+    uint32_t m_sent_this_cycle;     // Cache ports used in m_sent_cycle
+
+    static bool usesStoreEntry(CpuFIFO::REQTYPE type) {
+        return type == CpuFIFO::REQTYPE::WRITE || type == CpuFIFO::REQTYPE::RMW;
+    }
+    static const char* typeName(CpuFIFO::REQTYPE type) {
+        return (type == CpuFIFO::REQTYPE::READ) ? "load" : (type == CpuFIFO::REQTYPE::RMW) ? "atomic" : "store";
+    }
+
+    void markLoadReady(LSQEntry& entry);
+    void removeWaitingLoad(const CpuFIFO::ReqMsg& request);
+    void sendToCache(LSQEntry& entry);
+    void dropSatisfiedLoads();
 
 public:
-    LSQ();
+    LSQ(uint32_t max_loads = DEFAULT_LOAD_ENTRIES, uint32_t max_stores = DEFAULT_STORE_ENTRIES,
+        uint32_t cache_ports = DEFAULT_CACHE_PORTS);
     ~LSQ();
-    
+
     // Core functionality (3.3)
     void step();                    // Called every cycle
-    bool canAccept();              // Check if LSQ can accept new entry
+    bool canAccept(CpuFIFO::REQTYPE type); // Check if the load/store queue can accept new entry
     bool allocate(const CpuFIFO::ReqMsg& request); // Allocate new memory operation
     void retire();                 // Remove completed operations
     bool ldFwd(uint64_t address); // Check store-to-load forwarding (3.3)
     void commit(uint64_t requestId); // Handle operation completion
-    
+
     // Memory system interface (3.3)
     void pushToCache();           // Send requests to cache
-    void rxFromCache();           // Handle cache responses
-    
+    void rxFromCache(const CpuFIFO::RespMsg& response); // Handle a cache response the core routed here
+
     // Configuration
+    void configure(uint32_t max_loads, uint32_t max_stores, uint32_t cache_ports); // Resizes an empty LSQ
     void setCycle(uint64_t cycle) { m_current_cycle = cycle; }
     void setROB(ROB* rob) { m_rob = rob; }
     void setCpuFIFO(CpuFIFO* fifo) { m_cpuFIFO = fifo; }
-    
+    void setDebug(bool debug) { m_debug = debug; }
+
     // Utility functions
-    bool isEmpty() const { return m_lsq_q.empty(); }
-    uint32_t size() const { return m_num_entries; }
-    
-    void removeLastEntry() {
-        if (!m_lsq_q.empty()) {
-            m_lsq_q.pop_back();
-            m_num_entries--;
-        }
-    }
-    
+    bool isEmpty() const { return m_entries.empty(); }
+    uint32_t size() const { return m_num_loads + m_num_stores; }
+
+    void removeLastEntry();
+
     void printState() const;
+    void printStats(std::ostream &out, int coreId, int thread = -1) const;
+    void registerStats(StatsRegistry &stats) const; // Under the core (and thread) scope
 };
 
 } // namespace ns3
 
-#endif // LSQ_H
\ No newline at end of file
+#endif // LSQ_H
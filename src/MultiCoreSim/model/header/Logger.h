@@ -56,6 +56,7 @@ namespace ns3
         std::map<uint64_t, uint64_t> max_effective_latency; //core_id is the key, and the value is the max latency contribution
         std::map<uint64_t, uint64_t> average_latency; //core_id is the key, and the value is the average latency
         std::map<uint64_t, uint64_t> num_request; //core_id is the key, number of requests
+        std::map<uint64_t, uint64_t> throttled_cycles; //core_id is the key, cycles its memory requests were held by bandwidth regulation
 
         std::map<uint64_t, std::ofstream> report_files; //core_id is the key, and the value is the report file handler
         std::ofstream summary_file;                     //To report the worst-case values of all the cores
@@ -68,6 +69,7 @@ namespace ns3
         static Logger *_logger;
 
         Logger();
+        ~Logger();
         void prepareReportFile(uint64_t core_id);
         void initializeStats(uint64_t core_id);
         void calculateLatencies(uint64_t msg_id);
@@ -84,6 +86,7 @@ namespace ns3
         void registerReportPath(std::string file_path);
         void traceEnd(uint64_t core_id);
         void setClkCount(uint64_t core_id, uint64_t clk);
+        void addThrottledCycles(uint64_t core_id, uint64_t cycles);
 
         static Logger *getLogger()
         {
@@ -91,6 +94,13 @@ namespace ns3
                 Logger::_logger = new Logger();
             return Logger::_logger;
         }
+
+        // Drops the logger of the previous simulation run, closing its reports
+        static void reset()
+        {
+            delete Logger::_logger;
+            Logger::_logger = NULL;
+        }
     };
 }
 
@@ -17,12 +17,21 @@
 #include "CacheController.h"
 #include "CacheControllerExclusive.h"
 #include "CacheController_End2End.h"
+#include "CacheControllerPENDULUM.h"
+#include "CacheControllerPENDULUM_LLC.h"
 #include "Logger.h"
 #include "ns3/Bus.h"
 #include "ns3/TripleBus.h"
 #include "ns3/DirectInterconnect.h"
 #include "CommunicationInterface.h"
 #include "MainMemoryController.h"
+#include "MemoryBackend.h"
+#include "MultiChannelMemory.h"
+#include "NUMAMemory.h"
+#include "MMU.h"
+#include "PageAllocator.h"
+#include "IdGenerator.h"
+#include "StatsRegistry.h"
 // #include "MCsimInterface.h"
 
 #include <string>
@@ -52,6 +61,15 @@ private:
 
     // bus clk count
     uint64_t m_busCycle;
+
+    // Set once every core has finished its trace; the simulator is stopped then
+    bool m_done;
+
+    // Where the end-of-run statistics go
+    std::ostream* m_report;
+
+    // The counters of all the components by name, filled in by Start
+    StatsRegistry m_stats;
     
     // coherence protocol type
     CohProtType m_cohrProt;
@@ -71,14 +89,23 @@ private:
     // A list of Cache Ctrl engines
     std::list<CacheController*> m_cpuCacheCtrl;
 
+    // Address translation of the cores, when virtual memory is enabled
+    PageAllocator* m_page_allocator;
+    std::list<MMU*> m_mmus;
+
     // A list of Cache Ctrl Bus interface buffers
     // std::list<ns3::BusIfFIFO*> m_busIfFIFO;
 
-    // A pointer to shared cache controller engine
-    CacheController* m_SharedCacheCtrl;
+    // The buses and shared cache controller engine of each socket
+    struct Socket {
+      Bus* bus;
+      Bus* bus2;
+      CacheController* SharedCacheCtrl;
+    };
+    std::vector<Socket> m_sockets;
 
-    MainMemoryController* m_main_memory;
-    // MCsimInterface* m_mcsim_interface;
+    // Memory of all the sockets; a NUMAMemory when there is more than one
+    MemoryBackend* m_main_memory;
     // // A pointer to shared cache Bus IF buffers
     // BusIfFIFO* m_sharedCacheBusIfFIFO;
 
@@ -93,8 +120,6 @@ private:
 
     // // A pointer to Bus Arbiter
     // ns3::Ptr<ns3::BusArbiter> m_busArbiter;
-    Bus* bus;
-    Bus* bus2;
 
     // A pointer to Latency Logger component
     // std::list<ns3::Ptr<ns3::LatencyLogger> > m_latencyLogger;
@@ -111,6 +136,8 @@ private:
      
      // enable debug flag 
      void EnableDebugFlag(bool Enable);
+
+     void RegisterStats ();
 public:
     // Constructor
     MCoreSimProject(MCoreSimProjectXml projectXmlCfg);
@@ -122,6 +149,16 @@ public:
     // Calls the next step on the simulation
     static void Step (MCoreSimProject* project);
 
+    bool IsDone () { return m_done; }
+    uint64_t GetBusCycle () { return m_busCycle; }
+
+    // The end-of-run statistics are printed to report instead of cout
+    void SetReportStream (std::ostream* report) { m_report = report; }
+
+    // Statistics of all the components, as of the current cycle
+    void PrintStats (std::ostream& out);
+    const StatsRegistry& GetStats () const { return m_stats; }
+
     void setup1(MCoreSimProjectXml projectXmlCfg);
     void setup2(MCoreSimProjectXml projectXmlCfg);
 
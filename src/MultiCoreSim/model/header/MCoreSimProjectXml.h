@@ -10,11 +10,15 @@
 #define _MCoreSimProjectXml_H
 
 #include <list>
+#include <map>
 #include <stdlib.h>
 #include <string.h>
 #include "tinyxml.h"
 #include "CacheXml.h"
 #include "L1BusCnfgXml.h"
+#include "DRAMCnfgXml.h"
+#include "VMCnfgXml.h"
+#include "NUMACnfgXml.h"
 
 using namespace std;
 
@@ -30,23 +34,43 @@ private:
     int  m_cach2Cache;
     string m_cohProtocol;
     int m_outOfOrderStages;
+    int m_robSize;
+    int m_robRetireWidth;
+    int m_loadQueueSize;
+    int m_storeQueueSize;
+    int m_lsqCachePorts;
+    int m_dispatchWidth;
 
     list<CacheXml> m_privateCaches;
+    map<int, CacheXml> m_instCaches; // core cacheId -> its L1I (instCache element), if any
     CacheXml m_sharedCache;
     L1BusCnfgXml m_L1BusCnfg;
     
     int m_dramSimEnable;
     int m_dramId;
     string m_dramModle;
+    string m_dramParamFile;
+    string m_memRecordFile;      // Records the latency of every LLC read miss to this file, empty = off
+    string m_memReplayMode;      // REPLAY backend: EXACT (recorded latency of the same miss) or DISTRIBUTION
     int m_dramLatcy;
     int m_dramOutstandReq;
     int m_dramctrlClkNanoSec;
     int m_dramctrlClkSkew; 
+    int m_memChannels;           // Memory channels, each with its own controller
+    string m_memInterleave;      // LINE, PAGE or XOR
+    int m_memChannelQueueSize;   // Requests a channel link holds
+    int m_memChannelLinkLatcy;   // Cycles a request spends on a channel link
+    DRAMCnfgXml m_dramCnfg;      // Organization and timing of the DRAM model
+    VMCnfgXml m_vmCnfg;          // Address translation, off unless VirtualMemory Enable="1"
+    NUMACnfgXml m_numaCnfg;      // Sockets and the links between them, one socket unless NUMA Sockets > 1
     
      
     // The name of the path used for Benchmark trace files
     string m_bmsPath;
 
+    // Where the run writes its cpu/ctrl traces and latency reports, the BMs path if empty
+    string m_outputPath;
+
     // trace file names
     string m_cpuTraceFile;
     string m_cohCtrlsTraceFile;
@@ -60,6 +84,10 @@ public:
         return m_privateCaches;
     }
 
+    map<int, CacheXml> GetInstCaches() {
+        return m_instCaches;
+    }
+
     void SetPrivateCaches(list<CacheXml> privateCaches) {
         m_privateCaches = privateCaches;
     }
@@ -80,6 +108,14 @@ public:
       return m_bmsPath;
     }
 
+    void SetOutputPath (string path) {
+      m_outputPath = path;
+    }
+
+    string GetOutputPath () {
+      return m_outputPath.empty() ? m_bmsPath : m_outputPath;
+    }
+
     void SetCohCtrlsTraceFile (string fileName) {
       m_cohCtrlsTraceFile = fileName;
     }
@@ -167,6 +203,18 @@ public:
     string GetDRAMModle () {
       return m_dramModle;
     }
+
+    string GetDRAMParamFile () {
+      return m_dramParamFile;
+    }
+
+    string GetMemRecordFile () {
+      return m_memRecordFile;
+    }
+
+    string GetMemReplayMode () {
+      return m_memReplayMode;
+    }
     
     int GetDRAMOutstandReq () {
       return m_dramOutstandReq;
@@ -183,6 +231,34 @@ public:
     int GetDRAMCtrlClkSkew () {
       return m_dramctrlClkSkew;
     }
+
+    int GetMemChannels () {
+      return m_memChannels;
+    }
+
+    string GetMemInterleave () {
+      return m_memInterleave;
+    }
+
+    int GetMemChannelQueueSize () {
+      return m_memChannelQueueSize;
+    }
+
+    int GetMemChannelLinkLatcy () {
+      return m_memChannelLinkLatcy;
+    }
+
+    DRAMCnfgXml GetDRAMCnfg () {
+      return m_dramCnfg;
+    }
+
+    VMCnfgXml GetVMCnfg () {
+      return m_vmCnfg;
+    }
+
+    NUMACnfgXml GetNUMACnfg () {
+      return m_numaCnfg;
+    }
     
     string GetCohrProtType () {
       return m_cohProtocol;
@@ -192,6 +268,30 @@ public:
       return m_outOfOrderStages;
     }  
 
+    int GetROBSize () {
+      return m_robSize;
+    }
+
+    int GetROBRetireWidth () {
+      return m_robRetireWidth;
+    }
+
+    int GetLoadQueueSize () {
+      return m_loadQueueSize;
+    }
+
+    int GetStoreQueueSize () {
+      return m_storeQueueSize;
+    }
+
+    int GetLSQCachePorts () {
+      return m_lsqCachePorts;
+    }
+
+    int GetDispatchWidth () {
+      return m_dispatchWidth;
+    }
+
     // load input configurations
     void LoadFromXml (TiXmlHandle root) {
        m_numberOfRuns       = 1;
@@ -203,15 +303,31 @@ public:
        m_busFIFOSize        = 6;
        m_cach2Cache         = true;
        m_privateCaches      = list<CacheXml> ();
+       m_instCaches         = map<int, CacheXml> ();
        m_sharedCache        = CacheXml ();
        m_L1BusCnfg          = L1BusCnfgXml ();
        m_dramSimEnable      = 0;
        m_dramOutstandReq    = 4;
        m_dramModle          = "FIXEDLat";
+       m_dramParamFile      = "";
+       m_memRecordFile      = "";
+       m_memReplayMode      = "EXACT";
        m_dramLatcy          = 100;
        m_dramId             = 200;
        m_dramctrlClkNanoSec = 100;
        m_dramctrlClkSkew    = 0;
+       m_memChannels        = 1;
+       m_memInterleave      = "LINE";
+       m_memChannelQueueSize = 16;
+       m_memChannelLinkLatcy = 0;
+       m_dramCnfg.LoadFromXml(TiXmlHandle((TiXmlNode*) NULL));
+       m_vmCnfg.LoadFromXml(TiXmlHandle((TiXmlNode*) NULL));
+       m_robSize            = 32;
+       m_robRetireWidth     = 4;
+       m_loadQueueSize      = 8;
+       m_storeQueueSize     = 8;
+       m_lsqCachePorts      = 1;
+       m_dispatchWidth      = 1;
        
        // read configuration parameters from xml file
        TiXmlElement* rootPtr = root.Element();
@@ -230,6 +346,12 @@ public:
           rootPtr->QueryStringAttribute("CohProtocol", &m_cohProtocol); 
           std::cout << "DEBUG COH Protocol Name in XML header: "<< m_cohProtocol << std::endl;
           rootPtr->QueryIntAttribute("OutOfOrderStages", &m_outOfOrderStages);
+          rootPtr->QueryIntAttribute("ROBSize", &m_robSize);
+          rootPtr->QueryIntAttribute("ROBRetireWidth", &m_robRetireWidth);
+          rootPtr->QueryIntAttribute("LoadQueueSize", &m_loadQueueSize);
+          rootPtr->QueryIntAttribute("StoreQueueSize", &m_storeQueueSize);
+          rootPtr->QueryIntAttribute("LSQCachePorts", &m_lsqCachePorts);
+          rootPtr->QueryIntAttribute("DispatchWidth", &m_dispatchWidth);
           
           // get interconnect configuration parameters
           TiXmlHandle interConnectRoot = root.FirstChildElement("InterConnect");
@@ -251,6 +373,15 @@ public:
                TiXmlHandle privateCacheHandle = TiXmlHandle(privateCachePtr);
                newPrivateCache.LoadFromXml(privateCacheHandle);
                m_privateCaches.push_back(newPrivateCache);
+
+               // A core fetches its instructions through an L1I only if it has one
+               TiXmlElement* instCachePtr = privateCachePtr->FirstChildElement("instCache");
+               if (instCachePtr) {
+                 CacheXml newInstCache;
+                 TiXmlHandle instCacheHandle = TiXmlHandle(instCachePtr);
+                 newInstCache.LoadFromXml(instCacheHandle);
+                 m_instCaches[newPrivateCache.GetCacheId()] = newInstCache;
+               }
              }
           }
 
@@ -269,15 +400,37 @@ public:
             DRAMCnfgRootPtr->QueryIntAttribute   ("DRAMId", &m_dramId                       );
             DRAMCnfgRootPtr->QueryIntAttribute   ("DRAMSIMEnable", &m_dramSimEnable         );
             DRAMCnfgRootPtr->QueryStringAttribute("MEMMODLE", &m_dramModle                  );
+            DRAMCnfgRootPtr->QueryStringAttribute("MEMParamFile", &m_dramParamFile          );
+            DRAMCnfgRootPtr->QueryStringAttribute("MEMRecordFile", &m_memRecordFile         );
+            DRAMCnfgRootPtr->QueryStringAttribute("MEMReplayMode", &m_memReplayMode         );
             DRAMCnfgRootPtr->QueryIntAttribute   ("MEMLATENCY", &m_dramLatcy                );
             DRAMCnfgRootPtr->QueryIntAttribute   ("MEMOutsandingReqs", &m_dramOutstandReq   );
             DRAMCnfgRootPtr->QueryIntAttribute   ("ctrlClkNanoSec" , &m_dramctrlClkNanoSec  );
             DRAMCnfgRootPtr->QueryIntAttribute   ("ctrlClkSkew"    , &m_dramctrlClkSkew     );
+            DRAMCnfgRootPtr->QueryIntAttribute   ("MEMChannels"    , &m_memChannels         );
+            DRAMCnfgRootPtr->QueryStringAttribute("MEMInterleave"  , &m_memInterleave       );
+            DRAMCnfgRootPtr->QueryIntAttribute   ("MEMChannelQueueSize"  , &m_memChannelQueueSize );
+            DRAMCnfgRootPtr->QueryIntAttribute   ("MEMChannelLinkLatency", &m_memChannelLinkLatcy );
           }
+          m_dramCnfg.LoadFromXml(DRAMCnfgRoot);
+
+          m_vmCnfg.LoadFromXml(root.FirstChildElement("VirtualMemory"));
+          m_numaCnfg.LoadFromXml(root.FirstChildElement("NUMA"));
                           
        }
     } // void LoadFromXml
 
+    // load input configurations from the text of a configuration file
+    bool LoadFromString (const string &xmlText) {
+       TiXmlDocument doc;
+       doc.Parse(xmlText.c_str());
+       if (doc.Error())
+         return false;
+       TiXmlHandle hDoc(&doc);
+       LoadFromXml(TiXmlHandle(hDoc.FirstChildElement().Element()));
+       return true;
+    }
+
 };
 
 #endif /* _MCoreSimProjectXml_H */
@@ -14,14 +14,24 @@
 #include "ns3/core-module.h"
 
 #include "CommunicationInterface.h"
+#include "MemoryBackend.h"
 #include "MCoreSimProjectXml.h"
-#include "FRFCFS_Buffer.h"
+
+#include <deque>
+#include <unordered_map>
 
 #include "ns3/MCsim.h"
 
 namespace ns3
 {
-    class MCsimInterface : public ns3::Object
+    /*
+     * Memory backend "MCsim", the external MCsim memory-controller simulator.
+     * The parameter file is the MCsim system .ini file.
+     *
+     * Reads sent to MCsim wait in a table keyed by address, so a completion
+     * callback finds its request in O(1).
+     */
+    class MCsimInterface : public ns3::Object, public MemoryBackend
     {
     protected:
         int m_id;
@@ -35,18 +45,15 @@ namespace ns3
         uint64_t m_read_count;
         uint64_t m_write_count;
 
-        vector<Message> m_pending_requests;
-        vector<Message> m_output_buffer;
+        std::unordered_map<uint64_t, std::deque<Message>> m_pending_requests; // addr -> reads in MCsim, oldest first
+        std::deque<Message> m_output_buffer;
         
         CommunicationInterface *m_lower_interface; // A pointer to the lower Interface FIFO
 
-        FRFCFS_Buffer<Message, MCsimInterface> *m_processing_queue;
-        
         MCsim::MultiChannelMemorySystem *m_mcsim;
 
         virtual void cycleProcess();
         virtual void processLogic();
-        virtual void addRequests2ProcessingQueue(FRFCFS_Buffer<Message, MCsimInterface> &buf);
 
         virtual void read_callback(unsigned, uint64_t, uint64_t);
         virtual void write_callback(unsigned, uint64_t, uint64_t);
@@ -54,13 +61,12 @@ namespace ns3
     public:
         static TypeId GetTypeId(void); // Override TypeId.
 
-        MCsimInterface(MCoreSimProjectXml &projectXml, CommunicationInterface *lower_interface, int llc_id);
+        MCsimInterface(MCoreSimProjectXml &projectXml, CommunicationInterface *lower_interface, int llc_id,
+                       std::string param_file);
         ~MCsimInterface();
 
         virtual void init();
         static void step(Ptr<MCsimInterface> memory_controller);
-
-        virtual FRFCFS_State getRequestState(const Message &, FRFCFS_State);
     };
 }
 
@@ -0,0 +1,133 @@
+#ifndef MMU_H
+#define MMU_H
+
+#include "MemTemplate.h"
+#include "PageAllocator.h"
+#include "StatsRegistry.h"
+#include "VMCnfgXml.h"
+#include <deque>
+#include <list>
+#include <map>
+#include <unordered_map>
+#include <unordered_set>
+#include <vector>
+#include <iostream>
+
+namespace ns3 {
+
+/**
+ * @brief Set-associative TLB with LRU replacement
+ *
+ * Holds virtual page numbers only; the translation itself comes from the
+ * page tables of the PageAllocator.
+ */
+class TLB {
+private:
+    struct Entry {
+        bool valid;
+        uint64_t vpn;
+        uint64_t last_use;
+    };
+
+    uint32_t m_sets;
+    uint32_t m_ways;
+    std::vector<Entry> m_entries;   // m_sets x m_ways
+    uint64_t m_tick;
+
+public:
+    uint64_t m_hits;
+    uint64_t m_misses;
+
+    TLB(uint32_t entries, uint32_t ways);
+
+    bool lookup(uint64_t vpn);      // Counts a hit or a miss
+    void insert(uint64_t vpn);
+};
+
+/**
+ * @brief Address translation between a core and its private cache
+ *
+ * The core's loads and stores go through the MMU on their way to the L1D:
+ * the core writes its CpuFIFO as before, the MMU translates each request and
+ * passes it on to the CpuFIFO of the cache, and returns the responses with the
+ * virtual address restored.
+ *
+ * A request looks up the L1 TLB, then the L2 TLB, and on a miss in both waits
+ * for a page walk. A walk reads one PTE per page-table level through the L1D,
+ * so it sees the cache hierarchy and memory like any load. Requests to a page
+ * that is being walked wait for that walk, and at most PageWalkers walks are
+ * in progress. Instruction fetch through the L1I is not translated.
+ *
+ * Translated requests leave for the cache in the order the core sent them,
+ * except that a request may pass older ones that are still translating when
+ * it is to another page and no atomic lies between them. An atomic leaves
+ * only once everything older has left, so a TLB hit never overtakes a fence.
+ */
+class MMU {
+private:
+    // Set in the msgIds of PTE reads. The core numbers its requests from 0, so
+    // a response is routed by this bit and a PTE read never shares an id with
+    // a load or store on the same L1D
+    static const uint64_t PTE_READ_ID = 1ULL << 63;
+
+    struct Walk {
+        uint64_t vpn;
+        int level;                              // Level of the PTE read next or in flight
+        bool pte_pending;                       // A PTE read is at the cache
+        uint64_t start_cycle;
+        std::vector<uint64_t> waiters;          // msgIds of the requests to the page
+    };
+
+    struct Pending {
+        CpuFIFO::ReqMsg request;    // Physical address once translated
+        uint64_t vpn;
+        bool translated;
+        uint64_t ready_cycle;
+    };
+
+    uint16_t m_coreId;
+    uint32_t m_asid;                // Address space the core's page tables belong to
+    CpuFIFO* m_coreFIFO;            // Written by the core's LSQ
+    CpuFIFO* m_cacheFIFO;           // Read by the L1D controller
+    PageAllocator* m_allocator;
+
+    TLB m_l1_tlb;
+    TLB m_l2_tlb;
+    uint32_t m_l1_latency;
+    uint32_t m_l2_latency;
+    uint32_t m_max_walks;
+
+    uint64_t m_cycle;
+    std::list<Pending> m_pending;                           // Requests not yet at the cache, in the core's order
+    std::unordered_map<uint64_t, std::list<Pending>::iterator> m_pending_of; // msgId -> its m_pending entry
+    std::unordered_map<uint64_t, uint64_t> m_vaddr_of;      // msgId -> virtual address, requests at the cache
+    std::unordered_map<uint64_t, Walk> m_walks;             // vpn -> walk in progress or waiting for a walker
+    std::deque<uint64_t> m_walk_queue;                      // Walks waiting for a walker, oldest first
+    std::vector<uint64_t> m_active_walks;                   // vpns of the walks in progress
+    std::unordered_map<uint64_t, uint64_t> m_walk_of;       // msgId of a PTE read -> vpn
+    uint64_t m_pte_read_ids;                                // PTE reads numbered so far
+
+    // Statistics
+    uint64_t m_walks_done;
+    uint64_t m_walk_cycles;         // Sum over walks, start to last PTE
+    uint64_t m_max_walk_cycles;
+    uint64_t m_pte_reads;
+
+    void translate(const CpuFIFO::ReqMsg& request);
+    void finishTranslation(uint64_t msgId, uint64_t ready_cycle);
+    void rxFromCache();
+    void startWalks();
+    void issuePTEReads();
+    void sendToCache();
+
+public:
+    MMU(uint16_t coreId, uint32_t asid, CpuFIFO* coreFIFO, CpuFIFO* cacheFIFO, PageAllocator* allocator, VMCnfgXml& cfg);
+
+    void step(uint64_t cycle);      // Called by the core every cycle
+    void printStats(std::ostream &out) const;
+    void registerStats(StatsRegistry &stats) const; // Under the core scope
+};
+
+} // namespace ns3
+
+#endif // MMU_H
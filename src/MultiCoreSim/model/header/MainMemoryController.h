@@ -14,12 +14,25 @@
 #include "ns3/core-module.h"
 
 #include "CommunicationInterface.h"
+#include "MemoryBackend.h"
 #include "MCoreSimProjectXml.h"
-#include "FRFCFS_Buffer.h"
+#include "TimingWheel.h"
+
+#include <unordered_map>
+#include <vector>
 
 namespace ns3
 {
-    class MainMemoryController : public ns3::Object
+    /*
+     * Fixed-latency main memory, memory backend "FIXEDLat": every read is
+     * answered MEMLATENCY controller cycles after it arrives. A write to an
+     * address with a write still in flight is merged into that write.
+     *
+     * Requests in flight are kept by sequence number and their completions
+     * on a timing wheel, so accepting and completing a request is O(1)
+     * however many are outstanding.
+     */
+    class MainMemoryController : public ns3::Object, public MemoryBackend
     {
     protected:
         int m_id;
@@ -33,25 +46,33 @@ namespace ns3
         
         uint64_t m_read_count;
         uint64_t m_write_count;
+        uint64_t m_coalesced_writes;
 
         CommunicationInterface *m_lower_interface; // A pointer to the lower Interface FIFO
 
-        FRFCFS_Buffer<Message, MainMemoryController> *m_processing_queue;
+        std::unordered_map<uint64_t, Message> m_in_flight; // sequence number -> request
+        TimingWheel m_completions;                        // sequence number -> completion cycle
+        std::vector<uint64_t> m_completed;                // Scratch for m_completions.advance()
+        std::unordered_map<uint64_t, uint64_t> m_pending_writes; // address -> sequence number of its write in flight
+        uint64_t m_next_seq;
 
         virtual void cycleProcess();
         virtual void processLogic();
-        virtual void addRequests2ProcessingQueue(FRFCFS_Buffer<Message, MainMemoryController> &buf);
+        virtual void acceptRequest();
+        virtual uint32_t requestLatency(const Message &) { return m_memory_latency; } // Cycles until a request completes
+        void sendReadResponse(const Message &request); // Returns the data of a read to the LLC
 
     public:
         static TypeId GetTypeId(void); // Override TypeId.
 
         MainMemoryController(MCoreSimProjectXml &projectXml, CommunicationInterface *lower_interface, int llc_id);
-        ~MainMemoryController();
+        virtual ~MainMemoryController();
 
         virtual void init();
         static void step(Ptr<MainMemoryController> memory_controller);
 
-        virtual FRFCFS_State getRequestState(const Message &, FRFCFS_State);
+        virtual void printStats(std::ostream &out);
+        virtual void registerStats(StatsRegistry &stats);
     };
 }
 
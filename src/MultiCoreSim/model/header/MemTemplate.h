@@ -65,7 +65,8 @@ namespace ns3
       READ = 0,      // Load operation
       WRITE = 1,     // Store operation
       REPLACE = 2,   // Cache line replacement
-      COMPUTE = 3    // Compute instruction
+      COMPUTE = 3,   // Compute instruction
+      RMW = 4        // Atomic read-modify-write (LOCK-prefixed instruction)
     };
 
     /**
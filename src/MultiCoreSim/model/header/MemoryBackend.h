@@ -0,0 +1,60 @@
+#ifndef _MemoryBackend_H
+#define _MemoryBackend_H
+
+#include "CommunicationInterface.h"
+#include "MCoreSimProjectXml.h"
+#include "StatsRegistry.h"
+
+#include <iostream>
+#include <map>
+#include <string>
+#include <vector>
+
+namespace ns3
+{
+    /*
+     * A main-memory model behind the LLC. It talks to the LLC only through
+     * the CommunicationInterface it is created with: it pops requests from it
+     * and pushes read data back as DATA_RESPONSE messages to the LLC.
+     */
+    class MemoryBackend
+    {
+    public:
+        virtual ~MemoryBackend() {}
+
+        virtual void init() = 0;                      // Schedules the first cycle
+        virtual void printStats(std::ostream &) {}
+        virtual void registerStats(StatsRegistry &) {} // The counters printStats prints, by name
+    };
+
+    /*
+     * Memory backends by name. The backend of a run is the DRAMCnfg MEMMODLE
+     * attribute; MEMParamFile is handed to it as its own parameter file
+     * (empty if not given). A backend registers itself from its translation
+     * unit with REGISTER_MEMORY_BACKEND, so a backend that is not built is
+     * simply not available. With MEMRecordFile set, Create returns the
+     * backend behind a MemoryLatencyRecorder. The instance is the index of
+     * the memory controller in the run (socket-major, then channel), used by
+     * backends that keep one file per controller.
+     */
+    class MemoryBackendRegistry
+    {
+    public:
+        typedef MemoryBackend *(*Factory)(MCoreSimProjectXml &projectXml, CommunicationInterface *lower_interface,
+                                          int llc_id, int instance, const std::string &param_file);
+
+        static bool Register(const std::string &name, Factory factory);
+        static MemoryBackend *Create(const std::string &name, MCoreSimProjectXml &projectXml,
+                                     CommunicationInterface *lower_interface, int llc_id, int instance,
+                                     const std::string &param_file);
+        static std::vector<std::string> Names();
+
+    private:
+        static std::map<std::string, Factory> &Factories();
+    };
+}
+
+#define REGISTER_MEMORY_BACKEND(name, factory) \
+    static bool _memory_backend_registered_##factory = ns3::MemoryBackendRegistry::Register(name, factory)
+
+#endif /* _MemoryBackend_H */
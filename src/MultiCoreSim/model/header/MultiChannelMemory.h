@@ -0,0 +1,115 @@
+#ifndef _MultiChannelMemory_H
+#define _MultiChannelMemory_H
+
+#include "ns3/ptr.h"
+#include "ns3/object.h"
+#include "ns3/core-module.h"
+
+#include "CommunicationInterface.h"
+#include "MemoryBackend.h"
+#include "MCoreSimProjectXml.h"
+
+#include <deque>
+#include <vector>
+
+namespace ns3
+{
+    /*
+     * Point-to-point link between the channel interleaver and the memory
+     * controller of one channel. The controller sees it as its lower
+     * interface; a request becomes visible to it link-latency cycles after
+     * the interleaver sent it.
+     */
+    class MemoryChannelLink : public CommunicationInterface
+    {
+    protected:
+        struct Entry
+        {
+            Message msg;
+            uint64_t cycle; // Cycle the interleaver sent the request
+        };
+
+        std::deque<Entry> m_requests;
+        std::deque<Message> m_responses;
+        int m_max_size;
+        uint64_t m_latency;
+        uint64_t m_cycle;
+
+    public:
+        uint64_t m_accepted;    // Requests the controller took
+        uint64_t m_queue_delay; // Sum over them of the cycles spent on the link
+
+        MemoryChannelLink(int id, int max_size, uint64_t latency);
+
+        // Memory-controller side
+        virtual bool peekMessage(Message *out_msg) override;
+        virtual void popFrontMessage() override;
+        virtual bool pushMessage(Message &msg, uint64_t cycle, MessageType type = MessageType::REQUEST) override;
+
+        // Interleaver side
+        bool sendRequest(const Message &msg);
+        bool peekResponse(Message *out_msg);
+        void popResponse();
+
+        void setCycle(uint64_t cycle) { m_cycle = cycle; }
+        bool hasRequests() const { return !m_requests.empty(); }
+    };
+
+    /*
+     * N memory channels behind the LLC, each with its own link, queues and
+     * memory controller (any registered backend, MEMMODLE). LLC misses are
+     * distributed by the interleaving function: LINE (consecutive cache
+     * lines), PAGE (consecutive DRAM rows) or XOR (the channel bits of the
+     * line address hashed with the bits above them). A channel controller
+     * sees addresses with the channel bits removed, so its own address
+     * mapping stays dense.
+     */
+    class MultiChannelMemory : public ns3::Object, public MemoryBackend
+    {
+    protected:
+        struct Channel
+        {
+            MemoryChannelLink *link;
+            MemoryBackend *backend;
+            uint64_t outstanding_reads;
+            uint64_t reads;
+            uint64_t writes;
+            uint64_t busy_cycles;    // Cycles with requests on the link or reads outstanding
+            uint64_t blocked_cycles; // Cycles the next LLC request waited for this channel's link
+        };
+
+        int m_id;
+        double m_dt;
+        double m_clk_skew;
+        uint64_t m_clk_cycle;
+
+        bool m_xor_hash;
+        int m_granularity_bits; // log2 of the interleaving granularity in bytes
+        int m_channel_bits;     // log2 of the number of channels
+
+        CommunicationInterface *m_lower_interface; // Interface to the LLC-DRAM bus
+        std::vector<Channel> m_channels;
+
+        uint64_t foldHighBits(uint64_t high);
+        int channelOf(uint64_t addr);
+        uint64_t localAddr(uint64_t addr);
+        uint64_t globalAddr(uint64_t local, int channel);
+
+        virtual void cycleProcess();
+
+    public:
+        static TypeId GetTypeId(void); // Override TypeId.
+
+        MultiChannelMemory(MCoreSimProjectXml &projectXml, CommunicationInterface *lower_interface, int llc_id,
+                           int first_instance = 0); // Channel i is memory controller first_instance + i
+        ~MultiChannelMemory();
+
+        virtual void init();
+        static void step(Ptr<MultiChannelMemory> memory);
+
+        virtual void printStats(std::ostream &out);
+        virtual void registerStats(StatsRegistry &stats);
+    };
+}
+
+#endif /* _MultiChannelMemory_H */
@@ -0,0 +1,60 @@
+#ifndef _NUMACnfgXml_H
+#define _NUMACnfgXml_H
+#include "tinyxml.h"
+#include <string>
+
+using namespace std;
+
+/*
+ * Multi-socket parameters, read from the NUMA element. With Sockets > 1
+ * every socket gets its own bus, LLC and memory controller, and the
+ * sockets reach each other's memory over point-to-point links. A page
+ * lives in the memory of one socket, picked by the Placement policy.
+ * Latencies are in memory controller cycles.
+ */
+class NUMACnfgXml {
+private:
+  int    m_sockets;
+  string m_placement;          // FIRST_TOUCH (socket of the first miss to the page) or INTERLEAVE (page mod sockets)
+  int    m_pageSize;           // Placement granularity in bytes
+  int    m_linkLatency;        // Cycles from the end of a transfer on a link to its arrival
+  int    m_linkBytesPerCycle;  // Link bandwidth, per direction
+  int    m_linkQueueSize;      // Messages a link direction holds, in flight or waiting
+  int    m_linkHeaderBytes;    // Bytes of a message without data (read request)
+
+public:
+
+  int GetSockets ()            { return m_sockets;           }
+  string GetPlacement ()       { return m_placement;         }
+  int GetPageSize ()           { return m_pageSize;          }
+  int GetLinkLatency ()        { return m_linkLatency;       }
+  int GetLinkBytesPerCycle ()  { return m_linkBytesPerCycle; }
+  int GetLinkQueueSize ()      { return m_linkQueueSize;     }
+  int GetLinkHeaderBytes ()    { return m_linkHeaderBytes;   }
+
+  void LoadFromXml(TiXmlHandle root) {
+
+     // default values
+     m_sockets           = 1;
+     m_placement         = "FIRST_TOUCH";
+     m_pageSize          = 4096;
+     m_linkLatency       = 40;
+     m_linkBytesPerCycle = 16;
+     m_linkQueueSize     = 32;
+     m_linkHeaderBytes   = 16;
+
+     TiXmlElement* NUMARootPtr = root.Element();
+     if (NUMARootPtr == NULL)
+       return;
+
+     NUMARootPtr->QueryIntAttribute    ("Sockets"           , &m_sockets           );
+     NUMARootPtr->QueryStringAttribute ("Placement"         , &m_placement         );
+     NUMARootPtr->QueryIntAttribute    ("PageSize"          , &m_pageSize          );
+     NUMARootPtr->QueryIntAttribute    ("LinkLatency"       , &m_linkLatency       );
+     NUMARootPtr->QueryIntAttribute    ("LinkBytesPerCycle" , &m_linkBytesPerCycle );
+     NUMARootPtr->QueryIntAttribute    ("LinkQueueSize"     , &m_linkQueueSize     );
+     NUMARootPtr->QueryIntAttribute    ("LinkHeaderBytes"   , &m_linkHeaderBytes   );
+  }
+};
+
+#endif /* _NUMACnfgXml_H */
@@ -0,0 +1,132 @@
+#ifndef _NUMAMemory_H
+#define _NUMAMemory_H
+
+#include "ns3/ptr.h"
+#include "ns3/object.h"
+#include "ns3/core-module.h"
+
+#include "CommunicationInterface.h"
+#include "MemoryBackend.h"
+#include "MultiChannelMemory.h"
+#include "MCoreSimProjectXml.h"
+
+#include <deque>
+#include <map>
+#include <unordered_map>
+#include <vector>
+
+namespace ns3
+{
+    /*
+     * Memory side of a multi-socket system. Every socket has its own memory
+     * controller (any registered backend, or MultiChannelMemory when
+     * MEMChannels > 1) behind its LLC, and every ordered pair of sockets is
+     * connected by a link of fixed latency and bandwidth. The LLC misses of
+     * a socket go to the memory of the page's home socket: directly when it
+     * is the socket itself, otherwise as a request over the link to the home
+     * socket, with the read data (or the write-back data) crossing the link
+     * as well.
+     *
+     * Sockets only interact through the links, so a message sent at cycle c
+     * cannot affect another socket before c + LinkLatency; that is the
+     * lookahead for simulating the sockets in parallel.
+     *
+     * The LLCs of different sockets are not kept coherent, and no directory
+     * or snoop traffic crosses the links. Lines that one socket writes back
+     * after another socket read them are counted as cross-socket sharing, and
+     * the first one is reported, since results for such workloads are not
+     * meaningful. (A clean eviction is silent, so a line can be counted after
+     * the reader's copy has already gone.)
+     */
+    class NUMAMemory : public ns3::Object, public MemoryBackend
+    {
+    protected:
+        enum Placement
+        {
+            FIRST_TOUCH = 0,
+            INTERLEAVE
+        };
+
+        struct Transfer
+        {
+            Message msg;
+            bool response;
+            uint64_t arrive_cycle; // Cycle the message is at the far end of the link
+        };
+
+        // One direction of the link between two sockets
+        struct Link
+        {
+            std::deque<Transfer> queue; // In flight, in order of arrival
+            uint64_t busy_until;        // First cycle the link is free to start the next transfer
+            uint64_t messages;
+            uint64_t bytes;
+            uint64_t busy_cycles;
+            uint64_t blocked_cycles;    // Cycles a message waited for room on the link
+        };
+
+        struct Socket
+        {
+            CommunicationInterface *llc_interface; // Interface to the socket's LLC-DRAM bus
+            MemoryChannelLink *mem_link;           // To the socket's own memory controller
+            MemoryBackend *memory;
+
+            uint64_t local_reads;
+            uint64_t remote_reads;
+            uint64_t local_read_latency;  // Sum over reads, miss to data back at the LLC
+            uint64_t remote_read_latency;
+            uint64_t local_writes;
+            uint64_t remote_writes;
+            uint64_t home_pages;          // Pages placed in the socket's memory
+            uint64_t shared_writes;       // Write-backs of lines other sockets had read
+        };
+
+        struct PendingRead
+        {
+            int socket;           // Socket whose LLC missed
+            uint64_t start_cycle;
+            bool remote;
+        };
+
+        double m_dt;
+        double m_clk_skew;
+        uint64_t m_clk_cycle;
+
+        Placement m_placement;
+        int m_page_bits;
+        int m_line_size;
+        int m_header_bytes;
+        int m_link_bytes_per_cycle;
+        int m_link_queue_size;
+        uint64_t m_link_latency;
+
+        std::vector<Socket> m_sockets;
+        std::vector<Link> m_links; // m_links[from * sockets + to]
+        std::unordered_map<uint64_t, int> m_page_home; // FIRST_TOUCH: page -> socket
+        std::unordered_map<uint64_t, uint64_t> m_line_readers; // line -> sockets that read it since it was last written back
+        bool m_sharing_reported;
+        std::multimap<std::pair<uint64_t, uint64_t>, PendingRead> m_pending; // (msg_id, addr)
+
+        int homeOf(uint64_t addr, int socket);
+        Link &link(int from, int to) { return m_links[from * m_sockets.size() + to]; }
+        bool sendOnLink(int from, int to, const Message &msg, bool response);
+        bool completeRead(int socket, Message &msg);
+        void trackSharing(int socket, const Message &msg);
+
+        virtual void cycleProcess();
+
+    public:
+        static TypeId GetTypeId(void); // Override TypeId.
+
+        NUMAMemory(MCoreSimProjectXml &projectXml, std::vector<CommunicationInterface *> llc_interfaces, int llc_id);
+        ~NUMAMemory();
+
+        virtual void init();
+        static void step(Ptr<NUMAMemory> memory);
+
+        virtual void printStats(std::ostream &out);
+        virtual void registerStats(StatsRegistry &stats);
+    };
+}
+
+#endif /* _NUMAMemory_H */
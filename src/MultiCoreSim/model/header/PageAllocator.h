@@ -0,0 +1,81 @@
+#ifndef PAGE_ALLOCATOR_H
+#define PAGE_ALLOCATOR_H
+
+#include "VMCnfgXml.h"
+#include "StatsRegistry.h"
+#include <stdint.h>
+#include <random>
+#include <unordered_map>
+#include <unordered_set>
+#include <vector>
+#include <iostream>
+
+namespace ns3 {
+
+/**
+ * @brief Physical page allocator and page tables of all the address spaces
+ *
+ * Page tables are kept per address space (asid); cores running the same
+ * process share one. A virtual page gets a physical frame the first time a
+ * core translates it; the policy picks the frame:
+ * - SEQUENTIAL: frames in order of first touch
+ * - RANDOM: uniformly random free frames
+ * - HUGE: 2MB pages in order of first touch
+ * - COLOR: frames of colour (core mod PageColors) of the core that touched
+ *   the page first, frame colour = frame mod PageColors
+ *
+ * Page tables are radix trees of 512-entry tables, four levels for 4KB pages
+ * and three for 2MB pages. Table pages are allocated like data pages, so the
+ * PTE addresses a walk reads are real physical addresses.
+ */
+class PageAllocator {
+public:
+    enum class Policy {
+        Sequential,
+        Random,
+        Huge,
+        Color
+    };
+
+private:
+    static const int TABLE_BITS = 12;       // 4KB page-table pages
+    static const int INDEX_BITS = 9;        // 512 PTEs of 8 bytes per table
+
+    Policy m_policy;
+    int m_page_bits;                // log2 of the page size
+    int m_levels;                   // Page-table levels a walk reads
+    uint64_t m_frames;              // Physical frames of m_page_bits
+    uint32_t m_colors;
+
+    uint64_t m_next_frame;                  // SEQUENTIAL, HUGE
+    std::vector<uint64_t> m_next_in_color;  // COLOR: next frame index of each colour
+    std::mt19937_64 m_rng;                  // RANDOM
+    std::unordered_set<uint64_t> m_used;    // RANDOM: frames handed out
+
+    uint64_t m_table_chunk;         // Frame table pages are carved from
+    uint32_t m_table_chunk_left;    // Table pages left in m_table_chunk
+
+    std::unordered_map<uint64_t, uint64_t> m_pages;  // (asid, vpn) -> frame
+    std::unordered_map<uint64_t, uint64_t> m_tables; // (asid, level, vpn prefix) -> table physical address
+
+    uint64_t m_table_pages;         // Page-table pages allocated
+
+    uint64_t allocFrame(uint32_t core);
+    uint64_t allocTable(uint32_t core);
+
+public:
+    PageAllocator(VMCnfgXml& cfg);
+
+    int pageBits() const { return m_page_bits; }
+    int levels() const { return m_levels; }
+
+    uint64_t translate(uint32_t asid, uint64_t vpn, uint32_t core);            // Frame of a virtual page
+    uint64_t pteAddr(uint32_t asid, int level, uint64_t vpn, uint32_t core);  // PTE the walk reads at level (0 = root)
+
+    void printStats(std::ostream &out) const;
+    void registerStats(StatsRegistry &stats) const;
+};
+
+} // namespace ns3
+
+#endif // PAGE_ALLOCATOR_H
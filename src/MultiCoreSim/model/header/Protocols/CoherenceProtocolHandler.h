@@ -15,6 +15,7 @@
 #include "ns3/IdGenerator.h"
 #include "ns3/CacheDataHandler.h"
 #include "ns3/SNOOPProtocolCommon.h"
+#include "ns3/StatsRegistry.h"
 
 #include <string.h>
 
@@ -43,6 +44,8 @@ namespace ns3
         inline FSMReader * fsm() { return m_fsm; }
 
         virtual void updateCycle(uint64_t cycle);
+        virtual void printStats(std::ostream &out) {}
+        virtual void registerStats(StatsRegistry &) {}
     };
 }
 
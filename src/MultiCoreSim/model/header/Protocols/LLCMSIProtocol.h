@@ -12,6 +12,9 @@
 #include "CoherenceProtocolHandler.h"
 #include "MSIProtocol.h"
 
+#include <map>
+#include <set>
+
 namespace ns3
 {
     class LLCMSIProtocol : public CoherenceProtocolHandler
@@ -44,9 +47,25 @@ namespace ns3
 
         std::vector<ControllerAction> controller_actions; //used only for returning data
 
+        // Optional "Upgrade" event of the CSV (see MSIProtocol), -1 if the FSM
+        // does not define it and Upgrades are served as GetM.
+        int m_upgrade_event_id;
+
+        // Cores holding a copy of each line, as seen in bus order. An Upgrade
+        // from a core that is no longer a holder lost its S copy to a GetM,
+        // Upgrade or invalidation ordered before it, so it is served as a GetM.
+        std::map<uint64_t, std::set<uint16_t>> m_holders;
+
+        uint64_t m_upgrade_count;
+        uint64_t m_upgrade_without_data_count;
+        uint64_t m_upgrade_as_getm_count;
+
+        bool isHolder(const Message &msg);
+        void updateHolders(const Message &msg, EventId event_id);
+
         virtual void readEvent(Message &msg, GenericCacheLine &cache_line, EventId *out_id);
 
-        virtual std::vector<ControllerAction> &handleAction(std::vector<int> &actions, Message &msg,
+        virtual std::vector<ControllerAction> &handleAction(const FSMReader::ActionList &actions, Message &msg,
                                                             GenericCacheLine &cache_line, int next_state);
 
     public:
@@ -56,6 +75,8 @@ namespace ns3
         virtual const std::vector<ControllerAction> &processRequest(Message &request_msg) override;
         virtual FRFCFS_State getRequestState(const Message &, FRFCFS_State) override;
         virtual void createDefaultCacheLine(uint64_t address, GenericCacheLine *cache_line) override;
+        virtual void printStats(std::ostream &out) override;
+        virtual void registerStats(StatsRegistry &stats) override;
     };
 }
 
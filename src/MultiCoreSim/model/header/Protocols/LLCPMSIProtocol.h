@@ -31,7 +31,7 @@ namespace ns3
             WaitData
         };
 
-        virtual std::vector<ControllerAction> &handleAction(std::vector<int> &actions, Message &msg,
+        virtual std::vector<ControllerAction> &handleAction(const FSMReader::ActionList &actions, Message &msg,
                                                             GenericCacheLine &cache_line_info, int next_state) override;
 
     public:
@@ -10,6 +10,7 @@
 #define _LLCPendulum_H
 
 #include "LLCMSIProtocol.h"
+#include "Pendulum.h"
 
 namespace ns3
 {
@@ -25,7 +26,8 @@ namespace ns3
             SelfInv,
             Inv_GetM,
             Sharers_0,
-            Data_fromLowerInteface
+            Data_fromLowerInterface,
+            Data_fromUpperInterface,
         };
 
         enum class ActionId
@@ -38,17 +40,19 @@ namespace ns3
             SaveReq,
             SetOwner,
             ClearOwner,
-            Fault
+            Fault,
+            GetData,
         };
 
-        virtual void readEvent(Message &msg, GenericCache::CacheLineInfo cache_line_info, LLCMSIProtocol::EventId *out_id) override;
-        virtual std::vector<ControllerAction> &handleAction(std::vector<int> &actions, Message &msg,
-                                                            const GenericCache::CacheLineInfo &cache_line_info, int next_state) override;
+        virtual void readEvent(Message &msg, GenericCacheLine &cache_line, LLCMSIProtocol::EventId *out_id) override;
+        virtual std::vector<ControllerAction> &handleAction(const FSMReader::ActionList &actions, Message &msg,
+                                                            GenericCacheLine &cache_line, int next_state) override;
 
     public:
-        LLCPendulum(GenericCache *cache, const std::string &fsm_path, int coreId);
+        LLCPendulum(CacheDataHandler *cache, const std::string &fsm_path, int coreId, int sharedMemId);
         ~LLCPendulum();
 
+        virtual const std::vector<ControllerAction> &processRequest(Message &request_msg) override;
     };
 }
 
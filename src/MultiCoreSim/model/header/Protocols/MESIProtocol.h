@@ -51,7 +51,7 @@ namespace ns3
         virtual std::vector<int> statesRequireWriteBack() override;
         virtual void readEvent(Message &msg, MSIProtocol::EventId *out_id) override;
         
-        virtual std::vector<ControllerAction> &handleAction(std::vector<int> &actions, Message &msg,
+        virtual std::vector<ControllerAction> &handleAction(const FSMReader::ActionList &actions, Message &msg,
                                                             GenericCacheLine &cache_line_info, int next_state) override;
 
     public:
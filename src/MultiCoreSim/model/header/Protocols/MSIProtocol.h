@@ -11,6 +11,8 @@
 
 #include "CoherenceProtocolHandler.h"
 
+#include <set>
+
 namespace ns3
 {
     class MSIProtocol : public CoherenceProtocolHandler
@@ -19,6 +21,7 @@ namespace ns3
         static const uint64_t REQUEST_TYPE_GETS = 0;
         static const uint64_t REQUEST_TYPE_GETM = 1;
         static const uint64_t REQUEST_TYPE_PUTM = 2;
+        static const uint64_t REQUEST_TYPE_UPG  = 3;
         static const uint64_t REQUEST_TYPE_INV  = 10;
 
     protected:
@@ -55,11 +58,36 @@ namespace ns3
 
         std::vector<ControllerAction> controller_actions; //used only for returning data
 
+        // Upgrade (S -> M without a data response). The CSV opts in by defining the
+        // "Upg" action and the "Own_Upg"/"Other_Upg" events (use ids that are free in
+        // the derived protocols' enums too). Without them an Upgrade seen on the bus
+        // is treated as a GetM, so older CSVs keep working.
+        int m_upgrade_action_id;
+        int m_own_upgrade_event_id;
+        int m_other_upgrade_event_id;
+
+        uint64_t m_getm_count;
+        uint64_t m_upgrade_count;
+        uint64_t m_lost_upgrade_count;
+
+        // Lines with an Upgrade on the bus, and those of them whose S copy was
+        // invalidated by a GetM, Upgrade or Inv ordered before the Upgrade. The
+        // LLC serves a lost Upgrade as a GetM, so it is treated as one here too.
+        std::set<uint64_t> m_pending_upgrades;
+        std::set<uint64_t> m_lost_upgrades;
+
+        // The states of statesRequireWriteBack() as flags indexed by state,
+        // built on first use (the derived protocols' states are not known yet
+        // in this constructor)
+        std::vector<bool> m_owner_states;
+        bool isOwnerState(int state);
+
         virtual std::vector<int> statesRequireWriteBack();
 
         virtual void readEvent(Message &msg, EventId *out_id);
+        void resolveUpgradeRace(const Message &msg, const GenericCacheLine &cache_line, EventId *event_id);
 
-        virtual std::vector<ControllerAction> &handleAction(std::vector<int> &actions, Message &msg,
+        virtual std::vector<ControllerAction> &handleAction(const FSMReader::ActionList &actions, Message &msg,
                                                             GenericCacheLine &cache_line, int next_state);
 
     public:
@@ -68,6 +96,8 @@ namespace ns3
 
         virtual const std::vector<ControllerAction> &processRequest(Message &request_msg) override;
         virtual FRFCFS_State getRequestState(const Message &, FRFCFS_State) override;
+        virtual void printStats(std::ostream &out) override;
+        virtual void registerStats(StatsRegistry &stats) override;
     };
 }
 
@@ -29,7 +29,7 @@ namespace ns3
             PutM_nonDem,
         };
 
-        virtual std::vector<ControllerAction> &handleAction(std::vector<int> &actions, Message &msg,
+        virtual std::vector<ControllerAction> &handleAction(const FSMReader::ActionList &actions, Message &msg,
                                                             GenericCacheLine &cache_line_info, int next_state) override;
 
     public:
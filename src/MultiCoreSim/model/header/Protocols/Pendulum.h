@@ -15,6 +15,10 @@ namespace ns3
 {
     class Pendulum: public MSIProtocol
     {
+    public:
+        static const uint64_t REQUEST_TYPE_INV_GETM = 4;
+        static const uint64_t REQUEST_TYPE_SELF_INV = 5;
+
     protected:
         enum class EventId
         {
@@ -25,18 +29,21 @@ namespace ns3
             Own_GetS,
             Own_GetM,
             Own_PutM,
-            
+
             Other_GetS,
             Other_GetM,
-            
+
             Timeout,
-            
+
             Own_InvGetM,
             Own_SelfInv,
-            
+
             Other_InvGetM,
-            
+
             Data,
+
+            Other_PutM,
+            Other_SelfInv,
         };
 
         enum class ActionId
@@ -57,13 +64,15 @@ namespace ns3
         };
 
         virtual void readEvent(Message &msg, MSIProtocol::EventId *out_id) override;
-        virtual std::vector<ControllerAction> &handleAction(std::vector<int> &actions, Message &msg,
-                                                            const GenericCache::CacheLineInfo &cache_line_info, int next_state) override;
+        virtual std::vector<ControllerAction> &handleAction(const FSMReader::ActionList &actions, Message &msg,
+                                                            GenericCacheLine &cache_line, int next_state) override;
 
     public:
-        Pendulum(GenericCache *cache, const std::string &fsm_path, int coreId, int sharedMemId);
+        Pendulum(CacheDataHandler *cache, const std::string &fsm_path, int coreId, int sharedMemId);
         ~Pendulum();
 
+        virtual const std::vector<ControllerAction> &processRequest(Message &request_msg) override;
+        virtual FRFCFS_State getRequestState(const Message &, FRFCFS_State) override;
     };
 }
 
@@ -15,7 +15,7 @@
 #include "LLCMSIProtocol.h"
 #include "LLCPMSIProtocol.h"
 #include "LLCPMESIProtocol.h"
-// #include "LLCPendulum.h"
+#include "LLCPendulum.h"
 
 #include "MSIProtocol.h"
 #include "MESIProtocol.h"
@@ -24,7 +24,7 @@
 #include "PMESIProtocol.h"
 #include "PMSIAsteriskProtocol.h"
 #include "PMESIAsteriskProtocol.h"
-// #include "Pendulum.h"
+#include "Pendulum.h"
 
 namespace ns3
 {
@@ -72,11 +72,11 @@ namespace ns3
             case CohProtType::SNOOP_PMESI_ASTERISK:
                 return new PMESIAsteriskProtocol(cache, fsm_path, core_id, shared_mem_id);
                 
-            // case CohProtType::SNOOP_PENDULUM:
-            //     return new Pendulum(cache, fsm_path, core_id, shared_mem_id);
+            case CohProtType::SNOOP_PENDULUM:
+                return new Pendulum(cache, fsm_path, core_id, shared_mem_id);
                 
-            // case CohProtType::SNOOP_LLC_PENDULUM:
-            //     return new LLCPendulum(cache, fsm_path, core_id);
+            case CohProtType::SNOOP_LLC_PENDULUM:
+                return new LLCPendulum(cache, fsm_path, core_id, shared_mem_id);
             
             default:
                 return NULL;
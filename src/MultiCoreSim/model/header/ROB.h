@@ -3,6 +3,7 @@
 
 #include "MemTemplate.h"
 #include <vector>
+#include <unordered_map>
 #include <iostream>
 #include <iomanip>
 
@@ -15,49 +16,77 @@ class CpuCoreGenerator; // Forward declaration for CPU
  * @brief Reorder Buffer (ROB) implementation for Out-of-Order execution
  * 
  * Requirements from 3.2:
- * - Fixed size (32 entries)
+ * - Fixed size (32 entries by default, configurable per core)
  * - In-order retirement
  * - Multiple instruction retirement per cycle (IPC)
  * - Maintains program order
+ *
+ * Entries live in a power-of-two ring indexed by head/tail sequence numbers,
+ * and a msgId -> sequence map makes commit O(1), so allocation, commit and
+ * retirement cost the same for a 32 or a 512 entry window. Consecutive compute
+ * instructions are merged into one entry that still occupies (and retires)
+ * one ROB slot per instruction.
  */
 class ROB {
 private:
-    static const uint32_t MAX_ENTRIES = 32;  // Maximum ROB entries (3.2)
-    static const uint32_t IPC = 4;           // Instructions retired per cycle (3.2)
+    static const uint32_t DEFAULT_ENTRIES = 32;  // Default ROB entries (3.2)
+    static const uint32_t DEFAULT_IPC = 4;       // Default instructions retired per cycle (3.2)
     
     struct ROBEntry {
         CpuFIFO::ReqMsg request;    // Instruction details
+        uint64_t key;               // msgId the entry was allocated (and indexed in m_seq_of) under
         bool ready;                 // True when instruction committed (3.3)
         uint64_t allocate_cycle;    // Cycle when instruction was allocated
+        uint32_t count;             // Instructions in the entry (a run of compute instructions shares one)
     };
     
-    uint32_t m_num_entries;         // Current number of entries
-    std::vector<ROBEntry> m_rob_q;  // Queue storing ROB entries
+    uint32_t m_max_entries;         // ROB capacity
+    uint32_t m_retire_width;        // Instructions retired per cycle
+    uint32_t m_num_entries;         // Current number of instructions held
+    std::vector<ROBEntry> m_rob_q;  // Ring storing ROB entries (size is a power of two)
+    uint64_t m_mask;                // m_rob_q.size() - 1
+    uint64_t m_head;                // Sequence number of the oldest entry
+    uint64_t m_tail;                // Sequence number the next entry gets
+    std::unordered_map<uint64_t, uint64_t> m_seq_of; // msgId -> sequence number of its entry
     LSQ* m_lsq;                     // Pointer to LSQ for store commits
     CpuCoreGenerator* m_cpu;        // Pointer to CPU core
+    uint32_t m_thread;              // Hardware thread of m_cpu this ROB partition belongs to
     uint64_t m_current_cycle;       // Current CPU cycle
+    bool m_debug;                   // Log every allocation and retirement and dump the ROB each cycle
+
+    ROBEntry& entryAt(uint64_t seq) { return m_rob_q[seq & m_mask]; }
+    const ROBEntry& entryAt(uint64_t seq) const { return m_rob_q[seq & m_mask]; }
 
 public:
-    ROB();
+    ROB(uint32_t max_entries = DEFAULT_ENTRIES, uint32_t retire_width = DEFAULT_IPC);
     ~ROB();
     
     // Core functionality (3.2, 3.3, 3.4)
     void step();                    // Called every cycle
     bool canAccept();              // Check if ROB can accept new entry
-    bool allocate(const CpuFIFO::ReqMsg& request); // Allocate new instruction
+    bool allocate(const CpuFIFO::ReqMsg& request, uint32_t count = 1); // Allocate new instruction(s)
     void retire();                 // Retire ready instructions in-order
     void commit(uint64_t requestId); // Mark instruction as ready
     
+    // Resizes an empty ROB (used when the core is configured)
+    void configure(uint32_t max_entries, uint32_t retire_width);
+
     // Utility functions
-    bool isEmpty() const { return m_rob_q.empty(); }
+    bool isEmpty() const { return m_num_entries == 0; }
     uint32_t size() const { return m_num_entries; }
+    uint32_t capacity() const { return m_max_entries; }
+    uint32_t freeEntries() const { return m_max_entries - m_num_entries; }
+    uint32_t retireWidth() const { return m_retire_width; }
     void setCycle(uint64_t cycle) { m_current_cycle = cycle; }
     
     void removeLastEntry() {
-        if (!m_rob_q.empty()) {
-            m_rob_q.pop_back();
-            m_num_entries--;
-            std::cout << "[ROB] Removed last entry, size now: " << m_num_entries << std::endl;
+        if (m_num_entries > 0) {
+            m_tail--;
+            m_seq_of.erase(entryAt(m_tail).key);
+            m_num_entries -= entryAt(m_tail).count;
+            if (m_debug) {
+                std::cout << "[ROB] Removed last entry, size now: " << m_num_entries << std::endl;
+            }
         }
     }
 
@@ -66,22 +95,27 @@ public:
         std::cout << "[ROB] LSQ connection established" << std::endl;
     }
     
-    void setCpu(CpuCoreGenerator* cpu) { 
+    void setCpu(CpuCoreGenerator* cpu, uint32_t thread = 0) { 
         m_cpu = cpu;
-        std::cout << "[ROB] CPU connection established" << std::endl;
+        m_thread = thread;
+        std::cout << "[ROB] CPU connection established (thread " << thread << ")" << std::endl;
     }
     
     CpuCoreGenerator* getCpu() const { return m_cpu; }
+    uint32_t getThread() const { return m_thread; }
     
     // Debug support
+    void setDebug(bool debug) { m_debug = debug; }
+
     void printState() const {
         std::cout << "\n[ROB] Current State:" << std::endl;
-        std::cout << "  Entries: " << m_num_entries << "/" << MAX_ENTRIES << std::endl;
+        std::cout << "  Entries: " << m_num_entries << "/" << m_max_entries << std::endl;
         std::cout << "  Queue contents:" << std::endl;
-        for (size_t i = 0; i < m_rob_q.size(); i++) {
-            const auto& entry = m_rob_q[i];
-            std::cout << "    [" << i << "] ID: " << entry.request.msgId
+        for (uint64_t seq = m_head; seq != m_tail; seq++) {
+            const auto& entry = entryAt(seq);
+            std::cout << "    [" << (seq - m_head) << "] ID: " << entry.request.msgId
                       << " Type: " << (int)entry.request.type
+                      << " Count: " << entry.count
                       << " Ready: " << (entry.ready ? "Yes" : "No")
                       << " Cycle: " << entry.allocate_cycle << std::endl;
         }
@@ -90,4 +124,4 @@ public:
 
 } // namespace ns3
 
-#endif // ROB_H
\ No newline at end of file
+#endif // ROB_H
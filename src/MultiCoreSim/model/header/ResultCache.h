@@ -0,0 +1,60 @@
+#ifndef _ResultCache_H
+#define _ResultCache_H
+
+#include <string>
+#include <vector>
+
+namespace ns3
+{
+    /*
+     * On-disk store of simulation results, keyed by everything a result
+     * depends on: the configuration (canonicalized, so attribute order,
+     * comments and layout do not matter), the protocol FSM tables, the
+     * contents of the trace files and the memory parameter file, and the
+     * simulator itself: the MultiCoreSim library that is loaded (found with
+     * dladdr, so a rebuilt model changes the key even when the driver
+     * executable is unchanged) and the driver. The key is 128 bits, the
+     * ns-3 Murmur3 and FNV-1a 64-bit hashes side by side.
+     *
+     * Hashing a large trace is not free, so the digest of a file is kept
+     * in the cache too and reused while the file's size and modification
+     * time stay the same.
+     *
+     * Entries and digests are written to a temporary file and renamed into
+     * place, so readers never see a partial one, and Lock serializes the
+     * processes (or threads) simulating the same key: the first one runs
+     * it, the others wait and then find its result.
+     */
+    class ResultCache
+    {
+    private:
+        std::string m_dir;
+
+        std::string entryPath(const std::string &key, const std::string &suffix);
+        bool copyFile(const std::string &from, const std::string &to);
+
+    public:
+        ResultCache(const std::string &dir);
+
+        static std::string Digest(const char *data, size_t size);
+        static std::string CanonicalXml(const std::string &config_file);
+
+        // Content digest of a file, "" if it cannot be read
+        std::string FileDigest(const std::string &path);
+
+        // Key of a run of config_file on the traces in bms_path by the
+        // simulator executable; "" if a part of it cannot be read
+        std::string Key(const std::string &config_file, const std::string &bms_path, const std::string &fsm_dir,
+                        const std::string &simulator);
+
+        // Copies the stored result of key to result_file; false on a miss
+        bool Fetch(const std::string &key, const std::string &result_file);
+        bool Store(const std::string &key, const std::string &result_file);
+
+        // Exclusive lock on key, held until Unlock; -1 if it cannot be taken
+        int Lock(const std::string &key);
+        void Unlock(int lock);
+    };
+}
+
+#endif /* _ResultCache_H */
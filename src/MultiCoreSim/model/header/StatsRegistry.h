@@ -0,0 +1,65 @@
+#ifndef _StatsRegistry_H
+#define _StatsRegistry_H
+
+#include <cstdint>
+#include <functional>
+#include <set>
+#include <string>
+#include <utility>
+#include <vector>
+
+namespace ns3
+{
+    /*
+     * The named statistics of a run. Once the project is set up each
+     * component adds its counters here (registerStats, next to its
+     * printStats), either as a pointer to the counter or as a function for
+     * a derived value such as an average or a rate. Reading the registry
+     * gives the current values in the order they were added, so it can be
+     * read during the run as well as at its end.
+     *
+     * A container adds a Scope around the stats of what it holds, e.g.
+     * "Memory channel 1" around the stats of that channel's backend, so the
+     * same stat of two instances gets two names. Adding a name twice is a
+     * bug in the caller and throws std::logic_error.
+     */
+    class StatsRegistry
+    {
+    public:
+        typedef std::function<double()> Reader;
+
+        // Prefixes the names added while it is alive; an empty name adds nothing
+        class Scope
+        {
+        private:
+            StatsRegistry &m_stats;
+
+        public:
+            Scope(StatsRegistry &stats, const std::string &name) : m_stats(stats) { m_stats.m_scopes.push_back(name); }
+            ~Scope() { m_stats.m_scopes.pop_back(); }
+        };
+
+    private:
+        std::vector<std::string> m_scopes;
+        std::vector<std::pair<std::string, Reader>> m_stats;
+        std::set<std::string> m_names;
+
+    public:
+        // The counter must outlive the registry's readers
+        template <typename T>
+        void add(const std::string &name, const T *counter)
+        {
+            add(name, Reader([counter]() { return (double)*counter; }));
+        }
+        void add(const std::string &name, Reader reader);
+
+        std::vector<std::pair<std::string, double>> read() const;
+        void clear();
+        size_t size() const { return m_stats.size(); }
+
+        // num / den, or 0 without any den
+        static double Ratio(uint64_t num, uint64_t den) { return (den > 0) ? (double)num / den : 0.0; }
+    };
+}
+
+#endif /* _StatsRegistry_H */
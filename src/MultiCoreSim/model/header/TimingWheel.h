@@ -0,0 +1,65 @@
+#ifndef _TimingWheel_H
+#define _TimingWheel_H
+
+#include <stdint.h>
+#include <vector>
+#include <unordered_map>
+
+namespace ns3
+{
+    /**
+ * brief Hierarchical timing wheel that holds one expiry cycle per key (a cache
+ * line address key for PENDULUM). Scheduling is O(1); advancing one cycle costs
+ * O(1) plus the number of expired keys, with an occasional cascade of an upper
+ * level slot into the lower levels.
+ *
+ * Cancelling or re-scheduling a key only updates m_active; the old entry stays
+ * in its slot and is dropped when it is reached.
+ */
+
+    class TimingWheel
+    {
+    public:
+        TimingWheel(uint64_t start_cycle = 0);
+        ~TimingWheel();
+
+        // (Re)arms the timer of key to expire at expiry_cycle
+        void schedule(uint64_t key, uint64_t expiry_cycle);
+        void cancel(uint64_t key);
+        bool isScheduled(uint64_t key) const;
+
+        // Processes every cycle up to and including `cycle`, appending the keys
+        // whose timers expired to out_expired in expiry order
+        void advance(uint64_t cycle, std::vector<uint64_t> &out_expired);
+
+        inline uint64_t size() const { return m_active.size(); }
+
+    private:
+        static const int LEVEL_BITS = 6;
+        static const int LEVELS = 4;
+        static const int SLOTS = 1 << LEVEL_BITS;
+        static const uint64_t SLOT_MASK = SLOTS - 1;
+        static const uint64_t MAX_DELTA = (1ULL << (LEVEL_BITS * LEVELS)) - 1;
+
+        struct Entry
+        {
+            uint64_t key;
+            uint64_t expiry;
+        };
+
+        std::vector<Entry> m_slots[LEVELS][SLOTS];
+        std::unordered_map<uint64_t, uint64_t> m_active; // key -> expiry cycle of its live timer
+        uint64_t m_next_cycle;                           // next cycle advance() processes
+        uint64_t m_entry_count;                          // live and stale entries held by the slots
+
+        void insert(const Entry &entry);
+        void cascade(int level);
+        inline bool isLive(const Entry &entry) const
+        {
+            std::unordered_map<uint64_t, uint64_t>::const_iterator it = m_active.find(entry.key);
+            return it != m_active.end() && it->second == entry.expiry;
+        }
+    };
+}
+
+#endif /* _TimingWheel_H */
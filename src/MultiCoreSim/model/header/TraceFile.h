@@ -0,0 +1,68 @@
+#ifndef TRACE_FILE_H
+#define TRACE_FILE_H
+
+#include <cstddef>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <string>
+
+namespace ns3 {
+
+/**
+ * @brief A trace file mapped read-only into memory
+ *
+ * A file is mapped once per process however many readers it has: Open hands
+ * out the mapping the process already has for the path while any reader still
+ * holds it. Since the mapping is shared, the pages of a trace are also shared
+ * by every process simulating it (e.g. the points of a sweep).
+ */
+class MappedTrace {
+private:
+    std::string m_path;
+    const char* m_data;
+    size_t m_size;
+
+    static std::mutex s_lock;
+    static std::map<std::string, std::weak_ptr<const MappedTrace>> s_open;
+
+    explicit MappedTrace(const std::string& path);
+
+public:
+    ~MappedTrace();
+    MappedTrace(const MappedTrace&) = delete;
+    MappedTrace& operator=(const MappedTrace&) = delete;
+
+    // NULL if the file cannot be opened
+    static std::shared_ptr<const MappedTrace> Open(const std::string& path);
+
+    const char* data() const { return m_data; }
+    size_t size() const { return m_size; }
+    const std::string& path() const { return m_path; }
+};
+
+/**
+ * @brief Reads the lines of a MappedTrace, in place of an std::ifstream
+ */
+class TraceReader {
+private:
+    std::shared_ptr<const MappedTrace> m_trace;
+    size_t m_pos;
+
+public:
+    TraceReader() : m_pos(0) {}
+
+    void open(const char* path);
+    bool is_open() const { return m_trace != NULL; }
+    void close();
+
+    // True once every line has been read
+    bool eof() const { return !m_trace || m_pos >= m_trace->size(); }
+
+    // Next line without its end of line; false at the end of the trace
+    bool getline(std::string& line);
+};
+
+} // namespace ns3
+
+#endif // TRACE_FILE_H
@@ -0,0 +1,114 @@
+#ifndef _TraceReplayMemory_H
+#define _TraceReplayMemory_H
+
+#include "MainMemoryController.h"
+
+#include <fstream>
+#include <functional>
+#include <map>
+#include <queue>
+#include <random>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+namespace ns3
+{
+    /*
+     * Records the latency the memory returns for every LLC read miss. It
+     * sits between the LLC-DRAM bus and a memory backend as the backend's
+     * lower interface, so it adds no delay of its own. Each read is written
+     * to the trace as
+     *
+     *     <addr (hex)> <seq> <queue depth> <latency>
+     *
+     * where seq counts the earlier reads of the same address, the queue
+     * depth is the number of reads the memory had outstanding when the read
+     * arrived, and the latency is in controller cycles from arrival to data.
+     *
+     * Created by MemoryBackendRegistry::Create around any backend but REPLAY
+     * when the DRAMCnfg MEMRecordFile attribute is set. With several memory
+     * controllers (channels or sockets) controller n writes
+     * MEMRecordFile.<n>.
+     */
+    class MemoryLatencyRecorder : public CommunicationInterface, public MemoryBackend
+    {
+    protected:
+        struct PendingRead
+        {
+            uint64_t seq;
+            uint32_t depth;
+            int64_t arrive_ns;
+        };
+
+        CommunicationInterface *m_lower_interface; // Interface to the LLC-DRAM bus
+        MemoryBackend *m_backend;
+        double m_dt;
+
+        std::ofstream m_trace;
+        std::string m_trace_file;
+        std::unordered_map<uint64_t, uint64_t> m_read_seq; // addr -> reads of it so far
+        std::multimap<std::pair<uint64_t, uint64_t>, PendingRead> m_pending; // (msg_id, addr)
+
+        uint64_t m_recorded;
+        uint64_t m_latency_sum;
+
+    public:
+        MemoryLatencyRecorder(MCoreSimProjectXml &projectXml, CommunicationInterface *lower_interface, int instance);
+        ~MemoryLatencyRecorder();
+
+        void SetBackend(MemoryBackend *backend) { m_backend = backend; }
+
+        // Backend side
+        virtual bool peekMessage(Message *out_msg) override;
+        virtual void popFrontMessage() override;
+        virtual bool pushMessage(Message &msg, uint64_t cycle, MessageType type = MessageType::REQUEST) override;
+        virtual bool rollback(uint64_t address, uint64_t mask, Message *out_msg) override;
+
+        virtual void init();
+        virtual void printStats(std::ostream &out);
+        virtual void registerStats(StatsRegistry &stats);
+    };
+
+    /*
+     * Memory backend "REPLAY": answers reads with the latencies of a trace
+     * written by MemoryLatencyRecorder (MEMParamFile, or MEMParamFile.<n>
+     * for controller n) instead of modelling DRAM timing.
+     *
+     * MEMReplayMode EXACT gives a read the recorded latency of the same
+     * address and seq. A read the trace does not have (the cache hierarchy
+     * changed, so the miss stream did too) and every read in DISTRIBUTION
+     * mode draws a latency from the recorded latencies of reads that saw
+     * the same queue depth, in power-of-two depth buckets. Writes complete
+     * after MEMLATENCY cycles.
+     */
+    class TraceReplayMemory : public MainMemoryController
+    {
+    protected:
+        static const int DEPTH_BUCKETS = 10;
+
+        bool m_exact;
+        std::unordered_map<uint64_t, std::vector<uint32_t>> m_latencies; // addr -> latency by seq
+        std::vector<uint32_t> m_by_depth[DEPTH_BUCKETS];
+        std::unordered_map<uint64_t, uint64_t> m_read_seq;
+        std::priority_queue<uint64_t, std::vector<uint64_t>, std::greater<uint64_t>> m_read_completions;
+        std::mt19937 m_rng;
+
+        uint64_t m_exact_reads;
+        uint64_t m_sampled_reads;
+        uint64_t m_replayed_latency;
+
+        static int depthBucket(uint32_t depth);
+        uint32_t sampleLatency(uint32_t depth);
+        virtual uint32_t requestLatency(const Message &msg);
+
+    public:
+        TraceReplayMemory(MCoreSimProjectXml &projectXml, CommunicationInterface *lower_interface, int llc_id,
+                          int instance, std::string trace_file);
+
+        virtual void printStats(std::ostream &out);
+        virtual void registerStats(StatsRegistry &stats);
+    };
+}
+
+#endif /* _TraceReplayMemory_H */
@@ -0,0 +1,81 @@
+#ifndef _VMCnfgXml_H
+#define _VMCnfgXml_H
+#include "tinyxml.h"
+#include <string>
+
+using namespace std;
+
+/*
+ * Virtual memory parameters, read from the VirtualMemory element. With
+ * Enable="1" every core translates the addresses of its loads and stores
+ * through its own L1 and L2 TLB and a page-table walker before they reach
+ * its private cache. Latencies are in CPU cycles. The cores share one
+ * address space unless their cache elements give them different ASIDs.
+ */
+class VMCnfgXml {
+private:
+  int    m_enable;
+  string m_pageAllocator;   // SEQUENTIAL, RANDOM, HUGE (2MB pages) or COLOR
+  int    m_physMemMB;       // Physical memory the allocator hands out
+  int    m_pageColors;      // COLOR: frame colours, a core allocates from colour (core index mod colours)
+  int    m_randomSeed;      // RANDOM: seed of the frame selection
+
+  int    m_l1TLBEntries;
+  int    m_l1TLBWays;
+  int    m_l1TLBLatency;
+  int    m_l2TLBEntries;
+  int    m_l2TLBWays;
+  int    m_l2TLBLatency;
+  int    m_pageWalkers;     // Page walks a core can have in progress
+
+public:
+
+  bool GetEnable ()            { return m_enable != 0;      }
+  string GetPageAllocator ()   { return m_pageAllocator;    }
+  int GetPhysMemMB ()          { return m_physMemMB;        }
+  int GetPageColors ()         { return m_pageColors;       }
+  int GetRandomSeed ()         { return m_randomSeed;       }
+  int GetL1TLBEntries ()       { return m_l1TLBEntries;     }
+  int GetL1TLBWays ()          { return m_l1TLBWays;        }
+  int GetL1TLBLatency ()       { return m_l1TLBLatency;     }
+  int GetL2TLBEntries ()       { return m_l2TLBEntries;     }
+  int GetL2TLBWays ()          { return m_l2TLBWays;        }
+  int GetL2TLBLatency ()       { return m_l2TLBLatency;     }
+  int GetPageWalkers ()        { return m_pageWalkers;      }
+
+  void LoadFromXml(TiXmlHandle root) {
+
+     // default values
+     m_enable        = 0;
+     m_pageAllocator = "SEQUENTIAL";
+     m_physMemMB     = 4096;
+     m_pageColors    = 1;
+     m_randomSeed    = 1;
+     m_l1TLBEntries  = 64;
+     m_l1TLBWays     = 4;
+     m_l1TLBLatency  = 1;
+     m_l2TLBEntries  = 1536;
+     m_l2TLBWays     = 12;
+     m_l2TLBLatency  = 7;
+     m_pageWalkers   = 2;
+
+     TiXmlElement* VMRootPtr = root.Element();
+     if (VMRootPtr == NULL)
+       return;
+
+     VMRootPtr->QueryIntAttribute    ("Enable"        , &m_enable        );
+     VMRootPtr->QueryStringAttribute ("PageAllocator" , &m_pageAllocator );
+     VMRootPtr->QueryIntAttribute    ("PhysMemMB"     , &m_physMemMB     );
+     VMRootPtr->QueryIntAttribute    ("PageColors"    , &m_pageColors    );
+     VMRootPtr->QueryIntAttribute    ("RandomSeed"    , &m_randomSeed    );
+     VMRootPtr->QueryIntAttribute    ("L1TLBEntries"  , &m_l1TLBEntries  );
+     VMRootPtr->QueryIntAttribute    ("L1TLBWays"     , &m_l1TLBWays     );
+     VMRootPtr->QueryIntAttribute    ("L1TLBLatency"  , &m_l1TLBLatency  );
+     VMRootPtr->QueryIntAttribute    ("L2TLBEntries"  , &m_l2TLBEntries  );
+     VMRootPtr->QueryIntAttribute    ("L2TLBWays"     , &m_l2TLBWays     );
+     VMRootPtr->QueryIntAttribute    ("L2TLBLatency"  , &m_l2TLBLatency  );
+     VMRootPtr->QueryIntAttribute    ("PageWalkers"   , &m_pageWalkers   );
+  }
+};
+
+#endif /* _VMCnfgXml_H */
@@ -7,6 +7,9 @@
  */
 
 #include "../header/CacheController.h"
+
+#include <algorithm>
+
 #define DEBUG_MSGS
 namespace ns3
 {
@@ -47,6 +50,22 @@ namespace ns3
                                                                  cacheXml.GetNPendReq());
                                                                          
         m_data_access_arbiter = (private_caches_id == NULL) ? NULL : new RRFCFSArbiter(private_caches_id, cacheXml.GetDataAccessLatency());
+
+        m_non_blocking = cacheXml.GetNonBlocking();
+        m_max_outstanding_misses = (cacheXml.GetMSHRs() > 0) ? cacheXml.GetMSHRs() : 1;
+
+        m_primary_misses = 0;
+        m_secondary_misses = 0;
+        m_mshr_full_stalls = 0;
+        m_miss_cycles = 0;
+        m_outstanding_sum = 0;
+        m_max_outstanding = 0;
+
+        m_atomic_latency = (cacheXml.GetAtomicLatency() > 0) ? cacheXml.GetAtomicLatency() : 0;
+        m_atomic_count = 0;
+        m_atomic_latency_sum = 0;
+        m_atomic_misses = 0;
+        m_held_snoops = 0;
     }
 
     CacheController::~CacheController()
@@ -61,6 +80,7 @@ namespace ns3
         m_protocol->updateCycle(m_cache_cycle);
         this->processDataArrayBuffer();
         this->processLogic(); // Call cache controller
+        this->sampleOutstandingMisses();
 
         Simulator::Schedule(NanoSeconds(m_dt), &CacheController::step, Ptr<CacheController>(this)); // Schedule the next run
         m_cache_cycle++;
@@ -72,6 +92,136 @@ namespace ns3
         Simulator::Schedule(NanoSeconds(m_clk_skew), &CacheController::step, Ptr<CacheController>(this));
     }
 
+    void CacheController::printStats(std::ostream &out)
+    {
+        m_protocol->printStats(out);
+
+        out << "Core " << m_core_id << " primary misses = " << m_primary_misses << std::endl;
+        out << "Core " << m_core_id << " secondary misses merged = " << m_secondary_misses << std::endl;
+        out << "Core " << m_core_id << " MSHR full stalls = " << m_mshr_full_stalls << std::endl;
+        out << "Core " << m_core_id << " max outstanding misses = " << m_max_outstanding << std::endl;
+        out << "Core " << m_core_id << " MLP (avg outstanding misses when >= 1) = "
+            << ((m_miss_cycles > 0) ? (double)m_outstanding_sum / m_miss_cycles : 0.0) << std::endl;
+
+        if (m_atomic_count == 0)
+            return;
+
+        out << "Core " << m_core_id << " atomics = " << m_atomic_count << ", avg atomic latency = "
+            << (double)m_atomic_latency_sum / m_atomic_count << " cycles" << std::endl;
+        out << "Core " << m_core_id << " atomic misses (line not in M) = " << m_atomic_misses << std::endl;
+        out << "Core " << m_core_id << " snoop cycles held off by atomics = " << m_held_snoops << std::endl;
+
+        // The lines whose atomics missed most often are the contended locks
+        std::vector<std::pair<uint64_t, AtomicLineStats>> lines(m_atomic_lines.begin(), m_atomic_lines.end());
+        std::sort(lines.begin(), lines.end(),
+                  [](const std::pair<uint64_t, AtomicLineStats> &a, const std::pair<uint64_t, AtomicLineStats> &b)
+                  { return a.second.misses > b.second.misses || (a.second.misses == b.second.misses && a.first < b.first); });
+        for (size_t i = 0; i < lines.size() && i < 5 && lines[i].second.misses > 0; i++)
+        {
+            out << "Core " << m_core_id << " contended line 0x" << std::hex
+                << (lines[i].first << int(log2(m_cache_line_size))) << std::dec
+                << " atomics = " << lines[i].second.atomics << ", misses = " << lines[i].second.misses
+                << ", snoop cycles held off = " << lines[i].second.held_snoops << std::endl;
+        }
+    }
+
+    // The stats of a cache that serves CPU requests; the contended lines are only in the report
+    void CacheController::registerStats(StatsRegistry &stats)
+    {
+        m_protocol->registerStats(stats);
+
+        StatsRegistry::Scope core(stats, "Core " + std::to_string(m_core_id));
+        stats.add("primary misses", &m_primary_misses);
+        stats.add("secondary misses merged", &m_secondary_misses);
+        stats.add("MSHR full stalls", &m_mshr_full_stalls);
+        stats.add("max outstanding misses", &m_max_outstanding);
+        stats.add("MLP (avg outstanding misses when >= 1)",
+                  [this]() { return StatsRegistry::Ratio(m_outstanding_sum, m_miss_cycles); });
+        stats.add("atomics", &m_atomic_count);
+        stats.add("avg atomic latency", [this]() { return StatsRegistry::Ratio(m_atomic_latency_sum, m_atomic_count); });
+        stats.add("atomic misses (line not in M)", &m_atomic_misses);
+        stats.add("snoop cycles held off by atomics", &m_held_snoops);
+    }
+
+    // Closes an atomic and holds its line; msg may be any CPU response
+    void CacheController::completeAtomic(const Message &msg)
+    {
+        std::unordered_map<uint64_t, uint64_t>::iterator it = m_atomics.find(msg.msg_id);
+        if (it == m_atomics.end())
+            return;
+
+        uint64_t key = getAddressKey(msg.addr);
+        m_atomic_count++;
+        m_atomic_latency_sum += m_cache_cycle - it->second;
+        m_atomic_lines[key].atomics++;
+        m_locked_lines[key] = m_cache_cycle + m_atomic_latency;
+        m_atomics.erase(it);
+    }
+
+    bool CacheController::isLineHeld(uint64_t addr)
+    {
+        std::unordered_map<uint64_t, uint64_t>::iterator it = m_locked_lines.find(getAddressKey(addr));
+        if (it == m_locked_lines.end())
+            return false;
+        if (it->second > m_cache_cycle)
+            return true;
+        m_locked_lines.erase(it);
+        return false;
+    }
+
+    void CacheController::sampleOutstandingMisses()
+    {
+        uint32_t outstanding = m_pending_cpu_requests.size();
+        if (outstanding == 0)
+            return;
+
+        m_miss_cycles++;
+        m_outstanding_sum += outstanding;
+        if (outstanding > m_max_outstanding)
+            m_max_outstanding = outstanding;
+    }
+
+    // A load joins any outstanding miss of its block; a store only joins one
+    // that is already getting the block in M
+    bool CacheController::mergeSecondaryMiss(const Message &msg)
+    {
+        if (!m_non_blocking)
+            return false;
+
+        std::map<uint64_t, std::queue<Message>>::iterator it = m_pending_cpu_requests.find(getAddressKey(msg.addr));
+        if (it == m_pending_cpu_requests.end() || it->second.empty())
+            return false;
+
+        if (msg.complementary_value != CpuFIFO::REQTYPE::READ &&
+            !(msg.complementary_value == CpuFIFO::REQTYPE::WRITE &&
+              it->second.front().complementary_value == CpuFIFO::REQTYPE::WRITE))
+            return false;
+
+        it->second.push(msg);
+        m_secondary_misses++;
+        if (m_atomics.count(msg.msg_id))
+        {
+            m_atomic_misses++;
+            m_atomic_lines[getAddressKey(msg.addr)].misses++;
+        }
+        return true;
+    }
+
+    // True if msg is a CPU request that would start a new miss
+    bool CacheController::needsFreeMSHR(const Message &msg)
+    {
+        if (msg.source != Message::Source::LOWER_INTERCONNECT ||
+            (msg.complementary_value != CpuFIFO::REQTYPE::READ && msg.complementary_value != CpuFIFO::REQTYPE::WRITE))
+            return false;
+
+        if (m_pending_cpu_requests.find(getAddressKey(msg.addr)) != m_pending_cpu_requests.end())
+            return false;
+
+        GenericCacheLine cache_line;
+        m_data_handler->readLineBits(msg.addr, &cache_line);
+        return !m_protocol->fsm()->isHit(cache_line.state, (int)msg.complementary_value);
+    }
+
     void CacheController::step(Ptr<CacheController> cache_controller)
     {
         cache_controller->cycleProcess();
@@ -100,11 +250,34 @@ namespace ns3
     {
         this->addRequests2ProcessingQueue(*m_processing_queue);
 
+        // primary misses that found every MSHR busy, they go back to the queue
+        // once this cycle's ready messages are processed
+        std::vector<Message> deferred_misses;
+        // other cores' requests for a line an atomic still holds
+        std::vector<Message> held_snoops;
+
         while(true)
         {
             Message ready_msg;
             if (m_processing_queue->getFirstReady(&ready_msg) == false)
-                return;
+                break;
+
+            if (m_non_blocking && m_pending_cpu_requests.size() >= m_max_outstanding_misses &&
+                needsFreeMSHR(ready_msg))
+            {
+                m_mshr_full_stalls++;
+                deferred_misses.push_back(ready_msg);
+                continue;
+            }
+
+            if (ready_msg.source == Message::Source::UPPER_INTERCONNECT && ready_msg.owner != m_core_id &&
+                ready_msg.data == NULL && isLineHeld(ready_msg.addr))
+            {
+                m_held_snoops++;
+                m_atomic_lines[getAddressKey(ready_msg.addr)].held_snoops++;
+                held_snoops.push_back(ready_msg);
+                continue;
+            }
 
             if(ready_msg.source == Message::Source::LOWER_INTERCONNECT)
                 Logger::getLogger()->updateRequest(ready_msg.msg_id, Logger::EntryId::CACHE_CHECKPOINT);
@@ -122,6 +295,25 @@ namespace ns3
             for (ControllerAction action : actions)
                 callActionFunction(action);
         }
+
+        for (const Message &msg : deferred_misses)
+        {
+            if (!m_processing_queue->pushBack(msg, FRFCFS_State::NonReady))
+            {
+                cout << "CacheController: error there is no free space to push request to processing queue" << endl;
+                exit(0);
+            }
+        }
+
+        // Back at the front, in arrival order, to be tried again next cycle
+        for (std::vector<Message>::reverse_iterator it = held_snoops.rbegin(); it != held_snoops.rend(); it++)
+        {
+            if (!m_processing_queue->pushFront(*it))
+            {
+                cout << "CacheController: error there is no free space to push request to processing queue" << endl;
+                exit(0);
+            }
+        }
     }
 
     void CacheController::processDataArrayBuffer()
@@ -163,7 +355,18 @@ namespace ns3
         if (m_lower_interface->peekMessage(&msg))
         {
             msg.source = Message::Source::LOWER_INTERCONNECT;
-            if (buf.pushBack(msg, FRFCFS_State::NonReady)) {
+            // An atomic needs the line writable, which is what a store asks the protocol for
+            if (msg.complementary_value == CpuFIFO::REQTYPE::RMW && msg.data == NULL)
+            {
+                msg.complementary_value = CpuFIFO::REQTYPE::WRITE;
+                m_atomics.emplace(msg.msg_id, m_cache_cycle);
+            }
+            if (mergeSecondaryMiss(msg)) {
+                m_lower_interface->popFrontMessage();
+                std::cerr << msg.msg_id << "," << msg.addr << "," \
+                    << "add_req" << "," <<  m_core_id << ","<< m_cache_cycle<<"\n";
+            }
+            else if (buf.pushBack(msg, FRFCFS_State::NonReady)) {
                 m_lower_interface->popFrontMessage();
                 std::cerr << msg.msg_id << "," << msg.addr << "," \
                     << "add2q_l" << "," <<  m_core_id << ","<< m_cache_cycle<<"\n";
@@ -181,7 +384,15 @@ namespace ns3
     void CacheController::addtoPendingRequests(void *data_ptr)
     {
         Message *msg = (Message *)data_ptr;
-        this->m_pending_cpu_requests[this->getAddressKey(msg->addr)].push(*msg);
+        std::queue<Message> &pending = this->m_pending_cpu_requests[this->getAddressKey(msg->addr)];
+        if (pending.empty())
+            m_primary_misses++;
+        if (m_atomics.count(msg->msg_id))
+        {
+            m_atomic_misses++;
+            m_atomic_lines[getAddressKey(msg->addr)].misses++;
+        }
+        pending.push(*msg);
         std::cerr << msg->msg_id << "," << msg->addr << "," \
             << "add_req" << "," <<  m_core_id << ","<< m_cache_cycle<<"\n";
         delete msg;
@@ -194,7 +405,7 @@ namespace ns3
         if (m_pending_cpu_requests.find(getAddressKey(msg->addr)) != m_pending_cpu_requests.end())
         {
             queue<Message> pending_messages = this->m_pending_cpu_requests[this->getAddressKey(msg->addr)];
-            if (pending_messages.size() > 1)
+            if (pending_messages.size() > 1 && !m_non_blocking)
                 cout << "How !!!!!1" << endl;
             while (!pending_messages.empty())
             {
@@ -215,6 +426,7 @@ namespace ns3
 //                }
                 std::cerr << msg->msg_id << "," << msg->addr << "," \
                     << "respond" << "," <<  m_core_id << ","<< m_cache_cycle << "\n";
+                completeAtomic(pending_messages.front());
                 // push updated message to lower interface as DATA_RESPONSE
                 if (!m_lower_interface->pushMessage(pending_messages.front(), this->m_cache_cycle, MessageType::DATA_RESPONSE))
                 {
@@ -291,6 +503,8 @@ namespace ns3
             msg->copy(cache_line.m_data);
         }
 
+        completeAtomic(*msg);
+
         std::cerr << msg->msg_id << "," << msg->addr << "," 
                 << "hitActn" << "," <<  m_core_id << ","<< m_cache_cycle<<"\n";
         //if (m_core_id != 10) {
@@ -7,8 +7,7 @@
  */
 
 #include "../header/CacheControllerPENDULUM.h"
-#include "../header/TimerCache.h";
-#include "../header/LLCTimerCache.h";
+#include "../header/IdGenerator.h"
 
 namespace ns3
 {
@@ -21,47 +20,52 @@ namespace ns3
 
     // private controller constructor
     CacheControllerPENDULUM::CacheControllerPENDULUM(CacheXml &cacheXml, string &fsm_path, CommunicationInterface *upper_interface,
-                                     CommunicationInterface *lower_interface, bool cach2Cache,
-                                     int sharedMemId, CohProtType pType) : CacheController(cacheXml, fsm_path, upper_interface,
-                                     lower_interface, cach2Cache, sharedMemId, pType)
+                                                     CommunicationInterface *lower_interface, bool cach2Cache,
+                                                     int sharedMemId, CohProtType pType)
+        : CacheController(cacheXml, fsm_path, upper_interface, lower_interface, cach2Cache, sharedMemId, pType),
+          m_timers(m_cache_cycle)
     {
-        timer_val = 100; //TODO: Will receive from the XML file
-        // Pointer to TimerCacheFrmt?
-        num_cacheLines = cacheXml.GetCacheSize() / cacheXml.GetBlockSize();
+        m_timer_cycles = cacheXml.GetPendulumTimer();
+        m_timeout_count = 0;
     }
 
     CacheControllerPENDULUM::~CacheControllerPENDULUM()
-    {}
-
-    void CacheControllerPENDULUM::initializeCacheHandler(CacheXml &cacheXml)
     {
-        uint32_t cacheLines = cacheXml.GetCacheSize() / cacheXml.GetBlockSize();
-        m_cache = new TimerCache(cacheLines);
-        m_cache->SetCacheType(cacheXml.GetMappingType());
-        m_cache->SetCacheSize(cacheXml.GetCacheSize());
-        m_cache->SetCacheBlkSize(cacheXml.GetBlockSize());
-        m_cache->SetCacheNways(cacheXml.GetNWays());
-        m_cache->SetCacheNsets(cacheLines / cacheXml.GetNWays());
     }
 
     void CacheControllerPENDULUM::addRequests2ProcessingQueue(FRFCFS_Buffer<Message, CoherenceProtocolHandler> &buf)
     {
+        m_expired.clear();
+        m_timers.advance(m_cache_cycle, m_expired);
 
-        if (!self_msgs.empty())
+        for (uint64_t key : m_expired)
         {
-            Message msg = self_msgs[0];
-
-            if (buf.pushFront(msg))
-                self_msgs.erase(self_msgs.begin());
+            Message msg((uint64_t)IdGenerator::nextReqId(),        // Id
+                        key << int(log2(this->m_cache_line_size)), // Addr
+                        m_cache_cycle,                             // Cycle
+                        0,                                         // Complementary_value
+                        (uint16_t)this->m_core_id);                // Owner
+            msg.source = Message::Source::SELF;
+            m_timeout_msgs.push_back(msg);
         }
 
-        // Add the function here to check the timeout of every cacheline 
-        vector <Message> timeout_requests = ((TimerCache*)m_cache)->checktimeout(this->m_cache_cycle, num_cacheLines, this->m_core_id);
-
-        for (Message msg : timeout_requests)
+        // One timeout enters the processing queue per cycle, the rest wait their turn
+        while (!m_timeout_msgs.empty())
         {
-            buf.pushFront(msg);
-            delete &msg;
+            GenericCacheLine cache_line;
+            // The line may have been replaced since its timer expired
+            if (!m_data_handler->readLineBits(m_timeout_msgs.front().addr, &cache_line) || !cache_line.valid)
+            {
+                m_timeout_msgs.pop_front();
+                continue;
+            }
+
+            if (buf.pushFront(m_timeout_msgs.front()))
+            {
+                m_timeout_msgs.pop_front();
+                m_timeout_count++;
+            }
+            break;
         }
 
         CacheController::addRequests2ProcessingQueue(buf);
@@ -69,72 +73,35 @@ namespace ns3
 
     void CacheControllerPENDULUM::callActionFunction(ControllerAction action)
     {
-        switch(action.type)
+        switch (action.type)
         {
-            case ControllerAction::Type::TIMER_ACTION: this->timer_actions(action.data); return;
-            case ControllerAction::Type::ADD_SHARER: this->add_sharer(action.data); return;
-            case ControllerAction::Type::REMOVE_SHARER: this->remove_sharer(action.data); return;
+            case ControllerAction::Type::TIMER_ACTION: this->timerAction(action.data); return;
 
             default: CacheController::callActionFunction(action); return;
         }
     }
 
-    void CacheControllerPENDULUM::timer_actions(void *data_ptr)
+    void CacheControllerPENDULUM::timerAction(void *data_ptr)
     {
         Message *msg = (Message *)data_ptr;
 
-        TimerCache::CacheLineInfo cache_line_info = this->m_cache->GetCacheLineInfo(msg->addr);
-        uint32_t set_index = cache_line_info.set_idx;
-        uint32_t way_index = cache_line_info.way_idx;
-
-        TimerCacheFrmt *cacheline = (TimerCacheFrmt *)data_ptr;
-        int new_timeout = (msg->complementary_value == 1) ? 0 : this->m_cache_cycle + timer_val;      // TODO Pass it in the data array 
-        cacheline->timeout = new_timeout;
-
-        this->m_cache->WriteCacheLine(set_index, way_index, *cacheline);
+        if (msg->complementary_value == 1) // Stop_T
+            m_timers.cancel(this->getAddressKey(msg->addr));
+        else                               // RT
+            m_timers.schedule(this->getAddressKey(msg->addr), m_cache_cycle + m_timer_cycles);
 
-        delete[](data_ptr);
+        delete msg;
     }
 
-    void CacheControllerPENDULUM::add_sharer(void *data_ptr)
+    void CacheControllerPENDULUM::printStats(std::ostream &out)
     {
-        Message *msg = (Message *)data_ptr;
-
-        LLCTimerCache::CacheLineInfo cache_line_info = m_cache->GetCacheLineInfo(msg->addr);
-        uint32_t set_index = cache_line_info.set_idx;
-        uint32_t way_index = cache_line_info.way_idx;
-
-        LLCTimerCacheFrmt *cacheline = (LLCTimerCacheFrmt *)data_ptr;
-        cacheline->sharer_count++;
-        this->m_cache->WriteCacheLine(set_index, way_index, *cacheline);
-
-        delete[](data_ptr);
+        CacheController::printStats(out);
+        out << "Core " << m_core_id << " PENDULUM timeouts = " << m_timeout_count << std::endl;
     }
 
-    void CacheControllerPENDULUM::remove_sharer(void *data_ptr)
+    void CacheControllerPENDULUM::registerStats(StatsRegistry &stats)
     {
-        Message *msg = (Message *)data_ptr;
-        
-        // Get cache info from data_ptr
-        LLCTimerCache::CacheLineInfo cache_line_info = m_cache->GetCacheLineInfo(msg->addr);
-        uint32_t set_index = cache_line_info.set_idx;
-        uint32_t way_index = cache_line_info.way_idx;
-
-        LLCTimerCacheFrmt *cacheline = (LLCTimerCacheFrmt *)data_ptr;
-
-        // Read cacheline
-        if(cacheline->sharer_count == 1)
-        {
-            // Trigger Sharers_0 event
-            msg->source = Message::Source::SELF;
-            self_msgs.push_back(*msg);         
-        }
-
-        //Write cachline
-        cacheline->sharer_count--;
-        this->m_cache->WriteCacheLine(set_index, way_index, *cacheline);
-
-        delete[](data_ptr);
+        CacheController::registerStats(stats);
+        stats.add("Core " + std::to_string(m_core_id) + " PENDULUM timeouts", &m_timeout_count);
     }
-
 }
@@ -0,0 +1,77 @@
+#include "../header/CacheControllerPENDULUM_LLC.h"
+
+namespace ns3
+{
+    // override ns3 type
+    TypeId CacheControllerPENDULUM_LLC::GetTypeId(void)
+    {
+        static TypeId tid = TypeId("ns3::CacheControllerPENDULUM_LLC").SetParent<Object>();
+        return tid;
+    }
+
+    // private controller constructor
+    CacheControllerPENDULUM_LLC::CacheControllerPENDULUM_LLC(CacheXml &cacheXml, string &fsm_path, CommunicationInterface *upper_interface,
+                                                             CommunicationInterface *lower_interface, bool cach2Cache,
+                                                             int sharedMemId, CohProtType pType, vector<int> *private_caches_id)
+        : CacheController_End2End(cacheXml, fsm_path, upper_interface, lower_interface, cach2Cache, sharedMemId, pType, private_caches_id)
+    {
+    }
+
+    CacheControllerPENDULUM_LLC::~CacheControllerPENDULUM_LLC()
+    {
+    }
+
+    void CacheControllerPENDULUM_LLC::addRequests2ProcessingQueue(FRFCFS_Buffer<Message, CoherenceProtocolHandler> &buf)
+    {
+        if (!m_sharers_0_msgs.empty())
+        {
+            if (buf.pushFront(m_sharers_0_msgs.front()))
+                m_sharers_0_msgs.pop_front();
+        }
+
+        CacheController_End2End::addRequests2ProcessingQueue(buf);
+    }
+
+    void CacheControllerPENDULUM_LLC::callActionFunction(ControllerAction action)
+    {
+        switch (action.type)
+        {
+            case ControllerAction::Type::ADD_SHARER: this->addSharer(action.data); return;
+            case ControllerAction::Type::REMOVE_SHARER: this->removeSharer(action.data); return;
+
+            default: CacheController_End2End::callActionFunction(action); return;
+        }
+    }
+
+    void CacheControllerPENDULUM_LLC::addSharer(void *data_ptr)
+    {
+        Message *msg = (Message *)data_ptr;
+
+        m_sharer_count[this->getAddressKey(msg->addr)]++;
+
+        delete msg;
+    }
+
+    void CacheControllerPENDULUM_LLC::removeSharer(void *data_ptr)
+    {
+        Message *msg = (Message *)data_ptr;
+        std::unordered_map<uint64_t, int>::iterator it = m_sharer_count.find(this->getAddressKey(msg->addr));
+
+        if (it == m_sharer_count.end())
+        {
+            cout << "CacheControllerPENDULUM_LLC(id = " << this->m_core_id << "): Sharer removed from a line without sharers" << endl;
+            exit(0);
+        }
+
+        if (--it->second == 0)
+        {
+            // Trigger the Sharers_0 event
+            m_sharer_count.erase(it);
+            msg->source = Message::Source::SELF;
+            msg->cycle = this->m_cache_cycle;
+            m_sharers_0_msgs.push_back(*msg);
+        }
+
+        delete msg;
+    }
+}
@@ -8,6 +8,8 @@
 
 #include "../header/CacheController_End2End.h"
 
+#include <stdexcept>
+
 namespace ns3
 {
     // override ns3 type
@@ -24,12 +26,243 @@ namespace ns3
         : CacheController(cacheXml, fsm_path, upper_interface, lower_interface, cach2Cache, sharedMemId, pType, private_caches_id)
     {
         m_owner_of_latest_data = -1;
+        m_regulation_period = (cacheXml.GetRegulationPeriod() > 0) ? cacheXml.GetRegulationPeriod() : 0;
+
+        string policy = cacheXml.GetWBDrainPolicy();
+        if (policy == "EAGER")
+            m_wb_policy = WBDrainPolicy::EAGER;
+        else if (policy == "WATERMARK")
+            m_wb_policy = WBDrainPolicy::WATERMARK;
+        else if (policy == "IDLE")
+            m_wb_policy = WBDrainPolicy::IDLE;
+        else
+        {
+            throw std::runtime_error("CacheController_End2End: unknown write-back drain policy " + policy +
+                                     " (EAGER, WATERMARK or IDLE)");
+        }
+        m_wb_buffer_size = (cacheXml.GetWBBufferSize() > 0) ? cacheXml.GetWBBufferSize() : 1;
+        m_wb_high_watermark = std::min((uint32_t)std::max(cacheXml.GetWBHighWatermark(), 1), m_wb_buffer_size);
+        m_wb_low_watermark = std::min((uint32_t)std::max(cacheXml.GetWBLowWatermark(), 0), m_wb_high_watermark - 1);
+        m_wb_draining = false;
+        m_wb_flushing = false;
+        m_last_mem_read_cycle = 0;
+
+        m_wb_sent = 0;
+        m_wb_coalesced = 0;
+        m_wb_forwarded = 0;
+        m_wb_forced = 0;
+        m_wb_occupancy_sum = 0;
     }
 
     CacheController_End2End::~CacheController_End2End()
     {
     }
 
+    void CacheController_End2End::SetMemBudget(int owner_id, int core_id, int budget)
+    {
+        if (budget <= 0)
+            return;
+
+        m_core_of_owner[owner_id] = core_id;
+        if (m_budgets.find(core_id) == m_budgets.end())
+        {
+            CoreBudget &core = m_budgets[core_id];
+            core.used = 0;
+            core.throttled_requests = 0;
+            core.throttled_cycles = 0;
+        }
+        m_budgets[core_id].budget = budget;
+    }
+
+    void CacheController_End2End::cycleProcess()
+    {
+        if (m_regulation_period > 0)
+            this->regulateBandwidth();
+        if (!m_wb_buffer.empty())
+            this->drainWriteBacks();
+
+        CacheController::cycleProcess();
+    }
+
+    // Replenish the budgets at the start of each period and release the requests they allow
+    // while the memory interface has room
+    void CacheController_End2End::regulateBandwidth()
+    {
+        bool new_period = (m_cache_cycle % m_regulation_period) == 0;
+
+        for (std::map<int, CoreBudget>::iterator it = m_budgets.begin(); it != m_budgets.end(); it++)
+        {
+            CoreBudget &core = it->second;
+            if (new_period)
+                core.used = 0;
+
+            while (!core.throttled.empty() && core.used < core.budget)
+            {
+                Message *msg = core.throttled.front();
+                if (!rollbackRequest(msg) && !trySendMemoryRequest(msg))
+                    break;
+                core.throttled.pop_front();
+                core.used++;
+            }
+
+            if (!core.throttled.empty())
+            {
+                core.throttled_cycles++;
+                Logger::getLogger()->addThrottledCycles(it->first, 1);
+            }
+        }
+    }
+
+    // Holds the request back if its core has used up its budget for this period
+    bool CacheController_End2End::throttleRequest(Message *msg)
+    {
+        if (m_regulation_period == 0)
+            return false;
+
+        std::map<int, int>::iterator owner = m_core_of_owner.find(msg->owner);
+        if (owner == m_core_of_owner.end())
+            return false;
+
+        CoreBudget &core = m_budgets[owner->second];
+        if (core.used < core.budget && core.throttled.empty())
+        {
+            core.used++;
+            return false;
+        }
+
+        core.throttled.push_back(msg);
+        core.throttled_requests++;
+        return true;
+    }
+
+    void CacheController_End2End::sendMemoryRequest(Message *msg)
+    {
+        m_last_mem_read_cycle = m_cache_cycle;
+        CacheController::sendBusRequest(msg);
+    }
+
+    // Returns false, keeping msg, if the memory interface is full
+    bool CacheController_End2End::trySendMemoryRequest(Message *msg)
+    {
+        msg->cycle = this->m_cache_cycle;
+        if (!m_upper_interface->pushMessage(*msg, this->m_cache_cycle, MessageType::REQUEST))
+            return false;
+
+        m_last_mem_read_cycle = m_cache_cycle;
+        delete msg;
+        return true;
+    }
+
+    // Returns false if the memory interface is full, the write-back then stays buffered
+    bool CacheController_End2End::sendWriteBack(Message &msg)
+    {
+        if (!m_upper_interface->pushMessage(msg, this->m_cache_cycle, MessageType::DATA_RESPONSE))
+            return false;
+        m_wb_sent++;
+        return true;
+    }
+
+    void CacheController_End2End::bufferWriteBack(const Message &msg)
+    {
+        for (Message &buffered : m_wb_buffer)
+        {
+            if (getAddressKey(buffered.addr) == getAddressKey(msg.addr))
+            {
+                buffered.copy(msg.data);
+                m_wb_coalesced++;
+                return;
+            }
+        }
+
+        // With the interface full too, the buffer holds one more until it drains
+        if (m_wb_buffer.size() >= m_wb_buffer_size && sendWriteBack(m_wb_buffer.front()))
+        {
+            m_wb_buffer.pop_front();
+            m_wb_forced++;
+        }
+        m_wb_buffer.push_back(msg);
+    }
+
+    void CacheController_End2End::drainWriteBacks()
+    {
+        m_wb_occupancy_sum += m_wb_buffer.size();
+
+        bool drain = m_wb_flushing;
+        switch (m_wb_policy)
+        {
+            case WBDrainPolicy::EAGER:
+                drain = true;
+                break;
+            case WBDrainPolicy::WATERMARK:
+                if (m_wb_buffer.size() >= m_wb_high_watermark)
+                    m_wb_draining = true;
+                drain |= m_wb_draining;
+                break;
+            case WBDrainPolicy::IDLE:
+                drain |= m_last_mem_read_cycle + 1 < m_cache_cycle;
+                break;
+        }
+
+        if (!drain || !sendWriteBack(m_wb_buffer.front()))
+            return;
+
+        m_wb_buffer.pop_front();
+        if (m_wb_buffer.size() <= m_wb_low_watermark)
+            m_wb_draining = false;
+    }
+
+    bool CacheController_End2End::flushWriteBacks()
+    {
+        m_wb_flushing = true;
+        return m_wb_buffer.empty();
+    }
+
+    void CacheController_End2End::printStats(std::ostream &out)
+    {
+        // The LLC tracks no misses of its own, only its protocol's stats come from CacheController
+        m_protocol->printStats(out);
+
+        if (m_wb_policy != WBDrainPolicy::EAGER)
+        {
+            out << "LLC write-backs sent = " << m_wb_sent << ", coalesced = " << m_wb_coalesced
+                << ", served misses = " << m_wb_forwarded << ", forced by a full buffer = " << m_wb_forced
+                << ", avg buffer occupancy = " << ((m_cache_cycle > 0) ? (double)m_wb_occupancy_sum / m_cache_cycle : 0.0)
+                << endl;
+        }
+
+        for (std::map<int, CoreBudget>::iterator it = m_budgets.begin(); it != m_budgets.end(); it++)
+        {
+            out << "Core " << it->first << " memory budget = " << it->second.budget << " per " << m_regulation_period
+                << " cycles, throttled requests = " << it->second.throttled_requests
+                << ", throttled cycles = " << it->second.throttled_cycles << std::endl;
+        }
+    }
+
+    // The LLC tracks no misses of its own, so only its protocol's stats come from CacheController
+    void CacheController_End2End::registerStats(StatsRegistry &stats)
+    {
+        m_protocol->registerStats(stats);
+
+        if (m_wb_policy != WBDrainPolicy::EAGER)
+        {
+            stats.add("LLC write-backs sent", &m_wb_sent);
+            stats.add("LLC write-backs coalesced", &m_wb_coalesced);
+            stats.add("LLC write-backs served misses", &m_wb_forwarded);
+            stats.add("LLC write-backs forced by a full buffer", &m_wb_forced);
+            stats.add("LLC avg write-back buffer occupancy",
+                      [this]() { return StatsRegistry::Ratio(m_wb_occupancy_sum, m_cache_cycle); });
+        }
+
+        // Budgets are all set before the run, so the map no longer changes
+        for (std::map<int, CoreBudget>::iterator it = m_budgets.begin(); it != m_budgets.end(); it++)
+        {
+            StatsRegistry::Scope core(stats, "Core " + std::to_string(it->first));
+            stats.add("memory budget", &it->second.budget);
+            stats.add("throttled requests", &it->second.throttled_requests);
+            stats.add("throttled cycles", &it->second.throttled_cycles);
+        }
+    }
+
     void CacheController_End2End::addRequests2ProcessingQueue(FRFCFS_Buffer<Message, CoherenceProtocolHandler> &buf)
     {
         Message msg;
@@ -56,8 +289,30 @@ namespace ns3
     void CacheController_End2End::sendBusRequest(void *data_ptr)
     {
         Message *msg = (Message *)data_ptr;
+
+        if (rollbackRequest(msg) || throttleRequest(msg))
+            return;
+
+        sendMemoryRequest(msg);
+    }
+
+    // Serves the request from a write-back to the same line that has not left for memory yet
+    bool CacheController_End2End::rollbackRequest(Message *msg)
+    {
         Message returned_msg;
 
+        for (Message &buffered : m_wb_buffer)
+        {
+            if (getAddressKey(buffered.addr) == getAddressKey(msg->addr))
+            {
+                msg->copy(buffered.data);
+                m_upper_interface->pushMessage2RX(*msg, MessageType::DATA_RESPONSE);
+                m_wb_forwarded++;
+                delete msg;
+                return true;
+            }
+        }
+
         if(m_upper_interface->rollback(msg->addr, this->m_cache_line_size, &returned_msg))
         {
             if(returned_msg.data != NULL)
@@ -71,11 +326,9 @@ namespace ns3
                 exit(0);
             }
             delete msg;
+            return true;
         }
-        else
-        {
-            CacheController::sendBusRequest(data_ptr);
-        }
+        return false;
     }
 
     void CacheController_End2End::performWriteBack(void *data_ptr)
@@ -105,11 +358,10 @@ namespace ns3
         //}
 
 
-        if (!m_upper_interface->pushMessage(*msg, this->m_cache_cycle, MessageType::DATA_RESPONSE))
-        {
-            cout << "CacheController: Cannot insert the Msg into BusTxResp FIFO, FIFO is Full" << endl;
-            exit(0);
-        }
+        // EAGER sends right away unless older write-backs wait or the memory
+        // interface is full; the buffer is drained every cycle then
+        if (m_wb_policy != WBDrainPolicy::EAGER || !m_wb_buffer.empty() || !sendWriteBack(*msg))
+            bufferWriteBack(*msg);
 
         delete msg;
     }
@@ -17,6 +17,8 @@ namespace ns3
     {
         line_added2PWB = false;
         address_of_recently_added2PWB = 0;
+        MSHR_max_size = (cacheXml.GetMSHRs() > 0) ? cacheXml.GetMSHRs() : 1;
+        WB_max_size = (cacheXml.GetWBBufferSize() > 0) ? cacheXml.GetWBBufferSize() : 1;
     }
 
     CacheDataHandler_COTS::~CacheDataHandler_COTS()
@@ -411,21 +413,13 @@ namespace ns3
             OwnData_Execlusive,
         };
 
-        int next_state;
-        vector<int> actions;
         GenericCacheLine *cache_line = (GenericCacheLine*)getLine(set,way);
 
-//        CacheDataHandler::readLineBits(address, &cache_line);
-        m_protocol->fsm()->getTransition(
+        const FSMReader::Transition &transition = m_protocol->fsm()->getTransition(
             cache_line->state,
-            static_cast<int>(EventId::Replacement),
-            next_state,
-            actions
-        );  
-//        std::cout << "current state: " << cache_line->state
-//            << ", next state: " << next_state << "\n";
-//        std::cout << actions.size() << std::endl;
-        return (actions.size() == 0) ? false : true;
+            static_cast<int>(EventId::Replacement)
+        );
+        return (transition.actions.size() == 0) ? false : true;
     }
 
 }
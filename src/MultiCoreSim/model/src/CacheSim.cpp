@@ -8,58 +8,242 @@
 
 #include "../header/CacheSim.h"
 
+#include <cstdlib>
+#include <limits>
+#include <stdexcept>
+
 namespace ns3
 {
-    CacheSim::CacheSim(const char *config_file_path, const char *output_logs_path)
+    void CacheSimStats::read(const StatsRegistry &registry)
+    {
+        m_values.clear();
+        m_order.clear();
+        for (const std::pair<std::string, double> &stat : registry.read())
+        {
+            m_values[stat.first] = stat.second;
+            m_order.push_back(stat.first);
+        }
+    }
+
+    double CacheSimStats::get(const std::string &name, double fallback) const
+    {
+        std::map<std::string, double>::const_iterator it = m_values.find(name);
+        return (it == m_values.end()) ? fallback : it->second;
+    }
+
+    std::mutex CacheSim::s_simulator_lock;
+    bool CacheSim::s_simulator_busy = false;
+
+    CacheSim::CacheSim(const char *config_file_path, const char *bms_path, const char *output_path)
     {
         TiXmlDocument doc(config_file_path);
-        doc.LoadFile();
+        if (!doc.LoadFile())
+            throw std::runtime_error(std::string("CacheSim: cannot load configuration file ") + config_file_path);
 
         TiXmlHandle hDoc(&doc);
         TiXmlElement *root = hDoc.FirstChildElement().Element();
         TiXmlHandle hroot = TiXmlHandle(root);
 
-        MCoreSimProjectXml xml;
-        xml.LoadFromXml(hroot);
-        xml.SetBMsPath(string(output_logs_path));
+        m_config.LoadFromXml(hroot);
+        m_config.SetBMsPath(string(bms_path));
+        if (output_path != NULL)
+            m_config.SetOutputPath(string(output_path));
 
-        // setup simulation environment
-        project = new MCoreSimProject(xml);
+        simulator_thread = NULL;
+        project = NULL;
+        m_owns_simulator = false;
+        m_finished = false;
+        m_cycles = 0;
+    }
+
+    CacheSim::CacheSim(const MCoreSimProjectXml &config)
+    {
+        m_config = config;
+
+        simulator_thread = NULL;
+        project = NULL;
+        m_owns_simulator = false;
+        m_finished = false;
+        m_cycles = 0;
+    }
+
+    CacheSim::~CacheSim()
+    {
+        if (simulator_thread != NULL)
+        {
+            if (simulator_thread->joinable())
+                simulator_thread->join();
+            delete simulator_thread;
+        }
+
+        // Destroyed in the middle of a run
+        abandon();
+    }
+
+    // Waiting for the owner could wait forever: it may be the calling thread itself
+    void CacheSim::acquireSimulator()
+    {
+        if (m_owns_simulator)
+            return;
+        std::lock_guard<std::mutex> lock(s_simulator_lock);
+        if (s_simulator_busy)
+            throw std::runtime_error("CacheSim: the simulator belongs to another CacheSim until its run is over or "
+                                     "it is destroyed");
+        s_simulator_busy = true;
+        m_owns_simulator = true;
+    }
+
+    void CacheSim::releaseSimulator()
+    {
+        if (!m_owns_simulator)
+            return;
+        std::lock_guard<std::mutex> lock(s_simulator_lock);
+        s_simulator_busy = false;
+        m_owns_simulator = false;
+    }
+
+    // Takes the simulator and sets the project up on it
+    void CacheSim::start()
+    {
+        if (project != NULL || m_finished)
+            return;
+
+        acquireSimulator();
 
         // set simulation clock to one nano-Second
         // clock resolution is the smallest time value
         // that can be respresented in our simulator
-        Time::SetResolution(Time::NS); // MS, US, PS
+        static std::once_flag resolution_set;
+        std::call_once(resolution_set, []() { Time::SetResolution(Time::NS); }); // MS, US, PS
 
-        // initialize the simulator
-        project->Start();
+        // setup simulation environment
+        try
+        {
+            project = new MCoreSimProject(m_config);
+            project->SetReportStream(&m_report);
 
-        simulator_thread = NULL;
+            // initialize the simulator
+            project->Start();
+        }
+        catch (...)
+        {
+            abandon();
+            throw;
+        }
     }
 
-    CacheSim::~CacheSim()
+    bool CacheSim::runUntil(uint64_t cycle)
     {
-        delete project;
+        start();
+
+        bool time_up = false;
+        while (!m_finished && !time_up && project->GetBusCycle() < cycle)
+        {
+            if (cycle != std::numeric_limits<uint64_t>::max())
+                Simulator::Stop(NanoSeconds((cycle - project->GetBusCycle()) * m_config.GetBusClkInNanoSec()));
+            try
+            {
+                Simulator::Run();
+            }
+            catch (...)
+            {
+                abandon();
+                throw;
+            }
+
+            // Stopped by the project (traces done), by the configured simulation time, or by us
+            time_up = Simulator::IsFinished() ||
+                      (!m_config.GetRunTillSimEnd() && Simulator::Now() >= MilliSeconds(m_config.GetTotalTimeInSeconds()));
+            if (project->IsDone() || time_up)
+                finish();
+        }
+        return m_finished;
     }
 
-    void CacheSim::run()
+    // Collects the statistics and hands the simulator to the next instance
+    void CacheSim::finish()
     {
-        simulator_thread = new thread([](){
-            Simulator::Run();
+        if (!project->IsDone())
+        {
+            m_report << "Simulation time is up at Bus Clock Cycle # " << project->GetBusCycle() << endl;
+            project->PrintStats(m_report);
+        }
+        m_stats.read(project->GetStats());
+        m_cycles = project->GetBusCycle();
+        m_finished = true;
 
-            // clean up once done
+        // clean up once done
+        Simulator::Destroy();
+        delete project;
+        project = NULL;
+        releaseSimulator();
+    }
+
+    // Drops a run that cannot go on, and the simulator with it
+    void CacheSim::abandon()
+    {
+        if (m_owns_simulator)
             Simulator::Destroy();
+        delete project;
+        project = NULL;
+        releaseSimulator();
+    }
+
+    bool CacheSim::runToCompletion()
+    {
+        return runUntil(std::numeric_limits<uint64_t>::max());
+    }
+
+    bool CacheSim::runFor(uint64_t cycles)
+    {
+        start();
+        if (m_finished)
+            return true;
+        return runUntil(project->GetBusCycle() + cycles);
+    }
+
+    uint64_t CacheSim::cycles() const
+    {
+        return (project != NULL) ? project->GetBusCycle() : m_cycles;
+    }
+
+    const CacheSimStats &CacheSim::stats()
+    {
+        if (!m_finished && project != NULL)
+            m_stats.read(project->GetStats());
+        return m_stats;
+    }
+
+    void CacheSim::run()
+    {
+        if (simulator_thread != NULL)
+            throw std::logic_error("CacheSim: run() called twice");
+        if (!m_finished)
+            acquireSimulator();
+        simulator_thread = new thread([this]()
+        {
+            try
+            {
+                this->runToCompletion();
+            }
+            catch (...)
+            {
+                m_thread_error = std::current_exception();
+            }
         });
     }
 
     void CacheSim::join()
     {
-        if(simulator_thread != NULL)
+        if (simulator_thread == NULL)
+            throw std::logic_error("CacheSim: join() without run()");
+        if (simulator_thread->joinable())
             simulator_thread->join();
-        else
+        if (m_thread_error)
         {
-            cout << "Fatal error: the simulator thread was created properly!!" << endl;
-            exit(0);
+            std::exception_ptr error = m_thread_error;
+            m_thread_error = NULL;
+            std::rethrow_exception(error);
         }
     }
-}
\ No newline at end of file
+}
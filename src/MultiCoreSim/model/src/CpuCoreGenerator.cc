@@ -10,8 +10,12 @@
 #include "../header/CpuCoreGenerator.h"
 #include "../header/Logger.h"
 #include <sstream>
+#include <algorithm>
+#include <cmath>
 #include "../header/ROB.h"
 #include "../header/LSQ.h"
+#include "../header/MMU.h"
+#include "../header/IdGenerator.h"
 
 namespace ns3 {
 
@@ -21,44 +25,37 @@ namespace ns3 {
         return tid;
     }
 
-    CpuCoreGenerator::CpuCoreGenerator(CpuFIFO* associatedCpuFIFO) 
+    CpuCoreGenerator::CpuCoreGenerator(CpuFIFO* associatedCpuFIFO)
         : m_coreId(0),
           m_dt(1.0),
           m_clkSkew(0.0),
           m_logFileGenEnable(false),
           m_cpuFIFO(associatedCpuFIFO),
-          m_rob(nullptr),
-          m_lsq(nullptr),
+          m_fetch_policy(FetchPolicy::RoundRobin),
+          m_rr_next(0),
+          m_instFIFO(NULL),
+          m_instCacheId(0),
+          m_instBlockBits(6),
+          m_fetch_buffer_size(16),
+          m_mmu(NULL),
           m_cpuCycle(0),
-          m_remaining_compute(0),
-          m_newSampleRdy(false),
-          m_cpuReqDone(false),
           m_cpuCoreSimDone(false),
-          m_sent_requests(0),
           m_number_of_OoO_requests(16),
+          m_dispatch_width(1),
           m_cpuReqCnt(0),
           m_cpuRespCnt(0),
           m_prevReqFinish(true),
           m_prevReqFinishCycle(0),
           m_prevReqArriveCycle(0) {
-              
+
         std::cout << "[CPU] Initializing Core " << m_coreId << std::endl;
-        
-        // Create and connect components
-        m_rob = new ROB();
-        m_lsq = new LSQ();
-        
-        // Set up connections
-        m_lsq->setROB(m_rob);
-        m_rob->setLSQ(m_lsq);
-        m_lsq->setCpuFIFO(m_cpuFIFO);
-        m_rob->setCpu(this);
+
+        // A core runs a single thread until SetThreads() says otherwise
+        m_threads.push_back(NewThread(0));
     }
 
     CpuCoreGenerator::~CpuCoreGenerator() {
-        if (m_bmTrace.is_open()) {
-            m_bmTrace.close();
-        }
+        DeleteThreads();
         if (m_cpuTrace.is_open()) {
             m_cpuTrace.close();
         }
@@ -67,13 +64,86 @@ namespace ns3 {
         }
     }
 
+    /**
+     * @brief Create a hardware thread with its own ROB and LSQ
+     * @param id Thread index within the core
+     */
+    CpuCoreGenerator::HwThread* CpuCoreGenerator::NewThread(uint32_t id) {
+        HwThread* thread = new HwThread();
+        thread->id = id;
+        thread->remaining_compute = 0;
+        thread->newSampleRdy = false;
+        thread->reqDone = false;
+        thread->done = false;
+        thread->sent_requests = 0;
+        thread->reqCnt = 0;
+        thread->respCnt = 0;
+        thread->retired = 0;
+        thread->fetched = 0;
+        thread->fetchLineValid = false;
+        thread->fetchLine = 0;
+        thread->hasNextInst = false;
+        thread->nextInst = 0;
+        thread->fetchPending = false;
+        thread->instDone = false;
+        thread->fetchRequests = 0;
+        thread->fetchStallCycles = 0;
+
+        // Create and connect components
+        thread->rob = new ROB();
+        thread->lsq = new LSQ();
+
+        // Set up connections
+        thread->lsq->setROB(thread->rob);
+        thread->rob->setLSQ(thread->lsq);
+        thread->lsq->setCpuFIFO(m_cpuFIFO);
+        thread->rob->setCpu(this, id);
+        return thread;
+    }
+
+    void CpuCoreGenerator::DeleteThreads() {
+        for (HwThread* thread : m_threads) {
+            if (thread->bmTrace.is_open()) {
+                thread->bmTrace.close();
+            }
+            if (thread->instTrace.is_open()) {
+                thread->instTrace.close();
+            }
+            delete thread->rob;
+            delete thread->lsq;
+            delete thread;
+        }
+        m_threads.clear();
+    }
+
+    /**
+     * @brief Set the number of hardware threads (SMT) and their fetch policy
+     * @param threads Number of threads, each one reads its own trace
+     * @param policy Order in which threads get the dispatch slots of a cycle
+     *
+     * Must be called before the trace files, ROB and LSQ are configured.
+     */
+    void CpuCoreGenerator::SetThreads(int threads, FetchPolicy policy) {
+        DeleteThreads();
+        for (int i = 0; i < std::max(threads, 1); i++) {
+            m_threads.push_back(NewThread(i));
+        }
+        m_fetch_policy = policy;
+        std::cout << "[CPU] Core " << m_coreId << " runs " << m_threads.size() << " thread(s), fetch policy "
+                  << (policy == FetchPolicy::ICount ? "ICOUNT" : "RR") << std::endl;
+    }
+
     // Configuration methods
-    void CpuCoreGenerator::SetBmFileName(std::string bmFileName) {
-        m_bmFileName = bmFileName;
+    void CpuCoreGenerator::SetBmFileName(std::string bmFileName, int thread) {
+        m_threads.at(thread)->bmFileName = bmFileName;
+    }
+
+    void CpuCoreGenerator::SetInstFileName(std::string instFileName, int thread) {
+        m_threads.at(thread)->instFileName = instFileName;
     }
 
     void CpuCoreGenerator::SetCpuTraceFile(std::string fileName) {
-        m_cpuTraceFileName = fileName; 
+        m_cpuTraceFileName = fileName;
     }
 
     void CpuCoreGenerator::SetCtrlsTraceFile(std::string fileName) {
@@ -110,205 +180,514 @@ namespace ns3 {
 
     /**
      * @brief Set maximum number of in-flight OoO requests
-     * @param stages Number of OoO stages
+     * @param stages Number of OoO stages (per thread)
      */
     void CpuCoreGenerator::SetOutOfOrderStages(int stages) {
         m_number_of_OoO_requests = stages;
     }
-    
+
+    /**
+     * @brief Set the ROB capacity and retire width of this core
+     * @param size Number of ROB entries, split evenly between the threads
+     * @param retireWidth Instructions retired per cycle by each thread's partition
+     */
+    void CpuCoreGenerator::SetROBConfig(int size, int retireWidth) {
+        int partition = std::max(size / (int)m_threads.size(), 1);
+        for (HwThread* thread : m_threads) {
+            thread->rob->configure(partition, retireWidth);
+        }
+    }
+
+    /**
+     * @brief Set the load/store queue sizes and cache ports of this core
+     * @param loadQueueSize Number of load queue entries of each thread
+     * @param storeQueueSize Number of store queue entries of each thread
+     * @param cachePorts Requests each thread's LSQ sends to the cache per cycle
+     */
+    void CpuCoreGenerator::SetLSQConfig(int loadQueueSize, int storeQueueSize, int cachePorts) {
+        for (HwThread* thread : m_threads) {
+            thread->lsq->configure(loadQueueSize, storeQueueSize, cachePorts);
+        }
+    }
+
+    /**
+     * @brief Set how many instructions of each kind are dispatched per cycle
+     * @param width Compute instructions, and separately memory instructions, per cycle
+     */
+    void CpuCoreGenerator::SetDispatchWidth(int width) {
+        m_dispatch_width = (width > 0) ? width : 1;
+    }
+
+    /**
+     * @brief Model instruction fetch through a private L1I
+     * @param instFIFO Interface to the L1I of this core
+     * @param instCacheId Id of the L1I, fetch requests are sent on its behalf
+     * @param blockSize L1I block size, one block is fetched per request
+     * @param fetchBufferSize Fetched instructions a thread can hold before dispatch
+     *
+     * Threads without an instruction-fetch trace are not limited by fetch.
+     */
+    void CpuCoreGenerator::SetInstFetch(CpuFIFO* instFIFO, int instCacheId, int blockSize, int fetchBufferSize) {
+        m_instFIFO = instFIFO;
+        m_instCacheId = instCacheId;
+        m_instBlockBits = (int)log2(blockSize);
+        m_fetch_buffer_size = (fetchBufferSize > 0) ? fetchBufferSize : 1;
+    }
+
+    /**
+     * @brief Translate the core's loads and stores on their way to the L1D
+     * @param mmu MMU between the CpuFIFO of this core and the L1D, owned by the caller
+     */
+    void CpuCoreGenerator::SetMMU(MMU* mmu) {
+        m_mmu = mmu;
+    }
+
+    void CpuCoreGenerator::printStats(std::ostream &out) {
+        for (HwThread* thread : m_threads) {
+            if (m_threads.size() > 1) {
+                out << "Core " << m_coreId << " thread " << thread->id << " instructions retired = " << thread->retired
+                    << " (IPC " << ((m_cpuCycle > 0) ? (double)thread->retired / m_cpuCycle : 0.0) << ")" << std::endl;
+            }
+            if (m_instFIFO && thread->fetchRequests > 0) {
+                out << "Core " << m_coreId;
+                if (m_threads.size() > 1) {
+                    out << " thread " << thread->id;
+                }
+                out << " L1I fetch requests = " << thread->fetchRequests
+                    << ", fetch stall cycles = " << thread->fetchStallCycles << std::endl;
+            }
+            thread->lsq->printStats(out, m_coreId, (m_threads.size() > 1) ? (int)thread->id : -1);
+        }
+        if (m_mmu) {
+            m_mmu->printStats(out);
+        }
+    }
+
+    void CpuCoreGenerator::registerStats(StatsRegistry &stats) {
+        StatsRegistry::Scope core(stats, "Core " + std::to_string(m_coreId));
+        for (HwThread* thread : m_threads) {
+            StatsRegistry::Scope hwThread(stats, (m_threads.size() > 1) ? "thread " + std::to_string(thread->id) : "");
+            stats.add("instructions retired", &thread->retired);
+            stats.add("IPC", [this, thread]() { return StatsRegistry::Ratio(thread->retired, m_cpuCycle); });
+            if (m_instFIFO) {
+                stats.add("L1I fetch requests", &thread->fetchRequests);
+                stats.add("fetch stall cycles", &thread->fetchStallCycles);
+            }
+            thread->lsq->registerStats(stats);
+        }
+        if (m_mmu) {
+            m_mmu->registerStats(stats);
+        }
+    }
+
     /**
      * @brief Initialize CPU core and start simulation
-     * 
-     * Opens benchmark trace file and schedules first cycle
+     *
+     * Opens the benchmark trace file of every thread and schedules first cycle
      */
     void CpuCoreGenerator::init() {
-        m_bmTrace.open(m_bmFileName.c_str());
-        if (!m_bmTrace.is_open()) {
-            std::cerr << "[CPU] ERROR: Could not open trace file " << m_bmFileName << std::endl;
-            throw std::runtime_error("Failed to open trace file");
+        for (HwThread* thread : m_threads) {
+            thread->rob->setDebug(m_logFileGenEnable);
+            thread->lsq->setDebug(m_logFileGenEnable);
+            thread->bmTrace.open(thread->bmFileName.c_str());
+            if (!thread->bmTrace.is_open()) {
+                std::cerr << "[CPU] ERROR: Could not open trace file " << thread->bmFileName << std::endl;
+                throw std::runtime_error("Failed to open trace file");
+            }
+
+            // The instruction-fetch trace is optional, without it the thread is not limited by fetch
+            if (m_instFIFO && !thread->instFileName.empty()) {
+                thread->instTrace.open(thread->instFileName.c_str());
+            }
+            if (!thread->instTrace.is_open()) {
+                thread->instDone = true;
+                if (m_instFIFO) {
+                    std::cout << "[CPU] Core " << m_coreId << " thread " << thread->id
+                              << " has no instruction-fetch trace " << thread->instFileName << std::endl;
+                }
+            }
         }
-        
+
         if (m_logFileGenEnable) {
             m_cpuTrace.open(m_cpuTraceFileName.c_str());
             m_ctrlsTrace.open(m_ctrlsTraceFileName.c_str());
         }
-        
+
         Simulator::Schedule(NanoSeconds(m_clkSkew), &CpuCoreGenerator::Step, Ptr<CpuCoreGenerator>(this));
     }
 
     /**
      * @brief Process transmit buffer operations
-     * 
+     *
+     * Orders the threads by the fetch policy and lets each one dispatch from
+     * the dispatch slots the threads before it left this cycle.
+     */
+    void CpuCoreGenerator::ProcessTxBuf() {
+        if (m_logFileGenEnable) {
+            std::cout << "\n[CPU] ========== Core " << m_coreId << " Cycle " << m_cpuCycle << " ==========" << std::endl;
+            std::cout << "[CPU] - Request count: " << m_cpuReqCnt << std::endl;
+            std::cout << "[CPU] - Response count: " << m_cpuRespCnt << std::endl;
+        }
+
+        std::vector<HwThread*> order;
+        order.reserve(m_threads.size());
+        for (size_t i = 0; i < m_threads.size(); i++) {
+            order.push_back(m_threads[(m_rr_next + i) % m_threads.size()]);
+        }
+        m_rr_next = (m_rr_next + 1) % m_threads.size();
+
+        // ICOUNT: the thread with the fewest instructions in flight goes first,
+        // ties keep the round-robin order
+        if (m_fetch_policy == FetchPolicy::ICount) {
+            std::stable_sort(order.begin(), order.end(), [](const HwThread* a, const HwThread* b) {
+                return a->rob->size() < b->rob->size();
+            });
+        }
+
+        uint32_t compute_budget = m_dispatch_width;
+        uint32_t mem_budget = m_dispatch_width;
+        for (HwThread* thread : order) {
+            if (!thread->done) {
+                ProcessThreadTx(*thread, compute_budget, mem_budget);
+            }
+        }
+    }
+
+    /**
+     * @brief Dispatch the instructions of one thread
+     *
      * Main instruction processing loop:
      * 1. Handle pending compute instructions
      * 2. Process memory operations
      * 3. Read next trace line when ready
-     * 
+     *
      * For each instruction:
      * - Allocate in ROB (all instructions)
      * - Allocate in LSQ (memory operations)
      * - Handle store-to-load forwarding
      * - Mark ready status appropriately
      */
-    void CpuCoreGenerator::ProcessTxBuf() {
-        std::cout << "\n[CPU] ========== Core " << m_coreId << " Cycle " << m_cpuCycle << " ==========" << std::endl;
-        std::cout << "[CPU] Pipeline state:" << std::endl;
-        std::cout << "[CPU] - In-flight requests: " << m_sent_requests << "/" << m_number_of_OoO_requests << std::endl;
-        std::cout << "[CPU] - Remaining compute: " << m_remaining_compute << std::endl;
-        std::cout << "[CPU] - Request count: " << m_cpuReqCnt << std::endl;
-        std::cout << "[CPU] - Response count: " << m_cpuRespCnt << std::endl;
-        
+    void CpuCoreGenerator::ProcessThreadTx(HwThread& thread, uint32_t& compute_budget, uint32_t& mem_budget) {
+        if (m_logFileGenEnable) {
+            std::cout << "[CPU] Thread " << thread.id << " pipeline state:" << std::endl;
+            std::cout << "[CPU] - In-flight requests: " << thread.sent_requests << "/" << m_number_of_OoO_requests << std::endl;
+            std::cout << "[CPU] - Remaining compute: " << thread.remaining_compute << std::endl;
+        }
+
         // First check LSQ for stores ready to commit to cache
-        if (m_lsq && m_cpuFIFO && !m_cpuFIFO->m_txFIFO.IsFull()) {
-            m_lsq->pushToCache();
+        if (m_cpuFIFO && !m_cpuFIFO->m_txFIFO.IsFull()) {
+            thread.lsq->pushToCache();
+        }
+
+        // Nothing fetched for a thread that still has instructions to dispatch
+        if (fetchedInsts(thread) == 0 && (thread.remaining_compute > 0 || thread.newSampleRdy || !thread.reqDone)) {
+            thread.fetchStallCycles++;
         }
-        
+
         // First handle any remaining compute instructions from previous line
-        if (m_remaining_compute > 0) {
-            std::cout << "[CPU] Processing compute instructions (" 
-                      << m_remaining_compute << " remaining)" << std::endl;
-              
-            // Try to allocate ONE compute instruction this cycle
-            if (m_rob && m_rob->canAccept() && m_sent_requests < m_number_of_OoO_requests) {
-                std::cout << "[CPU] Attempting to allocate compute instruction:" << std::endl;
-                
-                // Create compute instruction request
+        if (thread.remaining_compute > 0) {
+            if (m_logFileGenEnable) {
+                std::cout << "[CPU] Processing compute instructions ("
+                          << thread.remaining_compute << " remaining)" << std::endl;
+            }
+
+            // Dispatch up to the remaining compute slots of this cycle as one ROB entry
+            uint32_t batch = std::min(thread.remaining_compute, compute_budget);
+            batch = std::min(batch, thread.rob->freeEntries());
+            batch = std::min(batch, fetchedInsts(thread));
+            batch = (thread.sent_requests < m_number_of_OoO_requests) ?
+                    std::min(batch, m_number_of_OoO_requests - thread.sent_requests) : 0;
+
+            if (batch > 0) {
+                if (m_logFileGenEnable) {
+                    std::cout << "[CPU] Attempting to allocate " << batch << " compute instructions:" << std::endl;
+                }
+
+                // Create compute instruction request, it stands for msgIds
+                // m_cpuReqCnt ... m_cpuReqCnt + batch - 1
                 CpuFIFO::ReqMsg compute_req;
-                compute_req.msgId = m_cpuReqCnt++;
+                compute_req.msgId = m_cpuReqCnt;
                 compute_req.reqCoreId = m_coreId;
                 compute_req.type = CpuFIFO::REQTYPE::COMPUTE;
                 compute_req.addr = 0;  // Special value for compute
                 compute_req.cycle = m_cpuCycle;
                 compute_req.ready = true;  // Compute instructions are ready immediately
-                
-                std::cout << "[CPU] Created compute request " << compute_req.msgId 
-                          << " at cycle " << m_cpuCycle << std::endl;
-                
+
+                if (m_logFileGenEnable) {
+                    std::cout << "[CPU] Created compute request " << compute_req.msgId
+                              << " at cycle " << m_cpuCycle << std::endl;
+                }
+
                 // Try to allocate in ROB
-                if (m_rob->allocate(compute_req)) {
-                    m_remaining_compute--;
-                    m_sent_requests++;  // Track compute instruction as in-flight
-                    std::cout << "[CPU] Successfully allocated compute instruction " 
-                              << compute_req.msgId << " (ready immediately)" << std::endl;
-                } else {
+                if (thread.rob->allocate(compute_req, batch)) {
+                    m_cpuReqCnt += batch;
+                    thread.reqCnt += batch;
+                    thread.remaining_compute -= batch;
+                    thread.sent_requests += batch;  // Track compute instructions as in-flight
+                    compute_budget -= batch;
+                    consumeFetched(thread, batch);
+                    if (m_logFileGenEnable) {
+                        std::cout << "[CPU] Successfully allocated compute instructions "
+                                  << compute_req.msgId << "-" << (m_cpuReqCnt - 1) << " (ready immediately)" << std::endl;
+                    }
+                } else if (m_logFileGenEnable) {
                     std::cout << "[CPU] ROB allocation failed, will retry next cycle" << std::endl;
                 }
             }
-            
+
             // If we still have compute instructions, return and try again next cycle
-            if (m_remaining_compute > 0) {
-                std::cout << "[CPU] Still have " << m_remaining_compute 
-                          << " compute instructions remaining, will continue next cycle" << std::endl;
+            if (thread.remaining_compute > 0) {
+                if (m_logFileGenEnable) {
+                    std::cout << "[CPU] Still have " << thread.remaining_compute
+                              << " compute instructions remaining, will continue next cycle" << std::endl;
+                }
                 return;  // Let Step() handle cycle advancement
             }
         }
-        
-        // Only proceed to memory instructions if all compute instructions are allocated
-        // Check if we can accept new instructions
-        if (m_sent_requests >= m_number_of_OoO_requests) {
-            std::cout << "[CPU] Maximum in-flight requests reached" << std::endl;
-            return;
+
+        // Only proceed to memory instructions if all compute instructions are allocated.
+        // Memory instructions have their own budget of m_dispatch_width per cycle.
+        while (mem_budget > 0) {
+            // Check if we can accept new instructions
+            if (thread.sent_requests >= m_number_of_OoO_requests) {
+                if (m_logFileGenEnable) {
+                    std::cout << "[CPU] Maximum in-flight requests reached" << std::endl;
+                }
+                return;
+            }
+
+            // Read new trace line if needed and no pending compute instructions
+            if (!thread.newSampleRdy && thread.remaining_compute == 0) {
+                // ReadTraceLine marks the thread done when it finds the end of the trace
+                if (thread.reqDone || !ReadTraceLine(thread)) {
+                    return;
+                }
+
+                // If we have compute instructions, handle them first
+                if (thread.remaining_compute > 0) {
+                    return;  // Process compute instructions next cycle
+                }
+            }
+
+            // Try to allocate memory instruction if we have one
+            if (!thread.newSampleRdy || fetchedInsts(thread) == 0 || !DispatchMemReq(thread)) {
+                return;
+            }
+            consumeFetched(thread, 1);
+            mem_budget--;
         }
-        
-        // Read new trace line if needed and no pending compute instructions
-        if (!m_newSampleRdy && !m_bmTrace.eof() && m_remaining_compute == 0) {
-            std::string line;
-            if (std::getline(m_bmTrace, line)) {
-                std::cout << "[CPU] Read trace line: " << line << std::endl;
-                
-                std::istringstream iss(line);
-                uint32_t compute_count;
-                std::string type;
-                uint64_t addr;
-                
-                // Parse compute count and type as before, but address as decimal
-                if (iss >> std::dec >> compute_count >> addr >> type) {
-                    m_remaining_compute = compute_count;
-                    std::cout << "[CPU] Found " << compute_count << " compute instructions" << std::endl;
-                    
-                    // If we have compute instructions, handle them first
-                    if (compute_count > 0) {
-                        return;  // Process compute instructions next cycle
-                    }
-                    
-                    // Otherwise setup memory request if present
-                    if (type == "R" || type == "W") {
-                        m_cpuMemReq.msgId = m_cpuReqCnt++;
-                        m_cpuMemReq.reqCoreId = m_coreId;
-                        m_cpuMemReq.addr = addr;
-                        m_cpuMemReq.cycle = m_cpuCycle;
-                        m_cpuMemReq.ready = false;
-                        
-                        if (type == "R") {
-                            m_cpuMemReq.type = CpuFIFO::REQTYPE::READ;
-                            std::cout << "[CPU] Parsed LOAD: addr=" << addr 
-                                      << " msgId=" << m_cpuMemReq.msgId << std::endl;
-                        }
-                        else {  // type == "W"
-                            m_cpuMemReq.type = CpuFIFO::REQTYPE::WRITE;
-                            m_cpuMemReq.ready = true;  // Stores ready immediately
-                            std::cout << "[CPU] Store instruction " << m_cpuMemReq.msgId 
-                                      << " will commit upon LSQ allocation" << std::endl;
-                        }
-                        m_newSampleRdy = true;
-                    }
+    }
+
+    /**
+     * @brief Read the next trace line of a thread into remaining_compute and memReq
+     * @return false at the end of the trace
+     */
+    bool CpuCoreGenerator::ReadTraceLine(HwThread& thread) {
+        std::string line;
+        if (!thread.bmTrace.getline(line)) {
+            thread.reqDone = true;
+            std::cout << "[CPU] Thread " << thread.id << " reached end of trace file" << std::endl;
+            return false;
+        }
+        if (m_logFileGenEnable) {
+            std::cout << "[CPU] Read trace line: " << line << std::endl;
+        }
+
+        std::istringstream iss(line);
+        uint32_t compute_count;
+        std::string type;
+        uint64_t addr;
+
+        // Parse compute count and type as before, but address as decimal
+        if (!(iss >> std::dec >> compute_count >> addr >> type)) {
+            std::cout << "[CPU] Error: Invalid trace format" << std::endl;
+            return true;
+        }
+        thread.remaining_compute = compute_count;
+        if (m_logFileGenEnable) {
+            std::cout << "[CPU] Found " << compute_count << " compute instructions" << std::endl;
+        }
+
+        // Setup memory request if present, it is dispatched after the compute instructions
+        if (type == "R" || type == "W" || type == "A") {
+            CpuFIFO::ReqMsg& req = thread.memReq;
+            req.msgId = m_cpuReqCnt++;
+            req.reqCoreId = m_coreId;
+            req.addr = addr;
+            req.cycle = m_cpuCycle;
+            req.ready = false;
+            thread.reqCnt++;
+
+            if (type == "R") {
+                req.type = CpuFIFO::REQTYPE::READ;
+                if (m_logFileGenEnable) {
+                    std::cout << "[CPU] Parsed LOAD: addr=" << addr
+                              << " msgId=" << req.msgId << std::endl;
                 }
-                else {
-                    std::cout << "[CPU] Error: Invalid trace format" << std::endl;
+            }
+            else if (type == "A") {
+                req.type = CpuFIFO::REQTYPE::RMW;  // Waits for its result like a load
+                if (m_logFileGenEnable) {
+                    std::cout << "[CPU] Parsed ATOMIC: addr=" << addr
+                              << " msgId=" << req.msgId << std::endl;
                 }
             }
-            else {
-                m_cpuReqDone = true;
-                std::cout << "[CPU] Reached end of trace file" << std::endl;
+            else {  // type == "W"
+                req.type = CpuFIFO::REQTYPE::WRITE;
+                req.ready = true;  // Stores ready immediately
+                if (m_logFileGenEnable) {
+                    std::cout << "[CPU] Store instruction " << req.msgId
+                              << " will commit upon LSQ allocation" << std::endl;
+                }
             }
+            thread.newSampleRdy = true;
         }
-        
-        // Try to allocate memory instruction if we have one
-        if (m_newSampleRdy) {
-            if (m_rob && m_lsq && m_rob->canAccept() && m_lsq->canAccept() && 
-                m_sent_requests < m_number_of_OoO_requests) {
-                
-                // For loads, check store-to-load forwarding first
-                if (m_cpuMemReq.type == CpuFIFO::REQTYPE::READ) {
-                    bool forwarded = m_lsq->ldFwd(m_cpuMemReq.addr);
-                    if (forwarded) {
-                        m_cpuMemReq.ready = true;  // Load got data from LSQ
-                        std::cout << "[CPU] Load " << m_cpuMemReq.msgId 
-                                  << " committed via store-to-load forwarding" << std::endl;
-                    } else {
-                        std::cout << "[CPU] No matching store found in LSQ for forwarding" << std::endl;
-                    }
+        return true;
+    }
+
+    /**
+     * @brief Allocate the pending memory request of a thread in its ROB and LSQ
+     * @return true if the request was dispatched
+     */
+    bool CpuCoreGenerator::DispatchMemReq(HwThread& thread) {
+        CpuFIFO::ReqMsg& req = thread.memReq;
+        if (!thread.rob->canAccept() || !thread.lsq->canAccept(req.type) ||
+            thread.sent_requests >= m_number_of_OoO_requests) {
+            return false;
+        }
+
+        // For loads, check store-to-load forwarding first
+        if (req.type == CpuFIFO::REQTYPE::READ) {
+            bool forwarded = thread.lsq->ldFwd(req.addr);
+            if (forwarded) {
+                req.ready = true;  // Load got data from LSQ
+                if (m_logFileGenEnable) {
+                    std::cout << "[CPU] Load " << req.msgId
+                              << " committed via store-to-load forwarding" << std::endl;
                 }
-                
-                // Try ROB first
-                bool rob_ok = m_rob->allocate(m_cpuMemReq);
-                bool lsq_ok = false;
-                
-                if (rob_ok) {
-                    // Then try LSQ
-                    lsq_ok = m_lsq->allocate(m_cpuMemReq);
-                    if (!lsq_ok) {
-                        m_rob->removeLastEntry();  // Rollback ROB allocation
-                        std::cout << "[CPU] LSQ allocation failed - rolled back ROB allocation" << std::endl;
-                    } else {
-                        m_sent_requests++;  // Track memory request as in-flight
-                        std::cout << "[CPU] Successfully allocated " 
-                                  << (m_cpuMemReq.type == CpuFIFO::REQTYPE::READ ? "LOAD" : "STORE")
-                                  << " to ROB and LSQ" << std::endl;
-                        std::cout << "[CPU] Updated in-flight requests: " << m_sent_requests 
-                                  << "/" << m_number_of_OoO_requests << std::endl;
-                        m_newSampleRdy = false;
-                    }
+            } else if (m_logFileGenEnable) {
+                std::cout << "[CPU] No matching store found in LSQ for forwarding" << std::endl;
+            }
+        }
+
+        // Try ROB first
+        if (!thread.rob->allocate(req)) {
+            return false;
+        }
+
+        // Then try LSQ
+        if (!thread.lsq->allocate(req)) {
+            thread.rob->removeLastEntry();  // Rollback ROB allocation
+            if (m_logFileGenEnable) {
+                std::cout << "[CPU] LSQ allocation failed - rolled back ROB allocation" << std::endl;
+            }
+            return false;
+        }
+
+        thread.sent_requests++;  // Track memory request as in-flight
+        m_thread_of[req.msgId] = thread.id;
+        if (m_logFileGenEnable) {
+            std::cout << "[CPU] Successfully allocated "
+                      << (req.type == CpuFIFO::REQTYPE::READ ? "LOAD" : (req.type == CpuFIFO::REQTYPE::RMW) ? "ATOMIC" : "STORE")
+                      << " to ROB and LSQ" << std::endl;
+            std::cout << "[CPU] Updated in-flight requests: " << thread.sent_requests
+                      << "/" << m_number_of_OoO_requests << std::endl;
+        }
+        thread.newSampleRdy = false;
+        return true;
+    }
+
+    /**
+     * @brief Fetch stage, run before dispatch every cycle
+     *
+     * Each thread fetches from the block the L1I last delivered until its fetch
+     * buffer is full or the next instruction lies in another block; that block
+     * is then requested from the L1I and the thread waits for it.
+     */
+    void CpuCoreGenerator::ProcessFetch() {
+        if (m_instFIFO == NULL) {
+            return;
+        }
+        ProcessFetchRx();
+        for (HwThread* thread : m_threads) {
+            FetchThread(*thread);
+        }
+    }
+
+    void CpuCoreGenerator::FetchThread(HwThread& thread) {
+        if (thread.instDone || thread.fetchPending) {
+            return;
+        }
+
+        while (thread.fetched < m_fetch_buffer_size) {
+            if (!thread.hasNextInst) {
+                std::string line;
+                if (!thread.instTrace.getline(line)) {
+                    thread.instDone = true;
+                    std::cout << "[CPU] Thread " << thread.id << " reached end of instruction-fetch trace" << std::endl;
+                    return;
                 }
+                std::istringstream iss(line);
+                if (!(iss >> std::hex >> thread.nextInst)) {
+                    continue;
+                }
+                thread.hasNextInst = true;
+            }
+
+            uint64_t block = thread.nextInst >> m_instBlockBits;
+            if (thread.fetchLineValid && block == thread.fetchLine) {
+                thread.fetched++;
+                thread.hasNextInst = false;
+                continue;
+            }
+
+            // The next instruction is in another block, ask the L1I for it
+            if (m_instFIFO->m_txFIFO.IsFull()) {
+                return;
+            }
+            CpuFIFO::ReqMsg req;
+            req.msgId = IdGenerator::nextReqId();
+            req.reqCoreId = m_instCacheId;
+            req.addr = block << m_instBlockBits;
+            req.cycle = m_cpuCycle;
+            req.type = CpuFIFO::REQTYPE::READ;
+            req.ready = false;
+            m_instFIFO->m_txFIFO.InsertElement(req);
+            m_fetch_thread_of[req.msgId] = thread.id;
+            thread.fetchPending = true;
+            thread.fetchRequests++;
+            if (m_logFileGenEnable) {
+                std::cout << "[CPU] Thread " << thread.id << " fetches block 0x" << std::hex << req.addr << std::dec
+                          << " from the L1I (msgId " << req.msgId << ")" << std::endl;
             }
+            return;
+        }
+    }
+
+    void CpuCoreGenerator::ProcessFetchRx() {
+        while (!m_instFIFO->m_rxFIFO.IsEmpty()) {
+            CpuFIFO::RespMsg resp = m_instFIFO->m_rxFIFO.GetFrontElement();
+            m_instFIFO->m_rxFIFO.PopElement();
+
+            std::unordered_map<uint64_t, uint32_t>::iterator owner = m_fetch_thread_of.find(resp.msgId);
+            if (owner == m_fetch_thread_of.end()) {
+                std::cout << "[CPU] Warning: L1I response " << resp.msgId << " matches no fetch in flight" << std::endl;
+                continue;
+            }
+            HwThread& thread = *m_threads[owner->second];
+            m_fetch_thread_of.erase(owner);
+
+            thread.fetchPending = false;
+            thread.fetchLineValid = true;
+            thread.fetchLine = resp.addr >> m_instBlockBits;
         }
     }
 
     /**
      * @brief Process receive buffer operations
-     * 
+     *
      * Handles:
-     * 1. Data returning from memory system
+     * 1. Data returning from memory system, routed to the thread that sent the request
      * 2. Committing loads when data arrives
      * 3. Simulation completion check
      */
@@ -317,79 +696,132 @@ namespace ns3 {
         while (!m_cpuFIFO->m_rxFIFO.IsEmpty()) {
             m_cpuMemResp = m_cpuFIFO->m_rxFIFO.GetFrontElement();
             m_cpuFIFO->m_rxFIFO.PopElement();
-            
+
+            std::unordered_map<uint64_t, uint32_t>::iterator owner = m_thread_of.find(m_cpuMemResp.msgId);
+            if (owner == m_thread_of.end()) {
+                std::cout << "[CPU] Warning: response " << m_cpuMemResp.msgId << " matches no request in flight" << std::endl;
+                continue;
+            }
+            HwThread& thread = *m_threads[owner->second];
+            m_thread_of.erase(owner);
+
             // Protect against underflow
-            if (m_sent_requests > 0) {
-                m_sent_requests--;
-                m_cpuRespCnt++;  // Use existing response counter
-                std::cout << "[CPU] Decremented in-flight requests to " << m_sent_requests 
-                          << "/" << m_number_of_OoO_requests << std::endl;
+            if (thread.sent_requests > 0) {
+                thread.sent_requests--;
+                if (m_logFileGenEnable) {
+                    std::cout << "[CPU] Decremented in-flight requests of thread " << thread.id << " to "
+                              << thread.sent_requests << "/" << m_number_of_OoO_requests << std::endl;
+                }
             }
-            
+            thread.respCnt++;
+            m_cpuRespCnt++;
+
             // For loads: mark as ready in ROB and LSQ
             // For stores: remove from LSQ (write confirmed)
-            if (m_rob) {
-                m_rob->commit(m_cpuMemResp.msgId);
-                std::cout << "[CPU] Request " << m_cpuMemResp.msgId 
+            thread.lsq->rxFromCache(m_cpuMemResp);
+            thread.rob->commit(m_cpuMemResp.msgId);
+            if (m_logFileGenEnable) {
+                std::cout << "[CPU] Request " << m_cpuMemResp.msgId
                           << " committed upon memory system response" << std::endl;
             }
-            if (m_lsq) {
-                m_lsq->commit(m_cpuMemResp.msgId);  // LSQ will handle based on instruction type
-                std::cout << "[CPU] LSQ notified of memory system response for request " 
+            thread.lsq->commit(m_cpuMemResp.msgId);  // LSQ will handle based on instruction type
+            if (m_logFileGenEnable) {
+                std::cout << "[CPU] LSQ notified of memory system response for request "
                           << m_cpuMemResp.msgId << std::endl;
             }
-            
+
             // Track request completion
             m_prevReqFinish = true;
             m_prevReqFinishCycle = m_cpuCycle;
         }
-        
+
         // Check if simulation is complete
-        if (m_cpuReqDone && m_cpuRespCnt >= m_cpuReqCnt) {
+        bool all_done = true;
+        for (HwThread* thread : m_threads) {
+            if (!thread->done && thread->reqDone && thread->respCnt >= thread->reqCnt) {
+                thread->done = true;
+                std::cout << "[CPU] Core " << m_coreId << " thread " << thread->id
+                          << " complete at cycle " << m_cpuCycle << std::endl;
+            }
+            all_done &= thread->done;
+        }
+
+        if (all_done) {
             m_cpuCoreSimDone = true;
-            std::cout << "\n[CPU] Core " << m_coreId << " simulation complete at cycle " 
+            std::cout << "\n[CPU] Core " << m_coreId << " simulation complete at cycle "
                       << m_cpuCycle << std::endl;
-            std::cout << "[CPU] Processed " << m_cpuReqCnt << " requests with " 
+            std::cout << "[CPU] Processed " << m_cpuReqCnt << " requests with "
                       << m_cpuRespCnt << " responses" << std::endl;
         }
     }
 
+    void CpuCoreGenerator::onInstructionRetired(uint32_t thread_id, const CpuFIFO::ReqMsg& request, uint32_t count) {
+        HwThread& thread = *m_threads[thread_id];
+        thread.sent_requests -= std::min(count, thread.sent_requests);  // Decrement in-flight count
+        thread.retired += count;
+        if (request.type == CpuFIFO::REQTYPE::COMPUTE) {
+            // Compute instructions get no memory response
+            thread.respCnt += count;
+            m_cpuRespCnt += count;
+        }
+        if (m_logFileGenEnable) {
+            std::cout << "[CPU] Instruction " << request.msgId << " retired (x" << count << ") by thread " << thread_id
+                      << ", in-flight: " << thread.sent_requests << "/" << m_number_of_OoO_requests << std::endl;
+        }
+    }
+
+    void CpuCoreGenerator::notifyRequestSentToCache(uint32_t thread_id) {
+        HwThread& thread = *m_threads[thread_id];
+        thread.sent_requests++;  // Track when request is actually sent to cache
+        if (m_logFileGenEnable) {
+            std::cout << "[CPU] Request sent to cache by thread " << thread_id << ", in-flight: "
+                      << thread.sent_requests << "/" << m_number_of_OoO_requests << std::endl;
+        }
+    }
+
+    void CpuCoreGenerator::notifyLoadForwarded(uint32_t thread_id, uint64_t msgId) {
+        HwThread& thread = *m_threads[thread_id];
+        m_thread_of.erase(msgId);
+        thread.respCnt++;  // Counts as its response, none comes from the cache
+        m_cpuRespCnt++;
+    }
+
     /**
      * @brief Main step function called each cycle
-     * 
+     *
      * Handles:
      * 1. ROB retirement
      * 2. LSQ operations
-     * 3. Processing TX and RX buffers
+     * 3. Instruction fetch
+     * 4. Processing TX and RX buffers, with address translation in between
      */
     void CpuCoreGenerator::Step(Ptr<CpuCoreGenerator> cpuCoreGenerator) {
-        std::cout << "\n[CPU] ========== Cycle " << cpuCoreGenerator->m_cpuCycle << " ==========" << std::endl;
-        
-        // Update ROB cycle
-        if (cpuCoreGenerator->m_rob) {
-            cpuCoreGenerator->m_rob->setCycle(cpuCoreGenerator->m_cpuCycle);
-            cpuCoreGenerator->m_rob->step();
-        }
-        
-        // Update LSQ cycle
-        if (cpuCoreGenerator->m_lsq) {
-            cpuCoreGenerator->m_lsq->setCycle(cpuCoreGenerator->m_cpuCycle);
-            cpuCoreGenerator->m_lsq->step();
-            
-            // First handle any cache responses
-            if (cpuCoreGenerator->m_cpuFIFO && !cpuCoreGenerator->m_cpuFIFO->m_rxFIFO.IsEmpty()) {
-                cpuCoreGenerator->m_lsq->rxFromCache();
-            }
-            
-            // Then try to send stores to cache
-            if (cpuCoreGenerator->m_cpuFIFO && !cpuCoreGenerator->m_cpuFIFO->m_txFIFO.IsFull()) {
-                cpuCoreGenerator->m_lsq->pushToCache();
-            }
+        if (cpuCoreGenerator->m_logFileGenEnable) {
+            std::cout << "\n[CPU] ========== Cycle " << cpuCoreGenerator->m_cpuCycle << " ==========" << std::endl;
+        }
+
+        for (HwThread* thread : cpuCoreGenerator->m_threads) {
+            // Update ROB cycle
+            thread->rob->setCycle(cpuCoreGenerator->m_cpuCycle);
+            thread->rob->step();
+
+            // Update LSQ cycle, it also sends requests to the cache
+            thread->lsq->setCycle(cpuCoreGenerator->m_cpuCycle);
+            thread->lsq->step();
         }
-        
-        // Process new instructions
+
+        // Fetch, then process new instructions
+        cpuCoreGenerator->ProcessFetch();
         cpuCoreGenerator->ProcessTxBuf();
+        if (cpuCoreGenerator->m_mmu) {
+            cpuCoreGenerator->m_mmu->step(cpuCoreGenerator->m_cpuCycle);
+        }
         cpuCoreGenerator->ProcessRxBuf();
+
+        // Schedule the next cycle
+        cpuCoreGenerator->m_cpuCycle++;
+        if (!cpuCoreGenerator->m_cpuCoreSimDone) {
+            Simulator::Schedule(NanoSeconds(cpuCoreGenerator->m_dt), &CpuCoreGenerator::Step, cpuCoreGenerator);
+        }
     }
 }
-
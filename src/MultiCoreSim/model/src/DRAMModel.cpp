@@ -0,0 +1,536 @@
+#include "../header/DRAMModel.h"
+
+#include <algorithm>
+#include <cmath>
+#include <stdexcept>
+
+namespace ns3
+{
+    static MemoryBackend *CreateDDR3(MCoreSimProjectXml &projectXml, CommunicationInterface *lower_interface,
+                                     int llc_id, int, const std::string &param_file)
+    {
+        return new DRAMModel(projectXml, lower_interface, llc_id, "DDR3", param_file);
+    }
+
+    static MemoryBackend *CreateDDR4(MCoreSimProjectXml &projectXml, CommunicationInterface *lower_interface,
+                                     int llc_id, int, const std::string &param_file)
+    {
+        return new DRAMModel(projectXml, lower_interface, llc_id, "DDR4", param_file);
+    }
+
+    REGISTER_MEMORY_BACKEND("DDR3", CreateDDR3);
+    REGISTER_MEMORY_BACKEND("DDR4", CreateDDR4);
+
+    // override ns3 type
+    TypeId DRAMModel::GetTypeId(void)
+    {
+        static TypeId tid = TypeId("ns3::DRAMModel").SetParent<MainMemoryController>();
+        return tid;
+    }
+
+    DRAMModel::DRAMModel(MCoreSimProjectXml &projectXml, CommunicationInterface *lower_interface, int llc_id,
+                         std::string standard, std::string param_file)
+        : MainMemoryController(projectXml, lower_interface, llc_id)
+    {
+        if (param_file.empty())
+            m_cnfg = projectXml.GetDRAMCnfg();
+        else
+        {
+            TiXmlDocument doc(param_file.c_str());
+            if (!doc.LoadFile())
+            {
+                throw std::runtime_error("DRAMModel: cannot load parameter file " + param_file);
+            }
+            m_cnfg.LoadFromXml(TiXmlHandle(doc.RootElement()), standard);
+        }
+        m_close_page = (m_cnfg.GetPagePolicy() == "CLOSE");
+        m_line_size = projectXml.GetSharedCache().GetBlockSize();
+        m_line_bits = (int)log2(m_line_size);
+
+        parseAddrMapping(m_cnfg.GetAddrMapping());
+
+        m_channels.resize(std::max(m_cnfg.GetChannels(), 1));
+        for (Channel &ch : m_channels)
+        {
+            ch.has_deferred = false;
+            ch.draining = false;
+            ch.bus_free = 0;
+            ch.next_wr = 0;
+            ch.write_cycles = 0;
+            ch.ranks.resize(std::max(m_cnfg.GetRanks(), 1));
+            for (int r = 0; r < (int)ch.ranks.size(); r++)
+            {
+                Rank &rank = ch.ranks[r];
+                rank.next_act = 0;
+                rank.next_rd = 0;
+                // Stagger the refreshes of the ranks over one tREFI
+                rank.next_refresh = (uint64_t)m_cnfg.GetTREFI() * (r + 1) / ch.ranks.size();
+                rank.refresh_until = 0;
+                rank.queued = 0;
+                rank.last_activity = 0;
+                rank.powered_down = false;
+                rank.wake_until = 0;
+                rank.banks.resize(std::max(m_cnfg.GetBanks(), 1));
+                for (Bank &bank : rank.banks)
+                {
+                    bank.open = false;
+                    bank.row = 0;
+                    bank.next_act = bank.next_pre = bank.next_rd = bank.next_wr = 0;
+                }
+            }
+        }
+
+        m_row_hits = 0;
+        m_row_misses = 0;
+        m_row_conflicts = 0;
+        m_fwd_reads = 0;
+        m_refreshes = 0;
+        m_coalesced_writes = 0;
+        m_write_induced_latency = 0;
+        m_max_write_induced_latency = 0;
+        m_refresh_stall_cycles = 0;
+        m_power_downs = 0;
+        m_power_down_cycles = 0;
+        m_read_latency = 0;
+    }
+
+    DRAMModel::~DRAMModel()
+    {
+    }
+
+    /*
+     * The mapping lists the fields from the most to the least significant
+     * bits of the line address, e.g. "RoRaBaChCo". Rank, bank, channel and
+     * column (lines per row) widths follow from the organization; the row
+     * takes all bits left above when it comes first, 16 bits otherwise.
+     */
+    void DRAMModel::parseAddrMapping(std::string mapping)
+    {
+        m_addr_fields.clear();
+        for (size_t i = 0; i + 1 < mapping.size(); i += 2)
+        {
+            std::string token = mapping.substr(i, 2);
+            if (token == "Ro")
+                m_addr_fields.push_back(std::make_pair(FIELD_ROW, (i == 0) ? 64 : 16));
+            else if (token == "Ra")
+                m_addr_fields.push_back(std::make_pair(FIELD_RANK, (int)log2(std::max(m_cnfg.GetRanks(), 1))));
+            else if (token == "Ba")
+                m_addr_fields.push_back(std::make_pair(FIELD_BANK, (int)log2(std::max(m_cnfg.GetBanks(), 1))));
+            else if (token == "Ch")
+                m_addr_fields.push_back(std::make_pair(FIELD_CHANNEL, (int)log2(std::max(m_cnfg.GetChannels(), 1))));
+            else if (token == "Co")
+                m_addr_fields.push_back(std::make_pair(FIELD_COLUMN, (int)log2(std::max(m_cnfg.GetRowBufferSize() / m_line_size, 1))));
+            else
+            {
+                throw std::runtime_error("DRAMModel: unknown field " + token + " in address mapping " + mapping);
+            }
+        }
+        std::reverse(m_addr_fields.begin(), m_addr_fields.end());
+    }
+
+    void DRAMModel::decode(uint64_t addr, Request &req)
+    {
+        uint64_t line = addr >> m_line_bits;
+        req.channel = req.rank = req.bank = 0;
+        req.row = 0;
+
+        for (size_t i = 0; i < m_addr_fields.size(); i++)
+        {
+            int bits = m_addr_fields[i].second;
+            uint64_t value = (bits >= 64) ? line : (line & ((1ULL << bits) - 1));
+            line = (bits >= 64) ? 0 : (line >> bits);
+
+            switch (m_addr_fields[i].first)
+            {
+            case FIELD_ROW:     req.row = value;          break;
+            case FIELD_RANK:    req.rank = (int)value;    break;
+            case FIELD_BANK:    req.bank = (int)value;    break;
+            case FIELD_CHANNEL: req.channel = (int)value; break;
+            case FIELD_COLUMN:                            break;
+            }
+        }
+    }
+
+    /*
+     * Put a request from the LLC into its channel's read or write queue.
+     * Returns false if that queue is full.
+     */
+    bool DRAMModel::enqueue(const Message &msg)
+    {
+        Request req;
+        req.msg.copy(msg);
+        req.is_write = (msg.data != NULL);
+        req.arrive_cycle = m_clk_cycle;
+        req.activated = false;
+        decode(msg.addr, req);
+        req.write_cycles_at_arrival = m_channels[req.channel].write_cycles;
+
+        Channel &ch = m_channels[req.channel];
+        uint64_t line = msg.addr >> m_line_bits;
+
+        if (!req.is_write)
+        {
+            // A read of a line waiting in the write queue gets its data from there
+            if (ch.write_lines.count(line) != 0)
+            {
+                m_read_count++;
+                m_fwd_reads++;
+                m_read_latency += 1;
+                m_responses.insert(std::make_pair(m_clk_cycle + 1, msg));
+                return true;
+            }
+
+            if ((int)ch.read_q.size() >= m_cnfg.GetReadQueueSize())
+                return false;
+            ch.read_q.push_back(req);
+            ch.ranks[req.rank].queued++;
+        }
+        else
+        {
+            // The newer data of a line already waiting to be written replaces the older
+            if (ch.write_lines.count(line) != 0)
+            {
+                for (Request &queued : ch.write_q)
+                {
+                    if ((queued.msg.addr >> m_line_bits) == line)
+                    {
+                        queued.msg.copy(msg.data);
+                        m_coalesced_writes++;
+                        return true;
+                    }
+                }
+            }
+
+            if ((int)ch.write_q.size() >= m_cnfg.GetWriteQueueSize())
+                return false;
+            ch.write_q.push_back(req);
+            ch.write_lines[line]++;
+            ch.ranks[req.rank].queued++;
+        }
+        return true;
+    }
+
+    /*
+     * A request whose queue is full is set aside in its channel's deferred
+     * slot, so the requests behind it still reach the other channels. The
+     * LLC is only held back once the request at its head finds that slot taken.
+     */
+    void DRAMModel::processLogic()
+    {
+        for (Channel &ch : m_channels)
+        {
+            if (ch.has_deferred && enqueue(ch.deferred))
+                ch.has_deferred = false;
+        }
+
+        Message msg;
+        while (m_lower_interface->peekMessage(&msg))
+        {
+            Request target;
+            decode(msg.addr, target);
+            Channel &ch = m_channels[target.channel];
+            if (ch.has_deferred)
+                break;
+            if (!enqueue(msg))
+            {
+                ch.deferred.copy(msg);
+                ch.has_deferred = true;
+            }
+            m_lower_interface->popFrontMessage();
+        }
+
+        for (Channel &ch : m_channels)
+            scheduleChannel(ch);
+
+        // Return the reads whose data burst has ended
+        while (!m_responses.empty() && m_responses.begin()->first <= m_clk_cycle)
+        {
+            sendReadResponse(m_responses.begin()->second);
+            m_responses.erase(m_responses.begin());
+        }
+    }
+
+    /*
+     * Refresh a rank once it is due: close its open banks, then keep it busy
+     * for tRFC. Returns true if it used the command bus this cycle.
+     */
+    bool DRAMModel::handleRefresh(Rank &rank)
+    {
+        if (m_clk_cycle < rank.refresh_until && rank.queued > 0)
+            m_refresh_stall_cycles++;
+        if (m_clk_cycle < rank.next_refresh || !rankReady(rank))
+            return false;
+
+        uint64_t ready = m_clk_cycle;
+        for (Bank &bank : rank.banks)
+        {
+            if (bank.open)
+            {
+                if (m_clk_cycle < bank.next_pre)
+                    return false;
+                precharge(rank, bank);
+                return true;
+            }
+            ready = std::max(ready, bank.next_act);
+        }
+        if (m_clk_cycle < ready)
+            return false;
+
+        rank.refresh_until = m_clk_cycle + m_cnfg.GetTRFC();
+        rank.next_refresh += m_cnfg.GetTREFI();
+        rank.last_activity = rank.refresh_until;
+        for (Bank &bank : rank.banks)
+            bank.next_act = std::max(bank.next_act, rank.refresh_until);
+        m_refreshes++;
+        return true;
+    }
+
+    /*
+     * A rank powers down once it has had no queued request and no command for
+     * PowerDownIdle cycles, and powers up (tXP) when a request for it arrives
+     * or its refresh is due.
+     */
+    void DRAMModel::updatePowerState(Rank &rank)
+    {
+        if (rank.powered_down)
+        {
+            if (rank.queued == 0 && m_clk_cycle < rank.next_refresh)
+            {
+                m_power_down_cycles++;
+                return;
+            }
+            rank.powered_down = false;
+            rank.wake_until = m_clk_cycle + m_cnfg.GetTXP();
+            rank.last_activity = m_clk_cycle;
+            return;
+        }
+
+        if (m_cnfg.GetPowerDownIdle() > 0 && rank.queued == 0 && rankReady(rank) &&
+            m_clk_cycle < rank.next_refresh && m_clk_cycle >= rank.last_activity + m_cnfg.GetPowerDownIdle())
+        {
+            rank.powered_down = true;
+            m_power_downs++;
+        }
+    }
+
+    bool DRAMModel::canActivate(Rank &rank, Bank &bank)
+    {
+        // A rank that is due for refresh opens no more rows
+        if (m_clk_cycle >= rank.next_refresh || !rankReady(rank) ||
+            m_clk_cycle < bank.next_act || m_clk_cycle < rank.next_act)
+            return false;
+        // No more than four ACTs to a rank in any tFAW window
+        return rank.act_window.size() < 4 || m_clk_cycle >= rank.act_window.front() + m_cnfg.GetTFAW();
+    }
+
+    bool DRAMModel::canIssueColumn(Channel &ch, Rank &rank, Bank &bank, bool is_write)
+    {
+        if (!rankReady(rank))
+            return false;
+        if (is_write)
+            return m_clk_cycle >= bank.next_wr && m_clk_cycle >= ch.next_wr &&
+                   ch.bus_free <= m_clk_cycle + m_cnfg.GetTCWL();
+        return m_clk_cycle >= bank.next_rd && m_clk_cycle >= rank.next_rd &&
+               ch.bus_free <= m_clk_cycle + m_cnfg.GetTCAS();
+    }
+
+    // True if a queued request other than q[skip_index] hits the row open in req's bank
+    bool DRAMModel::rowHasPendingHits(Channel &ch, const Request &req, int skip_index, bool in_write_q)
+    {
+        Bank &bank = ch.ranks[req.rank].banks[req.bank];
+        for (int q = 0; q < 2; q++)
+        {
+            std::deque<Request> &queue = (q == 0) ? ch.read_q : ch.write_q;
+            for (int i = 0; i < (int)queue.size(); i++)
+            {
+                if (i == skip_index && in_write_q == (q == 1))
+                    continue;
+                if (queue[i].rank == req.rank && queue[i].bank == req.bank && queue[i].row == bank.row)
+                    return true;
+            }
+        }
+        return false;
+    }
+
+    void DRAMModel::activate(Rank &rank, Bank &bank, uint64_t row)
+    {
+        bank.open = true;
+        bank.row = row;
+        bank.next_rd = bank.next_wr = m_clk_cycle + m_cnfg.GetTRCD();
+        bank.next_pre = std::max(bank.next_pre, m_clk_cycle + m_cnfg.GetTRAS());
+        rank.next_act = m_clk_cycle + m_cnfg.GetTRRD();
+        rank.last_activity = m_clk_cycle;
+        rank.act_window.push_back(m_clk_cycle);
+        if (rank.act_window.size() > 4)
+            rank.act_window.pop_front();
+    }
+
+    void DRAMModel::precharge(Rank &rank, Bank &bank)
+    {
+        rank.last_activity = m_clk_cycle;
+        bank.open = false;
+        bank.next_act = std::max(bank.next_act, m_clk_cycle + m_cnfg.GetTRP());
+    }
+
+    void DRAMModel::issueColumn(Channel &ch, std::deque<Request> &q, int index, bool in_write_q)
+    {
+        Request &req = q[index];
+        Rank &rank = ch.ranks[req.rank];
+        Bank &bank = rank.banks[req.bank];
+
+        if (req.activated)
+            m_row_misses++;
+        else
+            m_row_hits++;
+        rank.queued--;
+        rank.last_activity = m_clk_cycle;
+
+        if (req.is_write)
+        {
+            ch.bus_free = m_clk_cycle + m_cnfg.GetTCWL() + m_cnfg.GetTBURST();
+            rank.next_rd = std::max(rank.next_rd, ch.bus_free + m_cnfg.GetTWTR());
+            bank.next_pre = std::max(bank.next_pre, ch.bus_free + m_cnfg.GetTWR());
+            m_write_count++;
+
+            std::unordered_map<uint64_t, uint32_t>::iterator pending = ch.write_lines.find(req.msg.addr >> m_line_bits);
+            if (--pending->second == 0)
+                ch.write_lines.erase(pending);
+        }
+        else
+        {
+            ch.bus_free = m_clk_cycle + m_cnfg.GetTCAS() + m_cnfg.GetTBURST();
+            ch.next_wr = std::max(ch.next_wr, m_clk_cycle + m_cnfg.GetTRTW());
+            bank.next_pre = std::max(bank.next_pre, m_clk_cycle + m_cnfg.GetTRTP());
+            m_read_count++;
+            m_read_latency += ch.bus_free - req.arrive_cycle;
+
+            uint64_t write_induced = ch.write_cycles - req.write_cycles_at_arrival;
+            m_write_induced_latency += write_induced;
+            m_max_write_induced_latency = std::max(m_max_write_induced_latency, write_induced);
+            m_responses.insert(std::make_pair(ch.bus_free, req.msg));
+        }
+
+        // Closed page: auto-precharge unless another queued request wants this row
+        if (m_close_page && !rowHasPendingHits(ch, req, index, in_write_q))
+        {
+            bank.open = false;
+            bank.next_act = std::max(bank.next_act, bank.next_pre + m_cnfg.GetTRP());
+        }
+
+        q.erase(q.begin() + index);
+    }
+
+    /*
+     * FR-FCFS: the oldest row hit whose column command can issue goes first,
+     * otherwise the oldest request whose ACT or PRE can issue. A row is not
+     * closed while requests that hit it are queued.
+     */
+    void DRAMModel::scheduleChannel(Channel &ch)
+    {
+        for (Rank &rank : ch.ranks)
+            updatePowerState(rank);
+
+        for (Rank &rank : ch.ranks)
+        {
+            if (handleRefresh(rank))
+                return;
+        }
+
+        if (!ch.draining && (int)ch.write_q.size() >= m_cnfg.GetWriteHighWatermark())
+            ch.draining = true;
+        else if (ch.draining && (int)ch.write_q.size() <= m_cnfg.GetWriteLowWatermark())
+            ch.draining = false;
+
+        bool writes = ch.draining || (ch.read_q.empty() && !ch.write_q.empty());
+        std::deque<Request> &q = writes ? ch.write_q : ch.read_q;
+        if (writes && !ch.read_q.empty())
+            ch.write_cycles++;
+
+        for (int i = 0; i < (int)q.size(); i++)
+        {
+            Rank &rank = ch.ranks[q[i].rank];
+            Bank &bank = rank.banks[q[i].bank];
+            if (bank.open && bank.row == q[i].row && canIssueColumn(ch, rank, bank, q[i].is_write))
+            {
+                issueColumn(ch, q, i, writes);
+                return;
+            }
+        }
+
+        for (int i = 0; i < (int)q.size(); i++)
+        {
+            Rank &rank = ch.ranks[q[i].rank];
+            Bank &bank = rank.banks[q[i].bank];
+            if (!rankReady(rank) || (bank.open && bank.row == q[i].row))
+                continue;
+
+            if (!bank.open)
+            {
+                if (canActivate(rank, bank))
+                {
+                    activate(rank, bank, q[i].row);
+                    q[i].activated = true;
+                    return;
+                }
+            }
+            else if (m_clk_cycle >= bank.next_pre && !rowHasPendingHits(ch, q[i], i, writes))
+            {
+                precharge(rank, bank);
+                m_row_conflicts++;
+                return;
+            }
+        }
+    }
+
+    void DRAMModel::printStats(std::ostream &out)
+    {
+        uint64_t accesses = m_row_hits + m_row_misses;
+        double elapsed_ns = m_clk_cycle * m_dt;
+        uint64_t bytes = accesses * m_line_size;
+
+        out << "DRAM reads = " << m_read_count << " (" << m_fwd_reads << " from the write queue)"
+            << ", writes = " << m_write_count << endl;
+        out << "DRAM row hits = " << m_row_hits << ", row misses = " << m_row_misses
+            << ", row conflicts = " << m_row_conflicts
+            << ", row-hit rate = " << ((accesses > 0) ? (double)m_row_hits / accesses * 100 : 0.0) << "%" << endl;
+        out << "DRAM avg read latency = " << ((m_read_count > 0) ? (double)m_read_latency / m_read_count : 0.0)
+            << " cycles, refreshes = " << m_refreshes
+            << ", bandwidth = " << ((elapsed_ns > 0) ? bytes / elapsed_ns : 0.0) << " GB/s" << endl;
+
+        uint64_t rank_cycles = m_clk_cycle * m_cnfg.GetChannels() * m_cnfg.GetRanks();
+        out << "DRAM refresh stall cycles = " << m_refresh_stall_cycles << ", power-down entries = " << m_power_downs
+            << ", power-down residency = " << ((rank_cycles > 0) ? (double)m_power_down_cycles / rank_cycles * 100 : 0.0)
+            << "%" << endl;
+        out << "DRAM coalesced writes = " << m_coalesced_writes << ", avg write-induced read latency = "
+            << ((m_read_count > 0) ? (double)m_write_induced_latency / m_read_count : 0.0)
+            << " cycles, max = " << m_max_write_induced_latency << " cycles" << endl;
+    }
+
+    void DRAMModel::registerStats(StatsRegistry &stats)
+    {
+        stats.add("DRAM reads", &m_read_count);
+        stats.add("DRAM reads from the write queue", &m_fwd_reads);
+        stats.add("DRAM writes", &m_write_count);
+        stats.add("DRAM row hits", &m_row_hits);
+        stats.add("DRAM row misses", &m_row_misses);
+        stats.add("DRAM row conflicts", &m_row_conflicts);
+        stats.add("DRAM row-hit rate", [this]() { return StatsRegistry::Ratio(m_row_hits, m_row_hits + m_row_misses) * 100; });
+        stats.add("DRAM avg read latency", [this]() { return StatsRegistry::Ratio(m_read_latency, m_read_count); });
+        stats.add("DRAM refreshes", &m_refreshes);
+        stats.add("DRAM bandwidth", [this]()
+        {
+            double elapsed_ns = m_clk_cycle * m_dt;
+            return (elapsed_ns > 0) ? (m_row_hits + m_row_misses) * m_line_size / elapsed_ns : 0.0;
+        });
+        stats.add("DRAM refresh stall cycles", &m_refresh_stall_cycles);
+        stats.add("DRAM power-down entries", &m_power_downs);
+        stats.add("DRAM power-down residency", [this]()
+        {
+            return StatsRegistry::Ratio(m_power_down_cycles, m_clk_cycle * m_cnfg.GetChannels() * m_cnfg.GetRanks()) * 100;
+        });
+        stats.add("DRAM coalesced writes", &m_coalesced_writes);
+        stats.add("DRAM avg write-induced read latency",
+                  [this]() { return StatsRegistry::Ratio(m_write_induced_latency, m_read_count); });
+        stats.add("DRAM max write-induced read latency", &m_max_write_induced_latency);
+    }
+}
@@ -8,12 +8,17 @@
 
 #include "../header/FSMReader.h"
 
+#ifdef NS3_MULTICORESIM_COMPILED_FSM
+#include "ns3/CompiledFSMTables.h"
+#endif
+
 using namespace std;
 namespace ns3
 {
     FSMReader::FSMReader(const string &fsmPath)
     {
         string line;
+        vector<FSMState> states;
         ifstream fsmFile(fsmPath);
 
         if (!fsmFile.is_open())
@@ -31,11 +36,82 @@ namespace ns3
             else if (line.find(STATE_CSV_ID) < string::npos)
                 this->parseFile(fsmFile, this->m_stateIds);
             else if (line.find(STATE_CSV_TABLE) < string::npos)
-                this->parseFile(fsmFile, this->m_states);
+                this->parseFile(fsmFile, states);
         }
         fsmFile.close();
+
+        this->compile(states);
+    }
+
+    FSMReader::FSMReader(const CompiledFSM &fsm)
+    {
+        for (int i = 0; i < fsm.event_id_count; i++)
+            m_eventIds[fsm.event_ids[i].name] = fsm.event_ids[i].value;
+        for (int i = 0; i < fsm.action_id_count; i++)
+            m_actionIds[fsm.action_ids[i].name] = fsm.action_ids[i].value;
+        for (int i = 0; i < fsm.state_id_count; i++)
+            m_stateIds[fsm.state_ids[i].name] = fsm.state_ids[i].value;
+
+        m_state_count = fsm.state_count;
+        m_event_count = fsm.event_count;
+
+        // The generated tables are static, so the ActionList views point straight into them
+        this->buildTable(fsm.action_pool, fsm.transitions, fsm.state_info);
     }
 
+    FSMReader *FSMReader::create(const string &fsmPath)
+    {
+        const CompiledFSM *fsm = findCompiledFSM(fsmPath);
+        if (fsm != NULL)
+            return new FSMReader(*fsm);
+        return new FSMReader(fsmPath);
+    }
+
+#ifdef NS3_MULTICORESIM_COMPILED_FSM
+    // 64-bit FNV-1a, as computed by utils/generate-fsm-tables.py
+    static unsigned long long ContentHash(const string &data)
+    {
+        unsigned long long hash = 0xcbf29ce484222325ULL;
+        for (unsigned char byte : data)
+            hash = (hash ^ byte) * 0x100000001b3ULL;
+        return hash;
+    }
+
+    // The table is found by the protocol's CSV name, so a run needs no CSV
+    // files. A CSV at fsmPath that differs from the one the table was
+    // generated from (edited since the build, or another protocol of the
+    // same name) overrides the table and is parsed instead.
+    const CompiledFSM *FSMReader::findCompiledFSM(const string &fsmPath)
+    {
+        string file_name = fsmPath.substr(fsmPath.find_last_of('/') + 1);
+        const CompiledFSM *table = NULL;
+        for (int i = 0; compiled_fsm_tables[i] != NULL && table == NULL; i++)
+        {
+            if (file_name == compiled_fsm_tables[i]->file_name)
+                table = compiled_fsm_tables[i];
+        }
+        if (table == NULL)
+            return NULL;
+
+        ifstream fsmFile(fsmPath, ios::binary);
+        if (!fsmFile.is_open())
+            return table;
+        stringstream content;
+        content << fsmFile.rdbuf();
+        if (ContentHash(content.str()) != table->content_hash)
+        {
+            cout << "FSMReader: " << fsmPath << " differs from the compiled " << file_name << ", using the CSV" << endl;
+            return NULL;
+        }
+        return table;
+    }
+#else
+    const CompiledFSM *FSMReader::findCompiledFSM(const string &)
+    {
+        return NULL;
+    }
+#endif
+
     void FSMReader::parseFile(ifstream &file, map<string, int> &ids)
     {
         string line;
@@ -57,58 +133,97 @@ namespace ns3
     {
         string line;
         while (getline(file, line))
-            states.push_back(FSMState(line, this->m_eventIds, this->m_actionIds, this->m_stateIds));
+            states.push_back(FSMState(line, this->m_actionIds, this->m_stateIds));
     }
 
-    int FSMReader::getState(const std::string &state_name)
+    void FSMReader::compile(vector<FSMState> &states)
     {
-        return m_stateIds[state_name];
-    }
+        m_state_count = (int)states.size();
+        m_event_count = (int)m_eventIds.size();
 
-    void FSMReader::getTransition(int current_state, int event, int& out_next_state, std::vector<int>& out_actions)
-    {
-        out_next_state = this->m_states[current_state].getNextState(event);
-        out_actions = this->m_states[current_state].getActions(event);
-    }
+        vector<CompiledFSM::Transition> cells(m_state_count * m_event_count);
+        vector<CompiledFSM::StateInfo> state_info(m_state_count);
 
-    bool FSMReader::isValidState(int state)
-    {
-        return this->m_states[state].is_data_valid;
+        for (int s = 0; s < m_state_count; s++)
+        {
+            state_info[s].stable = states[s].stable;
+            state_info[s].is_data_valid = states[s].is_data_valid;
+
+            for (int e = 0; e < m_event_count; e++)
+            {
+                CompiledFSM::Transition &cell = cells[s * m_event_count + e];
+                const vector<int> &actions = states[s].getActions(e);
+
+                cell.next_state = states[s].getNextState(e);
+                cell.action_offset = (int)m_action_pool.size();
+                cell.action_count = (int)actions.size();
+                m_action_pool.insert(m_action_pool.end(), actions.begin(), actions.end());
+            }
+        }
+
+        // m_action_pool is not touched after this point, so the ActionList views stay valid
+        this->buildTable(m_action_pool.data(), cells.data(), state_info.data());
     }
 
-    bool FSMReader::isHit(int state, int Event)
+    void FSMReader::buildTable(const int *action_pool, const CompiledFSM::Transition *cells,
+                               const CompiledFSM::StateInfo *state_info)
     {
-        vector<int> actions = this->m_states[state].getActions(Event);
-        int hit_id = this->m_actionIds["Hit"];
-        for(int action : actions)
+        map<string, int>::const_iterator it;
+        int hit_id = ((it = m_actionIds.find("Hit")) != m_actionIds.end()) ? it->second : -1;
+        int stall_id = ((it = m_actionIds.find("Stall")) != m_actionIds.end()) ? it->second : -1;
+
+        m_table.resize(m_state_count * m_event_count);
+        m_state_valid.resize(m_state_count);
+        m_state_stable.resize(m_state_count);
+
+        for (int s = 0; s < m_state_count; s++)
         {
-            if(action == hit_id)
-                return true;
+            m_state_valid[s] = state_info[s].is_data_valid;
+            m_state_stable[s] = state_info[s].stable;
         }
-        return false;
-    }
 
-    bool FSMReader::isStall(int state, int Event)
-    {
-        vector<int> actions = this->m_states[state].getActions(Event);
-        int stall_id = this->m_actionIds["Stall"];
-        for(int action : actions)
+        for (int i = 0; i < m_state_count * m_event_count; i++)
         {
-            if(action == stall_id)
-                return true;
+            Transition &transition = m_table[i];
+            const int *first = action_pool + cells[i].action_offset;
+
+            transition.next_state = cells[i].next_state;
+            transition.actions = ActionList(first, cells[i].action_count);
+            transition.action_mask = 0;
+            transition.is_hit = false;
+            transition.is_stall = false;
+
+            for (int action : transition.actions)
+            {
+                if (action >= 0 && action < 64)
+                    transition.action_mask |= (uint64_t)1 << action;
+                transition.is_hit |= (action == hit_id);
+                transition.is_stall |= (action == stall_id);
+            }
         }
-        return false;
     }
 
-    bool FSMReader::isStable(int state)
+    int FSMReader::getState(const std::string &state_name)
+    {
+        return m_stateIds[state_name];
+    }
+
+    int FSMReader::getEvent(const std::string &event_name) const
+    {
+        map<string, int>::const_iterator it = m_eventIds.find(event_name);
+        return (it != m_eventIds.end()) ? it->second : -1;
+    }
+
+    int FSMReader::getAction(const std::string &action_name) const
     {
-        return this->m_states[state].stable;
+        map<string, int>::const_iterator it = m_actionIds.find(action_name);
+        return (it != m_actionIds.end()) ? it->second : -1;
     }
 
     /****************************************************** FSMReader::FSMState ******************************************************/
 
-    FSMReader::FSMState::FSMState(const string &line, const map<string, int> &eventIds,
-                                  const map<string, int> &actionIds, const map<string, int> &stateIds)
+    FSMReader::FSMState::FSMState(const string &line, const map<string, int> &actionIds,
+                                  const map<string, int> &stateIds)
     {
         stringstream str_stream(line);
         string field;
@@ -1,251 +1,515 @@
 #include "../header/LSQ.h"
 #include "../header/ROB.h"
 #include "../header/CpuCoreGenerator.h"
+#include <stdexcept>
+#include <cstdint>
+#include <sstream>
 
 namespace ns3 {
 
-LSQ::LSQ() 
-    : m_num_entries(0), 
-      m_cpuFIFO(nullptr), 
+LSQ::LSQ(uint32_t max_loads, uint32_t max_stores, uint32_t cache_ports)
+    : m_max_loads(0),
+      m_max_stores(0),
+      m_cache_ports(0),
+      m_num_loads(0),
+      m_num_stores(0),
+      m_last_allocated(0),
+      m_cpuFIFO(nullptr),
       m_rob(nullptr),
-      m_current_cycle(0) {
-    m_lsq_q.reserve(MAX_ENTRIES);
-    std::cout << "[LSQ] Initialized with " << MAX_ENTRIES << " entries capacity" << std::endl;
+      m_current_cycle(0),
+      m_debug(false),
+      m_fwd_hits(0),
+      m_loads_sent(0),
+      m_stores_sent(0),
+      m_blocked_loads(0),
+      m_blocked_stores(0),
+      m_port_stalls(0),
+      m_blocked_load_cycle(UINT64_MAX),
+      m_blocked_store_cycle(UINT64_MAX),
+      m_port_stall_cycle(UINT64_MAX),
+      m_rmws_sent(0),
+      m_rmw_latency(0),
+      m_rmw_drain_cycles(0),
+      m_fence_stalls(0),
+      m_fence_stall_cycle(UINT64_MAX),
+      m_sent_cycle(0),
+      m_sent_this_cycle(0) {
+    configure(max_loads, max_stores, cache_ports);
 }
 
 LSQ::~LSQ() {}
 
+void LSQ::configure(uint32_t max_loads, uint32_t max_stores, uint32_t cache_ports) {
+    if (!m_entries.empty()) {
+        std::cerr << "[LSQ] ERROR: Cannot resize a non-empty LSQ" << std::endl;
+        throw std::runtime_error("LSQ resized while in use");
+    }
+
+    m_max_loads = (max_loads > 0) ? max_loads : DEFAULT_LOAD_ENTRIES;
+    m_max_stores = (max_stores > 0) ? max_stores : DEFAULT_STORE_ENTRIES;
+    m_cache_ports = (cache_ports > 0) ? cache_ports : DEFAULT_CACHE_PORTS;
+    m_entries.reserve(m_max_loads + m_max_stores);
+
+    std::cout << "[LSQ] Initialized with " << m_max_loads << " load and " << m_max_stores
+              << " store entries capacity, " << m_cache_ports << " cache port(s)" << std::endl;
+}
+
 void LSQ::step() {
-    std::cout << "\n[LSQ] Step at cycle " << m_current_cycle << std::endl;
-    std::cout << "[LSQ] Current entries: " << m_num_entries << "/" << MAX_ENTRIES << std::endl;
-    
-    // As per 3.3, handle memory operations every cycle
+    if (m_debug) {
+        std::cout << "\n[LSQ] Step at cycle " << m_current_cycle << std::endl;
+        std::cout << "[LSQ] Current entries: loads " << m_num_loads << "/" << m_max_loads
+                  << ", stores " << m_num_stores << "/" << m_max_stores << std::endl;
+    }
+
+    // As per 3.3, handle memory operations every cycle. Cache responses are
+    // read by the core, which hands each one to the LSQ of its thread.
     pushToCache();  // Try to send stores to cache
-    rxFromCache();  // Handle cache responses
     retire();       // Remove completed operations
 }
 
-bool LSQ::canAccept() {
-    bool can_accept = m_num_entries < MAX_ENTRIES;
-    std::cout << "[LSQ] Can accept new entry: " << (can_accept ? "yes" : "no") 
-              << " (" << m_num_entries << "/" << MAX_ENTRIES << ")" << std::endl;
+bool LSQ::canAccept(CpuFIFO::REQTYPE type) {
+    bool is_store = usesStoreEntry(type);
+    bool can_accept = is_store ? (m_num_stores < m_max_stores) : (m_num_loads < m_max_loads);
+    if (m_debug) {
+        std::cout << "[LSQ] Can accept new " << (is_store ? "store" : "load") << ": " << (can_accept ? "yes" : "no")
+                  << " (" << (is_store ? m_num_stores : m_num_loads) << "/"
+                  << (is_store ? m_max_stores : m_max_loads) << ")" << std::endl;
+    }
+    // The core asks again every cycle it stays blocked, count each cycle once
+    if (!can_accept) {
+        if (is_store && m_blocked_store_cycle != m_current_cycle) {
+            m_blocked_stores++;
+            m_blocked_store_cycle = m_current_cycle;
+        } else if (!is_store && m_blocked_load_cycle != m_current_cycle) {
+            m_blocked_loads++;
+            m_blocked_load_cycle = m_current_cycle;
+        }
+    }
     return can_accept;
 }
 
 bool LSQ::allocate(const CpuFIFO::ReqMsg& request) {
-    if (!canAccept()) {
-        std::cout << "[LSQ] Allocation failed - LSQ full" << std::endl;
+    bool is_store = usesStoreEntry(request.type);
+    if ((is_store && m_num_stores >= m_max_stores) || (!is_store && m_num_loads >= m_max_loads)) {
+        if (m_debug) {
+            std::cout << "[LSQ] Allocation failed - " << (is_store ? "store" : "load") << " queue full" << std::endl;
+        }
         return false;
     }
-    
-    LSQEntry entry;
+
+    LSQEntry& entry = m_entries[request.msgId];
     entry.request = request;
     entry.ready = false;
     entry.waitingForCache = false;
     entry.cache_ack = false;
-    
+    entry.allocate_cycle = m_current_cycle;
+    entry.sent_cycle = 0;
+    m_last_allocated = request.msgId;
+    m_order.insert(request.msgId);
+
+    // An atomic takes a store entry, but the core waits for its result like a load
+    if (request.type == CpuFIFO::REQTYPE::RMW) {
+        m_rmw_q.push_back(request.msgId);
+        m_num_stores++;
+    }
     // As per 3.3.2: Store Instructions commit by the time you allocate them in the LSQ
     // Rationale: stores are not critical to CPU pipeline since CPU is not waiting for data
-    if (request.type == CpuFIFO::REQTYPE::WRITE) {
+    else if (is_store) {
         entry.ready = true;
-        std::cout << "[LSQ] Store ready immediately (CPU not waiting for data)" << std::endl;
+        if (m_debug) {
+            std::cout << "[LSQ] Store ready immediately (CPU not waiting for data)" << std::endl;
+        }
         if (m_rob) {
             m_rob->commit(request.msgId);
         }
+        m_store_q.push_back(request.msgId);
+        m_store_addrs[request.addr]++;
+        m_num_stores++;
     }
     // As per 3.3.3: For loads, check store forwarding first
-    else if (request.type == CpuFIFO::REQTYPE::READ) {
+    else {
         // Check for store-to-load forwarding
         if (ldFwd(request.addr)) {
             entry.ready = true;
-            std::cout << "[LSQ] Load ready immediately due to store forwarding" << std::endl;
+            m_fwd_hits++;
+            m_completed.push_back(request.msgId);
+            if (m_debug) {
+                std::cout << "[LSQ] Load ready immediately due to store forwarding" << std::endl;
+            }
             if (m_rob) {
                 m_rob->commit(request.msgId);
             }
+        } else {
+            m_waiting_loads[request.addr].push_back(request.msgId);
         }
+        m_load_q.push_back(request.msgId);
+        m_num_loads++;
+    }
+
+    if (m_debug) {
+        std::cout << "[LSQ] Allocated "
+                  << typeName(request.type)
+                  << " request " << request.msgId
+                  << " addr=0x" << std::hex << request.addr << std::dec
+                  << " ready=" << entry.ready << std::endl;
     }
-    
-    m_lsq_q.push_back(entry);
-    m_num_entries++;
-    
-    std::cout << "[LSQ] Allocated " 
-              << (request.type == CpuFIFO::REQTYPE::READ ? "load" : "store")
-              << " request " << request.msgId 
-              << " addr=0x" << std::hex << request.addr << std::dec 
-              << " ready=" << entry.ready << std::endl;
     return true;
 }
 
+void LSQ::removeLastEntry() {
+    auto it = m_entries.find(m_last_allocated);
+    if (it == m_entries.end()) {
+        return;
+    }
+
+    const CpuFIFO::ReqMsg& request = it->second.request;
+    if (request.type == CpuFIFO::REQTYPE::RMW) {
+        if (!m_rmw_q.empty() && m_rmw_q.back() == request.msgId) {
+            m_rmw_q.pop_back();
+        }
+        m_num_stores--;
+    } else if (request.type == CpuFIFO::REQTYPE::WRITE) {
+        if (!m_store_q.empty() && m_store_q.back() == request.msgId) {
+            m_store_q.pop_back();
+        }
+        if (--m_store_addrs[request.addr] == 0) {
+            m_store_addrs.erase(request.addr);
+        }
+        m_num_stores--;
+    } else {
+        if (!m_load_q.empty() && m_load_q.back() == request.msgId) {
+            m_load_q.pop_back();
+        }
+        removeWaitingLoad(request);
+        m_num_loads--;
+    }
+    // A forwarded load may already be on the completed list; retire() skips missing entries
+    m_order.erase(m_last_allocated);
+    m_entries.erase(it);
+}
+
+void LSQ::removeWaitingLoad(const CpuFIFO::ReqMsg& request) {
+    auto it = m_waiting_loads.find(request.addr);
+    if (it == m_waiting_loads.end()) {
+        return;
+    }
+
+    std::vector<uint64_t>& loads = it->second;
+    for (size_t i = 0; i < loads.size(); i++) {
+        if (loads[i] == request.msgId) {
+            loads.erase(loads.begin() + i);
+            break;
+        }
+    }
+    if (loads.empty()) {
+        m_waiting_loads.erase(it);
+    }
+}
+
+void LSQ::markLoadReady(LSQEntry& entry) {
+    entry.ready = true;
+    m_completed.push_back(entry.request.msgId);
+    if (m_rob) {
+        m_rob->commit(entry.request.msgId);
+    }
+}
+
 bool LSQ::ldFwd(uint64_t address) {
-    std::cout << "[LSQ] Checking store-to-load forwarding for address 0x" 
-              << std::hex << address << std::dec << std::endl;
-              
+    if (m_debug) {
+        std::cout << "[LSQ] Checking store-to-load forwarding for address 0x"
+                  << std::hex << address << std::dec << std::endl;
+    }
+
+    // A pending atomic is older than any load being checked, and nothing passes it
+    if (!m_rmw_q.empty()) {
+        if (m_debug) {
+            std::cout << "[LSQ] No forwarding while an atomic is pending" << std::endl;
+        }
+        return false;
+    }
+
     // As per 3.3.3 case 2: Check for store-to-load forwarding
-    bool found_store = false;
-    for (auto it = m_lsq_q.rbegin(); it != m_lsq_q.rend(); ++it) {
-        if (it->request.type == CpuFIFO::REQTYPE::WRITE && 
-            it->request.addr == address) {
-            
-            std::cout << "[LSQ] Found matching store (ID " << it->request.msgId 
-                      << ") for forwarding" << std::endl;
-            
-            // Mark all subsequent loads to this address as ready
-            for (auto& entry : m_lsq_q) {
-                if (entry.request.type == CpuFIFO::REQTYPE::READ &&
-                    entry.request.addr == address &&
-                    !entry.ready) {
-                    entry.ready = true;
-                    std::cout << "[LSQ] Marking load " << entry.request.msgId 
-                              << " ready through store forwarding" << std::endl;
-                    if (m_rob) {
-                        m_rob->commit(entry.request.msgId);
-                    }
-                }
+    if (m_store_addrs.find(address) == m_store_addrs.end()) {
+        if (m_debug) {
+            std::cout << "[LSQ] No matching store found for forwarding" << std::endl;
+        }
+        return false;
+    }
+
+    if (m_debug) {
+        std::cout << "[LSQ] Found matching store for forwarding" << std::endl;
+    }
+
+    // Mark all loads to this address that are still waiting as ready
+    auto it = m_waiting_loads.find(address);
+    if (it != m_waiting_loads.end()) {
+        for (uint64_t msgId : it->second) {
+            LSQEntry& entry = m_entries[msgId];
+            if (m_debug) {
+                std::cout << "[LSQ] Marking load " << msgId
+                          << " ready through store forwarding" << std::endl;
             }
-            found_store = true;
-            break;  // Only need youngest matching store
+            markLoadReady(entry);
+            m_fwd_hits++;
         }
+        m_waiting_loads.erase(it);
+    }
+    return true;
+}
+
+void LSQ::sendToCache(LSQEntry& entry) {
+    entry.waitingForCache = true;
+    entry.sent_cycle = m_current_cycle;
+    m_cpuFIFO->m_txFIFO.InsertElement(entry.request);
+    if (m_rob && m_rob->getCpu()) {
+        m_rob->getCpu()->notifyRequestSentToCache(m_rob->getThread());
+    }
+    m_sent_this_cycle++;
+    if (m_debug) {
+        std::cout << "[LSQ] Sent " << typeName(entry.request.type)
+                  << " request " << entry.request.msgId
+                  << " to cache (addr=0x" << std::hex << entry.request.addr
+                  << std::dec << ")" << std::endl;
     }
-    
-    if (!found_store) {
-        std::cout << "[LSQ] No matching store found for forwarding" << std::endl;
+}
+
+void LSQ::dropSatisfiedLoads() {
+    // Loads that store forwarding satisfied before they were sent never go to the cache
+    while (!m_load_q.empty()) {
+        auto it = m_entries.find(m_load_q.front());
+        if (it != m_entries.end() && !it->second.ready) {
+            break;
+        }
+        if (m_rob && m_rob->getCpu()) {
+            m_rob->getCpu()->notifyLoadForwarded(m_rob->getThread(), m_load_q.front());
+        }
+        m_load_q.pop_front();
     }
-    return found_store;
 }
 
 void LSQ::pushToCache() {
     // Check FIFO availability first
-    if (!m_cpuFIFO || m_cpuFIFO->m_txFIFO.IsFull()) {
-        std::cout << "[LSQ] Cannot push to cache - FIFO full or not connected" << std::endl;
+    if (!m_cpuFIFO) {
+        if (m_debug) {
+            std::cout << "[LSQ] Cannot push to cache - FIFO not connected" << std::endl;
+        }
         return;
     }
 
-    // Check for store operations ready to be sent to cache
-    for (auto& entry : m_lsq_q) {
-        if (entry.request.type == CpuFIFO::REQTYPE::WRITE && !entry.waitingForCache) {
-            // Send store to cache
-            entry.waitingForCache = true;
-            m_cpuFIFO->m_txFIFO.InsertElement(entry.request);
-            if (m_rob && m_rob->getCpu()) {
-                m_rob->getCpu()->notifyRequestSentToCache();
+    // pushToCache may run several times in a cycle, the ports are shared by all of them
+    if (m_sent_cycle != m_current_cycle) {
+        m_sent_cycle = m_current_cycle;
+        m_sent_this_cycle = 0;
+    }
+
+    dropSatisfiedLoads();
+
+    while (true) {
+        // Nothing younger than the oldest pending atomic may go to the cache
+        uint64_t fence = m_rmw_q.empty() ? UINT64_MAX : m_rmw_q.front();
+        bool send_rmw = (fence != UINT64_MAX && !m_entries[fence].waitingForCache && *m_order.begin() == fence);
+        bool send_store = !send_rmw && !m_store_q.empty() && m_store_q.front() < fence;
+        bool send_load = !send_rmw && !send_store && !m_load_q.empty() && m_load_q.front() < fence;
+        if (!send_rmw && !send_store && !send_load) {
+            if (fence != UINT64_MAX && (!m_store_q.empty() || !m_load_q.empty()) &&
+                m_fence_stall_cycle != m_current_cycle) {
+                m_fence_stalls++;
+                m_fence_stall_cycle = m_current_cycle;
             }
-            std::cout << "[LSQ] Sent store request " << entry.request.msgId 
-                      << " to cache (addr=0x" << std::hex << entry.request.addr 
-                      << std::dec << ")" << std::endl;
-            return;  // Only send one request per cycle
+            return;
         }
-    }
 
-    // Check for load operations ready to be sent to cache
-    for (auto& entry : m_lsq_q) {
-        if (entry.request.type == CpuFIFO::REQTYPE::READ && !entry.waitingForCache && !entry.ready) {
-            // Only send loads that haven't been satisfied by forwarding
-            entry.waitingForCache = true;
-            m_cpuFIFO->m_txFIFO.InsertElement(entry.request);
-            if (m_rob && m_rob->getCpu()) {
-                m_rob->getCpu()->notifyRequestSentToCache();
+        if (m_sent_this_cycle >= m_cache_ports || m_cpuFIFO->m_txFIFO.IsFull()) {
+            if (m_debug) {
+                std::cout << "[LSQ] Cannot push to cache - no cache port or FIFO slot left this cycle" << std::endl;
+            }
+            if (m_port_stall_cycle != m_current_cycle) {
+                m_port_stalls++;
+                m_port_stall_cycle = m_current_cycle;
             }
-            std::cout << "[LSQ] Sent load request " << entry.request.msgId 
-                      << " to cache (addr=0x" << std::hex << entry.request.addr 
-                      << std::dec << ")" << std::endl;
-            return;  // Only send one request per cycle
+            return;
+        }
+
+        // An atomic goes once everything older has left the LSQ, then stores before loads
+        if (send_rmw) {
+            LSQEntry& entry = m_entries[fence];
+            m_rmw_drain_cycles += m_current_cycle - entry.allocate_cycle;
+            sendToCache(entry);
+            m_rmws_sent++;
+        } else if (send_store) {
+            sendToCache(m_entries[m_store_q.front()]);
+            m_store_q.pop_front();
+            m_stores_sent++;
+        } else {
+            sendToCache(m_entries[m_load_q.front()]);
+            m_load_q.pop_front();
+            m_loads_sent++;
         }
+
+        dropSatisfiedLoads();
     }
 }
 
-void LSQ::rxFromCache() {
-    // Check FIFO availability first
-    if (!m_cpuFIFO || m_cpuFIFO->m_rxFIFO.IsEmpty()) {
-        return;
+void LSQ::rxFromCache(const CpuFIFO::RespMsg& response) {
+    if (m_debug) {
+        std::cout << "[LSQ] Received cache response for request " << response.msgId
+                  << " (addr=0x" << std::hex << response.addr << std::dec << ")" << std::endl;
     }
-    
-    // Process one response per cycle as per original design
-    auto response = m_cpuFIFO->m_rxFIFO.GetFrontElement();
-    m_cpuFIFO->m_rxFIFO.PopElement();
-    
-    std::cout << "[LSQ] Received cache response for request " << response.msgId 
-              << " (addr=0x" << std::hex << response.addr << std::dec << ")" << std::endl;
-    
+
     // Find matching request in LSQ
-    for (auto& entry : m_lsq_q) {
-        if (entry.request.msgId == response.msgId) {
-            if (entry.request.type == CpuFIFO::REQTYPE::READ) {
-                // Case 1 from 3.3.3: Load commits when data comes back from memory
-                entry.ready = true;
-                entry.waitingForCache = false;
-                std::cout << "[LSQ] Load data received from memory, marking ready" << std::endl;
-                if (m_rob) {
-                    m_rob->commit(entry.request.msgId);
-                }
-            } else if (entry.request.type == CpuFIFO::REQTYPE::WRITE) {
-                // For stores: mark cache write as acknowledged (for retirement)
-                entry.cache_ack = true;
-                entry.waitingForCache = false;
-                std::cout << "[LSQ] Store write acknowledged by cache" << std::endl;
-            }
-            break;
+    auto it = m_entries.find(response.msgId);
+    if (it == m_entries.end()) {
+        return;
+    }
+
+    LSQEntry& entry = it->second;
+    entry.waitingForCache = false;
+    if (entry.request.type == CpuFIFO::REQTYPE::READ) {
+        // Case 1 from 3.3.3: Load commits when data comes back from memory
+        if (m_debug) {
+            std::cout << "[LSQ] Load data received from memory, marking ready" << std::endl;
+        }
+        if (!entry.ready) {
+            removeWaitingLoad(entry.request);
+            markLoadReady(entry);
+        }
+    } else if (entry.request.type == CpuFIFO::REQTYPE::RMW) {
+        // The atomic has its result and the line written; the fence lifts
+        if (m_debug) {
+            std::cout << "[LSQ] Atomic completed by cache, marking ready" << std::endl;
+        }
+        m_rmw_latency += m_current_cycle - entry.sent_cycle;
+        entry.cache_ack = true;
+        markLoadReady(entry);
+        if (!m_rmw_q.empty() && m_rmw_q.front() == entry.request.msgId) {
+            m_rmw_q.pop_front();
+        }
+    } else if (entry.request.type == CpuFIFO::REQTYPE::WRITE) {
+        // For stores: mark cache write as acknowledged (for retirement)
+        entry.cache_ack = true;
+        m_completed.push_back(entry.request.msgId);
+        if (m_debug) {
+            std::cout << "[LSQ] Store write acknowledged by cache" << std::endl;
         }
     }
 }
 
 void LSQ::retire() {
-    if (m_lsq_q.empty()) return;
-    
-    // As per 3.4.1: LSQ retire has different semantics - just removes entries
-    auto it = m_lsq_q.begin();
-    while (it != m_lsq_q.end()) {
-        bool can_remove = false;
-        
-        if (it->request.type == CpuFIFO::REQTYPE::READ) {
-            // For loads: remove when ready (either from cache or forwarding)
-            can_remove = it->ready;
-            if (can_remove) {
-                std::cout << "[LSQ] Removing completed load " << it->request.msgId 
-                          << " (addr=0x" << std::hex << it->request.addr 
+    // As per 3.4.1: LSQ retire has different semantics - just removes entries.
+    // Loads are removed once ready (either from cache or forwarding), stores
+    // only after the cache acknowledges the write.
+    for (uint64_t msgId : m_completed) {
+        auto it = m_entries.find(msgId);
+        if (it == m_entries.end()) {
+            continue;
+        }
+
+        const CpuFIFO::ReqMsg& request = it->second.request;
+        if (request.type == CpuFIFO::REQTYPE::READ) {
+            if (m_debug) {
+                std::cout << "[LSQ] Removing completed load " << request.msgId
+                          << " (addr=0x" << std::hex << request.addr
+                          << std::dec << ")" << std::endl;
+            }
+            m_num_loads--;
+        } else if (request.type == CpuFIFO::REQTYPE::RMW) {
+            if (m_debug) {
+                std::cout << "[LSQ] Removing completed atomic " << request.msgId
+                          << " (addr=0x" << std::hex << request.addr
                           << std::dec << ")" << std::endl;
             }
+            m_num_stores--;
         } else {
-            // For stores: remove only after cache acknowledges write completion
-            // Note: Stores are ready on allocation (3.3.2) but need cache_ack to be removed
-            can_remove = it->ready && it->cache_ack;
-            if (can_remove) {
-                std::cout << "[LSQ] Removing completed store " << it->request.msgId 
-                          << " (addr=0x" << std::hex << it->request.addr 
+            if (m_debug) {
+                std::cout << "[LSQ] Removing completed store " << request.msgId
+                          << " (addr=0x" << std::hex << request.addr
                           << std::dec << ") - cache write confirmed" << std::endl;
             }
+            if (--m_store_addrs[request.addr] == 0) {
+                m_store_addrs.erase(request.addr);
+            }
+            m_num_stores--;
         }
-        
-        if (can_remove) {
-            it = m_lsq_q.erase(it);
-            m_num_entries--;
-            std::cout << "[LSQ] Entry removed, remaining entries: " << m_num_entries << "/" << MAX_ENTRIES << std::endl;
-        } else {
-            ++it;
+
+        m_order.erase(msgId);
+        m_entries.erase(it);
+        if (m_debug) {
+            std::cout << "[LSQ] Entry removed, remaining entries: " << size() << "/"
+                      << (m_max_loads + m_max_stores) << std::endl;
         }
     }
+    m_completed.clear();
 }
 
 void LSQ::commit(uint64_t requestId) {
-    std::cout << "[LSQ] Processing commit for request " << requestId << std::endl;
-    
-    for (auto& entry : m_lsq_q) {
-        if (entry.request.msgId == requestId) {
-            if (entry.request.type == CpuFIFO::REQTYPE::WRITE) {
-                if (entry.cache_ack) {
-                    // Store has been written to cache, can be removed
-                    std::cout << "[LSQ] Store " << requestId 
-                              << " committed and written to cache" << std::endl;
-                } else {
-                    // Need to write store to cache
-                    std::cout << "[LSQ] Store " << requestId 
-                              << " committed but waiting for cache write" << std::endl;
-                }
+    if (m_debug) {
+        std::cout << "[LSQ] Processing commit for request " << requestId << std::endl;
+    }
+
+    auto it = m_entries.find(requestId);
+    if (it == m_entries.end()) {
+        if (m_debug) {
+            std::cout << "[LSQ] Warning: Request " << requestId << " not found for commit" << std::endl;
+        }
+        return;
+    }
+
+    const LSQEntry& entry = it->second;
+    if (entry.request.type == CpuFIFO::REQTYPE::WRITE) {
+        if (entry.cache_ack) {
+            // Store has been written to cache, can be removed
+            if (m_debug) {
+                std::cout << "[LSQ] Store " << requestId
+                          << " committed and written to cache" << std::endl;
+            }
+        } else {
+            // Need to write store to cache
+            if (m_debug) {
+                std::cout << "[LSQ] Store " << requestId
+                          << " committed but waiting for cache write" << std::endl;
             }
-            return;
         }
     }
-    
-    std::cout << "[LSQ] Warning: Request " << requestId << " not found for commit" << std::endl;
 }
 
-} // namespace ns3
\ No newline at end of file
+void LSQ::printState() const {
+    std::cout << "\n[LSQ] Current State:" << std::endl;
+    std::cout << "  Loads: " << m_num_loads << "/" << m_max_loads
+              << ", Stores: " << m_num_stores << "/" << m_max_stores << std::endl;
+    std::cout << "  Unsent loads: " << m_load_q.size() << ", Unsent stores: " << m_store_q.size() << std::endl;
+}
+
+void LSQ::printStats(std::ostream &out, int coreId, int thread) const {
+    std::ostringstream prefix;
+    prefix << "Core " << coreId;
+    if (thread >= 0) {
+        prefix << " thread " << thread;
+    }
+    out << prefix.str() << " LSQ store-to-load forwards = " << m_fwd_hits << std::endl;
+    out << prefix.str() << " LSQ loads sent to cache = " << m_loads_sent << std::endl;
+    out << prefix.str() << " LSQ stores sent to cache = " << m_stores_sent << std::endl;
+    out << prefix.str() << " LSQ cycles loads blocked (load queue full) = " << m_blocked_loads << std::endl;
+    out << prefix.str() << " LSQ cycles stores blocked (store queue full) = " << m_blocked_stores << std::endl;
+    out << prefix.str() << " LSQ cache port stall cycles = " << m_port_stalls << std::endl;
+    if (m_rmws_sent > 0) {
+        out << prefix.str() << " LSQ atomics sent to cache = " << m_rmws_sent << std::endl;
+        out << prefix.str() << " LSQ avg atomic latency = " << (double)m_rmw_latency / m_rmws_sent << std::endl;
+        out << prefix.str() << " LSQ avg atomic fence drain cycles = " << (double)m_rmw_drain_cycles / m_rmws_sent << std::endl;
+        out << prefix.str() << " LSQ fence stall cycles = " << m_fence_stalls << std::endl;
+    }
+}
+
+void LSQ::registerStats(StatsRegistry &stats) const {
+    stats.add("LSQ store-to-load forwards", &m_fwd_hits);
+    stats.add("LSQ loads sent to cache", &m_loads_sent);
+    stats.add("LSQ stores sent to cache", &m_stores_sent);
+    stats.add("LSQ cycles loads blocked (load queue full)", &m_blocked_loads);
+    stats.add("LSQ cycles stores blocked (store queue full)", &m_blocked_stores);
+    stats.add("LSQ cache port stall cycles", &m_port_stalls);
+    stats.add("LSQ atomics sent to cache", &m_rmws_sent);
+    stats.add("LSQ avg atomic latency", [this]() { return StatsRegistry::Ratio(m_rmw_latency, m_rmws_sent); });
+    stats.add("LSQ avg atomic fence drain cycles", [this]() { return StatsRegistry::Ratio(m_rmw_drain_cycles, m_rmws_sent); });
+    stats.add("LSQ fence stall cycles", &m_fence_stalls);
+}
+
+} // namespace ns3
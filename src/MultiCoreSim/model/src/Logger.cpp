@@ -18,6 +18,12 @@ namespace ns3
     {
     }
 
+    Logger::~Logger()
+    {
+        for (std::map<uint64_t, std::vector<uint64_t>*>::iterator it = log_entries.begin(); it != log_entries.end(); it++)
+            delete[] it->second;
+    }
+
     void Logger::addRequest(uint64_t cpu_id, CpuFIFO::ReqMsg &entry)
     {
         log_entries[entry.msgId] = new vector<uint64_t>[NUM_OF_ELEMENTS_PER_ENTRY];
@@ -244,7 +250,8 @@ namespace ns3
         stream << "Worst-case DRAM Latency,";
         stream << "Worst-case Total Latency,";
         stream << "Worst-case Effective Latency,";
-        stream << "Average Latency";
+        stream << "Average Latency,";
+        stream << "Regulation Throttled Cycles";
 
         report_files[core_id] << endl;
         report_files[core_id] << endl;
@@ -269,7 +276,8 @@ namespace ns3
         stream << worst_case_dram_latency[core_id] << ",";
         stream << worst_case_latency[core_id] << ",";
         stream << max_effective_latency[core_id] << ",";
-        stream << 1.0 * average_latency[core_id] / num_request[core_id];
+        stream << 1.0 * average_latency[core_id] / num_request[core_id] << ",";
+        stream << throttled_cycles[core_id];
 
         report_files[core_id] << stream.str() << endl;
         report_files[core_id].close();
@@ -288,4 +296,9 @@ namespace ns3
     {
         core_clk_count[core_id] = clk;
     }
+
+    void Logger::addThrottledCycles(uint64_t core_id, uint64_t cycles)
+    {
+        throttled_cycles[core_id] += cycles;
+    }
 }
\ No newline at end of file
@@ -9,6 +9,8 @@
 #include "../header/MCoreSimProject.h"
 #include "ns3/simulator.h"
 
+#include <stdexcept>
+
 using namespace std;
 using namespace ns3;
 
@@ -24,6 +26,15 @@ MCoreSimProject::MCoreSimProject(MCoreSimProjectXml projectXmlCfg)
   // Get clock frequency
   m_dt = projectXmlCfg.GetBusClkInNanoSec();
   m_busCycle = 0;
+  m_done = false;
+  m_report = &cout;
+  m_main_memory = NULL;
+  m_page_allocator = NULL;
+
+  // Several projects can run one after another in a process; each one starts
+  // from fresh request ids and logger
+  IdGenerator::reset();
+  Logger::reset();
 
   // Get Run Till Sim End Flag
   m_runTillSimEnd = projectXmlCfg.GetRunTillSimEnd();
@@ -47,6 +58,28 @@ MCoreSimProject::~MCoreSimProject()
   }
   m_cpuFIFO.clear();
 
+  for (MMU *mmu : m_mmus)
+  {
+    delete mmu;
+  }
+  m_mmus.clear();
+  delete m_page_allocator;
+
+  // The controllers are ns-3 objects; once the simulator is destroyed no
+  // event holds them any more and the last reference is ours
+  for (CacheController *cache_ctrl : m_cpuCacheCtrl)
+  {
+    cache_ctrl->Unref();
+  }
+  m_cpuCacheCtrl.clear();
+  for (Socket &socket : m_sockets)
+  {
+    if (socket.SharedCacheCtrl)
+      socket.SharedCacheCtrl->Unref();
+  }
+  m_sockets.clear();
+  delete m_main_memory;
+
   // delete m_sharedCacheBusIfFIFO;
   // delete m_sharedCacheDRAMBusIfFIFO;
 }
@@ -60,6 +93,11 @@ void MCoreSimProject::setup1(MCoreSimProjectXml projectXmlCfg)
 
   // Get all cpu configurations from xml
   list<CacheXml> xmlPrivateCaches = projectXmlCfg.GetPrivateCaches();
+
+  // One physical memory and set of page tables for all the cores
+  VMCnfgXml vmCnfg = projectXmlCfg.GetVMCnfg();
+  m_page_allocator = vmCnfg.GetEnable() ? new PageAllocator(vmCnfg) : NULL;
+
   list<CacheXml> xmlSharedCaches;
 
   CacheXml xmlSharedCache = projectXmlCfg.GetSharedCache();
@@ -85,8 +123,32 @@ void MCoreSimProject::setup1(MCoreSimProjectXml projectXmlCfg)
 
   m_maxPendReq = 0;
 
-  bus = new TripleBus(xmlPrivateCaches, xmlSharedCaches, 
-    projectXmlCfg.GetBusFIFOSize(), L1BusCnfg.GetReqBusLatcy(), L1BusCnfg.GetRespBusLatcy());
+  // Cores are split among the sockets, in cacheId order unless their Socket is given
+  int nSockets = max(1, projectXmlCfg.GetNUMACnfg().GetSockets());
+  map<int, int> coreSocket;
+  int coreIndex = 0;
+  for (list<CacheXml>::iterator it = xmlPrivateCaches.begin(); it != xmlPrivateCaches.end(); it++, coreIndex++)
+    coreSocket[it->GetCacheId()] = (it->GetSocket() >= 0) ? it->GetSocket() % nSockets
+                                                          : coreIndex * nSockets / (int)xmlPrivateCaches.size();
+
+  // Each socket has a bus of its own; an L1I is a bus agent of its own, next to the L1D of its core
+  map<int, CacheXml> xmlInstCaches = projectXmlCfg.GetInstCaches();
+  vector<list<CacheXml>> xmlBusAgents(nSockets);
+  for (list<CacheXml>::iterator it = xmlPrivateCaches.begin(); it != xmlPrivateCaches.end(); it++)
+    xmlBusAgents[coreSocket[it->GetCacheId()]].push_back(*it);
+  for (map<int, CacheXml>::iterator it = xmlInstCaches.begin(); it != xmlInstCaches.end(); it++)
+    xmlBusAgents[coreSocket[it->first]].push_back(it->second);
+
+  m_sockets.resize(nSockets);
+  for (int s = 0; s < nSockets; s++)
+  {
+    if (xmlBusAgents[s].empty())
+    {
+      throw std::runtime_error("Socket " + to_string(s) + " has no cores");
+    }
+    m_sockets[s].bus = new TripleBus(xmlBusAgents[s], xmlSharedCaches, 
+      projectXmlCfg.GetBusFIFOSize(), L1BusCnfg.GetReqBusLatcy(), L1BusCnfg.GetRespBusLatcy());
+  }
 
   // iterate over each core
   for (list<CacheXml>::iterator it = xmlPrivateCaches.begin(); it != xmlPrivateCaches.end(); it++)
@@ -100,27 +162,59 @@ void MCoreSimProject::setup1(MCoreSimProjectXml projectXmlCfg)
     m_cpuFIFO.push_back(newCpuFIFO);
 
     /*
-     * instantiate cpu cores
+     * instantiate cpu cores; with virtual memory the core talks to an MMU
+     * through a FIFO of its own and the MMU to the cache through newCpuFIFO
      */
-    Ptr<CpuCoreGenerator> newCpuCore = CreateObject<CpuCoreGenerator>(newCpuFIFO);
+    CpuFIFO *coreFIFO = newCpuFIFO;
+    if (m_page_allocator)
+    {
+      coreFIFO = new CpuFIFO(PrivateCacheXml.GetCacheId(), projectXmlCfg.GetCpuFIFOSize());
+      m_cpuFIFO.push_back(coreFIFO);
+    }
+    Ptr<CpuCoreGenerator> newCpuCore = CreateObject<CpuCoreGenerator>(coreFIFO);
+    if (m_page_allocator)
+    {
+      MMU *mmu = new MMU(PrivateCacheXml.GetCacheId(), PrivateCacheXml.GetASID(), coreFIFO, newCpuFIFO,
+                         m_page_allocator, vmCnfg);
+      m_mmus.push_back(mmu);
+      newCpuCore->SetMMU(mmu);
+    }
+    newCpuCore->SetThreads(PrivateCacheXml.GetThreads(),
+                           (PrivateCacheXml.GetFetchPolicy() == "ICOUNT") ? CpuCoreGenerator::FetchPolicy::ICount
+                                                                         : CpuCoreGenerator::FetchPolicy::RoundRobin);
     stringstream bmTraceFile, cpuTraceFile, ctrlTraceFile;
     bmTraceFile << projectXmlCfg.GetBMsPath() << "/trace_C" << PrivateCacheXml.GetCacheId() << ".trc.shared";
-    cpuTraceFile << projectXmlCfg.GetBMsPath() << "/" << projectXmlCfg.GetCpuTraceFile() << PrivateCacheXml.GetCacheId() << ".txt";
-    ctrlTraceFile << projectXmlCfg.GetBMsPath() << "/" << projectXmlCfg.GetCohCtrlsTraceFile() << PrivateCacheXml.GetCacheId() << ".txt";
+    cpuTraceFile << projectXmlCfg.GetOutputPath() << "/" << projectXmlCfg.GetCpuTraceFile() << PrivateCacheXml.GetCacheId() << ".txt";
+    ctrlTraceFile << projectXmlCfg.GetOutputPath() << "/" << projectXmlCfg.GetCohCtrlsTraceFile() << PrivateCacheXml.GetCacheId() << ".txt";
     double cpuClkPeriod = PrivateCacheXml.GetCpuClkNanoSec();
     double cpuClkSkew = cpuClkPeriod * PrivateCacheXml.GetCpuClkSkew() / 100.00;
     newCpuCore->SetCoreId(PrivateCacheXml.GetCacheId());
     newCpuCore->SetBmFileName(bmTraceFile.str());
+    // Thread t > 0 of an SMT core reads trace_C<core>_T<t>.trc.shared
+    for (int thread = 1; thread < newCpuCore->GetThreads(); thread++)
+    {
+      stringstream threadTraceFile;
+      threadTraceFile << projectXmlCfg.GetBMsPath() << "/trace_C" << PrivateCacheXml.GetCacheId() << "_T" << thread << ".trc.shared";
+      newCpuCore->SetBmFileName(threadTraceFile.str(), thread);
+      bm_paths.push_back(threadTraceFile.str());
+    }
     newCpuCore->SetCpuTraceFile(cpuTraceFile.str());
     newCpuCore->SetCtrlsTraceFile(ctrlTraceFile.str());
     newCpuCore->SetDt(cpuClkPeriod);
     newCpuCore->SetClkSkew(cpuClkSkew);
     newCpuCore->SetLogFileGenEnable(m_logFileGenEnable);
     newCpuCore->SetOutOfOrderStages(projectXmlCfg.GetOutOfOrderStages());
+    newCpuCore->SetROBConfig((PrivateCacheXml.GetROBSize() > 0) ? PrivateCacheXml.GetROBSize() : projectXmlCfg.GetROBSize(),
+                             (PrivateCacheXml.GetROBRetireWidth() > 0) ? PrivateCacheXml.GetROBRetireWidth() : projectXmlCfg.GetROBRetireWidth());
+    newCpuCore->SetLSQConfig((PrivateCacheXml.GetLoadQueueSize() > 0) ? PrivateCacheXml.GetLoadQueueSize() : projectXmlCfg.GetLoadQueueSize(),
+                             (PrivateCacheXml.GetStoreQueueSize() > 0) ? PrivateCacheXml.GetStoreQueueSize() : projectXmlCfg.GetStoreQueueSize(),
+                             (PrivateCacheXml.GetLSQCachePorts() > 0) ? PrivateCacheXml.GetLSQCachePorts() : projectXmlCfg.GetLSQCachePorts());
+    newCpuCore->SetDispatchWidth((PrivateCacheXml.GetDispatchWidth() > 0) ? PrivateCacheXml.GetDispatchWidth() : projectXmlCfg.GetDispatchWidth());
     m_cpuCoreGens.push_back(newCpuCore);
 
     bm_paths.push_back(bmTraceFile.str());
 
+    Bus* bus = m_sockets[coreSocket[PrivateCacheXml.GetCacheId()]].bus;
     CommunicationInterface* bus_interface = bus->getInterfaceFor(PrivateCacheXml.GetCacheId());
 
     /*
@@ -130,6 +224,9 @@ void MCoreSimProject::setup1(MCoreSimProjectXml projectXmlCfg)
     if (m_cohrProt == CohProtType::SNOOP_MESI || m_cohrProt == CohProtType::SNOOP_MOESI)
       newCacheCtrl = new CacheControllerExclusive(PrivateCacheXml, m_fsm_protocol_path, bus_interface, newCpuFIFO,
                                                   projectXmlCfg.GetCache2Cache(), xmlSharedCache.GetCacheId(), m_cohrProt);
+    else if (m_cohrProt == CohProtType::SNOOP_PENDULUM)
+      newCacheCtrl = new CacheControllerPENDULUM(PrivateCacheXml, m_fsm_protocol_path, bus_interface, newCpuFIFO,
+                                                 projectXmlCfg.GetCache2Cache(), xmlSharedCache.GetCacheId(), m_cohrProt);
     else
       newCacheCtrl = new CacheController(PrivateCacheXml, m_fsm_protocol_path, bus_interface, newCpuFIFO,
                                          projectXmlCfg.GetCache2Cache(), xmlSharedCache.GetCacheId(), m_cohrProt);
@@ -140,21 +237,86 @@ void MCoreSimProject::setup1(MCoreSimProjectXml projectXmlCfg)
     {
       m_maxPendReq = PrivateCacheXml.GetNPendReq();
     }
+
+    /*
+     * instantiate the L1I of the core, if it has one; thread t reads its
+     * instruction addresses from trace_C<core>.itrc.shared (t = 0) or
+     * trace_C<core>_T<t>.itrc.shared
+     */
+    map<int, CacheXml>::iterator instIt = xmlInstCaches.find(PrivateCacheXml.GetCacheId());
+    if (instIt != xmlInstCaches.end())
+    {
+      CacheXml InstCacheXml = instIt->second;
+      CpuFIFO *instFIFO = new CpuFIFO(InstCacheXml.GetCacheId(), projectXmlCfg.GetCpuFIFOSize());
+      m_cpuFIFO.push_back(instFIFO);
+
+      newCpuCore->SetInstFetch(instFIFO, InstCacheXml.GetCacheId(), InstCacheXml.GetBlockSize(), InstCacheXml.GetFetchBufferSize());
+      for (int thread = 0; thread < newCpuCore->GetThreads(); thread++)
+      {
+        stringstream instTraceFile;
+        instTraceFile << projectXmlCfg.GetBMsPath() << "/trace_C" << PrivateCacheXml.GetCacheId();
+        if (thread > 0)
+          instTraceFile << "_T" << thread;
+        instTraceFile << ".itrc.shared";
+        newCpuCore->SetInstFileName(instTraceFile.str(), thread);
+      }
+
+      CommunicationInterface* inst_bus_interface = bus->getInterfaceFor(InstCacheXml.GetCacheId());
+      CacheController *instCacheCtrl;
+      if (m_cohrProt == CohProtType::SNOOP_MESI || m_cohrProt == CohProtType::SNOOP_MOESI)
+        instCacheCtrl = new CacheControllerExclusive(InstCacheXml, m_fsm_protocol_path, inst_bus_interface, instFIFO,
+                                                     projectXmlCfg.GetCache2Cache(), xmlSharedCache.GetCacheId(), m_cohrProt);
+      else if (m_cohrProt == CohProtType::SNOOP_PENDULUM)
+        instCacheCtrl = new CacheControllerPENDULUM(InstCacheXml, m_fsm_protocol_path, inst_bus_interface, instFIFO,
+                                                    projectXmlCfg.GetCache2Cache(), xmlSharedCache.GetCacheId(), m_cohrProt);
+      else
+        instCacheCtrl = new CacheController(InstCacheXml, m_fsm_protocol_path, inst_bus_interface, instFIFO,
+                                            projectXmlCfg.GetCache2Cache(), xmlSharedCache.GetCacheId(), m_cohrProt);
+
+      m_cpuCacheCtrl.push_back(instCacheCtrl);
+    }
   }
 
-  bus2 = new Bus(xmlSharedCaches, projectXmlCfg.GetDRAMId(), projectXmlCfg.GetBusFIFOSize(), bus->getLowerLevelIds());
-  CommunicationInterface* LLC_bus_interface = bus->getInterfaceFor(xmlSharedCache.GetCacheId());
-  CommunicationInterface* LLC_DRAM_interface = bus2->getInterfaceFor(xmlSharedCache.GetCacheId());
+  // The memory bus and LLC of each socket, and the memory of all the sockets behind them
+  vector<CommunicationInterface*> DRAM_LLC_interfaces;
+  for (int s = 0; s < nSockets; s++)
+  {
+    Socket &socket = m_sockets[s];
+    socket.bus2 = new Bus(xmlSharedCaches, projectXmlCfg.GetDRAMId(), projectXmlCfg.GetBusFIFOSize(), socket.bus->getLowerLevelIds());
+    CommunicationInterface* LLC_bus_interface = socket.bus->getInterfaceFor(xmlSharedCache.GetCacheId());
+    CommunicationInterface* LLC_DRAM_interface = socket.bus2->getInterfaceFor(xmlSharedCache.GetCacheId());
+
+    if (m_llcCohrProt == CohProtType::SNOOP_LLC_PENDULUM)
+      socket.SharedCacheCtrl = new CacheControllerPENDULUM_LLC(xmlSharedCache, m_fsm_llc_protocol_path, LLC_DRAM_interface, LLC_bus_interface,
+                                                               projectXmlCfg.GetCache2Cache(), projectXmlCfg.GetDRAMId(), m_llcCohrProt, socket.bus->getLowerLevelIds());
+    else
+      socket.SharedCacheCtrl = new CacheController_End2End(xmlSharedCache, m_fsm_llc_protocol_path, LLC_DRAM_interface, LLC_bus_interface,
+                                                           projectXmlCfg.GetCache2Cache(), projectXmlCfg.GetDRAMId(), m_llcCohrProt, socket.bus->getLowerLevelIds());
 
-  m_SharedCacheCtrl = new CacheController_End2End(xmlSharedCache, m_fsm_llc_protocol_path, LLC_DRAM_interface, LLC_bus_interface,
-                                          projectXmlCfg.GetCache2Cache(), projectXmlCfg.GetDRAMId(), m_llcCohrProt, bus->getLowerLevelIds());
+    // Per-core memory bandwidth budgets; a core's L1I draws on the budget of its L1D
+    CacheController_End2End *llcCtrl = dynamic_cast<CacheController_End2End *>(socket.SharedCacheCtrl);
+    for (list<CacheXml>::iterator it = xmlPrivateCaches.begin(); it != xmlPrivateCaches.end(); it++)
+    {
+      if (coreSocket[it->GetCacheId()] != s)
+        continue;
+      llcCtrl->SetMemBudget(it->GetCacheId(), it->GetCacheId(), it->GetMemBudget());
+      map<int, CacheXml>::iterator instIt = xmlInstCaches.find(it->GetCacheId());
+      if (instIt != xmlInstCaches.end())
+        llcCtrl->SetMemBudget(instIt->second.GetCacheId(), it->GetCacheId(), it->GetMemBudget());
+    }
 
+    DRAM_LLC_interfaces.push_back(socket.bus2->getInterfaceFor(projectXmlCfg.GetDRAMId()));
+  }
 
-  CommunicationInterface* DRAM_LLC_interface = bus2->getInterfaceFor(projectXmlCfg.GetDRAMId());
-  m_main_memory = new MainMemoryController(projectXmlCfg, DRAM_LLC_interface, xmlSharedCache.GetCacheId());
-  // m_mcsim_interface = new MCsimInterface(projectXmlCfg, DRAM_LLC_interface, xmlSharedCache.GetCacheId());
+  if (nSockets > 1)
+    m_main_memory = new NUMAMemory(projectXmlCfg, DRAM_LLC_interfaces, xmlSharedCache.GetCacheId());
+  else if (projectXmlCfg.GetMemChannels() > 1)
+    m_main_memory = new MultiChannelMemory(projectXmlCfg, DRAM_LLC_interfaces[0], xmlSharedCache.GetCacheId());
+  else
+    m_main_memory = MemoryBackendRegistry::Create(projectXmlCfg.GetDRAMModle(), projectXmlCfg, DRAM_LLC_interfaces[0],
+                                                  xmlSharedCache.GetCacheId(), 0, projectXmlCfg.GetDRAMParamFile());
 
-  Logger::getLogger()->registerReportPath(projectXmlCfg.GetBMsPath() + string("/newLogger"));   
+  Logger::getLogger()->registerReportPath(projectXmlCfg.GetOutputPath() + string("/newLogger"));   
   // if (L1BusCnfg.GetReqBusArb() == "RR" ||
   //     L1BusCnfg.GetReqBusArb() == "WRR" ||
   //     L1BusCnfg.GetReqBusArb() == "HRR")
@@ -171,6 +333,8 @@ void MCoreSimProject::setup2(MCoreSimProjectXml projectXmlCfg)
 
   // Get all cpu configurations from xml
   list<CacheXml> xmlPrivateCaches = projectXmlCfg.GetPrivateCaches();
+  m_page_allocator = NULL; // External CPUs send physical addresses
+
   list<CacheXml> xmlSharedCaches;
 
   CacheXml xmlSharedCache = projectXmlCfg.GetSharedCache();
@@ -194,7 +358,10 @@ void MCoreSimProject::setup2(MCoreSimProjectXml projectXmlCfg)
   // Get Coherence protocol type
   GetCohrProtocolType();
 
-  bus = new TripleBus(xmlPrivateCaches, xmlSharedCaches, projectXmlCfg.GetBusFIFOSize());
+  // The external CPUs share a single socket
+  m_sockets.resize(1);
+  Bus* bus = new TripleBus(xmlPrivateCaches, xmlSharedCaches, projectXmlCfg.GetBusFIFOSize());
+  m_sockets[0].bus = bus;
 
   // iterate over each core
   for (list<CacheXml>::iterator iter = xmlPrivateCaches.begin(); iter != xmlPrivateCaches.end(); iter++)
@@ -211,6 +378,10 @@ void MCoreSimProject::setup2(MCoreSimProjectXml projectXmlCfg)
       private_cache = new CacheControllerExclusive(*iter, m_fsm_protocol_path, bus_interface, 
                                                   cpu_interconnect->getInterfaceFor(iter->GetCacheId()),
                                                   projectXmlCfg.GetCache2Cache(), xmlSharedCache.GetCacheId(), m_cohrProt);
+    else if (m_cohrProt == CohProtType::SNOOP_PENDULUM)
+      private_cache = new CacheControllerPENDULUM(*iter, m_fsm_protocol_path, bus_interface, 
+                                                 cpu_interconnect->getInterfaceFor(iter->GetCacheId()),
+                                                 projectXmlCfg.GetCache2Cache(), xmlSharedCache.GetCacheId(), m_cohrProt);
     else
       private_cache = new CacheController(*iter, m_fsm_protocol_path, bus_interface, 
                                          cpu_interconnect->getInterfaceFor(iter->GetCacheId()),
@@ -220,19 +391,30 @@ void MCoreSimProject::setup2(MCoreSimProjectXml projectXmlCfg)
     cpu_interconnect->init();
   }
 
-  bus2 = new Bus(xmlSharedCaches, projectXmlCfg.GetDRAMId(), projectXmlCfg.GetBusFIFOSize(), bus->getLowerLevelIds());
+  Bus* bus2 = new Bus(xmlSharedCaches, projectXmlCfg.GetDRAMId(), projectXmlCfg.GetBusFIFOSize(), bus->getLowerLevelIds());
+  m_sockets[0].bus2 = bus2;
   CommunicationInterface* LLC_bus_interface = bus->getInterfaceFor(xmlSharedCache.GetCacheId());
   CommunicationInterface* LLC_DRAM_interface = bus2->getInterfaceFor(xmlSharedCache.GetCacheId());
 
-  m_SharedCacheCtrl = new CacheController_End2End(xmlSharedCache, m_fsm_llc_protocol_path, LLC_DRAM_interface, LLC_bus_interface,
-                                          projectXmlCfg.GetCache2Cache(), projectXmlCfg.GetDRAMId(), m_llcCohrProt, bus->getLowerLevelIds());
+  if (m_llcCohrProt == CohProtType::SNOOP_LLC_PENDULUM)
+    m_sockets[0].SharedCacheCtrl = new CacheControllerPENDULUM_LLC(xmlSharedCache, m_fsm_llc_protocol_path, LLC_DRAM_interface, LLC_bus_interface,
+                                                                     projectXmlCfg.GetCache2Cache(), projectXmlCfg.GetDRAMId(), m_llcCohrProt, bus->getLowerLevelIds());
+  else
+    m_sockets[0].SharedCacheCtrl = new CacheController_End2End(xmlSharedCache, m_fsm_llc_protocol_path, LLC_DRAM_interface, LLC_bus_interface,
+                                                         projectXmlCfg.GetCache2Cache(), projectXmlCfg.GetDRAMId(), m_llcCohrProt, bus->getLowerLevelIds());
 
+  CacheController_End2End *llcCtrl = dynamic_cast<CacheController_End2End *>(m_sockets[0].SharedCacheCtrl);
+  for (list<CacheXml>::iterator iter = xmlPrivateCaches.begin(); iter != xmlPrivateCaches.end(); iter++)
+    llcCtrl->SetMemBudget(iter->GetCacheId(), iter->GetCacheId(), iter->GetMemBudget());
 
   CommunicationInterface* DRAM_LLC_interface = bus2->getInterfaceFor(projectXmlCfg.GetDRAMId());
-  m_main_memory = new MainMemoryController(projectXmlCfg, DRAM_LLC_interface, xmlSharedCache.GetCacheId());
-  // m_mcsim_interface = new MCsimInterface(projectXmlCfg, DRAM_LLC_interface, xmlSharedCache.GetCacheId());
+  if (projectXmlCfg.GetMemChannels() > 1)
+    m_main_memory = new MultiChannelMemory(projectXmlCfg, DRAM_LLC_interface, xmlSharedCache.GetCacheId());
+  else
+    m_main_memory = MemoryBackendRegistry::Create(projectXmlCfg.GetDRAMModle(), projectXmlCfg, DRAM_LLC_interface,
+                                                  xmlSharedCache.GetCacheId(), 0, projectXmlCfg.GetDRAMParamFile());
 
-  Logger::getLogger()->registerReportPath(projectXmlCfg.GetBMsPath() + string("/newLogger"));   
+  Logger::getLogger()->registerReportPath(projectXmlCfg.GetOutputPath() + string("/newLogger"));   
   // if (L1BusCnfg.GetReqBusArb() == "RR" ||
   //     L1BusCnfg.GetReqBusArb() == "WRR" ||
   //     L1BusCnfg.GetReqBusArb() == "HRR")
@@ -263,16 +445,23 @@ void MCoreSimProject::Start()
     (*it)->init();
   }
 
-  m_SharedCacheCtrl->init();
-  // m_SharedCacheCtrl->initializeCacheData(bm_paths);
+  for (vector<Socket>::iterator it = m_sockets.begin(); it != m_sockets.end(); it++)
+  {
+    it->SharedCacheCtrl->init();
+    // it->SharedCacheCtrl->initializeCacheData(bm_paths);
+  }
 
   // m_dramCtrl->init();
   m_main_memory->init();
-  // m_mcsim_interface->init();
 
   // m_busArbiter->init();
-  bus->init();
-  bus2->init();
+  for (vector<Socket>::iterator it = m_sockets.begin(); it != m_sockets.end(); it++)
+  {
+    it->bus->init();
+    it->bus2->init();
+  }
+
+  RegisterStats();
 
   Simulator::Schedule(Seconds(0.0), &Step, this);
   Simulator::Stop(MilliSeconds(m_totalTimeInSeconds));
@@ -292,14 +481,25 @@ void MCoreSimProject::CycleProcess()
     SimulationDoneFlag &= (*it)->GetCpuSimDoneFlag();
   }
 
+  // The LLCs send the write-backs they still buffer before the run ends
+  for (vector<Socket>::iterator it = m_sockets.begin(); SimulationDoneFlag && it != m_sockets.end(); it++)
+  {
+    SimulationDoneFlag &= it->SharedCacheCtrl->flushWriteBacks();
+  }
+
   if (SimulationDoneFlag == true && m_cpuCoreGens.size() > 0)
   {
-    cout << "Current Simulation Done at Bus Clock Cycle # " << m_busCycle << endl;
+    *m_report << "Current Simulation Done at Bus Clock Cycle # " << m_busCycle << endl;
+    PrintStats(*m_report);
     cerr << "End\n";
     // cout << "L2 Nmiss =  " << m_SharedCacheCtrl->GetShareCacheMisses() << endl;
     // cout << "L2 NReq =  " << m_SharedCacheCtrl->GetShareCacheNReqs() << endl;
     // cout << "L2 Miss Rate =  " << (m_SharedCacheCtrl->GetShareCacheMisses() / (float)m_SharedCacheCtrl->GetShareCacheNReqs()) * 100 << endl;
-    exit(0);
+
+    // Simulator::Run returns to the caller, which may run another project
+    m_done = true;
+    Simulator::Stop();
+    return;
   }
 
   // Schedule the next run
@@ -307,6 +507,41 @@ void MCoreSimProject::CycleProcess()
   m_busCycle++;
 }
 
+void MCoreSimProject::PrintStats(std::ostream &out)
+{
+  for (list<Ptr<CpuCoreGenerator> >::iterator it = m_cpuCoreGens.begin(); it != m_cpuCoreGens.end(); it++)
+    (*it)->printStats(out);
+  for (list<CacheController *>::iterator it = m_cpuCacheCtrl.begin(); it != m_cpuCacheCtrl.end(); it++)
+    (*it)->printStats(out);
+  for (int s = 0; s < (int)m_sockets.size(); s++)
+  {
+    if (m_sockets.size() > 1)
+      out << "Socket " << s << " LLC:" << endl;
+    m_sockets[s].SharedCacheCtrl->printStats(out);
+  }
+  m_main_memory->printStats(out);
+  if (m_page_allocator)
+    m_page_allocator->printStats(out);
+}
+
+// The same components as PrintStats, once they are all set up
+void MCoreSimProject::RegisterStats()
+{
+  m_stats.clear();
+  for (list<Ptr<CpuCoreGenerator> >::iterator it = m_cpuCoreGens.begin(); it != m_cpuCoreGens.end(); it++)
+    (*it)->registerStats(m_stats);
+  for (list<CacheController *>::iterator it = m_cpuCacheCtrl.begin(); it != m_cpuCacheCtrl.end(); it++)
+    (*it)->registerStats(m_stats);
+  for (int s = 0; s < (int)m_sockets.size(); s++)
+  {
+    StatsRegistry::Scope socket(m_stats, (m_sockets.size() > 1) ? "Socket " + to_string(s) : "");
+    m_sockets[s].SharedCacheCtrl->registerStats(m_stats);
+  }
+  m_main_memory->registerStats(m_stats);
+  if (m_page_allocator)
+    m_page_allocator->registerStats(m_stats);
+}
+
 void MCoreSimProject::EnableDebugFlag(bool Enable)
 {
 
@@ -371,9 +606,15 @@ void MCoreSimProject::GetCohrProtocolType()
     m_fsm_protocol_path += "PMESI_asterisk.csv";
     m_fsm_llc_protocol_path += "PMESI_asterisk_LLC.csv";
   }
+  else if (cohType == "PENDULUM")
+  {
+    m_cohrProt = CohProtType::SNOOP_PENDULUM;
+    m_llcCohrProt = CohProtType::SNOOP_LLC_PENDULUM;
+    m_fsm_protocol_path += "Pendulum.csv";
+    m_fsm_llc_protocol_path += "Pendulum_LLC.csv";
+  }
   else
   {
-    std::cout << "Unsupported Coherence Protocol Cnfg Param = " << cohType << std::endl;
-    exit(0);
+    throw std::runtime_error("Unsupported Coherence Protocol Cnfg Param = " + cohType);
   }
 }
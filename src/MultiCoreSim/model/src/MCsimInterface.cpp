@@ -10,6 +10,14 @@
 
 namespace ns3
 {
+    static MemoryBackend *CreateMCsim(MCoreSimProjectXml &projectXml, CommunicationInterface *lower_interface,
+                                      int llc_id, int, const std::string &param_file)
+    {
+        return new MCsimInterface(projectXml, lower_interface, llc_id, param_file);
+    }
+
+    REGISTER_MEMORY_BACKEND("MCsim", CreateMCsim);
+
     // override ns3 type
     TypeId MCsimInterface::GetTypeId(void)
     {
@@ -17,7 +25,8 @@ namespace ns3
         return tid;
     }
 
-    MCsimInterface::MCsimInterface(MCoreSimProjectXml &projectXml, CommunicationInterface *lower_interface, int llc_id)
+    MCsimInterface::MCsimInterface(MCoreSimProjectXml &projectXml, CommunicationInterface *lower_interface, int llc_id,
+                                   std::string param_file)
     {
         m_id = projectXml.GetDRAMId();
         m_llc_id = llc_id;
@@ -33,14 +42,18 @@ namespace ns3
 
         m_lower_interface = lower_interface;
 
-        m_processing_queue = new FRFCFS_Buffer<Message, MCsimInterface>(&MCsimInterface::getRequestState, this);
 
         /******************************************** Initialization of MCsim ********************************************/
         unsigned int num_cores = projectXml.GetNumPrivCore();
+        if (param_file.empty())
+        {
+            cout << "MCsimInterface: the MCsim backend needs its .ini file as MEMParamFile" << endl;
+            exit(0);
+        }
 
         m_mcsim = MCsim::getMemorySystemInstance(
             num_cores,
-            "/Users/Mhossam/Documents/PhD_Work/MCsim/MCsim/system/FRFCFS/FRFCFS.ini", // this should be parameterized
+            param_file,
             "DDR3",
             "1600H",
             "2Gb_x8",
@@ -79,15 +92,18 @@ namespace ns3
 
     void MCsimInterface::processLogic()
     {
-        addRequests2ProcessingQueue(*m_processing_queue);
-
+        // Hand one request per cycle from the LLC to MCsim
         Message ready_msg;
-        if (m_processing_queue->getFirstReady(&ready_msg))
+        if (m_lower_interface->peekMessage(&ready_msg))
         {
+            ready_msg.source = Message::Source::LOWER_INTERCONNECT;
+            ready_msg.cycle = m_clk_cycle;
+            m_lower_interface->popFrontMessage();
+
             if (m_mcsim->addRequest(ready_msg.owner, ready_msg.addr, ready_msg.data == NULL, m_llc_line_size)) // 1 -> Read, 0 -> Write
             {
                 if(ready_msg.data == NULL) //Add read requests only
-                    m_pending_requests.push_back(ready_msg);
+                    m_pending_requests[ready_msg.addr].push_back(ready_msg);
             }
             else
             {
@@ -98,63 +114,40 @@ namespace ns3
 
         if(!m_output_buffer.empty())
         {
-            if (!m_lower_interface->pushMessage(m_output_buffer[0], m_clk_cycle, MessageType::DATA_RESPONSE))
+            if (!m_lower_interface->pushMessage(m_output_buffer.front(), m_clk_cycle, MessageType::DATA_RESPONSE))
             {
                 cout << "MCsimInterface(id = " << this->m_id << "): Cannot insert the Msg into the lower interface FIFO, FIFO is Full" << endl;
                 exit(0);
             }
-            m_output_buffer.erase(m_output_buffer.begin());
+            m_output_buffer.pop_front();
         }
     }
 
-    void MCsimInterface::addRequests2ProcessingQueue(FRFCFS_Buffer<Message, MCsimInterface> &buf)
-    {
-        Message msg;
-
-        if (m_lower_interface->peekMessage(&msg))
-        {
-            msg.source = Message::Source::LOWER_INTERCONNECT;
-            msg.cycle = m_clk_cycle;
-            if (buf.pushBack(msg, FRFCFS_State::Ready))
-                m_lower_interface->popFrontMessage();
-        }
-    }
-
-    FRFCFS_State MCsimInterface::getRequestState(const Message &msg, FRFCFS_State current_state)
-    {
-        return FRFCFS_State::Ready;
-    }
-
     void MCsimInterface::read_callback(unsigned id, uint64_t address, uint64_t clock_cycle)
     {
-        bool found = false;
-        for (int i = 0; i < (int)m_pending_requests.size(); i++)
-        {
-            if (m_pending_requests[i].addr == address)
-            {
-                uint64_t data = m_read_count;
-                m_read_count++;
-
-                Message msg = Message(m_pending_requests[i].msg_id, // Id
-                                      m_pending_requests[i].addr,   // Addr
-                                      m_clk_cycle,                  // Cycle
-                                      0,                            // Complementary_value
-                                      m_pending_requests[i].owner); // Owner
-                msg.to.push_back((uint16_t)m_llc_id);               // To
-                msg.copy((uint8_t *)&data);
-                m_output_buffer.push_back(msg);
-
-                m_pending_requests.erase(m_pending_requests.begin() + i);
-                found = true;
-                break;
-            }
-        }
-        
-        if(!found)
+        std::unordered_map<uint64_t, std::deque<Message>>::iterator pending = m_pending_requests.find(address);
+        if (pending == m_pending_requests.end())
         {
             cout << "MCsimInterface: Error read_callback couldn't find the pending request" << endl;
             exit(0);
         }
+
+        Message &request = pending->second.front();
+        uint64_t data = m_read_count;
+        m_read_count++;
+
+        Message msg = Message(request.msg_id, // Id
+                              request.addr,   // Addr
+                              m_clk_cycle,    // Cycle
+                              0,              // Complementary_value
+                              request.owner); // Owner
+        msg.to.push_back((uint16_t)m_llc_id); // To
+        msg.copy((uint8_t *)&data);
+        m_output_buffer.push_back(msg);
+
+        pending->second.pop_front();
+        if (pending->second.empty())
+            m_pending_requests.erase(pending);
     }
 
     void MCsimInterface::write_callback(unsigned id, uint64_t address, uint64_t clock_cycle)
@@ -0,0 +1,255 @@
+#include "../header/MMU.h"
+#include <algorithm>
+
+namespace ns3 {
+
+TLB::TLB(uint32_t entries, uint32_t ways)
+    : m_tick(0),
+      m_hits(0),
+      m_misses(0) {
+    m_ways = std::max(std::min(ways, entries), 1U);
+    m_sets = std::max(entries / m_ways, 1U);
+    m_entries.resize(m_sets * m_ways);
+    for (Entry& entry : m_entries) {
+        entry.valid = false;
+        entry.vpn = 0;
+        entry.last_use = 0;
+    }
+}
+
+bool TLB::lookup(uint64_t vpn) {
+    Entry* set = &m_entries[(vpn % m_sets) * m_ways];
+    for (uint32_t way = 0; way < m_ways; way++) {
+        if (set[way].valid && set[way].vpn == vpn) {
+            set[way].last_use = ++m_tick;
+            m_hits++;
+            return true;
+        }
+    }
+    m_misses++;
+    return false;
+}
+
+void TLB::insert(uint64_t vpn) {
+    Entry* set = &m_entries[(vpn % m_sets) * m_ways];
+    Entry* victim = &set[0];
+    for (uint32_t way = 0; way < m_ways; way++) {
+        if (set[way].valid && set[way].vpn == vpn) {
+            victim = &set[way];
+            break;
+        }
+        if (!set[way].valid || set[way].last_use < victim->last_use) {
+            victim = &set[way];
+        }
+    }
+    victim->valid = true;
+    victim->vpn = vpn;
+    victim->last_use = ++m_tick;
+}
+
+MMU::MMU(uint16_t coreId, uint32_t asid, CpuFIFO* coreFIFO, CpuFIFO* cacheFIFO, PageAllocator* allocator, VMCnfgXml& cfg)
+    : m_coreId(coreId),
+      m_asid(asid),
+      m_coreFIFO(coreFIFO),
+      m_cacheFIFO(cacheFIFO),
+      m_allocator(allocator),
+      m_l1_tlb(std::max(cfg.GetL1TLBEntries(), 1), std::max(cfg.GetL1TLBWays(), 1)),
+      m_l2_tlb(std::max(cfg.GetL2TLBEntries(), 1), std::max(cfg.GetL2TLBWays(), 1)),
+      m_l1_latency(std::max(cfg.GetL1TLBLatency(), 0)),
+      m_l2_latency(std::max(cfg.GetL2TLBLatency(), 0)),
+      m_max_walks(std::max(cfg.GetPageWalkers(), 1)),
+      m_cycle(0),
+      m_pte_read_ids(0),
+      m_walks_done(0),
+      m_walk_cycles(0),
+      m_max_walk_cycles(0),
+      m_pte_reads(0) {
+}
+
+void MMU::step(uint64_t cycle) {
+    m_cycle = cycle;
+
+    rxFromCache();
+    while (!m_coreFIFO->m_txFIFO.IsEmpty()) {
+        translate(m_coreFIFO->m_txFIFO.GetFrontElement());
+        m_coreFIFO->m_txFIFO.PopElement();
+    }
+    startWalks();
+    issuePTEReads();
+    sendToCache();
+}
+
+void MMU::translate(const CpuFIFO::ReqMsg& request) {
+    uint64_t vpn = request.addr >> m_allocator->pageBits();
+
+    Pending pending;
+    pending.request = request;
+    pending.vpn = vpn;
+    pending.translated = false;
+    pending.ready_cycle = 0;
+    m_pending_of[request.msgId] = m_pending.insert(m_pending.end(), pending);
+
+    if (m_l1_tlb.lookup(vpn)) {
+        finishTranslation(request.msgId, m_cycle + m_l1_latency);
+        return;
+    }
+    if (m_l2_tlb.lookup(vpn)) {
+        m_l1_tlb.insert(vpn);
+        finishTranslation(request.msgId, m_cycle + m_l1_latency + m_l2_latency);
+        return;
+    }
+
+    // Missed both TLBs, the request waits for the walk of its page
+    auto it = m_walks.find(vpn);
+    if (it == m_walks.end()) {
+        Walk& walk = m_walks[vpn];
+        walk.vpn = vpn;
+        walk.level = 0;
+        walk.pte_pending = false;
+        walk.start_cycle = m_cycle;
+        walk.waiters.push_back(request.msgId);
+        m_walk_queue.push_back(vpn);
+    } else {
+        it->second.waiters.push_back(request.msgId);
+    }
+}
+
+void MMU::finishTranslation(uint64_t msgId, uint64_t ready_cycle) {
+    Pending& pending = *m_pending_of[msgId];
+    int bits = m_allocator->pageBits();
+    uint64_t vaddr = pending.request.addr;
+    uint64_t frame = m_allocator->translate(m_asid, vaddr >> bits, m_coreId);
+
+    m_vaddr_of[msgId] = vaddr;
+    pending.request.addr = (frame << bits) | (vaddr & ((1ULL << bits) - 1));
+    pending.translated = true;
+    pending.ready_cycle = ready_cycle;
+}
+
+void MMU::rxFromCache() {
+    while (!m_cacheFIFO->m_rxFIFO.IsEmpty()) {
+        CpuFIFO::RespMsg resp = m_cacheFIFO->m_rxFIFO.GetFrontElement();
+        m_cacheFIFO->m_rxFIFO.PopElement();
+
+        if ((resp.msgId & PTE_READ_ID) == 0) {
+            // Response to a load or store of the core, with its virtual address
+            auto vaddr = m_vaddr_of.find(resp.msgId);
+            if (vaddr != m_vaddr_of.end()) {
+                resp.addr = vaddr->second;
+                m_vaddr_of.erase(vaddr);
+            }
+            m_coreFIFO->m_rxFIFO.InsertElement(resp);
+            continue;
+        }
+
+        auto pte = m_walk_of.find(resp.msgId);
+        if (pte == m_walk_of.end()) {
+            continue;
+        }
+        uint64_t vpn = pte->second;
+        m_walk_of.erase(pte);
+        Walk& walk = m_walks[vpn];
+        walk.pte_pending = false;
+        if (++walk.level < m_allocator->levels()) {
+            continue;
+        }
+
+        // Last level read, the translation is known
+        uint64_t walk_cycles = m_cycle - walk.start_cycle;
+        m_walks_done++;
+        m_walk_cycles += walk_cycles;
+        m_max_walk_cycles = std::max(m_max_walk_cycles, walk_cycles);
+
+        m_l2_tlb.insert(vpn);
+        m_l1_tlb.insert(vpn);
+        for (uint64_t waiter : walk.waiters) {
+            finishTranslation(waiter, m_cycle);
+        }
+        m_active_walks.erase(std::find(m_active_walks.begin(), m_active_walks.end(), vpn));
+        m_walks.erase(vpn);
+    }
+}
+
+void MMU::startWalks() {
+    while (m_active_walks.size() < m_max_walks && !m_walk_queue.empty()) {
+        uint64_t vpn = m_walk_queue.front();
+        m_walk_queue.pop_front();
+        m_walks[vpn].start_cycle = m_cycle;
+        m_active_walks.push_back(vpn);
+    }
+}
+
+void MMU::issuePTEReads() {
+    for (uint64_t vpn : m_active_walks) {
+        Walk& walk = m_walks[vpn];
+        if (walk.pte_pending) {
+            continue;
+        }
+        if (m_cacheFIFO->m_txFIFO.IsFull()) {
+            return;
+        }
+
+        CpuFIFO::ReqMsg req;
+        req.msgId = PTE_READ_ID | m_pte_read_ids++;
+        req.reqCoreId = m_coreId;
+        req.addr = m_allocator->pteAddr(m_asid, walk.level, vpn, m_coreId);
+        req.cycle = m_cycle;
+        req.type = CpuFIFO::REQTYPE::READ;
+        req.ready = false;
+        m_cacheFIFO->m_txFIFO.InsertElement(req);
+
+        m_walk_of[req.msgId] = vpn;
+        walk.pte_pending = true;
+        m_pte_reads++;
+    }
+}
+
+void MMU::sendToCache() {
+    std::unordered_set<uint64_t> held_pages;    // Pages of older requests still translating
+    std::list<Pending>::iterator it = m_pending.begin();
+    while (it != m_pending.end() && !m_cacheFIFO->m_txFIFO.IsFull()) {
+        bool is_atomic = (it->request.type == CpuFIFO::REQTYPE::RMW);
+        bool ready = it->translated && it->ready_cycle <= m_cycle && held_pages.count(it->vpn) == 0;
+        if (is_atomic && (!ready || it != m_pending.begin())) {
+            return;     // Nothing passes an atomic, and it passes nothing
+        }
+        if (!ready) {
+            held_pages.insert(it->vpn);
+            it++;
+            continue;
+        }
+
+        m_cacheFIFO->m_txFIFO.InsertElement(it->request);
+        m_pending_of.erase(it->request.msgId);
+        it = m_pending.erase(it);
+    }
+}
+
+void MMU::printStats(std::ostream &out) const {
+    uint64_t l1 = m_l1_tlb.m_hits + m_l1_tlb.m_misses;
+    uint64_t l2 = m_l2_tlb.m_hits + m_l2_tlb.m_misses;
+    out << "Core " << m_coreId << " L1 TLB accesses = " << l1 << ", miss rate = "
+        << ((l1 > 0) ? (double)m_l1_tlb.m_misses / l1 * 100 : 0.0) << "%" << std::endl;
+    out << "Core " << m_coreId << " L2 TLB accesses = " << l2 << ", miss rate = "
+        << ((l2 > 0) ? (double)m_l2_tlb.m_misses / l2 * 100 : 0.0) << "%" << std::endl;
+    out << "Core " << m_coreId << " page walks = " << m_walks_done << ", PTE reads = " << m_pte_reads
+        << ", avg walk latency = " << ((m_walks_done > 0) ? (double)m_walk_cycles / m_walks_done : 0.0)
+        << " cycles, max = " << m_max_walk_cycles << " cycles" << std::endl;
+}
+
+void MMU::registerStats(StatsRegistry &stats) const {
+    stats.add("L1 TLB accesses", [this]() { return (double)(m_l1_tlb.m_hits + m_l1_tlb.m_misses); });
+    stats.add("L1 TLB miss rate", [this]() {
+        return StatsRegistry::Ratio(m_l1_tlb.m_misses, m_l1_tlb.m_hits + m_l1_tlb.m_misses) * 100;
+    });
+    stats.add("L2 TLB accesses", [this]() { return (double)(m_l2_tlb.m_hits + m_l2_tlb.m_misses); });
+    stats.add("L2 TLB miss rate", [this]() {
+        return StatsRegistry::Ratio(m_l2_tlb.m_misses, m_l2_tlb.m_hits + m_l2_tlb.m_misses) * 100;
+    });
+    stats.add("page walks", &m_walks_done);
+    stats.add("PTE reads", &m_pte_reads);
+    stats.add("avg walk latency", [this]() { return StatsRegistry::Ratio(m_walk_cycles, m_walks_done); });
+    stats.add("max walk latency", &m_max_walk_cycles);
+}
+
+} // namespace ns3
@@ -10,6 +10,14 @@
 
 namespace ns3
 {
+    static MemoryBackend *CreateFixedLatency(MCoreSimProjectXml &projectXml, CommunicationInterface *lower_interface,
+                                             int llc_id, int, const std::string &)
+    {
+        return new MainMemoryController(projectXml, lower_interface, llc_id);
+    }
+
+    REGISTER_MEMORY_BACKEND("FIXEDLat", CreateFixedLatency);
+
     // override ns3 type
     TypeId MainMemoryController::GetTypeId(void)
     {
@@ -31,11 +39,11 @@ namespace ns3
         
         m_read_count = 0;
         m_write_count = 0;
+        m_coalesced_writes = 0;
 
         m_lower_interface = lower_interface;    
 
-        
-        m_processing_queue = new FRFCFS_Buffer<Message, MainMemoryController>(&MainMemoryController::getRequestState, this);
+        m_next_seq = 0;
     }
 
     MainMemoryController::~MainMemoryController()
@@ -61,41 +69,64 @@ namespace ns3
 
     void MainMemoryController::processLogic()
     {
-        addRequests2ProcessingQueue(*m_processing_queue);
+        acceptRequest();
 
-        Message ready_msg;
-        if (m_processing_queue->getFirstReady(&ready_msg) == false)
-            return;
+        m_completed.clear();
+        m_completions.advance(m_clk_cycle, m_completed);
 
-        if (ready_msg.data == NULL) //Read message 
+        for (uint64_t seq : m_completed)
         {
-            m_read_count++;
-            uint64_t data = m_read_count;
-
-            Message msg = Message(ready_msg.msg_id,    // Id
-                                  ready_msg.addr,      // Addr
-                                  m_clk_cycle,         // Cycle
-                                  0,                   // Complementary_value
-                                  ready_msg.owner);    // Owner
-            msg.to.push_back((uint16_t) m_llc_id);     // To
-            msg.copy((uint8_t*)&data);
-                    
-            if (!m_lower_interface->pushMessage(msg, m_clk_cycle, MessageType::DATA_RESPONSE))
+            std::unordered_map<uint64_t, Message>::iterator it = m_in_flight.find(seq);
+            Message &ready_msg = it->second;
+
+            if (ready_msg.data == NULL) //Read message 
+            {
+                m_read_count++;
+                sendReadResponse(ready_msg);
+            }
+            else 
             {
-                cout << "MainMemoryController(id = " << this->m_id << "): Cannot insert the Msg into the lower interface FIFO, FIFO is Full" << endl;
-                exit(0);
+                m_write_count++;
+                m_pending_writes.erase(ready_msg.addr);
             }
+            m_in_flight.erase(it);
         }
-        else 
+    }
+    
+    void MainMemoryController::sendReadResponse(const Message &request)
+    {
+        uint64_t data = m_read_count;
+
+        Message msg = Message(request.msg_id,      // Id
+                              request.addr,        // Addr
+                              m_clk_cycle,         // Cycle
+                              0,                   // Complementary_value
+                              request.owner);      // Owner
+        msg.to.push_back((uint16_t) m_llc_id);     // To
+        msg.copy((uint8_t*)&data);
+
+        if (!m_lower_interface->pushMessage(msg, m_clk_cycle, MessageType::DATA_RESPONSE))
         {
-            m_write_count++;
-            // cout << "MainMemoryController: write msg id = " << ready_msg.msg_id;
-            // cout << ", count is " << m_write_count;
-            // cout << " and clk is " << m_clk_cycle << endl;
+            cout << "MainMemoryController(id = " << this->m_id << "): Cannot insert the Msg into the lower interface FIFO, FIFO is Full" << endl;
+            exit(0);
         }
     }
-    
-    void MainMemoryController::addRequests2ProcessingQueue(FRFCFS_Buffer<Message, MainMemoryController> &buf)
+
+    void MainMemoryController::printStats(std::ostream &out)
+    {
+        out << "Main memory reads = " << m_read_count << ", writes = " << m_write_count
+            << ", coalesced writes = " << m_coalesced_writes << endl;
+    }
+
+    void MainMemoryController::registerStats(StatsRegistry &stats)
+    {
+        stats.add("Main memory reads", &m_read_count);
+        stats.add("Main memory writes", &m_write_count);
+        stats.add("Main memory coalesced writes", &m_coalesced_writes);
+    }
+
+    // Takes one request per cycle from the LLC and schedules its completion
+    void MainMemoryController::acceptRequest()
     {
         Message msg;
 
@@ -103,19 +134,24 @@ namespace ns3
         {
             msg.source = Message::Source::LOWER_INTERCONNECT;
             msg.cycle = m_clk_cycle;
-            if (buf.pushBack(msg, FRFCFS_State::NonReady))
-                m_lower_interface->popFrontMessage();
-        }
-    }
+            m_lower_interface->popFrontMessage();
 
-    FRFCFS_State MainMemoryController::getRequestState(const Message &msg, FRFCFS_State current_state)
-    {
-        if(current_state == FRFCFS_State::NonReady)
-        {
-            if(msg.cycle + m_memory_latency <= m_clk_cycle)
-                return FRFCFS_State::Ready;
-        }
+            if (msg.data != NULL)
+            {
+                std::unordered_map<uint64_t, uint64_t>::iterator pending = m_pending_writes.find(msg.addr);
+                if (pending != m_pending_writes.end())
+                {
+                    m_in_flight[pending->second].copy(msg.data);
+                    m_coalesced_writes++;
+                    return;
+                }
+            }
 
-        return FRFCFS_State::NonReady;
-    }    
+            uint64_t seq = m_next_seq++;
+            if (msg.data != NULL)
+                m_pending_writes[msg.addr] = seq;
+            m_in_flight[seq] = msg;
+            m_completions.schedule(seq, m_clk_cycle + requestLatency(msg));
+        }
+    }
 }
\ No newline at end of file
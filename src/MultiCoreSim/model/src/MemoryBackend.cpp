@@ -0,0 +1,50 @@
+#include "../header/MemoryBackend.h"
+#include "../header/TraceReplayMemory.h"
+
+#include <stdexcept>
+
+namespace ns3
+{
+    // Built on first use, so backends can register during static initialization
+    std::map<std::string, MemoryBackendRegistry::Factory> &MemoryBackendRegistry::Factories()
+    {
+        static std::map<std::string, Factory> factories;
+        return factories;
+    }
+
+    bool MemoryBackendRegistry::Register(const std::string &name, Factory factory)
+    {
+        return Factories().insert(std::make_pair(name, factory)).second;
+    }
+
+    MemoryBackend *MemoryBackendRegistry::Create(const std::string &name, MCoreSimProjectXml &projectXml,
+                                                 CommunicationInterface *lower_interface, int llc_id, int instance,
+                                                 const std::string &param_file)
+    {
+        std::map<std::string, Factory>::iterator it = Factories().find(name);
+        if (it == Factories().end())
+        {
+            std::string error = "MemoryBackendRegistry: unknown memory backend " + name + ", available:";
+            for (const std::string &known : Names())
+                error += " " + known;
+            throw std::runtime_error(error);
+        }
+
+        // Record the read latencies of the backend, for a later run with the REPLAY backend
+        if (!projectXml.GetMemRecordFile().empty() && name != "REPLAY")
+        {
+            MemoryLatencyRecorder *recorder = new MemoryLatencyRecorder(projectXml, lower_interface, instance);
+            recorder->SetBackend(it->second(projectXml, recorder, llc_id, instance, param_file));
+            return recorder;
+        }
+        return it->second(projectXml, lower_interface, llc_id, instance, param_file);
+    }
+
+    std::vector<std::string> MemoryBackendRegistry::Names()
+    {
+        std::vector<std::string> names;
+        for (std::map<std::string, Factory>::iterator it = Factories().begin(); it != Factories().end(); it++)
+            names.push_back(it->first);
+        return names;
+    }
+}
@@ -0,0 +1,251 @@
+#include "../header/MultiChannelMemory.h"
+
+#include <cmath>
+#include <stdexcept>
+
+namespace ns3
+{
+    MemoryChannelLink::MemoryChannelLink(int id, int max_size, uint64_t latency)
+        : CommunicationInterface(id)
+    {
+        m_max_size = max_size;
+        m_latency = latency;
+        m_cycle = 0;
+        m_accepted = 0;
+        m_queue_delay = 0;
+    }
+
+    bool MemoryChannelLink::peekMessage(Message *out_msg)
+    {
+        if (m_requests.empty() || m_requests.front().cycle + m_latency > m_cycle)
+            return false;
+        *out_msg = m_requests.front().msg;
+        return true;
+    }
+
+    void MemoryChannelLink::popFrontMessage()
+    {
+        m_accepted++;
+        m_queue_delay += m_cycle - m_requests.front().cycle;
+        m_requests.pop_front();
+    }
+
+    bool MemoryChannelLink::pushMessage(Message &msg, uint64_t, MessageType)
+    {
+        m_responses.push_back(msg);
+        return true;
+    }
+
+    bool MemoryChannelLink::sendRequest(const Message &msg)
+    {
+        if ((int)m_requests.size() >= m_max_size)
+            return false;
+        Entry entry;
+        entry.msg = msg;
+        entry.cycle = m_cycle;
+        m_requests.push_back(entry);
+        return true;
+    }
+
+    bool MemoryChannelLink::peekResponse(Message *out_msg)
+    {
+        if (m_responses.empty())
+            return false;
+        *out_msg = m_responses.front();
+        return true;
+    }
+
+    void MemoryChannelLink::popResponse()
+    {
+        m_responses.pop_front();
+    }
+
+    // override ns3 type
+    TypeId MultiChannelMemory::GetTypeId(void)
+    {
+        static TypeId tid = TypeId("ns3::MultiChannelMemory").SetParent<Object>();
+        return tid;
+    }
+
+    MultiChannelMemory::MultiChannelMemory(MCoreSimProjectXml &projectXml, CommunicationInterface *lower_interface, int llc_id,
+                                           int first_instance)
+    {
+        m_id = projectXml.GetDRAMId();
+        m_dt = projectXml.GetDRAMCtrlClkNanoSec();
+        m_clk_skew = projectXml.GetDRAMCtrlClkSkew();
+        m_clk_cycle = 1;
+        m_lower_interface = lower_interface;
+
+        int channels = projectXml.GetMemChannels();
+        if (channels < 1 || (channels & (channels - 1)) != 0)
+        {
+            throw std::runtime_error("MultiChannelMemory: MEMChannels must be a power of two, got " + std::to_string(channels));
+        }
+        m_channel_bits = (int)log2(channels);
+
+        string interleave = projectXml.GetMemInterleave();
+        m_xor_hash = (interleave == "XOR");
+        if (interleave == "PAGE")
+            m_granularity_bits = (int)log2(projectXml.GetDRAMCnfg().GetRowBufferSize());
+        else if (interleave == "LINE" || interleave == "XOR")
+            m_granularity_bits = (int)log2(projectXml.GetSharedCache().GetBlockSize());
+        else
+        {
+            throw std::runtime_error("MultiChannelMemory: unknown interleaving " + interleave + " (LINE, PAGE or XOR)");
+        }
+
+        m_channels.resize(channels);
+        for (int i = 0; i < channels; i++)
+        {
+            Channel &ch = m_channels[i];
+            ch.link = new MemoryChannelLink(i, projectXml.GetMemChannelQueueSize(), projectXml.GetMemChannelLinkLatcy());
+            ch.backend = MemoryBackendRegistry::Create(projectXml.GetDRAMModle(), projectXml, ch.link, llc_id,
+                                                       first_instance + i, projectXml.GetDRAMParamFile());
+            ch.outstanding_reads = 0;
+            ch.reads = 0;
+            ch.writes = 0;
+            ch.busy_cycles = 0;
+            ch.blocked_cycles = 0;
+        }
+    }
+
+    // Run after the simulator is destroyed, so no event holds a backend any more
+    MultiChannelMemory::~MultiChannelMemory()
+    {
+        for (Channel &ch : m_channels)
+        {
+            delete ch.backend;
+            delete ch.link;
+        }
+    }
+
+    void MultiChannelMemory::init()
+    {
+        for (Channel &ch : m_channels)
+            ch.backend->init();
+        Simulator::Schedule(NanoSeconds(m_clk_skew), &MultiChannelMemory::step, Ptr<MultiChannelMemory>(this));
+    }
+
+    void MultiChannelMemory::step(Ptr<MultiChannelMemory> memory)
+    {
+        memory->cycleProcess();
+    }
+
+    // XOR of all channel-width groups of bits in high
+    uint64_t MultiChannelMemory::foldHighBits(uint64_t high)
+    {
+        uint64_t mask = (1ULL << m_channel_bits) - 1;
+        uint64_t folded = 0;
+        while (m_channel_bits > 0 && high != 0)
+        {
+            folded ^= high & mask;
+            high >>= m_channel_bits;
+        }
+        return folded;
+    }
+
+    int MultiChannelMemory::channelOf(uint64_t addr)
+    {
+        uint64_t mask = (1ULL << m_channel_bits) - 1;
+        uint64_t field = (addr >> m_granularity_bits) & mask;
+        if (m_xor_hash)
+            field ^= foldHighBits(addr >> (m_granularity_bits + m_channel_bits));
+        return (int)field;
+    }
+
+    uint64_t MultiChannelMemory::localAddr(uint64_t addr)
+    {
+        uint64_t low = addr & ((1ULL << m_granularity_bits) - 1);
+        return ((addr >> (m_granularity_bits + m_channel_bits)) << m_granularity_bits) | low;
+    }
+
+    uint64_t MultiChannelMemory::globalAddr(uint64_t local, int channel)
+    {
+        uint64_t low = local & ((1ULL << m_granularity_bits) - 1);
+        uint64_t high = local >> m_granularity_bits;
+        uint64_t field = (uint64_t)channel;
+        if (m_xor_hash)
+            field ^= foldHighBits(high);
+        return (high << (m_granularity_bits + m_channel_bits)) | (field << m_granularity_bits) | low;
+    }
+
+    void MultiChannelMemory::cycleProcess()
+    {
+        for (Channel &ch : m_channels)
+            ch.link->setCycle(m_clk_cycle);
+
+        // Hand LLC requests to their channels in order; a full link holds up the ones behind
+        Message msg;
+        while (m_lower_interface->peekMessage(&msg))
+        {
+            Channel &ch = m_channels[channelOf(msg.addr)];
+            uint64_t addr = msg.addr;
+            msg.addr = localAddr(addr);
+            if (!ch.link->sendRequest(msg))
+            {
+                ch.blocked_cycles++;
+                break;
+            }
+            m_lower_interface->popFrontMessage();
+
+            if (msg.data == NULL)
+            {
+                ch.reads++;
+                ch.outstanding_reads++;
+            }
+            else
+                ch.writes++;
+        }
+
+        // Return read data to the LLC with the original address
+        for (int i = 0; i < (int)m_channels.size(); i++)
+        {
+            Channel &ch = m_channels[i];
+            while (ch.link->peekResponse(&msg))
+            {
+                msg.addr = globalAddr(msg.addr, i);
+                if (!m_lower_interface->pushMessage(msg, m_clk_cycle, MessageType::DATA_RESPONSE))
+                    break;
+                ch.link->popResponse();
+                if (ch.outstanding_reads > 0)
+                    ch.outstanding_reads--;
+            }
+
+            if (ch.link->hasRequests() || ch.outstanding_reads > 0)
+                ch.busy_cycles++;
+        }
+
+        Simulator::Schedule(NanoSeconds(m_dt), &MultiChannelMemory::step, Ptr<MultiChannelMemory>(this));
+        m_clk_cycle++;
+    }
+
+    void MultiChannelMemory::printStats(std::ostream &out)
+    {
+        for (int i = 0; i < (int)m_channels.size(); i++)
+        {
+            Channel &ch = m_channels[i];
+            out << "Memory channel " << i << " reads = " << ch.reads << ", writes = " << ch.writes
+                << ", utilization = " << ((m_clk_cycle > 0) ? (double)ch.busy_cycles / m_clk_cycle * 100 : 0.0) << "%"
+                << ", avg queueing delay = "
+                << ((ch.link->m_accepted > 0) ? (double)ch.link->m_queue_delay / ch.link->m_accepted : 0.0) << " cycles"
+                << ", blocked cycles = " << ch.blocked_cycles << endl;
+            ch.backend->printStats(out);
+        }
+    }
+
+    void MultiChannelMemory::registerStats(StatsRegistry &stats)
+    {
+        for (int i = 0; i < (int)m_channels.size(); i++)
+        {
+            Channel &ch = m_channels[i];
+            StatsRegistry::Scope channel(stats, "Memory channel " + std::to_string(i));
+            stats.add("reads", &ch.reads);
+            stats.add("writes", &ch.writes);
+            stats.add("utilization", [this, &ch]() { return StatsRegistry::Ratio(ch.busy_cycles, m_clk_cycle) * 100; });
+            stats.add("avg queueing delay",
+                      [&ch]() { return StatsRegistry::Ratio(ch.link->m_queue_delay, ch.link->m_accepted); });
+            stats.add("blocked cycles", &ch.blocked_cycles);
+            ch.backend->registerStats(stats);
+        }
+    }
+}
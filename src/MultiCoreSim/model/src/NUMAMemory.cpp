@@ -0,0 +1,365 @@
+#include "../header/NUMAMemory.h"
+
+#include <algorithm>
+#include <cmath>
+#include <stdexcept>
+
+namespace ns3
+{
+    // override ns3 type
+    TypeId NUMAMemory::GetTypeId(void)
+    {
+        static TypeId tid = TypeId("ns3::NUMAMemory").SetParent<Object>();
+        return tid;
+    }
+
+    NUMAMemory::NUMAMemory(MCoreSimProjectXml &projectXml, std::vector<CommunicationInterface *> llc_interfaces, int llc_id)
+    {
+        m_dt = projectXml.GetDRAMCtrlClkNanoSec();
+        m_clk_skew = projectXml.GetDRAMCtrlClkSkew();
+        m_clk_cycle = 1;
+
+        NUMACnfgXml cnfg = projectXml.GetNUMACnfg();
+        if (cnfg.GetPlacement() == "FIRST_TOUCH")
+            m_placement = FIRST_TOUCH;
+        else if (cnfg.GetPlacement() == "INTERLEAVE")
+            m_placement = INTERLEAVE;
+        else
+        {
+            throw std::runtime_error("NUMAMemory: unknown page placement " + cnfg.GetPlacement() +
+                                     " (FIRST_TOUCH or INTERLEAVE)");
+        }
+
+        int page_size = cnfg.GetPageSize();
+        if (page_size < 1 || (page_size & (page_size - 1)) != 0)
+        {
+            throw std::runtime_error("NUMAMemory: PageSize must be a power of two, got " + std::to_string(page_size));
+        }
+        m_page_bits = (int)log2(page_size);
+        m_line_size = projectXml.GetSharedCache().GetBlockSize();
+        m_header_bytes = cnfg.GetLinkHeaderBytes();
+        m_link_bytes_per_cycle = std::max(1, cnfg.GetLinkBytesPerCycle());
+        m_link_queue_size = cnfg.GetLinkQueueSize();
+        m_link_latency = cnfg.GetLinkLatency();
+        m_sharing_reported = false;
+
+        int sockets = (int)llc_interfaces.size();
+        m_sockets.resize(sockets);
+        for (int i = 0; i < sockets; i++)
+        {
+            Socket &socket = m_sockets[i];
+            socket.llc_interface = llc_interfaces[i];
+            socket.mem_link = new MemoryChannelLink(i, projectXml.GetMemChannelQueueSize(), 0);
+            if (projectXml.GetMemChannels() > 1)
+                socket.memory = new MultiChannelMemory(projectXml, socket.mem_link, llc_id, i * projectXml.GetMemChannels());
+            else
+                socket.memory = MemoryBackendRegistry::Create(projectXml.GetDRAMModle(), projectXml, socket.mem_link, llc_id, i,
+                                                              projectXml.GetDRAMParamFile());
+            socket.local_reads = 0;
+            socket.remote_reads = 0;
+            socket.local_read_latency = 0;
+            socket.remote_read_latency = 0;
+            socket.local_writes = 0;
+            socket.remote_writes = 0;
+            socket.home_pages = 0;
+            socket.shared_writes = 0;
+        }
+
+        m_links.resize(sockets * sockets);
+        for (Link &l : m_links)
+        {
+            l.busy_until = 0;
+            l.messages = 0;
+            l.bytes = 0;
+            l.busy_cycles = 0;
+            l.blocked_cycles = 0;
+        }
+    }
+
+    // Run after the simulator is destroyed, so no event holds a socket's memory any more
+    NUMAMemory::~NUMAMemory()
+    {
+        for (Socket &socket : m_sockets)
+        {
+            delete socket.memory;
+            delete socket.mem_link;
+        }
+    }
+
+    void NUMAMemory::init()
+    {
+        for (Socket &socket : m_sockets)
+            socket.memory->init();
+        Simulator::Schedule(NanoSeconds(m_clk_skew), &NUMAMemory::step, Ptr<NUMAMemory>(this));
+    }
+
+    void NUMAMemory::step(Ptr<NUMAMemory> memory)
+    {
+        memory->cycleProcess();
+    }
+
+    int NUMAMemory::homeOf(uint64_t addr, int socket)
+    {
+        uint64_t page = addr >> m_page_bits;
+        if (m_placement == INTERLEAVE)
+            return (int)(page % m_sockets.size());
+
+        std::unordered_map<uint64_t, int>::iterator it = m_page_home.find(page);
+        if (it != m_page_home.end())
+            return it->second;
+        m_page_home[page] = socket;
+        m_sockets[socket].home_pages++;
+        return socket;
+    }
+
+    // Notes the sockets that read a line, and the write-backs of lines other sockets read
+    void NUMAMemory::trackSharing(int socket, const Message &msg)
+    {
+        uint64_t line = msg.addr / m_line_size;
+        uint64_t bit = 1ULL << (socket % 64);
+        if (msg.data == NULL)
+        {
+            m_line_readers[line] |= bit;
+            return;
+        }
+
+        std::unordered_map<uint64_t, uint64_t>::iterator it = m_line_readers.find(line);
+        if (it == m_line_readers.end())
+            return;
+        if ((it->second & ~bit) != 0)
+        {
+            if (!m_sharing_reported)
+                cout << "NUMAMemory: warning, line 0x" << std::hex << msg.addr << std::dec << " written back by socket "
+                     << socket << " was read by another socket; the sockets' LLCs are not coherent" << endl;
+            m_sharing_reported = true;
+            m_sockets[socket].shared_writes++;
+        }
+        // The writer's copy is gone, the other sockets may still hold theirs
+        if ((it->second &= ~bit) == 0)
+            m_line_readers.erase(it);
+    }
+
+    // Queues msg on the link from -> to; it arrives once the link has sent it and the latency has passed
+    bool NUMAMemory::sendOnLink(int from, int to, const Message &msg, bool response)
+    {
+        Link &l = link(from, to);
+        if ((int)l.queue.size() >= m_link_queue_size)
+        {
+            l.blocked_cycles++;
+            return false;
+        }
+
+        int bytes = m_header_bytes + ((response || msg.data != NULL) ? m_line_size : 0);
+        uint64_t start = std::max(m_clk_cycle, l.busy_until);
+        l.busy_until = start + (bytes + m_link_bytes_per_cycle - 1) / m_link_bytes_per_cycle;
+
+        Transfer transfer;
+        transfer.msg = msg;
+        transfer.response = response;
+        transfer.arrive_cycle = l.busy_until + m_link_latency;
+        l.queue.push_back(transfer);
+        l.messages++;
+        l.bytes += bytes;
+        return true;
+    }
+
+    // Hands read data to the LLC of socket and closes the read
+    bool NUMAMemory::completeRead(int socket, Message &msg)
+    {
+        if (!m_sockets[socket].llc_interface->pushMessage(msg, m_clk_cycle, MessageType::DATA_RESPONSE))
+            return false;
+
+        std::multimap<std::pair<uint64_t, uint64_t>, PendingRead>::iterator it =
+            m_pending.lower_bound(std::make_pair(msg.msg_id, msg.addr));
+        if (it != m_pending.end() && it->first == std::make_pair(msg.msg_id, msg.addr))
+        {
+            Socket &origin = m_sockets[it->second.socket];
+            uint64_t latency = m_clk_cycle - it->second.start_cycle;
+            if (it->second.remote)
+            {
+                origin.remote_reads++;
+                origin.remote_read_latency += latency;
+            }
+            else
+            {
+                origin.local_reads++;
+                origin.local_read_latency += latency;
+            }
+            m_pending.erase(it);
+        }
+        return true;
+    }
+
+    void NUMAMemory::cycleProcess()
+    {
+        int sockets = (int)m_sockets.size();
+        for (Socket &socket : m_sockets)
+            socket.mem_link->setCycle(m_clk_cycle);
+
+        // LLC misses go to the memory of their home socket, in order; a full link holds up the ones behind
+        Message msg;
+        for (int s = 0; s < sockets; s++)
+        {
+            Socket &socket = m_sockets[s];
+            while (socket.llc_interface->peekMessage(&msg))
+            {
+                int home = homeOf(msg.addr, s);
+                bool sent = (home == s) ? socket.mem_link->sendRequest(msg) : sendOnLink(s, home, msg, false);
+                if (!sent)
+                    break;
+                socket.llc_interface->popFrontMessage();
+                trackSharing(s, msg);
+
+                if (msg.data == NULL)
+                {
+                    PendingRead read;
+                    read.socket = s;
+                    read.start_cycle = m_clk_cycle;
+                    read.remote = (home != s);
+                    m_pending.insert(std::make_pair(std::make_pair(msg.msg_id, msg.addr), read));
+                }
+                else if (home != s)
+                    socket.remote_writes++;
+                else
+                    socket.local_writes++;
+            }
+        }
+
+        // Messages that reached the far end of their link
+        for (int from = 0; from < sockets; from++)
+        {
+            for (int to = 0; to < sockets; to++)
+            {
+                Link &l = link(from, to);
+                while (!l.queue.empty() && l.queue.front().arrive_cycle <= m_clk_cycle)
+                {
+                    Transfer &transfer = l.queue.front();
+                    bool accepted = transfer.response ? completeRead(to, transfer.msg)
+                                                      : m_sockets[to].mem_link->sendRequest(transfer.msg);
+                    if (!accepted)
+                        break;
+                    l.queue.pop_front();
+                }
+
+                if (l.busy_until > m_clk_cycle)
+                    l.busy_cycles++;
+            }
+        }
+
+        // Read data goes back to the socket that missed, over the link if it is another socket
+        for (int home = 0; home < sockets; home++)
+        {
+            Socket &socket = m_sockets[home];
+            while (socket.mem_link->peekResponse(&msg))
+            {
+                std::multimap<std::pair<uint64_t, uint64_t>, PendingRead>::iterator it =
+                    m_pending.lower_bound(std::make_pair(msg.msg_id, msg.addr));
+                int origin = (it != m_pending.end() && it->first == std::make_pair(msg.msg_id, msg.addr)) ? it->second.socket : home;
+
+                bool sent = (origin == home) ? completeRead(home, msg) : sendOnLink(home, origin, msg, true);
+                if (!sent)
+                    break;
+                socket.mem_link->popResponse();
+            }
+        }
+
+        Simulator::Schedule(NanoSeconds(m_dt), &NUMAMemory::step, Ptr<NUMAMemory>(this));
+        m_clk_cycle++;
+    }
+
+    void NUMAMemory::printStats(std::ostream &out)
+    {
+        uint64_t local_reads = 0, remote_reads = 0;
+        for (int s = 0; s < (int)m_sockets.size(); s++)
+        {
+            Socket &socket = m_sockets[s];
+            uint64_t reads = socket.local_reads + socket.remote_reads;
+            local_reads += socket.local_reads;
+            remote_reads += socket.remote_reads;
+            out << "Socket " << s << " local reads = " << socket.local_reads << ", remote reads = " << socket.remote_reads
+                << ", remote ratio = " << ((reads > 0) ? (double)socket.remote_reads / reads * 100 : 0.0) << "%"
+                << ", avg local read latency = "
+                << ((socket.local_reads > 0) ? (double)socket.local_read_latency / socket.local_reads : 0.0) << " cycles"
+                << ", avg remote read latency = "
+                << ((socket.remote_reads > 0) ? (double)socket.remote_read_latency / socket.remote_reads : 0.0) << " cycles"
+                << ", local writes = " << socket.local_writes << ", remote writes = " << socket.remote_writes
+                << ", home pages = " << socket.home_pages
+                << ", write-backs of lines other sockets read = " << socket.shared_writes << endl;
+        }
+        out << "NUMA remote read ratio = "
+            << ((local_reads + remote_reads > 0) ? (double)remote_reads / (local_reads + remote_reads) * 100 : 0.0) << "%" << endl;
+
+        for (int from = 0; from < (int)m_sockets.size(); from++)
+        {
+            for (int to = 0; to < (int)m_sockets.size(); to++)
+            {
+                if (from == to)
+                    continue;
+                Link &l = link(from, to);
+                out << "Socket link " << from << " -> " << to << " messages = " << l.messages << ", bytes = " << l.bytes
+                    << ", utilization = " << ((m_clk_cycle > 0) ? (double)l.busy_cycles / m_clk_cycle * 100 : 0.0) << "%"
+                    << ", blocked cycles = " << l.blocked_cycles << endl;
+            }
+        }
+
+        for (int s = 0; s < (int)m_sockets.size(); s++)
+        {
+            out << "Socket " << s << " memory:" << endl;
+            m_sockets[s].memory->printStats(out);
+        }
+    }
+
+    void NUMAMemory::registerStats(StatsRegistry &stats)
+    {
+        for (int s = 0; s < (int)m_sockets.size(); s++)
+        {
+            Socket &socket = m_sockets[s];
+            StatsRegistry::Scope scope(stats, "Socket " + std::to_string(s));
+            stats.add("local reads", &socket.local_reads);
+            stats.add("remote reads", &socket.remote_reads);
+            stats.add("remote ratio", [&socket]()
+            {
+                return StatsRegistry::Ratio(socket.remote_reads, socket.local_reads + socket.remote_reads) * 100;
+            });
+            stats.add("avg local read latency",
+                      [&socket]() { return StatsRegistry::Ratio(socket.local_read_latency, socket.local_reads); });
+            stats.add("avg remote read latency",
+                      [&socket]() { return StatsRegistry::Ratio(socket.remote_read_latency, socket.remote_reads); });
+            stats.add("local writes", &socket.local_writes);
+            stats.add("remote writes", &socket.remote_writes);
+            stats.add("home pages", &socket.home_pages);
+            stats.add("write-backs of lines other sockets read", &socket.shared_writes);
+        }
+        stats.add("NUMA remote read ratio", [this]()
+        {
+            uint64_t local_reads = 0, remote_reads = 0;
+            for (const Socket &socket : m_sockets)
+            {
+                local_reads += socket.local_reads;
+                remote_reads += socket.remote_reads;
+            }
+            return StatsRegistry::Ratio(remote_reads, local_reads + remote_reads) * 100;
+        });
+
+        for (int from = 0; from < (int)m_sockets.size(); from++)
+        {
+            for (int to = 0; to < (int)m_sockets.size(); to++)
+            {
+                if (from == to)
+                    continue;
+                Link &l = link(from, to);
+                StatsRegistry::Scope scope(stats, "Socket link " + std::to_string(from) + " -> " + std::to_string(to));
+                stats.add("messages", &l.messages);
+                stats.add("bytes", &l.bytes);
+                stats.add("utilization", [this, &l]() { return StatsRegistry::Ratio(l.busy_cycles, m_clk_cycle) * 100; });
+                stats.add("blocked cycles", &l.blocked_cycles);
+            }
+        }
+
+        for (int s = 0; s < (int)m_sockets.size(); s++)
+        {
+            StatsRegistry::Scope scope(stats, "Socket " + std::to_string(s) + " memory");
+            m_sockets[s].memory->registerStats(stats);
+        }
+    }
+}
@@ -0,0 +1,108 @@
+#include "../header/PageAllocator.h"
+#include <stdexcept>
+#include <algorithm>
+
+namespace ns3 {
+
+PageAllocator::PageAllocator(VMCnfgXml& cfg)
+    : m_policy(Policy::Sequential),
+      m_page_bits(TABLE_BITS),
+      m_levels(4),
+      m_colors(1),
+      m_next_frame(0),
+      m_rng(cfg.GetRandomSeed()),
+      m_table_chunk(0),
+      m_table_chunk_left(0),
+      m_table_pages(0) {
+
+    std::string policy = cfg.GetPageAllocator();
+    if (policy == "SEQUENTIAL") {
+        m_policy = Policy::Sequential;
+    } else if (policy == "RANDOM") {
+        m_policy = Policy::Random;
+    } else if (policy == "HUGE") {
+        m_policy = Policy::Huge;
+        m_page_bits = 21;
+        m_levels = 3;
+    } else if (policy == "COLOR") {
+        m_policy = Policy::Color;
+        m_colors = (cfg.GetPageColors() > 0) ? cfg.GetPageColors() : 1;
+        m_next_in_color.assign(m_colors, 0);
+    } else {
+        std::cerr << "[VM] ERROR: unknown page allocator " << policy
+                  << " (SEQUENTIAL, RANDOM, HUGE or COLOR)" << std::endl;
+        throw std::runtime_error("Unknown page allocator");
+    }
+
+    m_frames = std::max(((uint64_t)cfg.GetPhysMemMB() << 20) >> m_page_bits, (uint64_t)1);
+    std::cout << "[VM] " << policy << " page allocator, " << (1ULL << m_page_bits) << "-byte pages, "
+              << m_frames << " frames" << std::endl;
+}
+
+uint64_t PageAllocator::allocFrame(uint32_t core) {
+    switch (m_policy) {
+        case Policy::Random:
+            if (m_used.size() < m_frames) {
+                uint64_t frame;
+                do {
+                    frame = m_rng() % m_frames;
+                } while (!m_used.insert(frame).second);
+                return frame;
+            }
+            // Physical memory is used up, frames are shared from here on
+            return m_next_frame++ % m_frames;
+
+        case Policy::Color: {
+            uint32_t color = core % m_colors;
+            uint64_t frame = m_next_in_color[color]++ * m_colors + color;
+            return frame % m_frames;
+        }
+
+        default:
+            return m_next_frame++ % m_frames;
+    }
+}
+
+// Table pages are 4KB; with 2MB pages one frame holds 512 of them
+uint64_t PageAllocator::allocTable(uint32_t core) {
+    if (m_table_chunk_left == 0) {
+        m_table_chunk = allocFrame(core) << m_page_bits;
+        m_table_chunk_left = 1U << (m_page_bits - TABLE_BITS);
+    }
+    m_table_chunk_left--;
+    m_table_pages++;
+    return m_table_chunk + ((uint64_t)m_table_chunk_left << TABLE_BITS);
+}
+
+uint64_t PageAllocator::translate(uint32_t asid, uint64_t vpn, uint32_t core) {
+    uint64_t key = ((uint64_t)asid << 48) | vpn;
+    auto it = m_pages.find(key);
+    if (it != m_pages.end()) {
+        return it->second;
+    }
+    uint64_t frame = allocFrame(core);
+    m_pages[key] = frame;
+    return frame;
+}
+
+uint64_t PageAllocator::pteAddr(uint32_t asid, int level, uint64_t vpn, uint32_t core) {
+    int shift = INDEX_BITS * (m_levels - 1 - level);
+    uint64_t prefix = vpn >> (shift + INDEX_BITS);
+    uint64_t key = ((uint64_t)asid << 56) | ((uint64_t)level << 52) | prefix;
+
+    auto it = m_tables.find(key);
+    uint64_t table = (it != m_tables.end()) ? it->second : (m_tables[key] = allocTable(core));
+    return table + (((vpn >> shift) & ((1ULL << INDEX_BITS) - 1)) << 3);
+}
+
+void PageAllocator::printStats(std::ostream &out) const {
+    out << "VM pages mapped = " << m_pages.size() << " of " << (1ULL << m_page_bits)
+        << " bytes, page-table pages = " << m_table_pages << std::endl;
+}
+
+void PageAllocator::registerStats(StatsRegistry &stats) const {
+    stats.add("VM pages mapped", [this]() { return (double)m_pages.size(); });
+    stats.add("VM page-table pages", &m_table_pages);
+}
+
+} // namespace ns3
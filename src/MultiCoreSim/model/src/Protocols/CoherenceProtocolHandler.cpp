@@ -14,7 +14,7 @@ namespace ns3
     CoherenceProtocolHandler::CoherenceProtocolHandler(CacheDataHandler *cache, const string &fsm_path, int coreId, int sharedMemId)
     {
         this->m_data_handler = cache;
-        this->m_fsm = new FSMReader(fsm_path);
+        this->m_fsm = FSMReader::create(fsm_path);
 
         this->m_core_id = coreId;
         this->m_shared_memory_id = sharedMemId;
@@ -19,19 +19,10 @@ namespace ns3
     {
     }
 
-    vector<ControllerAction> &LLCMESIProtocol::handleAction(vector<int> &actions, Message &msg,
+    vector<ControllerAction> &LLCMESIProtocol::handleAction(const FSMReader::ActionList &actions, Message &msg,
                                                             GenericCacheLine &cache_line_info, int next_state)
     {
-        bool execlusiveData = false;
-        for (int i = 0; i < (int)actions.size(); i++)
-        {
-            if (actions[i] == (int)ActionId::SendExeclusiveData)
-            {
-                actions.erase(actions.begin() + i);
-                execlusiveData = true;
-                break;
-            }
-        }
+        bool execlusiveData = actions.contains((int)ActionId::SendExeclusiveData);
         LLCMSIProtocol::handleAction(actions, msg, cache_line_info, next_state);
 
         if (execlusiveData == true)
@@ -13,6 +13,11 @@ namespace ns3
 {
     LLCMSIProtocol::LLCMSIProtocol(CacheDataHandler *cache, const string &fsm_path, int coreId, int sharedMemId) : CoherenceProtocolHandler(cache, fsm_path, coreId, sharedMemId)
     {
+        m_upgrade_event_id = this->m_fsm->getEvent(string("Upgrade"));
+
+        m_upgrade_count = 0;
+        m_upgrade_without_data_count = 0;
+        m_upgrade_as_getm_count = 0;
     }
 
     LLCMSIProtocol::~LLCMSIProtocol()
@@ -75,19 +80,29 @@ namespace ns3
     {
         GenericCacheLine cache_line;
         EventId event_id;
-        int next_state;
-        vector<int> actions;
 
         m_data_handler->readLineBits(request_msg.addr, &cache_line);
 
         this->readEvent(request_msg, cache_line, &event_id);
-        this->m_fsm->getTransition(cache_line.state, (int)event_id, next_state, actions);
+        const FSMReader::Transition &transition = this->m_fsm->getTransition(cache_line.state, (int)event_id);
+        const FSMReader::ActionList &actions = transition.actions;
+        int next_state = transition.next_state;
+
+        if (request_msg.source == Message::Source::LOWER_INTERCONNECT && request_msg.data == NULL &&
+            request_msg.complementary_value == MSIProtocol::REQUEST_TYPE_UPG)
+        {
+            m_upgrade_count++;
+            if (event_id == EventId::GetM)
+                m_upgrade_as_getm_count++;
+            else if (!actions.contains((int)ActionId::SendData) && !actions.contains((int)ActionId::GetData))
+                m_upgrade_without_data_count++;
+        }
+        this->updateHolders(request_msg, event_id);
 
         // timestamp code
         if (cache_line.state != 0 && next_state == 0)
         {
-            auto isWrBack = std::find(actions.begin(), actions.end(), 7);
-            if (isWrBack != actions.end())
+            if (actions.contains((int)ActionId::WriteBack))
             {
                 
                 std::cerr << request_msg.msg_id << "," << request_msg.addr 
@@ -98,20 +113,18 @@ namespace ns3
         }
         if (event_id == EventId::GetS)
         {
-            auto isGetData = std::find(actions.begin(), actions.end(), 1);
             // If LLC does not need to get data, it won't modify its data array
-            if (isGetData == actions.end() && next_state != 5)
+            if (!actions.contains((int)ActionId::GetData) && next_state != 5)
             {
                 std::cerr << request_msg.msg_id << "," << request_msg.addr 
                     << "," << "wrCache" << "," <<  m_core_id << ","<< -1 << "\n";
             }
 
         } //
-        if (event_id == EventId::GetM)
+        if (event_id == EventId::GetM || (int)event_id == m_upgrade_event_id)
         {
-            auto isGetData = std::find(actions.begin(), actions.end(), 1);
             // If LLC does not need to get data, it won't modify its data array
-            if (isGetData == actions.end())
+            if (!actions.contains((int)ActionId::GetData))
             {
                 std::cerr << request_msg.msg_id << "," << request_msg.addr 
                     << "," << "wrCache" << "," <<  m_core_id << ","<< -1 << "\n";
@@ -132,10 +145,9 @@ namespace ns3
 
         if (event_id == EventId::Data_fromLowerInterface)
         {
-            auto isSaveData = std::find(actions.begin(), actions.end(), 3);
             // If LLC doesn't save data when receiving refill,
             // it won't modify its data array.
-            if (isSaveData == actions.end())
+            if (!actions.contains((int)ActionId::SaveData))
             {
                 std::cerr << request_msg.msg_id << "," << request_msg.addr 
                     << "," << "wrCache" << "," <<  m_core_id << ","<< -1 << "\n";
@@ -150,7 +162,7 @@ namespace ns3
         return handleAction(actions, request_msg, cache_line, next_state);
     }
 
-    vector<ControllerAction> &LLCMSIProtocol::handleAction(std::vector<int> &actions, Message &msg,
+    vector<ControllerAction> &LLCMSIProtocol::handleAction(const FSMReader::ActionList &actions, Message &msg,
                                                            GenericCacheLine &cache_line, int next_state)
     {
         this->controller_actions.clear();
@@ -229,6 +241,9 @@ namespace ns3
                 assert(false);
                 exit(0);
                 break;
+
+            default: // actions of derived protocols are handled by their own handleAction
+                continue;
             }
 
             this->controller_actions.push_back(controller_action);
@@ -274,6 +289,9 @@ namespace ns3
                 case MSIProtocol::REQUEST_TYPE_GETM:
                     *out_id = EventId::GetM;
                     break;
+                case MSIProtocol::REQUEST_TYPE_UPG:
+                    *out_id = (m_upgrade_event_id != -1 && isHolder(msg)) ? (EventId)m_upgrade_event_id : EventId::GetM;
+                    break;
                 case MSIProtocol::REQUEST_TYPE_PUTM:
                     if (msg.owner == m_core_id)
                         *out_id = EventId::Replacement;
@@ -298,6 +316,50 @@ namespace ns3
         }
     }
 
+    bool LLCMSIProtocol::isHolder(const Message &msg)
+    {
+        map<uint64_t, set<uint16_t>>::iterator it = m_holders.find(m_data_handler->lineAddress(msg.addr));
+        return it != m_holders.end() && it->second.count(msg.owner) != 0;
+    }
+
+    void LLCMSIProtocol::updateHolders(const Message &msg, EventId event_id)
+    {
+        if (m_upgrade_event_id == -1 || msg.source != Message::Source::LOWER_INTERCONNECT || msg.data != NULL)
+            return;
+
+        uint64_t line = m_data_handler->lineAddress(msg.addr);
+        if (event_id == EventId::GetS)
+            m_holders[line].insert(msg.owner);
+        else if (event_id == EventId::GetM || (int)event_id == m_upgrade_event_id)
+            m_holders[line] = set<uint16_t>{msg.owner};
+        else if (event_id == EventId::PutM_fromOwner || event_id == EventId::PutM_fromNonOwner)
+        {
+            m_holders[line].erase(msg.owner);
+            if (m_holders[line].empty())
+                m_holders.erase(line);
+        }
+        else if (event_id == EventId::Replacement || event_id == EventId::Own_Invalidation)
+            m_holders.erase(line);
+    }
+
+    void LLCMSIProtocol::printStats(std::ostream &out)
+    {
+        if (m_upgrade_event_id == -1)
+            return;
+        out << "LLC Upgrade requests = " << m_upgrade_count << std::endl;
+        out << "LLC Upgrade requests served without data = " << m_upgrade_without_data_count << std::endl;
+        out << "LLC Upgrade requests served as GetM (requester lost its copy) = " << m_upgrade_as_getm_count << std::endl;
+    }
+
+    void LLCMSIProtocol::registerStats(StatsRegistry &stats)
+    {
+        if (m_upgrade_event_id == -1)
+            return;
+        stats.add("LLC Upgrade requests", &m_upgrade_count);
+        stats.add("LLC Upgrade requests served without data", &m_upgrade_without_data_count);
+        stats.add("LLC Upgrade requests served as GetM (requester lost its copy)", &m_upgrade_as_getm_count);
+    }
+
     void LLCMSIProtocol::createDefaultCacheLine(uint64_t address, GenericCacheLine *cache_line)
     {
         int state = this->m_fsm->getState(string("IorS"));
@@ -19,31 +19,11 @@ namespace ns3
     {
     }
 
-    vector<ControllerAction> &LLCPMESIProtocol::handleAction(vector<int> &actions, Message &msg,
+    vector<ControllerAction> &LLCPMESIProtocol::handleAction(const FSMReader::ActionList &actions, Message &msg,
                                                              GenericCacheLine &cache_line_info, int next_state)
     {
-        bool wait_data = false;
-        bool execlusiveData = false;
-
-        for (int i = 0; i < (int)actions.size(); i++)
-        {
-            if (actions[i] == (int)ActionId::WaitData)
-            {
-                actions.erase(actions.begin() + i);
-                wait_data = true;
-                break;
-            }
-        }
-
-        for (int i = 0; i < (int)actions.size(); i++)
-        {
-            if (actions[i] == (int)ActionId::SendExeclusiveData)
-            {
-                actions.erase(actions.begin() + i);
-                execlusiveData = true;
-                break;
-            }
-        }
+        bool wait_data = actions.contains((int)ActionId::WaitData);
+        bool execlusiveData = actions.contains((int)ActionId::SendExeclusiveData);
 
         LLCMSIProtocol::handleAction(actions, msg, cache_line_info, next_state);
 
@@ -19,19 +19,10 @@ namespace ns3
     {
     }
     
-    vector<ControllerAction> &LLCPMSIProtocol::handleAction(vector<int> &actions, Message &msg,
+    vector<ControllerAction> &LLCPMSIProtocol::handleAction(const FSMReader::ActionList &actions, Message &msg,
                                                            GenericCacheLine &cache_line_info, int next_state)
     {
-        bool wait_data = false;
-        for (int i = 0; i < (int)actions.size(); i++)
-        {
-            if (actions[i] == (int)ActionId::WaitData)
-            {
-                actions.erase(actions.begin() + i);
-                wait_data = true;
-                break;
-            }
-        }
+        bool wait_data = actions.contains((int)ActionId::WaitData);
         LLCMSIProtocol::handleAction(actions, msg, cache_line_info, next_state);
 
         if (wait_data == true)
@@ -11,7 +11,7 @@ using namespace std;
 
 namespace ns3
 {
-    LLCPendulum::LLCPendulum(GenericCache *cache, const string &fsm_path, int coreId) : LLCMSIProtocol(cache, fsm_path, coreId)
+    LLCPendulum::LLCPendulum(CacheDataHandler *cache, const string &fsm_path, int coreId, int sharedMemId) : LLCMSIProtocol(cache, fsm_path, coreId, sharedMemId)
     {
     }
 
@@ -19,11 +19,22 @@ namespace ns3
     {
     }
 
+    const vector<ControllerAction> &LLCPendulum::processRequest(Message &request_msg)
+    {
+        GenericCacheLine cache_line;
+        LLCMSIProtocol::EventId event_id;
+
+        m_data_handler->readLineBits(request_msg.addr, &cache_line);
+
+        this->readEvent(request_msg, cache_line, &event_id);
+        const FSMReader::Transition &transition = this->m_fsm->getTransition(cache_line.state, (int)event_id);
 
-    vector<ControllerAction> &LLCPendulum::handleAction(vector<int> &actions, Message &msg,
-                                                           const GenericCache::CacheLineInfo &cache_line_info, int next_state)
+        return handleAction(transition.actions, request_msg, cache_line, transition.next_state);
+    }
+
+    vector<ControllerAction> &LLCPendulum::handleAction(const FSMReader::ActionList &actions, Message &msg,
+                                                        GenericCacheLine &cache_line, int next_state)
     {
-        int line_owner_id = cache_line_info.owner_id;
         this->controller_actions.clear();
 
         for (int action : actions)
@@ -31,115 +42,156 @@ namespace ns3
             ControllerAction controller_action;
             switch (static_cast<ActionId>(action))
             {
-            case ActionId::Stall: //return request to processing queue
-                controller_action.type = ControllerAction::Type::ADD_PENDING;
-                controller_action.data = (void *)new Message;
-                ((Message*)controller_action.data)->copy(msg);
-                break;
-            
-            case ActionId::IncrementSharer: //remove request from pending and respond to request
-                controller_action.type = ControllerAction::Type::ADD_SHARER;
-                controller_action.data = (void *)new Message;
-                ((Message*)controller_action.data)->copy(msg);
-                ((Message*)controller_action.data)->complementary_value = 0; //DualTrans == false
+            case ActionId::Stall:
+                controller_action.type = ControllerAction::Type::STALL;
+                controller_action.data = (void *)new Message();
+                ((Message *)controller_action.data)->copy(msg);
                 break;
 
-            case ActionId::DecrementSharer: //remove request from pending and respond to request
-                controller_action.type = ControllerAction::Type::REMOVE_SHARER;
-                controller_action.data = (void *)new Message;
-                ((Message*)controller_action.data)->copy(msg);
-                ((Message*)controller_action.data)->complementary_value = 0; //DualTrans == false
-                break;    
+            case ActionId::IncrementSharer:
+            case ActionId::DecrementSharer:
+                // the controller keeps the sharer count of the line, see CacheControllerPENDULUM_LLC
+                controller_action.type = (action == (int)ActionId::IncrementSharer) ? ControllerAction::Type::ADD_SHARER
+                                                                                    : ControllerAction::Type::REMOVE_SHARER;
+                controller_action.data = (void *)new Message();
+                ((Message *)controller_action.data)->copy(msg);
+                break;
 
-            case ActionId::SendData: //remove request from pending and respond to request
+            case ActionId::SendData: // remove request from pending and respond to request
                 controller_action.type = ControllerAction::Type::REMOVE_PENDING;
-                controller_action.data = (void *)new Message;
-                ((Message*)controller_action.data)->copy(msg);
-                ((Message*)controller_action.data)->complementary_value = 0; //DualTrans == false
+                controller_action.data = (void *)new Message();
+                ((Message *)controller_action.data)->copy(msg);
+                ((Message *)controller_action.data)->to.clear();
+                ((Message *)controller_action.data)->to.push_back(msg.owner);
+                break;
+
+            case ActionId::GetData:
+                // add request to pending requests
+                controller_action.type = ControllerAction::Type::ADD_PENDING;
+                controller_action.data = (void *)new Message();
+                ((Message *)controller_action.data)->copy(msg);
+                this->controller_actions.push_back(controller_action);
+
+                // request the line from main memory
+                controller_action.type = ControllerAction::Type::SEND_BUS_MSG;
+                controller_action.data = (void *)new Message(msg.msg_id,       // Id
+                                                             msg.addr,         // Addr
+                                                             0,                // Cycle
+                                                             (uint16_t)action, // Complementary_value
+                                                             msg.owner);       // Owner
+                ((Message *)controller_action.data)->to.push_back((uint16_t)this->m_shared_memory_id);
                 break;
 
             case ActionId::SaveReq:
-                //send Bus request, update cache line
                 controller_action.type = ControllerAction::Type::SAVE_REQ_FOR_WRITE_BACK;
-                controller_action.data = (void *)new Message{.msg_id = msg.msg_id,
-                                                             .addr = msg.addr,
-                                                             .from = (uint16_t)msg.from,
-                                                             .to = (uint16_t)this->m_core_id};
+                controller_action.data = (void *)new Message(msg.msg_id, // Id
+                                                             msg.addr,   // Addr
+                                                             0,          // Cycle
+                                                             0,          // Complementary_value
+                                                             msg.owner); // Owner
+                break;
 
             case ActionId::SetOwner:
-                line_owner_id = (msg.data == NULL) ? msg.from : msg.to;
+                cache_line.owner_id = msg.owner;
                 controller_action.type = ControllerAction::Type::NO_ACTION;
                 break;
 
             case ActionId::ClearOwner:
-                line_owner_id = -1;
+                cache_line.owner_id = -1;
                 controller_action.type = ControllerAction::Type::NO_ACTION;
                 break;
 
-            case ActionId::SaveData: //update cacheline (it happens by default if Action is not Stall)
+            case ActionId::SaveData: // update cacheline (it happens by default if Action is not Stall)
                 controller_action.type = ControllerAction::Type::NO_ACTION;
                 break;
 
             case ActionId::Fault:
-                std::cout << " LLCPendulum Fault Transaction detected" << std::endl;
+                std::cout << " LLCPendulum: Fault Transaction is detected" << std::endl;
+                assert(false);
                 exit(0);
                 break;
+
+            default:
+                continue;
             }
 
             this->controller_actions.push_back(controller_action);
         }
 
-        //update cache line
-        if ((actions.empty() && cache_line_info.IsExist) ||
-            (!actions.empty() && actions[0] != (int)ActionId::Stall))
-        {
-            GenericCacheLine cache_line(next_state, this->m_fsm->isValidState(next_state),
-                                        m_cache->CpuAddrMap(msg.addr).tag, msg.data, line_owner_id);
-            delete[] msg.data;
+        if ((actions.size() > 0) && (actions[0] == (int)ActionId::Stall))
+            return this->controller_actions;
 
-            ControllerAction controller_action;
-            controller_action.type = ControllerAction::Type::UPDATE_CACHE_LINE;
-            controller_action.data = (void *)new uint8_t[sizeof(cache_line) + sizeof(cache_line_info.set_idx) + sizeof(cache_line_info.way_idx)];
-            memcpy(controller_action.data, &cache_line, sizeof(cache_line));
-            memcpy((uint8_t *)controller_action.data + sizeof(cache_line), &cache_line_info.set_idx, sizeof(cache_line_info.set_idx));
-            memcpy((uint8_t *)controller_action.data + sizeof(cache_line) + sizeof(cache_line_info.set_idx),
-                   &cache_line_info.way_idx, sizeof(cache_line_info.way_idx));
+        // update cache line
+        ControllerAction controller_action;
 
-            this->controller_actions.push_back(controller_action);
-        }
+        cache_line.valid = this->m_fsm->isValidState(next_state);
+        cache_line.state = next_state;
+
+        controller_action.type = ControllerAction::Type::UPDATE_CACHE_LINE;
+        controller_action.data = (void *)new uint8_t[sizeof(Message) + sizeof(cache_line)];
+
+        new (controller_action.data) Message(msg);
+        new ((uint8_t *)controller_action.data + sizeof(Message)) GenericCacheLine(cache_line);
+
+        this->controller_actions.push_back(controller_action);
 
         return this->controller_actions;
     }
-    
-    void LLCPendulum::readEvent(Message &msg, GenericCache::CacheLineInfo cache_line_info, LLCMSIProtocol::EventId *out_id)
+
+    void LLCPendulum::readEvent(Message &msg, GenericCacheLine &cache_line, LLCMSIProtocol::EventId *out_id)
     {
+        EventId event_id;
+
         switch (msg.source)
         {
-        case Message::Source::LOWER_INTERCONNECT:
+        case Message::Source::SELF: // the controller saw the line's last sharer leave
+            event_id = EventId::Sharers_0;
+            break;
+
+        case Message::Source::UPPER_INTERCONNECT:
             if (msg.data == NULL)
-            { 
-                switch (msg.complementary_value)
-                {
-                case SNOOPPrivCohTrans::InvGetMTrans:
-                    *out_id = (LLCMSIProtocol::EventId) EventId::Inv_GetM;
-                    return;
-                case SNOOPPrivCohTrans::InvTrans:
-                    *out_id = (LLCMSIProtocol::EventId) EventId::SelfInv;
-                    return;
-                default: // Invalid Transaction
-                    break;
-                }
+            {
+                std::cout << "Invalid Message Source at LLC" << std::endl;
+                exit(0);
             }
+            event_id = EventId::Data_fromUpperInterface;
             break;
 
-        case Message::Source::SELF:
-            *out_id = (LLCMSIProtocol::EventId) EventId::Sharers_0;
-            return;
-        
-        default:
+        case Message::Source::LOWER_INTERCONNECT:
+            if (msg.data != NULL)
+            {
+                event_id = EventId::Data_fromLowerInterface;
+                break;
+            }
+
+            switch (msg.complementary_value)
+            {
+            case MSIProtocol::REQUEST_TYPE_GETS:
+                event_id = EventId::GetS;
+                break;
+            case MSIProtocol::REQUEST_TYPE_GETM:
+                event_id = EventId::GetM;
+                break;
+            case MSIProtocol::REQUEST_TYPE_PUTM:
+                event_id = (msg.owner == cache_line.owner_id) ? EventId::PutM_fromOwner : EventId::PutM_fromNonOwner;
+                break;
+            case Pendulum::REQUEST_TYPE_INV_GETM:
+                event_id = EventId::Inv_GetM;
+                break;
+            case Pendulum::REQUEST_TYPE_SELF_INV:
+                event_id = EventId::SelfInv;
+                break;
+            default: // Invalid Transaction
+                std::cout << " LLCPendulum: Invalid Transaction detected on the Bus" << std::endl;
+                exit(0);
+            }
             break;
+
+        default:
+            std::cout << "Invalid Message Source at LLC" << std::endl;
+            exit(0);
         }
 
-        LLCMSIProtocol::readEvent(msg, cache_line_info, out_id);
+        *out_id = (LLCMSIProtocol::EventId)event_id;
     }
-}
\ No newline at end of file
+}
@@ -34,19 +34,10 @@ namespace ns3
             *out_id = (MSIProtocol::EventId)((msg.complementary_value == 2) ? EventId::OwnData_Execlusive : EventId::OwnData);
     }
 
-    vector<ControllerAction> &MESIProtocol::handleAction(vector<int> &actions, Message &msg,
+    vector<ControllerAction> &MESIProtocol::handleAction(const FSMReader::ActionList &actions, Message &msg,
                                                             GenericCacheLine &cache_line_info, int next_state)
     {
-        bool remove_saved_request = false;
-        for (int i = 0; i < (int)actions.size(); i++)
-        {
-            if (actions[i] == (int)ActionId::removeSavedReq)
-            {
-                actions.erase(actions.begin() + i);
-                remove_saved_request = true;
-                break;
-            }
-        }
+        bool remove_saved_request = actions.contains((int)ActionId::removeSavedReq);
         MSIProtocol::handleAction(actions, msg, cache_line_info, next_state);
 
         if (remove_saved_request == true)
@@ -14,6 +14,13 @@ namespace ns3
 {
     MSIProtocol::MSIProtocol(CacheDataHandler *cache, const string &fsm_path, int coreId, int sharedMemId) : CoherenceProtocolHandler(cache, fsm_path, coreId, sharedMemId)
     {
+        m_upgrade_action_id = this->m_fsm->getAction(string("Upg"));
+        m_own_upgrade_event_id = this->m_fsm->getEvent(string("Own_Upg"));
+        m_other_upgrade_event_id = this->m_fsm->getEvent(string("Other_Upg"));
+
+        m_getm_count = 0;
+        m_upgrade_count = 0;
+        m_lost_upgrade_count = 0;
     }
 
     MSIProtocol::~MSIProtocol()
@@ -81,20 +88,39 @@ namespace ns3
         return states;
     }
 
+    bool MSIProtocol::isOwnerState(int state)
+    {
+        if (m_owner_states.empty())
+        {
+            // At least one flag, so the table is built only once
+            m_owner_states.resize(1, false);
+            for (int owner_state : this->statesRequireWriteBack())
+            {
+                if (owner_state < 0)
+                    continue;
+                if (owner_state >= (int)m_owner_states.size())
+                    m_owner_states.resize(owner_state + 1, false);
+                m_owner_states[owner_state] = true;
+            }
+        }
+        return state >= 0 && state < (int)m_owner_states.size() && m_owner_states[state];
+    }
+
     // Based on the request message and the current state of the address'
     // cache line, determine the next state of the line and return the 
     // required actions
     const vector<ControllerAction> &MSIProtocol::processRequest(Message &request_msg)
     {
         EventId event_id;
-        int next_state;
-        vector<int> actions;
         GenericCacheLine cache_line;
 
         m_data_handler->readLineBits(request_msg.addr, &cache_line);
 
         this->readEvent(request_msg, &event_id);
-        this->m_fsm->getTransition(cache_line.state, (int)event_id, next_state, actions);
+        this->resolveUpgradeRace(request_msg, cache_line, &event_id);
+        const FSMReader::Transition &transition = this->m_fsm->getTransition(cache_line.state, (int)event_id);
+        const FSMReader::ActionList &actions = transition.actions;
+        int next_state = transition.next_state;
 
         // Timestamp code
         // Message issued from core to its L1:
@@ -103,7 +129,7 @@ namespace ns3
             // If the message is a load or store:
             // check if message is a hit; if so, no need to modify either cache
             if ((event_id == EventId::Load || event_id == EventId::Store) &&
-                actions == vector<int>{1})
+                actions.size() == 1 && actions[0] == (int)ActionId::Hit)
             {
                 std::cerr << request_msg.msg_id << "," << request_msg.addr 
                     << "," << "wrCache" << "," <<  m_core_id << ","<< -1 << "\n";
@@ -193,7 +219,7 @@ namespace ns3
         return handleAction(actions, request_msg, cache_line, next_state);
     }
 
-    vector<ControllerAction> &MSIProtocol::handleAction(std::vector<int> &actions, Message &msg,
+    vector<ControllerAction> &MSIProtocol::handleAction(const FSMReader::ActionList &actions, Message &msg,
                                                         GenericCacheLine &cache_line, int next_state)
     {
         this->controller_actions.clear();
@@ -236,6 +262,9 @@ namespace ns3
                                                              (uint16_t)this->m_core_id);                                       // Owner
 
                 ((Message *)controller_action.data)->to.push_back((uint16_t)this->m_shared_memory_id);
+
+                if (action == (int)ActionId::GetM)
+                    m_getm_count++;
                 break;
             case ActionId::PutM:
                 // send Bus request, update cache line
@@ -274,6 +303,28 @@ namespace ns3
                 assert(1 != 1);
 //                exit(0);
                 break;
+
+            default:
+                if (action != m_upgrade_action_id) // actions of derived protocols are handled by their own handleAction
+                    continue;
+
+                // same as GetM, but the LLC and the other sharers do not send data back
+                controller_action.type = ControllerAction::Type::ADD_PENDING;
+                controller_action.data = (void *)new Message();
+                ((Message *)controller_action.data)->copy(msg);
+                this->controller_actions.push_back(controller_action);
+
+                controller_action.type = ControllerAction::Type::SEND_BUS_MSG;
+                controller_action.data = (void *)new Message(msg.msg_id,                    // Id
+                                                             msg.addr,                      // Addr
+                                                             0,                             // Cycle
+                                                             MSIProtocol::REQUEST_TYPE_UPG, // Complementary_value
+                                                             (uint16_t)this->m_core_id);    // Owner
+                ((Message *)controller_action.data)->to.push_back((uint16_t)this->m_shared_memory_id);
+
+                m_pending_upgrades.insert(m_data_handler->lineAddress(msg.addr));
+                m_upgrade_count++;
+                break;
             }
 
             this->controller_actions.push_back(controller_action);
@@ -299,6 +350,56 @@ namespace ns3
         return this->controller_actions;
     }
 
+    void MSIProtocol::resolveUpgradeRace(const Message &msg, const GenericCacheLine &cache_line, EventId *event_id)
+    {
+        if (m_upgrade_action_id == -1 || msg.source != Message::Source::UPPER_INTERCONNECT || msg.data != NULL)
+            return;
+
+        uint64_t line = m_data_handler->lineAddress(msg.addr);
+        if (m_own_upgrade_event_id != -1 && (int)*event_id == m_own_upgrade_event_id)
+        {
+            if (m_lost_upgrades.erase(line) != 0)
+            {
+                *event_id = EventId::Own_GetM;
+                m_lost_upgrade_count++;
+            }
+            m_pending_upgrades.erase(line);
+            return;
+        }
+
+        bool is_other_upgrade = m_other_upgrade_event_id != -1 && (int)*event_id == m_other_upgrade_event_id;
+        if ((is_other_upgrade || *event_id == EventId::Other_GetM || *event_id == EventId::Invalidation) &&
+            m_pending_upgrades.count(line) != 0)
+            m_lost_upgrades.insert(line);
+
+        // The requester lost its copy before its Upgrade and the LLC waits for
+        // the owner's data, as for a GetM
+        if (is_other_upgrade)
+        {
+            if (isOwnerState(cache_line.state))
+                *event_id = EventId::Other_GetM;
+        }
+    }
+
+    void MSIProtocol::printStats(std::ostream &out)
+    {
+        out << "Core " << m_core_id << " GetM requests = " << m_getm_count << std::endl;
+        if (m_upgrade_action_id == -1)
+            return;
+        out << "Core " << m_core_id << " Upgrade requests = " << m_upgrade_count << std::endl;
+        out << "Core " << m_core_id << " Upgrade requests reissued as GetM (copy invalidated first) = " << m_lost_upgrade_count << std::endl;
+    }
+
+    void MSIProtocol::registerStats(StatsRegistry &stats)
+    {
+        StatsRegistry::Scope core(stats, "Core " + std::to_string(m_core_id));
+        stats.add("GetM requests", &m_getm_count);
+        if (m_upgrade_action_id == -1)
+            return;
+        stats.add("Upgrade requests", &m_upgrade_count);
+        stats.add("Upgrade requests reissued as GetM (copy invalidated first)", &m_lost_upgrade_count);
+    }
+
     void MSIProtocol::readEvent(Message &msg, EventId *out_id)
     {
         switch (msg.source)
@@ -334,6 +435,12 @@ namespace ns3
                 case MSIProtocol::REQUEST_TYPE_PUTM:
                     *out_id = (msg.owner == m_core_id) ? EventId::Own_PutM : EventId::Other_PutM;
                     return;
+                case MSIProtocol::REQUEST_TYPE_UPG:
+                    if (msg.owner == m_core_id)
+                        *out_id = (m_own_upgrade_event_id != -1) ? (EventId)m_own_upgrade_event_id : EventId::Own_GetM;
+                    else
+                        *out_id = (m_other_upgrade_event_id != -1) ? (EventId)m_other_upgrade_event_id : EventId::Other_GetM;
+                    return;
                 case MSIProtocol::REQUEST_TYPE_INV:
                     *out_id = EventId::Invalidation;
                     return;
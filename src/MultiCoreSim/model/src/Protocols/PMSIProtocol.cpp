@@ -19,19 +19,10 @@ namespace ns3
     {
     }
 
-    vector<ControllerAction> &PMSIProtocol::handleAction(vector<int> &actions, Message &msg,
+    vector<ControllerAction> &PMSIProtocol::handleAction(const FSMReader::ActionList &actions, Message &msg,
                                                          GenericCacheLine &cache_line_info, int next_state)
     {
-        bool putm_non_demanding = false;
-        for (int i = 0; i < (int)actions.size(); i++)
-        {
-            if (actions[i] == (int)ActionId::PutM_nonDem)
-            {
-                actions.erase(actions.begin() + i);
-                putm_non_demanding = true;
-                break;
-            }
-        }
+        bool putm_non_demanding = actions.contains((int)ActionId::PutM_nonDem);
         MSIProtocol::handleAction(actions, msg, cache_line_info, next_state);
 
         if (putm_non_demanding == true)
@@ -11,15 +11,39 @@ using namespace std;
 
 namespace ns3
 {
-    Pendulum::Pendulum(GenericCache *cache, const string &fsm_path, int coreId, int sharedMemId) : MSIProtocol(cache, fsm_path, coreId, sharedMemId)
+    Pendulum::Pendulum(CacheDataHandler *cache, const string &fsm_path, int coreId, int sharedMemId) : MSIProtocol(cache, fsm_path, coreId, sharedMemId)
     {
     }
 
     Pendulum::~Pendulum()
     {
     }
-   vector<ControllerAction> &Pendulum::handleAction(vector<int> &actions, Message &msg,
-                                                        const GenericCache::CacheLineInfo &cache_line_info, int next_state)
+
+    FRFCFS_State Pendulum::getRequestState(const Message &msg, FRFCFS_State req_state)
+    {
+        // A timeout is only injected for a line that is still in the cache,
+        // so it never needs to allocate a way
+        if (msg.source == Message::Source::SELF)
+            return FRFCFS_State::Ready;
+
+        return MSIProtocol::getRequestState(msg, req_state);
+    }
+
+    const vector<ControllerAction> &Pendulum::processRequest(Message &request_msg)
+    {
+        MSIProtocol::EventId event_id;
+        GenericCacheLine cache_line;
+
+        m_data_handler->readLineBits(request_msg.addr, &cache_line);
+
+        this->readEvent(request_msg, &event_id);
+        const FSMReader::Transition &transition = this->m_fsm->getTransition(cache_line.state, (int)event_id);
+
+        return handleAction(transition.actions, request_msg, cache_line, transition.next_state);
+    }
+
+    vector<ControllerAction> &Pendulum::handleAction(const FSMReader::ActionList &actions, Message &msg,
+                                                     GenericCacheLine &cache_line, int next_state)
     {
         this->controller_actions.clear();
         for (int action : actions)
@@ -27,150 +51,173 @@ namespace ns3
             ControllerAction controller_action;
             switch (static_cast<ActionId>(action))
             {
-            case ActionId::Stall: //return request to processing queue
-                controller_action.type = ControllerAction::Type::ADD_PENDING;
-                controller_action.data = (void *)new Message;
+            case ActionId::Stall:
+                controller_action.type = ControllerAction::Type::STALL;
+                controller_action.data = (void *)new Message();
                 ((Message *)controller_action.data)->copy(msg);
                 break;
 
-            case ActionId::Hit: //remove request from pending and respond to cpu, update cache line
+            case ActionId::Hit: // remove request from pending and respond to cpu, update cache line
                 controller_action.type = (msg.source == Message::Source::LOWER_INTERCONNECT)
                                              ? ControllerAction::Type::HIT_Action
                                              : ControllerAction::Type::REMOVE_PENDING;
-                controller_action.data = (void *)new Message;
+                controller_action.data = (void *)new Message();
                 ((Message *)controller_action.data)->copy(msg);
                 break;
 
             case ActionId::GetS:
             case ActionId::GetM:
             case ActionId::Inv_GetM:
-                //add request to pending requests
+                // add request to pending requests
                 controller_action.type = ControllerAction::Type::ADD_PENDING;
-                controller_action.data = (void *)new Message;
+                controller_action.data = (void *)new Message();
                 ((Message *)controller_action.data)->copy(msg);
                 this->controller_actions.push_back(controller_action);
 
-                //send Bus request, update cache line
+                // send Bus request, update cache line
                 controller_action.type = ControllerAction::Type::SEND_BUS_MSG;
-                controller_action.data = (void *)new Message{.msg_id = msg.msg_id,
-                                                             .addr = msg.addr,
-                                                             .complementary_value = (uint16_t)action,
-                                                             .from = (uint16_t)this->m_core_id,
-                                                             .to = (uint16_t)this->m_shared_memory_id};
+                controller_action.data = (void *)new Message(msg.msg_id, // Id
+                                                             msg.addr,   // Addr
+                                                             0,          // Cycle
+                                                             (action == (int)ActionId::GetS)   ? MSIProtocol::REQUEST_TYPE_GETS
+                                                             : (action == (int)ActionId::GetM) ? MSIProtocol::REQUEST_TYPE_GETM
+                                                                                               : Pendulum::REQUEST_TYPE_INV_GETM, // Complementary_value
+                                                             (uint16_t)this->m_core_id);                                         // Owner
+                ((Message *)controller_action.data)->to.push_back((uint16_t)this->m_shared_memory_id);
+
+                if (action != (int)ActionId::GetS)
+                    m_getm_count++;
                 break;
 
             case ActionId::PutM:
-                //send Bus request, update cache line
+            case ActionId::SelfInv:
+                // send Bus request, update cache line
                 controller_action.type = ControllerAction::Type::SEND_BUS_MSG;
-                controller_action.data = (void *)new Message{.msg_id = msg.msg_id,
-                                                             .addr = msg.addr,
-                                                             .complementary_value = (uint16_t)action,   //Ask About Complementary value
-                                                             .from = (uint16_t)this->m_shared_memory_id,
-                                                             .to = (uint16_t)this->m_core_id};
+                controller_action.data = (void *)new Message(msg.msg_id, // Id
+                                                             msg.addr,   // Addr
+                                                             0,          // Cycle
+                                                             (action == (int)ActionId::PutM) ? MSIProtocol::REQUEST_TYPE_PUTM
+                                                                                             : Pendulum::REQUEST_TYPE_SELF_INV, // Complementary_value
+                                                             (uint16_t)this->m_core_id);                                        // Owner
+                ((Message *)controller_action.data)->to.push_back((uint16_t)this->m_shared_memory_id);
                 break;
 
             case ActionId::Data2Req:
             case ActionId::Data2Both:
-                //Do writeback, update cache line
+                // Do writeback, update cache line
                 controller_action.type = ControllerAction::Type::WRITE_BACK;
-                controller_action.data = (void *)new Message{.msg_id = msg.msg_id,
-                                                             .addr = msg.addr,
-                                                             .complementary_value = (uint16_t)((action == (int)ActionId::Data2Both) ? 1 : 0),
-                                                             .from = (uint16_t)msg.from,
-                                                             .to = (uint16_t)this->m_core_id};
+                controller_action.data = (void *)new Message(msg);
+
+                ((Message *)controller_action.data)->to.clear();
+                if (action == (int)ActionId::Data2Both)
+                    ((Message *)controller_action.data)->to.push_back((uint16_t)this->m_shared_memory_id);
                 break;
 
             case ActionId::SaveReq:
-                //send Bus request, update cache line
                 controller_action.type = ControllerAction::Type::SAVE_REQ_FOR_WRITE_BACK;
-                controller_action.data = (void *)new Message{.msg_id = msg.msg_id,
-                                                             .addr = msg.addr,
-                                                             .from = (uint16_t)msg.from,
-                                                             .to = (uint16_t)this->m_core_id};
+                controller_action.data = (void *)new Message(msg.msg_id, // Id
+                                                             msg.addr,   // Addr
+                                                             0,          // Cycle
+                                                             0,          // Complementary_value
+                                                             msg.owner); // Owner
                 break;
 
-            case ActionId::SelfInv:
-                controller_action.type = ControllerAction::Type::SEND_BUS_MSG;
-                controller_action.data = (void *)new Message{.msg_id = msg.msg_id,
-                                                             .addr = msg.addr,
-                                                             .complementary_value = (uint16_t)action,
-                                                             .from = (uint16_t)this->m_core_id,
-                                                             .to = (uint16_t)this->m_shared_memory_id};
-                break;
-            
             case ActionId::Stop_T:
             case ActionId::RT:
+                // stop (1) or (re)start (0) the line's timer, see CacheControllerPENDULUM
                 controller_action.type = ControllerAction::Type::TIMER_ACTION;
-                controller_action.data = (void *)new Message{.msg_id = msg.msg_id,
-                                                             .addr = msg.addr,
-                                                             .complementary_value = (uint16_t)((action == (int)ActionId::Stop_T) ? 1 : 0),
-                                                             .from = (uint16_t)msg.from,
-                                                             .to = (uint16_t)this->m_core_id};
+                controller_action.data = (void *)new Message(msg.msg_id,                                  // Id
+                                                             msg.addr,                                    // Addr
+                                                             0,                                           // Cycle
+                                                             (action == (int)ActionId::Stop_T) ? 1 : 0,   // Complementary_value
+                                                             (uint16_t)this->m_core_id);                  // Owner
                 break;
 
             case ActionId::Fault:
-                std::cout << " Pendulum: Fault Transaction detected" << std::endl;
+                std::cout << " Pendulum: Fault Transaction is detected" << std::endl;
+                assert(false);
                 exit(0);
-                break;
 
+            default:
+                continue;
             }
 
             this->controller_actions.push_back(controller_action);
         }
 
-        //update cache line
-        if ((actions.empty() && cache_line_info.IsExist) ||
-            (!actions.empty() && actions[0] != (int)ActionId::Stall))
-        {
-            GenericCacheLine cache_line(next_state, this->m_fsm->isValidState(next_state),
-                                        m_cache->CpuAddrMap(msg.addr).tag, msg.data);
-            delete[] msg.data;
+        if ((actions.size() > 0) && (actions[0] == (int)ActionId::Stall))
+            return this->controller_actions;
 
-            ControllerAction controller_action;
-            controller_action.type = ControllerAction::Type::UPDATE_CACHE_LINE;
-            controller_action.data = (void *)new uint8_t[sizeof(cache_line) + sizeof(cache_line_info.set_idx) + sizeof(cache_line_info.way_idx)];
-            memcpy(controller_action.data, &cache_line, sizeof(cache_line));
-            memcpy((uint8_t *)controller_action.data + sizeof(cache_line), &cache_line_info.set_idx, sizeof(cache_line_info.set_idx));
-            memcpy((uint8_t *)controller_action.data + sizeof(cache_line) + sizeof(cache_line_info.set_idx),
-                   &cache_line_info.way_idx, sizeof(cache_line_info.way_idx));
+        // update cache line
+        ControllerAction controller_action;
 
-            this->controller_actions.push_back(controller_action);
-        }
+        cache_line.valid = this->m_fsm->isValidState(next_state);
+        cache_line.state = next_state;
+
+        controller_action.type = ControllerAction::Type::UPDATE_CACHE_LINE;
+        controller_action.data = (void *)new uint8_t[sizeof(Message) + sizeof(cache_line)];
+
+        new (controller_action.data) Message(msg);
+        new ((uint8_t *)controller_action.data + sizeof(Message)) GenericCacheLine(cache_line);
+
+        this->controller_actions.push_back(controller_action);
 
         return this->controller_actions;
     }
 
     void Pendulum::readEvent(Message &msg, MSIProtocol::EventId *out_id)
     {
+        // Pendulum numbers its events differently from MSI, so the whole
+        // mapping is done here instead of falling back to MSIProtocol::readEvent
+        EventId event_id;
+
         switch (msg.source)
         {
+        case Message::Source::LOWER_INTERCONNECT:
+            event_id = (msg.complementary_value == CpuFIFO::REQTYPE::READ)    ? EventId::Load
+                       : (msg.complementary_value == CpuFIFO::REQTYPE::WRITE) ? EventId::Store
+                                                                              : EventId::Replacement;
+            break;
+
         case Message::Source::SELF:
-            *out_id = (MSIProtocol::EventId) EventId::Timeout;
-            return;
+            event_id = EventId::Timeout;
+            break;
 
         case Message::Source::UPPER_INTERCONNECT:
             if (msg.data != NULL)
             {
-                *out_id = (MSIProtocol::EventId) EventId::Data;
+                event_id = EventId::Data;
+                break;
             }
-            else
-            {
+
             switch (msg.complementary_value)
-                {
-                case SNOOPPrivCohTrans::InvGetMTrans:
-                    *out_id = (msg.to == m_core_id) ? (MSIProtocol::EventId) EventId::Own_InvGetM : (MSIProtocol::EventId) EventId::Other_InvGetM;
-                    return;
-                case SNOOPPrivCohTrans::InvTrans:
-                    *out_id = (MSIProtocol::EventId) EventId::Own_SelfInv;
-                    return;
-                default: 
-                    break;
-                }
+            {
+            case MSIProtocol::REQUEST_TYPE_GETS:
+                event_id = (msg.owner == m_core_id) ? EventId::Own_GetS : EventId::Other_GetS;
+                break;
+            case MSIProtocol::REQUEST_TYPE_GETM:
+                event_id = (msg.owner == m_core_id) ? EventId::Own_GetM : EventId::Other_GetM;
+                break;
+            case MSIProtocol::REQUEST_TYPE_PUTM:
+                event_id = (msg.owner == m_core_id) ? EventId::Own_PutM : EventId::Other_PutM;
+                break;
+            case Pendulum::REQUEST_TYPE_INV_GETM:
+                event_id = (msg.owner == m_core_id) ? EventId::Own_InvGetM : EventId::Other_InvGetM;
+                break;
+            case Pendulum::REQUEST_TYPE_SELF_INV:
+                event_id = (msg.owner == m_core_id) ? EventId::Own_SelfInv : EventId::Other_SelfInv;
+                break;
+            default: // Invalid Transaction
+                std::cout << " Pendulum: Invalid Transaction detected on the Bus" << std::endl;
+                exit(0);
             }
-        default:
             break;
+
+        default:
+            std::cout << "Invalid message source" << std::endl;
+            exit(0);
         }
-        MSIProtocol::readEvent(msg, out_id);
-    }
 
-}
\ No newline at end of file
+        *out_id = (MSIProtocol::EventId)event_id;
+    }
+}
@@ -1,27 +1,59 @@
 #include "../header/ROB.h"
 #include "../header/LSQ.h"
 #include "../header/CpuCoreGenerator.h"
+#include <stdexcept>
+#include <algorithm>
 
 namespace ns3 {
 
-ROB::ROB() 
-    : m_num_entries(0),
+ROB::ROB(uint32_t max_entries, uint32_t retire_width) 
+    : m_max_entries(0),
+      m_retire_width(0),
+      m_num_entries(0),
       m_rob_q(),
+      m_mask(0),
+      m_head(0),
+      m_tail(0),
       m_lsq(nullptr),
       m_cpu(nullptr),
-      m_current_cycle(0) {
-    m_rob_q.reserve(MAX_ENTRIES);
-    std::cout << "[ROB] Initialized with " << MAX_ENTRIES << " entries capacity" << std::endl;
+      m_thread(0),
+      m_current_cycle(0),
+      m_debug(false) {
+    configure(max_entries, retire_width);
 }
 
 ROB::~ROB() {}
 
+void ROB::configure(uint32_t max_entries, uint32_t retire_width) {
+    if (m_num_entries != 0) {
+        std::cerr << "[ROB] ERROR: Cannot resize a non-empty ROB" << std::endl;
+        throw std::runtime_error("ROB resized while in use");
+    }
+
+    m_max_entries = (max_entries > 0) ? max_entries : DEFAULT_ENTRIES;
+    m_retire_width = (retire_width > 0) ? retire_width : DEFAULT_IPC;
+
+    // Round the ring up to a power of two so a slot is seq & m_mask
+    uint64_t ring_size = 1;
+    while (ring_size < m_max_entries) {
+        ring_size <<= 1;
+    }
+    m_rob_q.assign(ring_size, ROBEntry());
+    m_mask = ring_size - 1;
+    m_head = m_tail = 0;
+    m_seq_of.clear();
+    m_seq_of.reserve(m_max_entries);
+
+    std::cout << "[ROB] Initialized with " << m_max_entries << " entries capacity, retire width "
+              << m_retire_width << std::endl;
+}
+
 void ROB::step() {
-    std::cout << "\n[ROB] ========== Step at cycle " << m_current_cycle << " ==========" << std::endl;
-    std::cout << "[ROB] Current entries: " << m_num_entries << "/" << MAX_ENTRIES << std::endl;
-    
-    // Print current ROB state
-    printState();
+    if (m_debug) {
+        std::cout << "\n[ROB] ========== Step at cycle " << m_current_cycle << " ==========" << std::endl;
+        std::cout << "[ROB] Current entries: " << m_num_entries << "/" << m_max_entries << std::endl;
+        printState();
+    }
     
     // As per 3.4, retire instructions every cycle
     retire();
@@ -29,110 +61,169 @@ void ROB::step() {
 }
 
 bool ROB::canAccept() {
-    bool can_accept = m_num_entries < MAX_ENTRIES;
-    std::cout << "[ROB] Can accept new entry: " << (can_accept ? "yes" : "no") 
-              << " (" << m_num_entries << "/" << MAX_ENTRIES << ")" << std::endl;
+    bool can_accept = m_num_entries < m_max_entries;
+    if (m_debug) {
+        std::cout << "[ROB] Can accept new entry: " << (can_accept ? "yes" : "no") 
+                  << " (" << m_num_entries << "/" << m_max_entries << ")" << std::endl;
+    }
     return can_accept;
 }
 
-bool ROB::allocate(const CpuFIFO::ReqMsg& request) {
-    if (!canAccept()) {
-        std::cout << "[ROB] Allocation failed - ROB full" << std::endl;
+bool ROB::allocate(const CpuFIFO::ReqMsg& request, uint32_t count) {
+    if (count == 0 || count > freeEntries()) {
+        if (m_debug) {
+            std::cout << "[ROB] Allocation failed - ROB full" << std::endl;
+        }
         return false;
     }
 
-    ROBEntry entry;
+    // A run of compute instructions (ids request.msgId ... request.msgId + count - 1)
+    // joins the compute entry at the tail when there is one
+    if (request.type == CpuFIFO::REQTYPE::COMPUTE && m_tail != m_head &&
+        entryAt(m_tail - 1).request.type == CpuFIFO::REQTYPE::COMPUTE) {
+        entryAt(m_tail - 1).count += count;
+        m_num_entries += count;
+        if (m_debug) {
+            std::cout << "[ROB] Merged " << count << " compute instructions from request " << request.msgId
+                      << " into the tail entry at cycle " << m_current_cycle << std::endl;
+        }
+        return true;
+    }
+
+    ROBEntry& entry = entryAt(m_tail);
     entry.request = request;
+    entry.key = request.msgId;
     entry.allocate_cycle = m_current_cycle;
+    entry.count = count;
     
     // As per 3.3.1, compute instructions are ready immediately
     entry.ready = (request.type == CpuFIFO::REQTYPE::COMPUTE);
     
-    m_rob_q.push_back(entry);
-    m_num_entries++;
+    // Compute entries are never committed, so only memory instructions are indexed
+    if (!entry.ready) {
+        m_seq_of[request.msgId] = m_tail;
+    }
+    m_tail++;
+    m_num_entries += count;
     
-    std::cout << "[ROB] Allocated entry for request " << request.msgId 
-              << " type=" << (int)request.type 
-              << " ready=" << entry.ready 
-              << " at cycle " << m_current_cycle << std::endl;
+    if (m_debug) {
+        std::cout << "[ROB] Allocated entry for request " << request.msgId 
+                  << " type=" << (int)request.type 
+                  << " count=" << count
+                  << " ready=" << entry.ready 
+                  << " at cycle " << m_current_cycle << std::endl;
+    }
     return true;
 }
 
 void ROB::retire() {
-    if (m_rob_q.empty()) {
-        std::cout << "[ROB] No entries to retire" << std::endl;
+    if (m_num_entries == 0) {
+        if (m_debug) {
+            std::cout << "[ROB] No entries to retire" << std::endl;
+        }
         return;
     }
     
-    std::cout << "[ROB] Starting retirement at cycle " << m_current_cycle << std::endl;
+    if (m_debug) {
+        std::cout << "[ROB] Starting retirement at cycle " << m_current_cycle << std::endl;
+    }
     
     // As per 3.4: ROB is the only class architecturally retiring instructions
     // Must maintain program order, so check from top of ROB queue
     uint32_t retired = 0;
     
     // Keep retiring until we hit IPC limit or a non-ready instruction
-    while (!m_rob_q.empty() && retired < IPC) {
-        ROBEntry& head = m_rob_q.front();
+    while (m_num_entries > 0 && retired < m_retire_width) {
+        ROBEntry& head = entryAt(m_head);
         
-        std::cout << "[ROB] Examining head entry: msgId=" << head.request.msgId 
-                  << " type=" << (int)head.request.type
-                  << " ready=" << head.ready 
-                  << " allocated at cycle " << head.allocate_cycle << std::endl;
+        if (m_debug) {
+            std::cout << "[ROB] Examining head entry: msgId=" << head.request.msgId 
+                      << " type=" << (int)head.request.type
+                      << " ready=" << head.ready 
+                      << " allocated at cycle " << head.allocate_cycle << std::endl;
+        }
         
         // Stop at first non-ready instruction to maintain program order
         if (!head.ready) {
-            std::cout << "[ROB] Head entry not ready (request " << head.request.msgId 
-                      << "), stopping retirement to maintain program order" << std::endl;
+            if (m_debug) {
+                std::cout << "[ROB] Head entry not ready (request " << head.request.msgId 
+                          << "), stopping retirement to maintain program order" << std::endl;
+            }
             break;
         }
         
-        std::cout << "[ROB] Architecturally retiring request " << head.request.msgId 
-                  << " type=" << (int)head.request.type 
-                  << " allocated at cycle " << head.allocate_cycle 
-                  << " retired at cycle " << m_current_cycle << std::endl;
+        if (m_debug) {
+            std::cout << "[ROB] Architecturally retiring request " << head.request.msgId 
+                      << " type=" << (int)head.request.type 
+                      << " allocated at cycle " << head.allocate_cycle 
+                      << " retired at cycle " << m_current_cycle << std::endl;
+        }
         
         // For stores, notify LSQ that store can be written to cache
         if (head.request.type == CpuFIFO::REQTYPE::WRITE && m_lsq) {
-            std::cout << "[ROB] Notifying LSQ to commit store " << head.request.msgId << std::endl;
+            if (m_debug) {
+                std::cout << "[ROB] Notifying LSQ to commit store " << head.request.msgId << std::endl;
+            }
             m_lsq->commit(head.request.msgId);
         }
 
+        // A compute entry retires as many of its instructions as the width allows
+        uint32_t n = std::min(head.count, m_retire_width - retired);
+
         // Notify CPU of retirement - CRITICAL for tracking in-flight instructions
         if (m_cpu) {
-            m_cpu->onInstructionRetired(head.request);
+            m_cpu->onInstructionRetired(m_thread, head.request, n);
         }
         
-        // Remove from ROB after architectural retirement
-        m_rob_q.erase(m_rob_q.begin());
-        m_num_entries--;
-        retired++;
+        m_num_entries -= n;
+        retired += n;
+        head.count -= n;
+        if (head.count > 0) {
+            head.request.msgId += n;
+            break;
+        }
+
+        // Remove from ROB after architectural retirement; a partly retired
+        // compute entry has moved its msgId on, the index keeps the first one
+        m_seq_of.erase(head.key);
+        m_head++;
         
-        std::cout << "[ROB] Successfully retired instruction " << head.request.msgId 
-                  << " (" << retired << "/" << IPC << " this cycle)" << std::endl;
+        if (m_debug) {
+            std::cout << "[ROB] Successfully retired instruction " << head.request.msgId 
+                      << " (" << retired << "/" << m_retire_width << " this cycle)" << std::endl;
+        }
     }
     
-    if (retired > 0) {
+    if (m_debug && retired > 0) {
         std::cout << "[ROB] Architecturally retired " << retired << " instructions this cycle" 
                   << ", remaining entries: " << m_num_entries << std::endl;
     }
     
-    std::cout << "[ROB] Retirement complete for cycle " << m_current_cycle << std::endl;
+    if (m_debug) {
+        std::cout << "[ROB] Retirement complete for cycle " << m_current_cycle << std::endl;
+    }
 }
 
 void ROB::commit(uint64_t requestId) {
-    std::cout << "[ROB] Attempting to commit request " << requestId << std::endl;
+    if (m_debug) {
+        std::cout << "[ROB] Attempting to commit request " << requestId << std::endl;
+    }
     
-    for (auto& entry : m_rob_q) {
-        if (entry.request.msgId == requestId) {
-            if (!entry.ready) {  // Only mark ready if not already ready
-                entry.ready = true;
+    auto it = m_seq_of.find(requestId);
+    if (it != m_seq_of.end()) {
+        ROBEntry& entry = entryAt(it->second);
+        if (!entry.ready) {  // Only mark ready if not already ready
+            entry.ready = true;
+            if (m_debug) {
                 std::cout << "[ROB] Marked request " << requestId << " as ready" << std::endl;
             }
-            return;
         }
+        return;
     }
     
-    std::cout << "[ROB] Warning: Request " << requestId << " not found for commit" << std::endl;
+    if (m_debug) {
+        std::cout << "[ROB] Warning: Request " << requestId << " not found for commit" << std::endl;
+    }
 }
 
 } // namespace ns3
\ No newline at end of file
@@ -0,0 +1,235 @@
+#include "../header/ResultCache.h"
+#include "../header/TraceFile.h"
+#include "../header/tinyxml.h"
+#include "ns3/core-module.h"
+
+#include <algorithm>
+#include <cstdio>
+#include <fstream>
+#include <sstream>
+#include <thread>
+
+#include <dirent.h>
+#include <dlfcn.h>
+#include <fcntl.h>
+#include <sys/file.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+namespace ns3
+{
+    static void MakeDirs(const std::string &dir)
+    {
+        for (size_t slash = dir.find('/', 1); slash != std::string::npos; slash = dir.find('/', slash + 1))
+            mkdir(dir.substr(0, slash).c_str(), 0755);
+        mkdir(dir.c_str(), 0755);
+    }
+
+    // Regular files of dir whose names start with prefix and end with suffix, sorted
+    static std::vector<std::string> ListFiles(const std::string &dir, const std::string &prefix, const std::string &suffix)
+    {
+        std::vector<std::string> names;
+        DIR *listing = opendir(dir.c_str());
+        if (listing == NULL)
+            return names;
+        for (struct dirent *entry = readdir(listing); entry != NULL; entry = readdir(listing))
+        {
+            std::string name = entry->d_name;
+            struct stat info;
+            if (name.compare(0, prefix.size(), prefix) != 0 || name.size() < prefix.size() + suffix.size() ||
+                name.compare(name.size() - suffix.size(), suffix.size(), suffix) != 0 ||
+                stat((dir + "/" + name).c_str(), &info) != 0 || !S_ISREG(info.st_mode))
+                continue;
+            names.push_back(name);
+        }
+        closedir(listing);
+        std::sort(names.begin(), names.end());
+        return names;
+    }
+
+    // The shared library (or the executable, when it is linked in) holding
+    // this module's code, i.e. the simulator the results come from
+    static std::string ModuleFile()
+    {
+        Dl_info info;
+        if (dladdr((void *)&ModuleFile, &info) == 0 || info.dli_fname == NULL)
+            return "";
+        return info.dli_fname;
+    }
+
+    static void CanonicalNode(const TiXmlNode *node, std::ostream &out)
+    {
+        for (const TiXmlNode *child = node->FirstChild(); child != NULL; child = child->NextSibling())
+        {
+            const TiXmlElement *element = child->ToElement();
+            const TiXmlText *text = child->ToText();
+            if (element != NULL)
+            {
+                std::vector<std::pair<std::string, std::string>> attributes;
+                for (const TiXmlAttribute *a = element->FirstAttribute(); a != NULL; a = a->Next())
+                    attributes.push_back(std::make_pair(std::string(a->Name()), std::string(a->Value())));
+                std::sort(attributes.begin(), attributes.end());
+
+                out << "<" << element->Value();
+                for (const std::pair<std::string, std::string> &a : attributes)
+                    out << " " << a.first << "=\"" << a.second << "\"";
+                out << ">";
+                CanonicalNode(element, out);
+                out << "</" << element->Value() << ">";
+            }
+            else if (text != NULL)
+                out << text->Value();
+        }
+    }
+
+    ResultCache::ResultCache(const std::string &dir)
+    {
+        m_dir = dir;
+    }
+
+    std::string ResultCache::Digest(const char *data, size_t size)
+    {
+        Hasher murmur;
+        Hasher fnv(Create<Hash::Function::Fnv1a>());
+        char hex[33];
+        snprintf(hex, sizeof(hex), "%016llx%016llx", (unsigned long long)murmur.GetHash64(data, size),
+                 (unsigned long long)fnv.GetHash64(data, size));
+        return std::string(hex);
+    }
+
+    // Elements with their attributes in name order, without comments or formatting
+    std::string ResultCache::CanonicalXml(const std::string &config_file)
+    {
+        TiXmlDocument doc(config_file.c_str());
+        if (!doc.LoadFile())
+            return "";
+        std::stringstream out;
+        CanonicalNode(&doc, out);
+        return out.str();
+    }
+
+    std::string ResultCache::entryPath(const std::string &key, const std::string &suffix)
+    {
+        return m_dir + "/" + key.substr(0, 2) + "/" + key + suffix;
+    }
+
+    // Copies through a temporary and a rename, so to is never seen half written
+    bool ResultCache::copyFile(const std::string &from, const std::string &to)
+    {
+        std::ifstream in(from.c_str(), std::ios::binary);
+        if (!in.is_open())
+            return false;
+
+        std::stringstream tmp;
+        tmp << to << ".tmp." << getpid() << "." << std::hash<std::thread::id>()(std::this_thread::get_id());
+        std::ofstream out(tmp.str().c_str(), std::ios::binary);
+        out << in.rdbuf();
+        out.close();
+        if (!out || rename(tmp.str().c_str(), to.c_str()) != 0)
+        {
+            unlink(tmp.str().c_str());
+            return false;
+        }
+        return true;
+    }
+
+    std::string ResultCache::FileDigest(const std::string &path)
+    {
+        struct stat info;
+        if (stat(path.c_str(), &info) != 0)
+            return "";
+
+        char *real = realpath(path.c_str(), NULL);
+        std::string name = real ? real : path;
+        free(real);
+
+        std::stringstream stamp;
+        stamp << info.st_size << " " << info.st_mtim.tv_sec << "." << info.st_mtim.tv_nsec;
+
+        // A digest of the file as it is now is already known
+        std::string memo = entryPath(Digest(name.data(), name.size()), ".digest");
+        std::ifstream known(memo.c_str());
+        std::string known_stamp, digest;
+        if (known.is_open() && std::getline(known, known_stamp) && std::getline(known, digest) &&
+            known_stamp == stamp.str() && !digest.empty())
+            return digest;
+
+        std::shared_ptr<const MappedTrace> file = MappedTrace::Open(path);
+        if (!file)
+            return "";
+        digest = Digest(file->data(), file->size());
+
+        MakeDirs(memo.substr(0, memo.rfind('/')));
+        std::stringstream tmp;
+        tmp << memo << ".tmp." << getpid() << "." << std::hash<std::thread::id>()(std::this_thread::get_id());
+        std::ofstream out(tmp.str().c_str());
+        out << stamp.str() << "\n" << digest << "\n";
+        out.close();
+        if (!out || rename(tmp.str().c_str(), memo.c_str()) != 0)
+            unlink(tmp.str().c_str());
+        return digest;
+    }
+
+    std::string ResultCache::Key(const std::string &config_file, const std::string &bms_path, const std::string &fsm_dir,
+                                 const std::string &simulator)
+    {
+        std::string config = CanonicalXml(config_file);
+        std::string model = FileDigest(ModuleFile());
+        std::string build = FileDigest(simulator);
+        if (config.empty() || model.empty() || build.empty())
+            return "";
+
+        std::stringstream parts;
+        parts << "config " << Digest(config.data(), config.size()) << "\n";
+        parts << "model " << model << "\n";
+        parts << "simulator " << build << "\n";
+        for (const std::string &name : ListFiles(fsm_dir, "", ".csv"))
+            parts << "fsm " << name << " " << FileDigest(fsm_dir + "/" + name) << "\n";
+        for (const std::string &name : ListFiles(bms_path, "trace_C", ""))
+            parts << "trace " << name << " " << FileDigest(bms_path + "/" + name) << "\n";
+
+        // The memory backend's own parameter file (DRAMCnfg MEMParamFile)
+        TiXmlDocument doc(config_file.c_str());
+        doc.LoadFile();
+        TiXmlElement *dram = TiXmlHandle(&doc).FirstChildElement().FirstChildElement("DRAMCnfg").Element();
+        std::string param_file;
+        if (dram != NULL && dram->QueryStringAttribute("MEMParamFile", &param_file) == TIXML_SUCCESS && !param_file.empty())
+            parts << "memparam " << FileDigest(param_file) << "\n";
+
+        std::string key = parts.str();
+        return Digest(key.data(), key.size());
+    }
+
+    bool ResultCache::Fetch(const std::string &key, const std::string &result_file)
+    {
+        return copyFile(entryPath(key, ".result"), result_file);
+    }
+
+    bool ResultCache::Store(const std::string &key, const std::string &result_file)
+    {
+        std::string entry = entryPath(key, ".result");
+        MakeDirs(entry.substr(0, entry.rfind('/')));
+        return copyFile(result_file, entry);
+    }
+
+    int ResultCache::Lock(const std::string &key)
+    {
+        std::string path = entryPath(key, ".lock");
+        MakeDirs(path.substr(0, path.rfind('/')));
+        int lock = open(path.c_str(), O_RDWR | O_CREAT, 0644);
+        if (lock >= 0 && flock(lock, LOCK_EX) != 0)
+        {
+            close(lock);
+            return -1;
+        }
+        return lock;
+    }
+
+    void ResultCache::Unlock(int lock)
+    {
+        if (lock < 0)
+            return;
+        flock(lock, LOCK_UN);
+        close(lock);
+    }
+}
@@ -0,0 +1,36 @@
+#include "../header/StatsRegistry.h"
+
+#include <stdexcept>
+
+namespace ns3
+{
+    void StatsRegistry::add(const std::string &name, Reader reader)
+    {
+        std::string full;
+        for (const std::string &scope : m_scopes)
+        {
+            if (!scope.empty())
+                full += scope + " ";
+        }
+        full += name;
+
+        if (!m_names.insert(full).second)
+            throw std::logic_error("StatsRegistry: " + full + " added twice");
+        m_stats.push_back(std::make_pair(full, reader));
+    }
+
+    std::vector<std::pair<std::string, double>> StatsRegistry::read() const
+    {
+        std::vector<std::pair<std::string, double>> values;
+        values.reserve(m_stats.size());
+        for (const std::pair<std::string, Reader> &stat : m_stats)
+            values.push_back(std::make_pair(stat.first, stat.second()));
+        return values;
+    }
+
+    void StatsRegistry::clear()
+    {
+        m_stats.clear();
+        m_names.clear();
+    }
+}
@@ -0,0 +1,124 @@
+#include "../header/TimingWheel.h"
+
+using namespace std;
+
+namespace ns3
+{
+    TimingWheel::TimingWheel(uint64_t start_cycle)
+    {
+        m_next_cycle = start_cycle;
+        m_entry_count = 0;
+    }
+
+    TimingWheel::~TimingWheel()
+    {
+    }
+
+    void TimingWheel::schedule(uint64_t key, uint64_t expiry_cycle)
+    {
+        unordered_map<uint64_t, uint64_t>::iterator it = m_active.find(key);
+        if (it != m_active.end() && it->second == expiry_cycle)
+            return;
+
+        m_active[key] = expiry_cycle;
+        insert(Entry{key, expiry_cycle});
+    }
+
+    void TimingWheel::cancel(uint64_t key)
+    {
+        m_active.erase(key);
+    }
+
+    bool TimingWheel::isScheduled(uint64_t key) const
+    {
+        return m_active.find(key) != m_active.end();
+    }
+
+    void TimingWheel::insert(const Entry &entry)
+    {
+        m_entry_count++;
+
+        // A timer that is already due goes into the slot processed next
+        if (entry.expiry <= m_next_cycle)
+        {
+            m_slots[0][m_next_cycle & SLOT_MASK].push_back(entry);
+            return;
+        }
+
+        uint64_t delta = entry.expiry - m_next_cycle;
+        for (int level = 0; level < LEVELS; level++)
+        {
+            if (delta < (1ULL << (LEVEL_BITS * (level + 1))))
+            {
+                m_slots[level][(entry.expiry >> (LEVEL_BITS * level)) & SLOT_MASK].push_back(entry);
+                return;
+            }
+        }
+
+        // Beyond the wheel's range: park it in the last slot of the top level, it
+        // is re-inserted with its real expiry when that slot is cascaded
+        uint64_t parked = m_next_cycle + MAX_DELTA;
+        m_slots[LEVELS - 1][(parked >> (LEVEL_BITS * (LEVELS - 1))) & SLOT_MASK].push_back(entry);
+    }
+
+    void TimingWheel::cascade(int level)
+    {
+        vector<Entry> entries;
+        entries.swap(m_slots[level][(m_next_cycle >> (LEVEL_BITS * level)) & SLOT_MASK]);
+        m_entry_count -= entries.size();
+
+        for (const Entry &entry : entries)
+        {
+            if (isLive(entry))
+                insert(entry);
+        }
+    }
+
+    void TimingWheel::advance(uint64_t cycle, vector<uint64_t> &out_expired)
+    {
+        while (m_next_cycle <= cycle)
+        {
+            if (m_active.empty())
+            {
+                // Nothing is armed, so the slots can only hold stale entries
+                if (m_entry_count > 0)
+                {
+                    for (int level = 0; level < LEVELS; level++)
+                        for (int slot = 0; slot < SLOTS; slot++)
+                            m_slots[level][slot].clear();
+                    m_entry_count = 0;
+                }
+                m_next_cycle = cycle + 1;
+                return;
+            }
+
+            uint64_t index = m_next_cycle & SLOT_MASK;
+
+            // When a level wraps, the matching slot of the level above moves down
+            for (int level = 1; index == 0 && level < LEVELS; level++)
+            {
+                cascade(level);
+                index = (m_next_cycle >> (LEVEL_BITS * level)) & SLOT_MASK;
+            }
+
+            vector<Entry> entries;
+            entries.swap(m_slots[0][m_next_cycle & SLOT_MASK]);
+            m_entry_count -= entries.size();
+            uint64_t now = m_next_cycle++;
+
+            for (const Entry &entry : entries)
+            {
+                if (!isLive(entry))
+                    continue;
+
+                if (entry.expiry <= now)
+                {
+                    out_expired.push_back(entry.key);
+                    m_active.erase(entry.key);
+                }
+                else
+                    insert(entry);
+            }
+        }
+    }
+}
@@ -0,0 +1,89 @@
+#include "../header/TraceFile.h"
+#include <cstring>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+namespace ns3 {
+
+std::mutex MappedTrace::s_lock;
+std::map<std::string, std::weak_ptr<const MappedTrace>> MappedTrace::s_open;
+
+MappedTrace::MappedTrace(const std::string& path)
+    : m_path(path),
+      m_data(NULL),
+      m_size(0) {
+    int fd = ::open(path.c_str(), O_RDONLY);
+    if (fd < 0) {
+        return;
+    }
+
+    struct stat info;
+    if (fstat(fd, &info) == 0) {
+        if (info.st_size == 0) {
+            m_data = "";  // An empty trace maps to nothing but is still open
+        } else {
+            void* data = mmap(NULL, info.st_size, PROT_READ, MAP_SHARED, fd, 0);
+            if (data != MAP_FAILED) {
+                madvise(data, info.st_size, MADV_SEQUENTIAL);
+                m_data = (const char*)data;
+                m_size = info.st_size;
+            }
+        }
+    }
+    ::close(fd);
+}
+
+MappedTrace::~MappedTrace() {
+    if (m_size > 0) {
+        munmap((void*)m_data, m_size);
+    }
+}
+
+std::shared_ptr<const MappedTrace> MappedTrace::Open(const std::string& path) {
+    std::lock_guard<std::mutex> lock(s_lock);
+
+    std::shared_ptr<const MappedTrace> trace = s_open[path].lock();
+    if (trace) {
+        return trace;
+    }
+
+    trace.reset(new MappedTrace(path));
+    if (trace->m_data == NULL) {
+        s_open.erase(path);
+        return NULL;
+    }
+    s_open[path] = trace;
+    return trace;
+}
+
+void TraceReader::open(const char* path) {
+    m_trace = MappedTrace::Open(path);
+    m_pos = 0;
+}
+
+void TraceReader::close() {
+    m_trace.reset();
+    m_pos = 0;
+}
+
+bool TraceReader::getline(std::string& line) {
+    if (eof()) {
+        return false;
+    }
+
+    const char* begin = m_trace->data() + m_pos;
+    size_t left = m_trace->size() - m_pos;
+    const char* end = (const char*)memchr(begin, '\n', left);
+    size_t length = end ? (size_t)(end - begin) : left;
+
+    m_pos += length + (end ? 1 : 0);
+    if (length > 0 && begin[length - 1] == '\r') {
+        length--;
+    }
+    line.assign(begin, length);
+    return true;
+}
+
+} // namespace ns3
@@ -0,0 +1,246 @@
+#include "../header/TraceReplayMemory.h"
+
+#include <algorithm>
+#include <cmath>
+#include <sstream>
+#include <stdexcept>
+
+namespace ns3
+{
+    // Memory controller n of a run uses file.<n>, controller 0 file itself
+    static std::string InstanceFile(const std::string &file, int instance)
+    {
+        if (instance == 0)
+            return file;
+        std::stringstream name;
+        name << file << "." << instance;
+        return name.str();
+    }
+
+    MemoryLatencyRecorder::MemoryLatencyRecorder(MCoreSimProjectXml &projectXml, CommunicationInterface *lower_interface,
+                                                 int instance)
+        : CommunicationInterface(lower_interface->m_interface_id)
+    {
+        m_lower_interface = lower_interface;
+        m_backend = NULL;
+        m_dt = projectXml.GetDRAMCtrlClkNanoSec();
+        m_recorded = 0;
+        m_latency_sum = 0;
+
+        m_trace_file = InstanceFile(projectXml.GetMemRecordFile(), instance);
+        m_trace.open(m_trace_file.c_str());
+        if (!m_trace.is_open())
+        {
+            throw std::runtime_error("MemoryLatencyRecorder: cannot open " + m_trace_file);
+        }
+        m_trace << "# addr seq depth latency" << endl;
+    }
+
+    MemoryLatencyRecorder::~MemoryLatencyRecorder()
+    {
+        delete m_backend;
+        m_trace.close();
+    }
+
+    bool MemoryLatencyRecorder::peekMessage(Message *out_msg)
+    {
+        return m_lower_interface->peekMessage(out_msg);
+    }
+
+    void MemoryLatencyRecorder::popFrontMessage()
+    {
+        Message msg;
+        if (m_lower_interface->peekMessage(&msg) && msg.data == NULL)
+        {
+            PendingRead read;
+            read.seq = m_read_seq[msg.addr]++;
+            read.depth = (uint32_t)m_pending.size();
+            read.arrive_ns = Simulator::Now().GetNanoSeconds();
+            m_pending.insert(std::make_pair(std::make_pair(msg.msg_id, msg.addr), read));
+        }
+        m_lower_interface->popFrontMessage();
+    }
+
+    bool MemoryLatencyRecorder::pushMessage(Message &msg, uint64_t cycle, MessageType type)
+    {
+        if (!m_lower_interface->pushMessage(msg, cycle, type))
+            return false;
+        if (type != MessageType::DATA_RESPONSE)
+            return true;
+
+        std::multimap<std::pair<uint64_t, uint64_t>, PendingRead>::iterator it =
+            m_pending.lower_bound(std::make_pair(msg.msg_id, msg.addr));
+        if (it != m_pending.end() && it->first == std::make_pair(msg.msg_id, msg.addr))
+        {
+            uint64_t latency = (uint64_t)llround((Simulator::Now().GetNanoSeconds() - it->second.arrive_ns) / m_dt);
+            m_trace << std::hex << msg.addr << std::dec << " " << it->second.seq << " " << it->second.depth
+                    << " " << latency << "\n";
+            m_recorded++;
+            m_latency_sum += latency;
+            m_pending.erase(it);
+        }
+        return true;
+    }
+
+    bool MemoryLatencyRecorder::rollback(uint64_t address, uint64_t mask, Message *out_msg)
+    {
+        return m_lower_interface->rollback(address, mask, out_msg);
+    }
+
+    void MemoryLatencyRecorder::init()
+    {
+        m_backend->init();
+    }
+
+    void MemoryLatencyRecorder::printStats(std::ostream &out)
+    {
+        m_backend->printStats(out);
+        out << "Memory latency trace " << m_trace_file << " reads recorded = " << m_recorded
+            << ", avg latency = " << ((m_recorded > 0) ? (double)m_latency_sum / m_recorded : 0.0) << " cycles" << endl;
+        m_trace.flush(); // The run ends with exit(), so the destructor may not get to it
+    }
+
+    void MemoryLatencyRecorder::registerStats(StatsRegistry &stats)
+    {
+        m_backend->registerStats(stats);
+        stats.add("Memory latency trace reads recorded", &m_recorded);
+        stats.add("Memory latency trace avg latency", [this]() { return StatsRegistry::Ratio(m_latency_sum, m_recorded); });
+    }
+
+    static MemoryBackend *CreateTraceReplay(MCoreSimProjectXml &projectXml, CommunicationInterface *lower_interface,
+                                            int llc_id, int instance, const std::string &param_file)
+    {
+        return new TraceReplayMemory(projectXml, lower_interface, llc_id, instance, param_file);
+    }
+
+    REGISTER_MEMORY_BACKEND("REPLAY", CreateTraceReplay);
+
+    TraceReplayMemory::TraceReplayMemory(MCoreSimProjectXml &projectXml, CommunicationInterface *lower_interface, int llc_id,
+                                         int instance, std::string trace_file)
+        : MainMemoryController(projectXml, lower_interface, llc_id)
+    {
+        string mode = projectXml.GetMemReplayMode();
+        if (mode == "EXACT")
+            m_exact = true;
+        else if (mode == "DISTRIBUTION")
+            m_exact = false;
+        else
+        {
+            throw std::runtime_error("TraceReplayMemory: unknown replay mode " + mode + " (EXACT or DISTRIBUTION)");
+        }
+
+        trace_file = InstanceFile(trace_file, instance);
+        std::ifstream trace(trace_file.c_str());
+        if (!trace.is_open())
+        {
+            throw std::runtime_error("TraceReplayMemory: cannot open latency trace " + trace_file);
+        }
+
+        std::string line;
+        uint64_t reads = 0;
+        while (std::getline(trace, line))
+        {
+            if (line.empty() || line[0] == '#')
+                continue;
+            std::istringstream fields(line);
+            uint64_t addr, seq;
+            uint32_t depth, latency;
+            if (!(fields >> std::hex >> addr >> std::dec >> seq >> depth >> latency))
+                continue;
+
+            if (m_exact)
+            {
+                std::vector<uint32_t> &by_seq = m_latencies[addr];
+                if (by_seq.size() <= seq)
+                    by_seq.resize(seq + 1, 0);
+                by_seq[seq] = latency;
+            }
+            m_by_depth[depthBucket(depth)].push_back(latency);
+            reads++;
+        }
+        if (reads == 0)
+        {
+            throw std::runtime_error("TraceReplayMemory: latency trace " + trace_file + " has no reads");
+        }
+
+        m_rng.seed(1);
+        m_exact_reads = 0;
+        m_sampled_reads = 0;
+        m_replayed_latency = 0;
+    }
+
+    // 0, 1, 2-3, 4-7, ... reads outstanding
+    int TraceReplayMemory::depthBucket(uint32_t depth)
+    {
+        int bucket = 0;
+        while (depth > 0 && bucket < DEPTH_BUCKETS - 1)
+        {
+            depth >>= 1;
+            bucket++;
+        }
+        return bucket;
+    }
+
+    // A recorded latency of the depth's bucket, or of the nearest bucket with any
+    uint32_t TraceReplayMemory::sampleLatency(uint32_t depth)
+    {
+        int bucket = depthBucket(depth);
+        for (int distance = 0; distance < DEPTH_BUCKETS; distance++)
+        {
+            for (int b : {bucket - distance, bucket + distance})
+            {
+                if (b < 0 || b >= DEPTH_BUCKETS || m_by_depth[b].empty())
+                    continue;
+                std::uniform_int_distribution<size_t> pick(0, m_by_depth[b].size() - 1);
+                return m_by_depth[b][pick(m_rng)];
+            }
+        }
+        return m_memory_latency;
+    }
+
+    uint32_t TraceReplayMemory::requestLatency(const Message &msg)
+    {
+        if (msg.data != NULL)
+            return m_memory_latency;
+
+        while (!m_read_completions.empty() && m_read_completions.top() <= m_clk_cycle)
+            m_read_completions.pop();
+        uint32_t depth = (uint32_t)m_read_completions.size();
+        uint64_t seq = m_read_seq[msg.addr]++;
+
+        uint32_t latency = 0;
+        std::unordered_map<uint64_t, std::vector<uint32_t>>::iterator it = m_latencies.find(msg.addr);
+        if (m_exact && it != m_latencies.end() && seq < it->second.size() && it->second[seq] > 0)
+        {
+            latency = it->second[seq];
+            m_exact_reads++;
+        }
+        else
+        {
+            latency = sampleLatency(depth);
+            m_sampled_reads++;
+        }
+        latency = std::max(latency, (uint32_t)1);
+
+        m_replayed_latency += latency;
+        m_read_completions.push(m_clk_cycle + latency);
+        return latency;
+    }
+
+    void TraceReplayMemory::printStats(std::ostream &out)
+    {
+        MainMemoryController::printStats(out);
+        uint64_t reads = m_exact_reads + m_sampled_reads;
+        out << "Replayed reads exact = " << m_exact_reads << ", sampled = " << m_sampled_reads
+            << ", avg latency = " << ((reads > 0) ? (double)m_replayed_latency / reads : 0.0) << " cycles" << endl;
+    }
+
+    void TraceReplayMemory::registerStats(StatsRegistry &stats)
+    {
+        MainMemoryController::registerStats(stats);
+        stats.add("Replayed reads exact", &m_exact_reads);
+        stats.add("Replayed reads sampled", &m_sampled_reads);
+        stats.add("Replayed reads avg latency",
+                  [this]() { return StatsRegistry::Ratio(m_replayed_latency, m_exact_reads + m_sampled_reads); });
+    }
+}
@@ -0,0 +1,1059 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+
+#include "ns3/test.h"
+#include "ns3/CacheController_End2End.h"
+#include "ns3/CacheSim.h"
+#include "ns3/DRAMModel.h"
+#include "ns3/LSQ.h"
+#include "ns3/MMU.h"
+#include "ns3/ROB.h"
+#include "ns3/ResultCache.h"
+#include "ns3/TimingWheel.h"
+
+#include <algorithm>
+#include <cstdio>
+#include <cstdlib>
+#include <deque>
+#include <fstream>
+#include <sstream>
+#include <string>
+#include <vector>
+
+#include <ftw.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+/**
+ * \file
+ * \ingroup multicoresim-tests
+ * MultiCoreSim test suite.
+ */
+
+/**
+ * \ingroup multicoresim-tests
+ * \defgroup multicoresim-tests MultiCoreSim test suite
+ */
+
+namespace ns3 {
+
+namespace tests {
+
+/**
+ * \ingroup multicoresim-tests
+ * A core request as the trace reader builds it.
+ *
+ * \param [in] msgId The request id.
+ * \param [in] type The request type.
+ * \param [in] addr The address of a load, store or atomic.
+ * \returns The request.
+ */
+static CpuFIFO::ReqMsg
+MakeRequest (uint64_t msgId, CpuFIFO::REQTYPE type, uint64_t addr = 0)
+{
+  CpuFIFO::ReqMsg request = CpuFIFO::ReqMsg ();
+  request.msgId = msgId;
+  request.addr = addr;
+  request.type = type;
+  return request;
+}
+
+/**
+ * \ingroup multicoresim-tests
+ * The current value of a registered statistic.
+ *
+ * \param [in] stats The registry.
+ * \param [in] name The statistic's full name.
+ * \returns Its value, or -1 if no statistic has that name.
+ */
+static double
+GetStat (const StatsRegistry &stats, const std::string &name)
+{
+  std::vector<std::pair<std::string, double> > values = stats.read ();
+  for (std::size_t i = 0; i < values.size (); i++)
+    {
+      if (values[i].first == name)
+        {
+          return values[i].second;
+        }
+    }
+  return -1;
+}
+
+/**
+ * \ingroup multicoresim-tests
+ * The interface between a component under test and the test: the component
+ * reads the messages queued in m_requests, and the messages it pushes land
+ * in m_pushed while there is room for them.
+ */
+class TestLink : public CommunicationInterface
+{
+public:
+  /**
+   * Constructor.
+   *
+   * \param [in] capacity The messages m_pushed takes before pushes fail.
+   */
+  TestLink (std::size_t capacity = 1000)
+    : CommunicationInterface (0),
+      m_capacity (capacity)
+  {
+  }
+
+  virtual bool peekMessage (Message *out_msg)
+  {
+    if (m_requests.empty ())
+      {
+        return false;
+      }
+    *out_msg = m_requests.front ();
+    return true;
+  }
+
+  virtual void popFrontMessage (void)
+  {
+    m_requests.pop_front ();
+  }
+
+  virtual bool pushMessage (Message &msg, uint64_t, MessageType)
+  {
+    if (m_pushed.size () >= m_capacity)
+      {
+        return false;
+      }
+    m_pushed.push_back (msg);
+    return true;
+  }
+
+  std::deque<Message> m_requests;  //!< Messages the component reads
+  std::vector<Message> m_pushed;   //!< Messages the component sent
+  std::size_t m_capacity;          //!< Messages m_pushed takes
+};
+
+/**
+ * \ingroup multicoresim-tests
+ * One core with an L1 and the LLC runs a three-line trace; the run has to
+ * end by itself once the last line is retired, well before the cycle cap.
+ */
+class TraceRunsToCompletionTestCase : public TestCase
+{
+public:
+  TraceRunsToCompletionTestCase ();
+
+private:
+  virtual void DoRun (void);
+};
+
+TraceRunsToCompletionTestCase::TraceRunsToCompletionTestCase ()
+  : TestCase ("Short trace runs to completion")
+{
+}
+
+void
+TraceRunsToCompletionTestCase::DoRun (void)
+{
+  char dir[] = "/tmp/multicoresim-test-XXXXXX";
+  NS_TEST_ASSERT_MSG_NE (mkdtemp (dir), 0, "cannot create a directory for the trace");
+  std::string bmsPath (dir);
+  std::string traceFile = bmsPath + "/trace_C0.trc.shared";
+
+  // <compute instructions> <address> <R|W>
+  std::ofstream trace (traceFile.c_str ());
+  trace << "2 4096 R\n"
+        << "0 4160 W\n"
+        << "1 8192 R\n";
+  trace.close ();
+
+  MCoreSimProjectXml config;
+  bool loaded = config.LoadFromString (
+    "<MCoreSimProject RunTillEnd=\"1\" totalTimeInSeconds=\"1000\" nCores=\"1\" CohProtocol=\"MSI\">"
+    "  <privateCaches><privateCache cacheId=\"0\"/></privateCaches>"
+    "  <sharedCaches><sharedCache cacheId=\"10\"/></sharedCaches>"
+    "  <DRAMCnfg MEMMODLE=\"FIXEDLat\" MEMLATENCY=\"20\"/>"
+    "</MCoreSimProject>");
+  NS_TEST_ASSERT_MSG_EQ (loaded, true, "the test configuration does not parse");
+  config.SetBMsPath (bmsPath);
+
+  CacheSim sim (config);
+  bool done = sim.runFor (100000);
+
+  unlink (traceFile.c_str ());
+  rmdir (dir);
+
+  NS_TEST_ASSERT_MSG_EQ (done, true, "the run did not end at the end of the trace");
+  NS_TEST_ASSERT_MSG_LT (sim.cycles (), 100000, "the run only ended at the cycle cap");
+  NS_TEST_ASSERT_MSG_EQ (sim.stats ().get ("Core 0 instructions retired"), 6,
+                         "3 compute and 3 memory instructions retire");
+}
+
+/**
+ * \ingroup multicoresim-tests
+ * Timers expire at their cycle, in expiry order, across the levels of the
+ * wheel; cancelled and re-armed timers fire only at their latest expiry.
+ */
+class TimingWheelTestCase : public TestCase
+{
+public:
+  TimingWheelTestCase ();
+
+private:
+  virtual void DoRun (void);
+};
+
+TimingWheelTestCase::TimingWheelTestCase ()
+  : TestCase ("Timing wheel expires timers in order across levels")
+{
+}
+
+void
+TimingWheelTestCase::DoRun (void)
+{
+  TimingWheel wheel (1);
+  std::vector<uint64_t> expired;
+
+  // Level 0, level 1 and level 2 expiries, and one beyond the wheel's range
+  wheel.schedule (1, 10);
+  wheel.schedule (2, 70);
+  wheel.schedule (3, 5000);
+  wheel.schedule (4, 3);
+  wheel.schedule (5, (1ULL << 24) + 100);
+  NS_TEST_ASSERT_MSG_EQ (wheel.size (), 5, "five timers armed");
+
+  wheel.advance (2, expired);
+  NS_TEST_ASSERT_MSG_EQ (expired.size (), 0, "nothing is due before cycle 3");
+
+  wheel.advance (10, expired);
+  NS_TEST_ASSERT_MSG_EQ (expired.size (), 2, "the timers of cycles 3 and 10 expired");
+  NS_TEST_ASSERT_MSG_EQ (expired[0], 4, "the earlier timer expires first");
+  NS_TEST_ASSERT_MSG_EQ (expired[1], 1, "then the timer of cycle 10");
+
+  // Re-arming moves a timer, cancelling drops it
+  wheel.schedule (2, 80);
+  wheel.cancel (3);
+  NS_TEST_ASSERT_MSG_EQ (wheel.isScheduled (3), false, "a cancelled timer is not armed");
+
+  expired.clear ();
+  wheel.advance (79, expired);
+  NS_TEST_ASSERT_MSG_EQ (expired.size (), 0, "the re-armed timer does not fire at its old cycle");
+  wheel.advance (80, expired);
+  NS_TEST_ASSERT_MSG_EQ (expired.size (), 1, "the re-armed timer fires at its new cycle");
+  NS_TEST_ASSERT_MSG_EQ (expired[0], 2, "the re-armed timer fires at its new cycle");
+
+  expired.clear ();
+  wheel.advance (10000, expired);
+  NS_TEST_ASSERT_MSG_EQ (expired.size (), 0, "the cancelled timer never fires");
+  NS_TEST_ASSERT_MSG_EQ (wheel.isScheduled (5), true, "the far timer is still armed");
+
+  wheel.advance ((1ULL << 24) + 99, expired);
+  NS_TEST_ASSERT_MSG_EQ (expired.size (), 0, "the far timer is not due yet");
+  wheel.advance ((1ULL << 24) + 100, expired);
+  NS_TEST_ASSERT_MSG_EQ (expired.size (), 1, "the far timer fires at its cycle");
+  NS_TEST_ASSERT_MSG_EQ (wheel.size (), 0, "no timer is left");
+}
+
+/**
+ * \ingroup multicoresim-tests
+ * The ROB retires in program order, at most its retire width per cycle, and
+ * a commit for an instruction that has already retired does not mark the
+ * younger instruction now in its ring slot ready.
+ */
+class RobRetireInOrderTestCase : public TestCase
+{
+public:
+  RobRetireInOrderTestCase ();
+
+private:
+  virtual void DoRun (void);
+};
+
+RobRetireInOrderTestCase::RobRetireInOrderTestCase ()
+  : TestCase ("ROB retires in program order")
+{
+}
+
+void
+RobRetireInOrderTestCase::DoRun (void)
+{
+  ROB rob (4, 2);
+  NS_TEST_ASSERT_MSG_EQ (rob.capacity (), 4, "configured capacity");
+
+  NS_TEST_ASSERT_MSG_EQ (rob.allocate (MakeRequest (1, CpuFIFO::REQTYPE::READ, 64)), true, "load allocated");
+  NS_TEST_ASSERT_MSG_EQ (rob.allocate (MakeRequest (2, CpuFIFO::REQTYPE::READ, 128)), true, "load allocated");
+  NS_TEST_ASSERT_MSG_EQ (rob.allocate (MakeRequest (3, CpuFIFO::REQTYPE::WRITE, 192)), true, "store allocated");
+  NS_TEST_ASSERT_MSG_EQ (rob.allocate (MakeRequest (4, CpuFIFO::REQTYPE::READ, 256)), true, "load allocated");
+  NS_TEST_ASSERT_MSG_EQ (rob.canAccept (), false, "the ROB is full");
+  NS_TEST_ASSERT_MSG_EQ (rob.allocate (MakeRequest (5, CpuFIFO::REQTYPE::READ, 320)), false, "no room left");
+
+  // Younger instructions complete first, but nothing passes the oldest
+  rob.commit (2);
+  rob.commit (3);
+  rob.commit (4);
+  rob.step ();
+  NS_TEST_ASSERT_MSG_EQ (rob.size (), 4, "nothing retires while the oldest load waits");
+
+  rob.commit (1);
+  rob.step ();
+  NS_TEST_ASSERT_MSG_EQ (rob.size (), 2, "two instructions retire per cycle");
+  rob.step ();
+  NS_TEST_ASSERT_MSG_EQ (rob.isEmpty (), true, "the rest retire the next cycle");
+
+  // Request 6 takes the ring slot request 2 had; a late commit of 2 is ignored
+  NS_TEST_ASSERT_MSG_EQ (rob.allocate (MakeRequest (5, CpuFIFO::REQTYPE::READ, 64)), true, "load allocated");
+  NS_TEST_ASSERT_MSG_EQ (rob.allocate (MakeRequest (6, CpuFIFO::REQTYPE::READ, 128)), true, "load allocated");
+  rob.commit (5);
+  rob.commit (2);
+  rob.step ();
+  NS_TEST_ASSERT_MSG_EQ (rob.size (), 1, "only the committed load retires");
+  rob.step ();
+  NS_TEST_ASSERT_MSG_EQ (rob.size (), 1, "a stale commit does not make a load ready");
+}
+
+/**
+ * \ingroup multicoresim-tests
+ * A run of compute instructions shares one ROB entry that still takes, and
+ * retires, one slot per instruction, so the retire width splits it.
+ */
+class RobComputeRunTestCase : public TestCase
+{
+public:
+  RobComputeRunTestCase ();
+
+private:
+  virtual void DoRun (void);
+};
+
+RobComputeRunTestCase::RobComputeRunTestCase ()
+  : TestCase ("ROB merges compute runs and retires them per instruction")
+{
+}
+
+void
+RobComputeRunTestCase::DoRun (void)
+{
+  ROB rob (8, 4);
+
+  // Instructions 1-3 and 4-5 join one entry, the load 6 follows it
+  NS_TEST_ASSERT_MSG_EQ (rob.allocate (MakeRequest (1, CpuFIFO::REQTYPE::COMPUTE), 3), true, "compute run allocated");
+  NS_TEST_ASSERT_MSG_EQ (rob.allocate (MakeRequest (4, CpuFIFO::REQTYPE::COMPUTE), 2), true, "compute run merged");
+  NS_TEST_ASSERT_MSG_EQ (rob.allocate (MakeRequest (6, CpuFIFO::REQTYPE::READ, 64)), true, "load allocated");
+  NS_TEST_ASSERT_MSG_EQ (rob.size (), 6, "each compute instruction takes a slot");
+  NS_TEST_ASSERT_MSG_EQ (rob.allocate (MakeRequest (7, CpuFIFO::REQTYPE::COMPUTE), 3), false,
+                         "a run larger than the free slots is refused");
+
+  rob.step ();
+  NS_TEST_ASSERT_MSG_EQ (rob.size (), 2, "four of the five compute instructions retire");
+  rob.step ();
+  NS_TEST_ASSERT_MSG_EQ (rob.size (), 1, "the last compute instruction retires, the load waits");
+
+  rob.commit (6);
+  rob.step ();
+  NS_TEST_ASSERT_MSG_EQ (rob.isEmpty (), true, "the committed load retires");
+}
+
+/**
+ * \ingroup multicoresim-tests
+ * A load to an address with a store in the LSQ is forwarded and never sent
+ * to the cache; stores leave before loads, one per cache port and cycle,
+ * and entries leave the LSQ once their response is back.
+ */
+class LsqForwardingAndPortsTestCase : public TestCase
+{
+public:
+  LsqForwardingAndPortsTestCase ();
+
+private:
+  virtual void DoRun (void);
+};
+
+LsqForwardingAndPortsTestCase::LsqForwardingAndPortsTestCase ()
+  : TestCase ("LSQ forwards stores to loads and sends one request per port")
+{
+}
+
+void
+LsqForwardingAndPortsTestCase::DoRun (void)
+{
+  CpuFIFO fifo (0, 8);
+  LSQ lsq (2, 2, 1);
+  lsq.setCpuFIFO (&fifo);
+  StatsRegistry stats;
+  lsq.registerStats (stats);
+
+  NS_TEST_ASSERT_MSG_EQ (lsq.allocate (MakeRequest (1, CpuFIFO::REQTYPE::WRITE, 64)), true, "store allocated");
+  NS_TEST_ASSERT_MSG_EQ (lsq.allocate (MakeRequest (2, CpuFIFO::REQTYPE::READ, 64)), true, "load allocated");
+  NS_TEST_ASSERT_MSG_EQ (lsq.allocate (MakeRequest (3, CpuFIFO::REQTYPE::READ, 128)), true, "load allocated");
+  NS_TEST_ASSERT_MSG_EQ (GetStat (stats, "LSQ store-to-load forwards"), 1, "the load of the stored line is forwarded");
+
+  // The core retries a full queue every cycle; the stall counts once a cycle
+  NS_TEST_ASSERT_MSG_EQ (lsq.canAccept (CpuFIFO::REQTYPE::READ), false, "the load queue is full");
+  NS_TEST_ASSERT_MSG_EQ (lsq.canAccept (CpuFIFO::REQTYPE::READ), false, "the load queue is full");
+  NS_TEST_ASSERT_MSG_EQ (GetStat (stats, "LSQ cycles loads blocked (load queue full)"), 1, "one blocked cycle");
+
+  // One port: the store goes, the load waiting for the cache stays
+  lsq.step ();
+  NS_TEST_ASSERT_MSG_EQ (fifo.m_txFIFO.GetQueueSize (), 1, "one request per port per cycle");
+  NS_TEST_ASSERT_MSG_EQ (fifo.m_txFIFO.GetFrontElement ().msgId, 1, "the store goes first");
+  NS_TEST_ASSERT_MSG_EQ (GetStat (stats, "LSQ cache port stall cycles"), 1, "the load waited for the port");
+  NS_TEST_ASSERT_MSG_EQ (lsq.size (), 2, "the forwarded load has left the LSQ");
+  fifo.m_txFIFO.PopElement ();
+
+  lsq.setCycle (1);
+  lsq.step ();
+  NS_TEST_ASSERT_MSG_EQ (fifo.m_txFIFO.GetQueueSize (), 1, "the load goes the next cycle");
+  NS_TEST_ASSERT_MSG_EQ (fifo.m_txFIFO.GetFrontElement ().msgId, 3, "the forwarded load is never sent");
+
+  CpuFIFO::RespMsg response = CpuFIFO::RespMsg ();
+  response.msgId = 3;
+  response.addr = 128;
+  lsq.rxFromCache (response);
+  response.msgId = 1;
+  response.addr = 64;
+  lsq.rxFromCache (response);
+  lsq.setCycle (2);
+  lsq.step ();
+  NS_TEST_ASSERT_MSG_EQ (lsq.isEmpty (), true, "answered requests leave the LSQ");
+  NS_TEST_ASSERT_MSG_EQ (GetStat (stats, "LSQ loads sent to cache"), 1, "one load was sent");
+  NS_TEST_ASSERT_MSG_EQ (GetStat (stats, "LSQ stores sent to cache"), 1, "one store was sent");
+}
+
+/**
+ * \ingroup multicoresim-tests
+ * A DRAMModel the test clocks itself, one controller cycle per Cycle ().
+ */
+class ClockedDRAMModel : public DRAMModel
+{
+public:
+  /**
+   * Constructor.
+   *
+   * \param [in] config The configuration with the DRAMCnfg element.
+   * \param [in] llc The interface to the LLC.
+   */
+  ClockedDRAMModel (MCoreSimProjectXml &config, CommunicationInterface *llc)
+    : DRAMModel (config, llc, 10)
+  {
+  }
+
+  /** Runs one controller cycle. */
+  void Cycle (void)
+  {
+    processLogic ();
+    m_clk_cycle++;
+  }
+};
+
+/**
+ * \ingroup multicoresim-tests
+ * The DRAM model configuration of the DRAM test cases: the DDR3 defaults
+ * of one channel and rank of 8 banks with 8KB rows, and 64-byte lines.
+ * With the default RoRaBaChCo mapping, addresses 64KB apart are in other
+ * rows of the same bank.
+ *
+ * \param [out] config The configuration to load.
+ * \returns True if the configuration parses.
+ */
+static bool
+LoadDRAMConfig (MCoreSimProjectXml &config)
+{
+  return config.LoadFromString (
+    "<MCoreSimProject>"
+    "  <sharedCaches><sharedCache cacheId=\"10\" blockSize=\"64\"/></sharedCaches>"
+    "  <DRAMCnfg MEMMODLE=\"DDR3\"/>"
+    "</MCoreSimProject>");
+}
+
+/**
+ * \ingroup multicoresim-tests
+ * FR-FCFS serves a younger row hit before an older request to another row
+ * of the same bank, and counts the row hits, misses and conflicts.
+ */
+class DRAMRowHitFirstTestCase : public TestCase
+{
+public:
+  DRAMRowHitFirstTestCase ();
+
+private:
+  virtual void DoRun (void);
+};
+
+DRAMRowHitFirstTestCase::DRAMRowHitFirstTestCase ()
+  : TestCase ("DRAM model serves row hits first")
+{
+}
+
+void
+DRAMRowHitFirstTestCase::DoRun (void)
+{
+  MCoreSimProjectXml config;
+  NS_TEST_ASSERT_MSG_EQ (LoadDRAMConfig (config), true, "the test configuration does not parse");
+
+  TestLink llc;
+  Ptr<ClockedDRAMModel> dram = Create<ClockedDRAMModel> (config, &llc);
+  StatsRegistry stats;
+  dram->registerStats (stats);
+
+  // Row 0, then row 1 of the same bank, then row 0 again
+  llc.m_requests.push_back (Message (1, 0));
+  llc.m_requests.push_back (Message (2, 65536));
+  llc.m_requests.push_back (Message (3, 64));
+  for (int cycle = 0; cycle < 200 && llc.m_pushed.size () < 3; cycle++)
+    {
+      dram->Cycle ();
+    }
+
+  NS_TEST_ASSERT_MSG_EQ (llc.m_pushed.size (), 3, "all three reads are answered");
+  NS_TEST_ASSERT_MSG_EQ (llc.m_pushed[0].msg_id, 1, "the first read opens row 0");
+  NS_TEST_ASSERT_MSG_EQ (llc.m_pushed[1].msg_id, 3, "the row 0 hit passes the older read of row 1");
+  NS_TEST_ASSERT_MSG_EQ (llc.m_pushed[2].msg_id, 2, "row 1 is opened last");
+  NS_TEST_ASSERT_MSG_EQ (GetStat (stats, "DRAM reads"), 3, "three reads");
+  NS_TEST_ASSERT_MSG_EQ (GetStat (stats, "DRAM row hits"), 1, "one row hit");
+  NS_TEST_ASSERT_MSG_EQ (GetStat (stats, "DRAM row misses"), 2, "two activates");
+  NS_TEST_ASSERT_MSG_EQ (GetStat (stats, "DRAM row conflicts"), 1, "row 0 is closed for row 1");
+}
+
+/**
+ * \ingroup multicoresim-tests
+ * A write to a line already in the write queue replaces the queued data,
+ * and a read of that line is answered from the write queue.
+ */
+class DRAMWriteQueueTestCase : public TestCase
+{
+public:
+  DRAMWriteQueueTestCase ();
+
+private:
+  virtual void DoRun (void);
+};
+
+DRAMWriteQueueTestCase::DRAMWriteQueueTestCase ()
+  : TestCase ("DRAM model coalesces writes and forwards them to reads")
+{
+}
+
+void
+DRAMWriteQueueTestCase::DoRun (void)
+{
+  MCoreSimProjectXml config;
+  NS_TEST_ASSERT_MSG_EQ (LoadDRAMConfig (config), true, "the test configuration does not parse");
+
+  TestLink llc;
+  Ptr<ClockedDRAMModel> dram = Create<ClockedDRAMModel> (config, &llc);
+  StatsRegistry stats;
+  dram->registerStats (stats);
+
+  uint8_t data[8] = { 0 };
+  Message write (1, 4096);
+  write.copy (data);
+  llc.m_requests.push_back (write);
+  write.msg_id = 2;
+  llc.m_requests.push_back (write);
+  llc.m_requests.push_back (Message (3, 4096));
+
+  dram->Cycle ();
+  dram->Cycle ();
+  NS_TEST_ASSERT_MSG_EQ (llc.m_pushed.size (), 1, "the read is answered the cycle after it arrives");
+  NS_TEST_ASSERT_MSG_EQ (llc.m_pushed[0].msg_id, 3, "the read is answered");
+
+  for (int cycle = 0; cycle < 200; cycle++)
+    {
+      dram->Cycle ();
+    }
+  NS_TEST_ASSERT_MSG_EQ (GetStat (stats, "DRAM coalesced writes"), 1, "the second write replaced the first");
+  NS_TEST_ASSERT_MSG_EQ (GetStat (stats, "DRAM reads from the write queue"), 1, "the read came from the write queue");
+  NS_TEST_ASSERT_MSG_EQ (GetStat (stats, "DRAM writes"), 1, "one write reaches the DRAM");
+  NS_TEST_ASSERT_MSG_EQ (GetStat (stats, "DRAM row misses"), 1, "only the write opened a row");
+}
+
+/**
+ * \ingroup multicoresim-tests
+ * An LLC whose write-back buffer the test fills and clocks itself, with
+ * the MSI LLC protocol read from Protocols_FSM like a run does.
+ */
+class WriteBackLLC : public CacheController_End2End
+{
+public:
+  /**
+   * Constructor.
+   *
+   * \param [in] cacheXml The LLC configuration with the write-back buffer.
+   * \param [in] fsmPath The path of the LLC protocol CSV.
+   * \param [in] memory The interface the write-backs are sent on.
+   * \param [in] bus The interface to the private caches.
+   */
+  WriteBackLLC (CacheXml &cacheXml, std::string &fsmPath, CommunicationInterface *memory, CommunicationInterface *bus)
+    : CacheController_End2End (cacheXml, fsmPath, memory, bus, false, 20, CohProtType::SNOOP_LLC_MSI)
+  {
+  }
+
+  /**
+   * Buffers a write-back of one line.
+   *
+   * \param [in] msgId The id of the write-back.
+   * \param [in] addr The address of the line.
+   */
+  void WriteBack (uint64_t msgId, uint64_t addr)
+  {
+    uint8_t data[8] = { 0 };
+    Message msg (msgId, addr);
+    msg.copy (data);
+    bufferWriteBack (msg);
+  }
+
+  /** Records a read sent to memory this cycle. */
+  void ReadMemory (void)
+  {
+    m_last_mem_read_cycle = m_cache_cycle;
+  }
+
+  /** Runs the write-back buffer for one cycle. */
+  void Cycle (void)
+  {
+    if (!m_wb_buffer.empty ())
+      {
+        drainWriteBacks ();
+      }
+    m_cache_cycle++;
+  }
+
+  /**
+   * \returns The write-backs in the buffer.
+   */
+  std::size_t Buffered (void) const
+  {
+    return m_wb_buffer.size ();
+  }
+};
+
+/**
+ * \ingroup multicoresim-tests
+ * The LLC configuration of the write-back test cases.
+ *
+ * \param [in] policy The WBDrainPolicy.
+ * \param [in] size The WBBufferSize.
+ * \param [out] config The configuration to load.
+ * \returns True if the configuration parses.
+ */
+static bool
+LoadWriteBackConfig (const std::string &policy, int size, MCoreSimProjectXml &config)
+{
+  std::ostringstream xml;
+  xml << "<MCoreSimProject CohProtocol=\"MSI\">"
+      << "  <sharedCaches><sharedCache cacheId=\"10\" WBDrainPolicy=\"" << policy << "\" WBBufferSize=\"" << size
+      << "\" WBHighWatermark=\"3\" WBLowWatermark=\"1\"/></sharedCaches>"
+      << "</MCoreSimProject>";
+  return config.LoadFromString (xml.str ());
+}
+
+/**
+ * \ingroup multicoresim-tests
+ * The WATERMARK policy holds write-backs until the buffer reaches the high
+ * watermark, then drains one per cycle down to the low watermark. Write-backs
+ * to a buffered line replace its data, and a write-back into a full buffer
+ * sends the oldest one early.
+ */
+class WriteBackWatermarkTestCase : public TestCase
+{
+public:
+  WriteBackWatermarkTestCase ();
+
+private:
+  virtual void DoRun (void);
+};
+
+WriteBackWatermarkTestCase::WriteBackWatermarkTestCase ()
+  : TestCase ("Write-back buffer drains between its watermarks")
+{
+}
+
+void
+WriteBackWatermarkTestCase::DoRun (void)
+{
+  MCoreSimProjectXml config;
+  NS_TEST_ASSERT_MSG_EQ (LoadWriteBackConfig ("WATERMARK", 4, config), true, "the test configuration does not parse");
+  CacheXml cacheXml = config.GetSharedCache ();
+  std::string fsmPath = "Protocols_FSM/MSI_LLC.csv";
+
+  TestLink memory;
+  TestLink bus;
+  Ptr<WriteBackLLC> llc = Create<WriteBackLLC> (cacheXml, fsmPath, &memory, &bus);
+  StatsRegistry stats;
+  llc->registerStats (stats);
+
+  llc->WriteBack (1, 0);
+  llc->WriteBack (2, 64);
+  llc->WriteBack (3, 0);
+  NS_TEST_ASSERT_MSG_EQ (llc->Buffered (), 2, "the write-back to a buffered line is coalesced");
+  for (int cycle = 0; cycle < 10; cycle++)
+    {
+      llc->Cycle ();
+    }
+  NS_TEST_ASSERT_MSG_EQ (memory.m_pushed.size (), 0, "nothing drains below the high watermark");
+
+  llc->WriteBack (4, 128);
+  for (int cycle = 0; cycle < 10; cycle++)
+    {
+      llc->Cycle ();
+    }
+  NS_TEST_ASSERT_MSG_EQ (memory.m_pushed.size (), 2, "the buffer drains down to the low watermark");
+  NS_TEST_ASSERT_MSG_EQ (memory.m_pushed[0].msg_id, 1, "the oldest write-back leaves first");
+  NS_TEST_ASSERT_MSG_EQ (llc->Buffered (), 1, "the low watermark stays buffered");
+
+  // A write-back into a full buffer sends the oldest one at once
+  llc->WriteBack (5, 192);
+  llc->WriteBack (6, 256);
+  llc->WriteBack (7, 320);
+  llc->WriteBack (8, 384);
+  NS_TEST_ASSERT_MSG_EQ (memory.m_pushed.size (), 3, "the write-back into the full buffer sent the oldest one");
+  NS_TEST_ASSERT_MSG_EQ (memory.m_pushed[2].msg_id, 4, "the oldest write-back was sent early");
+  NS_TEST_ASSERT_MSG_EQ (llc->Buffered (), 4, "the buffer stays full");
+
+  NS_TEST_ASSERT_MSG_EQ (GetStat (stats, "LLC write-backs sent"), 3, "three write-backs sent");
+  NS_TEST_ASSERT_MSG_EQ (GetStat (stats, "LLC write-backs coalesced"), 1, "one write-back coalesced");
+  NS_TEST_ASSERT_MSG_EQ (GetStat (stats, "LLC write-backs forced by a full buffer"), 1, "one write-back forced out");
+}
+
+/**
+ * \ingroup multicoresim-tests
+ * The IDLE policy sends write-backs only in cycles after no read went to
+ * memory, and once the cores are done the buffer drains whatever the
+ * policy.
+ */
+class WriteBackIdleTestCase : public TestCase
+{
+public:
+  WriteBackIdleTestCase ();
+
+private:
+  virtual void DoRun (void);
+};
+
+WriteBackIdleTestCase::WriteBackIdleTestCase ()
+  : TestCase ("Write-back buffer drains in idle memory cycles")
+{
+}
+
+void
+WriteBackIdleTestCase::DoRun (void)
+{
+  MCoreSimProjectXml config;
+  NS_TEST_ASSERT_MSG_EQ (LoadWriteBackConfig ("IDLE", 8, config), true, "the test configuration does not parse");
+  CacheXml cacheXml = config.GetSharedCache ();
+  std::string fsmPath = "Protocols_FSM/MSI_LLC.csv";
+
+  TestLink memory;
+  TestLink bus;
+  Ptr<WriteBackLLC> llc = Create<WriteBackLLC> (cacheXml, fsmPath, &memory, &bus);
+
+  llc->WriteBack (1, 0);
+  llc->WriteBack (2, 64);
+  for (int cycle = 0; cycle < 10; cycle++)
+    {
+      llc->ReadMemory ();
+      llc->Cycle ();
+    }
+  NS_TEST_ASSERT_MSG_EQ (memory.m_pushed.size (), 0, "nothing drains while reads go to memory");
+
+  llc->Cycle ();
+  NS_TEST_ASSERT_MSG_EQ (memory.m_pushed.size (), 0, "nothing drains in the cycle after a read");
+  llc->Cycle ();
+  NS_TEST_ASSERT_MSG_EQ (memory.m_pushed.size (), 1, "one write-back drains once memory is idle");
+
+  llc->WriteBack (3, 128);
+  NS_TEST_ASSERT_MSG_EQ (llc->flushWriteBacks (), false, "the buffer is not empty yet");
+  for (int cycle = 0; cycle < 10; cycle++)
+    {
+      llc->ReadMemory ();
+      llc->Cycle ();
+    }
+  NS_TEST_ASSERT_MSG_EQ (memory.m_pushed.size (), 3, "a flush drains despite the reads");
+  NS_TEST_ASSERT_MSG_EQ (llc->flushWriteBacks (), true, "the buffer is empty");
+}
+
+/**
+ * \ingroup multicoresim-tests
+ * A set-associative TLB hits on the pages it holds and replaces the least
+ * recently used page of a full set.
+ */
+class TlbLruTestCase : public TestCase
+{
+public:
+  TlbLruTestCase ();
+
+private:
+  virtual void DoRun (void);
+};
+
+TlbLruTestCase::TlbLruTestCase ()
+  : TestCase ("TLB replaces the least recently used page of a set")
+{
+}
+
+void
+TlbLruTestCase::DoRun (void)
+{
+  // Two sets of two ways, pages 0, 2 and 4 share set 0
+  TLB tlb (4, 2);
+  NS_TEST_ASSERT_MSG_EQ (tlb.lookup (0), false, "an empty TLB misses");
+  tlb.insert (0);
+  tlb.insert (2);
+  NS_TEST_ASSERT_MSG_EQ (tlb.lookup (0), true, "an inserted page hits");
+  NS_TEST_ASSERT_MSG_EQ (tlb.lookup (1), false, "a page of the other set misses");
+
+  // Page 2 is now the least recently used of set 0
+  tlb.insert (4);
+  NS_TEST_ASSERT_MSG_EQ (tlb.lookup (2), false, "the least recently used page was replaced");
+  NS_TEST_ASSERT_MSG_EQ (tlb.lookup (0), true, "the recently used page stays");
+  NS_TEST_ASSERT_MSG_EQ (tlb.lookup (4), true, "the new page hits");
+  NS_TEST_ASSERT_MSG_EQ (tlb.m_hits, 3, "three hits");
+  NS_TEST_ASSERT_MSG_EQ (tlb.m_misses, 3, "three misses");
+}
+
+/**
+ * \ingroup multicoresim-tests
+ * Steps an MMU over a range of cycles with an L1D that answers every PTE
+ * read in the next cycle.
+ *
+ * \param [in] mmu The MMU.
+ * \param [in] cache The CpuFIFO between the MMU and the L1D.
+ * \param [in] from The first cycle.
+ * \param [in] to The cycle after the last one.
+ * \param [out] sent The loads and stores the MMU sent to the L1D.
+ * \returns The most PTE reads the MMU sent in one cycle.
+ */
+static uint32_t
+StepMMU (MMU &mmu, CpuFIFO &cache, uint64_t from, uint64_t to, std::vector<CpuFIFO::ReqMsg> &sent)
+{
+  uint32_t maxPTEReads = 0;
+  for (uint64_t cycle = from; cycle < to; cycle++)
+    {
+      mmu.step (cycle);
+      uint32_t pteReads = 0;
+      while (!cache.m_txFIFO.IsEmpty ())
+        {
+          CpuFIFO::ReqMsg request = cache.m_txFIFO.GetFrontElement ();
+          cache.m_txFIFO.PopElement ();
+          if ((request.msgId >> 63) == 0)
+            {
+              sent.push_back (request);
+              continue;
+            }
+          CpuFIFO::RespMsg response;
+          response.msgId = request.msgId;
+          response.addr = request.addr;
+          response.reqcycle = request.cycle;
+          response.cycle = cycle;
+          cache.m_rxFIFO.InsertElement (response);
+          pteReads++;
+        }
+      maxPTEReads = std::max (maxPTEReads, pteReads);
+    }
+  return maxPTEReads;
+}
+
+/**
+ * \ingroup multicoresim-tests
+ * Requests that miss both TLBs wait for a page walk of one PTE read per
+ * level, requests to the page being walked share its walk, and at most
+ * PageWalkers walks are in progress. A later request to the page hits the
+ * L1 TLB, and responses return to the core with the virtual address.
+ */
+class MmuPageWalkTestCase : public TestCase
+{
+public:
+  MmuPageWalkTestCase ();
+
+private:
+  virtual void DoRun (void);
+};
+
+MmuPageWalkTestCase::MmuPageWalkTestCase ()
+  : TestCase ("MMU walks the page tables once per page")
+{
+}
+
+void
+MmuPageWalkTestCase::DoRun (void)
+{
+  MCoreSimProjectXml config;
+  bool loaded = config.LoadFromString (
+    "<MCoreSimProject>"
+    "  <VirtualMemory Enable=\"1\" PageAllocator=\"SEQUENTIAL\" PageWalkers=\"1\"/>"
+    "</MCoreSimProject>");
+  NS_TEST_ASSERT_MSG_EQ (loaded, true, "the test configuration does not parse");
+  VMCnfgXml vmCnfg = config.GetVMCnfg ();
+
+  PageAllocator allocator (vmCnfg);
+  CpuFIFO core (0, 8);
+  CpuFIFO cache (0, 8);
+  MMU mmu (0, 0, &core, &cache, &allocator, vmCnfg);
+  StatsRegistry stats;
+  mmu.registerStats (stats);
+
+  // Two loads to page 1, one to page 5
+  core.m_txFIFO.InsertElement (MakeRequest (0, CpuFIFO::REQTYPE::READ, 0x1000));
+  core.m_txFIFO.InsertElement (MakeRequest (1, CpuFIFO::REQTYPE::READ, 0x1008));
+  core.m_txFIFO.InsertElement (MakeRequest (2, CpuFIFO::REQTYPE::READ, 0x5000));
+
+  std::vector<CpuFIFO::ReqMsg> sent;
+  uint32_t maxPTEReads = StepMMU (mmu, cache, 1, 100, sent);
+  NS_TEST_ASSERT_MSG_EQ (maxPTEReads, 1, "one walker reads one PTE at a time");
+  NS_TEST_ASSERT_MSG_EQ (sent.size (), 3, "all three loads are translated");
+  NS_TEST_ASSERT_MSG_EQ (sent[0].msgId, 0, "the loads leave in order");
+  NS_TEST_ASSERT_MSG_EQ (sent[1].msgId, 1, "the loads leave in order");
+  NS_TEST_ASSERT_MSG_EQ (sent[2].msgId, 2, "the loads leave in order");
+  NS_TEST_ASSERT_MSG_EQ ((sent[0].addr >> 12), (sent[1].addr >> 12), "a page maps to one frame");
+  NS_TEST_ASSERT_MSG_NE ((sent[0].addr >> 12), (sent[2].addr >> 12), "two pages map to two frames");
+  NS_TEST_ASSERT_MSG_EQ ((sent[1].addr & 0xfff), 0x008, "the page offset is kept");
+  NS_TEST_ASSERT_MSG_EQ (GetStat (stats, "page walks"), 2, "one walk per page");
+  NS_TEST_ASSERT_MSG_EQ (GetStat (stats, "PTE reads"), 8, "four levels per walk");
+
+  // The L1D answers with the physical address, the core sees the virtual one
+  CpuFIFO::RespMsg response;
+  response.msgId = 1;
+  response.addr = sent[1].addr;
+  response.reqcycle = 100;
+  response.cycle = 100;
+  cache.m_rxFIFO.InsertElement (response);
+  uint64_t frame = sent[1].addr >> 12;
+  core.m_txFIFO.InsertElement (MakeRequest (3, CpuFIFO::REQTYPE::WRITE, 0x1010));
+  sent.clear ();
+  StepMMU (mmu, cache, 100, 102, sent);
+  NS_TEST_ASSERT_MSG_EQ (core.m_rxFIFO.IsEmpty (), false, "the response reaches the core");
+  NS_TEST_ASSERT_MSG_EQ (core.m_rxFIFO.GetFrontElement ().addr, 0x1008, "with its virtual address");
+  NS_TEST_ASSERT_MSG_EQ (sent.size (), 1, "the store hits the L1 TLB");
+  NS_TEST_ASSERT_MSG_EQ (sent[0].addr, ((frame << 12) | 0x010), "the store is translated");
+  NS_TEST_ASSERT_MSG_EQ (GetStat (stats, "page walks"), 2, "no walk for a TLB hit");
+}
+
+/**
+ * \ingroup multicoresim-tests
+ * Writes a file for a test.
+ *
+ * \param [in] path The file.
+ * \param [in] content What it holds.
+ */
+static void
+WriteFile (const std::string &path, const std::string &content)
+{
+  std::ofstream file (path.c_str ());
+  file << content;
+}
+
+/**
+ * \ingroup multicoresim-tests
+ * Removes one file or empty directory, for nftw.
+ *
+ * \param [in] path The file or directory.
+ * \returns The result of remove ().
+ */
+static int
+RemoveEntry (const char *path, const struct stat *, int, struct FTW *)
+{
+  return remove (path);
+}
+
+/**
+ * \ingroup multicoresim-tests
+ * The result cache key ignores attribute order and comments in the
+ * configuration but changes with its values and with the traces, and a
+ * stored result is fetched back under its key only.
+ */
+class ResultCacheTestCase : public TestCase
+{
+public:
+  ResultCacheTestCase ();
+
+private:
+  virtual void DoRun (void);
+};
+
+ResultCacheTestCase::ResultCacheTestCase ()
+  : TestCase ("Result cache keys runs by their inputs")
+{
+}
+
+void
+ResultCacheTestCase::DoRun (void)
+{
+  char dir[] = "/tmp/multicoresim-test-XXXXXX";
+  NS_TEST_ASSERT_MSG_NE (mkdtemp (dir), 0, "cannot create a directory for the cache");
+  std::string root (dir);
+  std::string bmsPath = root + "/bms";
+  mkdir (bmsPath.c_str (), 0755);
+
+  WriteFile (root + "/a.xml", "<MCoreSimProject nCores=\"1\" CohProtocol=\"MSI\"><DRAMCnfg MEMLATENCY=\"20\"/></MCoreSimProject>");
+  WriteFile (root + "/b.xml", "<!-- reordered -->\n<MCoreSimProject CohProtocol=\"MSI\" nCores=\"1\">\n"
+                              "  <DRAMCnfg MEMLATENCY=\"20\"/>\n</MCoreSimProject>\n");
+  WriteFile (root + "/c.xml", "<MCoreSimProject nCores=\"2\" CohProtocol=\"MSI\"><DRAMCnfg MEMLATENCY=\"20\"/></MCoreSimProject>");
+  WriteFile (root + "/simulator", "simulator build");
+
+  ResultCache cache (root + "/cache");
+  std::string simulator = root + "/simulator";
+  std::string key = cache.Key (root + "/a.xml", bmsPath, root, simulator);
+  NS_TEST_ASSERT_MSG_EQ (key.size (), 32, "a key is 128 bits of hex");
+  NS_TEST_ASSERT_MSG_EQ (cache.Key (root + "/b.xml", bmsPath, root, simulator), key,
+                         "attribute order, comments and layout do not change the key");
+  NS_TEST_ASSERT_MSG_NE (cache.Key (root + "/c.xml", bmsPath, root, simulator), key,
+                         "an attribute value changes the key");
+  NS_TEST_ASSERT_MSG_EQ (cache.Key (root + "/missing.xml", bmsPath, root, simulator), "",
+                         "no key without the configuration");
+
+  WriteFile (bmsPath + "/trace_C0.trc.shared", "1 4096 R\n");
+  std::string traceKey = cache.Key (root + "/a.xml", bmsPath, root, simulator);
+  NS_TEST_ASSERT_MSG_NE (traceKey, key, "a trace changes the key");
+  WriteFile (bmsPath + "/trace_C0.trc.shared", "1 4096 R\n2 8192 W\n");
+  NS_TEST_ASSERT_MSG_NE (cache.Key (root + "/a.xml", bmsPath, root, simulator), traceKey,
+                         "the trace's content changes the key");
+
+  std::string result = root + "/result.txt";
+  std::string fetched = root + "/fetched.txt";
+  NS_TEST_ASSERT_MSG_EQ (cache.Fetch (key, fetched), false, "nothing is stored yet");
+  int lock = cache.Lock (key);
+  NS_TEST_ASSERT_MSG_NE (lock, -1, "the key can be locked");
+  WriteFile (result, "Core 0 instructions retired = 6\n");
+  NS_TEST_ASSERT_MSG_EQ (cache.Store (key, result), true, "the result is stored");
+  cache.Unlock (lock);
+
+  NS_TEST_ASSERT_MSG_EQ (cache.Fetch (key, fetched), true, "the stored result is found");
+  std::ifstream in (fetched.c_str ());
+  std::string line;
+  std::getline (in, line);
+  NS_TEST_ASSERT_MSG_EQ (line, "Core 0 instructions retired = 6", "the stored result is fetched");
+  NS_TEST_ASSERT_MSG_EQ (cache.Fetch (traceKey, fetched), false, "other keys still miss");
+
+  nftw (dir, RemoveEntry, 16, FTW_DEPTH | FTW_PHYS);
+}
+
+/**
+ * \ingroup multicoresim-tests
+ * MultiCoreSim test suite.
+ */
+class MultiCoreSimTestSuite : public TestSuite
+{
+public:
+  MultiCoreSimTestSuite ()
+    : TestSuite ("multicoresim", UNIT)
+  {
+    AddTestCase (new TraceRunsToCompletionTestCase (), TestCase::QUICK);
+    AddTestCase (new TimingWheelTestCase (), TestCase::QUICK);
+    AddTestCase (new RobRetireInOrderTestCase (), TestCase::QUICK);
+    AddTestCase (new RobComputeRunTestCase (), TestCase::QUICK);
+    AddTestCase (new LsqForwardingAndPortsTestCase (), TestCase::QUICK);
+    AddTestCase (new DRAMRowHitFirstTestCase (), TestCase::QUICK);
+    AddTestCase (new DRAMWriteQueueTestCase (), TestCase::QUICK);
+    AddTestCase (new WriteBackWatermarkTestCase (), TestCase::QUICK);
+    AddTestCase (new WriteBackIdleTestCase (), TestCase::QUICK);
+    AddTestCase (new TlbLruTestCase (), TestCase::QUICK);
+    AddTestCase (new MmuPageWalkTestCase (), TestCase::QUICK);
+    AddTestCase (new ResultCacheTestCase (), TestCase::QUICK);
+  }
+};
+
+/**
+ * \ingroup multicoresim-tests
+ * MultiCoreSimTestSuite instance variable.
+ */
+static MultiCoreSimTestSuite g_multiCoreSimTestSuite;
+
+}  // namespace tests
+
+}  // namespace ns3
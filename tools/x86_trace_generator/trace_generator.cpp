@@ -283,7 +283,7 @@ void get_ld_ea(ADDRINT addr, UINT32 mem_read_size,
 #ifndef PINLINUX
                UINT32 eflag_value,
 #endif
-               THREADID threadid)
+               BOOL is_atomic, THREADID threadid)
 {
   THREADID tid = threadMap[threadid];
   THREAD_ENABLE_CHECK(tid);
@@ -292,7 +292,9 @@ void get_ld_ea(ADDRINT addr, UINT32 mem_read_size,
   if (trace_info == NULL)
     return;
   trace_info->vaddr1 = addr;
-  fprintf(memtrace,"%lx 1 R 0\n",addr);
+  // The read of an atomic is part of its single A line, written by get_st_ea
+  if (!is_atomic)
+    fprintf(memtrace,"%lx 1 R 0\n",addr);
   trace_info->mem_read_size = mem_read_size;
   trace_info->eflags = eflag_value;
 }
@@ -327,7 +329,7 @@ void get_st_ea(ADDRINT addr, UINT32 mem_st_size,
 #ifndef PINLINUX
                UINT32 eflag_value,
 #endif
-               THREADID threadid)
+               BOOL is_atomic, THREADID threadid)
 {
   THREADID tid = threadMap[threadid];
   THREAD_ENABLE_CHECK(tid);
@@ -336,7 +338,7 @@ void get_st_ea(ADDRINT addr, UINT32 mem_st_size,
   if (trace_info == NULL)
     return;
   trace_info->st_vaddr = addr;
-  fprintf(memtrace,"%lx 1 W 0\n",addr);
+  fprintf(memtrace, is_atomic ? "%lx 1 A 0\n" : "%lx 1 W 0\n", addr);
   trace_info->mem_write_size = mem_st_size;
   trace_info->eflags = eflag_value;
 }
@@ -835,6 +837,13 @@ void instrument(INS ins)
     }
   }
 
+  // ----------------------------------------
+  // Atomic read-modify-write: a LOCK-prefixed instruction, or XCHG with a
+  // memory operand (implicitly locked); traced as one A access
+  // ----------------------------------------
+  BOOL is_atomic = (INS_LockPrefix(ins) || INS_Opcode(ins) == XED_ICLASS_XCHG) &&
+                   INS_IsMemoryRead(ins) && INS_IsMemoryWrite(ins);
+
   // ----------------------------------------
   // Load instruction
   // ----------------------------------------
@@ -858,7 +867,7 @@ void instrument(INS ins)
 #ifndef PINLINUX
                      IARG_LEVEL_BASE::REG_VALUE, LEVEL_BASE::REG_EFLAGS,
 #endif
-                     IARG_THREAD_ID, IARG_END);
+                     IARG_BOOL, is_atomic, IARG_THREAD_ID, IARG_END);
     }
   }
 
@@ -872,7 +881,7 @@ void instrument(INS ins)
 #ifndef PINLINUX
                    IARG_LEVEL_BASE::REG_VALUE, LEVEL_BASE::REG_EFLAGS,
 #endif
-                   IARG_THREAD_ID, IARG_END);
+                   IARG_BOOL, is_atomic, IARG_THREAD_ID, IARG_END);
   }
 
   // ----------------------------------------
@@ -0,0 +1,52 @@
+#!/usr/bin/env python3
+#
+# Convert the instruction trace written by the Pin tool
+# (tools/x86_trace_generator, write_inst -> gzwrite of Inst_info records,
+# one <tracename>_<tid>.raw file per thread) into the instruction-fetch trace
+# CpuCoreGenerator reads: one instruction address per line, in hex.
+#
+# The record layout must match struct Inst_info in
+# tools/x86_trace_generator/trace_generator.h (native alignment, x86-64).
+#
+# Usage: convert-inst-trace.py trace_0.raw trace_C0.itrc.shared
+#        (thread t of an SMT core goes to trace_C<core>_T<t>.itrc.shared)
+
+import gzip
+import optparse
+import struct
+import sys
+
+MAX_SRC_NUM = 9
+MAX_DST_NUM = 6
+
+# num_read_regs, num_dest_regs, src[], dst[], cf_type, has_immediate, opcode,
+# has_st, is_fp, write_flg, num_ld, size, ld_vaddr1, ld_vaddr2, st_vaddr,
+# instruction_addr, branch_target, mem_read_size, mem_write_size, rep_dir,
+# actually_taken; "0Q" pads the record to its 8-byte alignment
+INST_INFO = struct.Struct("@BB%dB%dBB?B???BBQQQQQBB??0Q" % (MAX_SRC_NUM, MAX_DST_NUM))
+INST_ADDR_FIELD = 2 + MAX_SRC_NUM + MAX_DST_NUM + 8 + 3
+
+
+def main(argv):
+    parser = optparse.OptionParser(usage="%prog [options] <trace_N.raw> <output>")
+    parser.add_option("-n", "--max", type="int", default=0,
+                      help="stop after this many instructions (0 = all)")
+    (options, args) = parser.parse_args(argv)
+    if len(args) != 2:
+        parser.error("expected an input and an output file")
+
+    count = 0
+    with gzip.open(args[0], "rb") as raw, open(args[1], "w") as out:
+        while options.max == 0 or count < options.max:
+            record = raw.read(INST_INFO.size)
+            if len(record) < INST_INFO.size:
+                break
+            out.write("%x\n" % INST_INFO.unpack(record)[INST_ADDR_FIELD])
+            count += 1
+
+    sys.stderr.write("%s: %d instructions\n" % (args[1], count))
+    return 0
+
+
+if __name__ == "__main__":
+    sys.exit(main(sys.argv[1:]))
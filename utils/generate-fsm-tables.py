@@ -0,0 +1,234 @@
+#!/usr/bin/env python3
+#
+# Compile the MultiCoreSim coherence protocol FSMs (Protocols_FSM/*.csv) into
+# constexpr C++ tables.  The output header defines one ns3::CompiledFSM per CSV
+# plus the NULL-terminated compiled_fsm_tables[] registry that FSMReader::create
+# searches by file name and content hash (64-bit FNV-1a of the CSV bytes), so a
+# CSV that differs from the one a table was generated from, e.g. a same-named
+# file in another directory, is still read from the CSV at run time.
+#
+# The CSV is interpreted exactly as FSMReader does it:
+#   - a line containing EventNum / ActionNum / StateNum starts an id section of
+#     "value,name" rows, terminated by a row with an empty name;
+#   - a line containing State starts the transition table, which runs to the
+#     end of the file: "state,stable,valid,<event 0>,<event 1>,...";
+#   - a cell is "act1/act2/next", "act/" (stay), "next", or empty (stay).
+#
+# Usage: generate-fsm-tables.py -o CompiledFSMTables.h file1.csv [file2.csv ...]
+
+import optparse
+import os
+import re
+import sys
+
+EVENT_CSV_ID = "EventNum"
+ACTION_CSV_ID = "ActionNum"
+STATE_CSV_ID = "StateNum"
+STATE_CSV_TABLE = "State"
+
+
+class FsmSpec(object):
+    def __init__(self, path):
+        self.path = path
+        self.file_name = os.path.basename(path)
+        self.content_hash = 0
+        self.event_ids = {}
+        self.action_ids = {}
+        self.state_ids = {}
+        self.rows = []
+
+    def error(self, msg):
+        sys.stderr.write("%s: %s\n" % (self.path, msg))
+        sys.exit(1)
+
+
+def split_fields(line):
+    # std::getline(..., ',') does not produce a trailing empty field
+    fields = line.split(',')
+    if fields and fields[-1] == '':
+        fields.pop()
+    return fields
+
+
+def parse_ids(lines, pos, ids):
+    while pos < len(lines):
+        fields = split_fields(lines[pos])
+        pos += 1
+        name = fields[1] if len(fields) > 1 else ''
+        if len(name) == 0:
+            break
+        ids[name] = int(fields[0] or 0)
+    return pos
+
+
+def fnv1a_64(data):
+    # Must match FSMReader's ContentHash
+    h = 0xcbf29ce484222325
+    for byte in bytearray(data):
+        h = ((h ^ byte) * 0x100000001b3) & 0xffffffffffffffff
+    return h
+
+
+def parse_csv(path):
+    spec = FsmSpec(path)
+    with open(path, 'rb') as f:
+        data = f.read()
+    spec.content_hash = fnv1a_64(data)
+    lines = data.decode('utf-8', 'replace').split('\n')
+    if lines and lines[-1] == '':
+        lines.pop()
+
+    pos = 0
+    while pos < len(lines):
+        line = lines[pos]
+        pos += 1
+        if EVENT_CSV_ID in line:
+            pos = parse_ids(lines, pos, spec.event_ids)
+        elif ACTION_CSV_ID in line:
+            pos = parse_ids(lines, pos, spec.action_ids)
+        elif STATE_CSV_ID in line:
+            pos = parse_ids(lines, pos, spec.state_ids)
+        elif STATE_CSV_TABLE in line:
+            spec.rows = lines[pos:]
+            break
+    return spec
+
+
+def compile_fsm(spec):
+    event_count = len(spec.event_ids)
+    state_info = []
+    transitions = []
+    action_pool = []
+
+    def lookup(ids, name, kind):
+        if name not in ids:
+            spec.error("unknown %s '%s'" % (kind, name))
+        return ids[name]
+
+    for row in spec.rows:
+        fields = split_fields(row)
+        state_name = fields[0] if fields else ''
+        stable = len(fields) > 1 and fields[1].strip() == '1'
+        valid = len(fields) > 2 and fields[2].strip() == '1'
+        state_info.append((stable, valid))
+
+        cells = fields[3:]
+        for event in range(event_count):
+            if event >= len(cells):
+                # FSMReader's map lookup yields state 0 with no actions
+                transitions.append((0, len(action_pool), 0))
+                continue
+
+            field = cells[event].split('\r')[0]
+            actions = []
+            if len(field) == 0:
+                next_state = lookup(spec.state_ids, state_name, 'state')
+            elif '/' in field:
+                last = field.rfind('/')
+                next_name = field[last + 1:]
+                next_state = lookup(spec.state_ids, next_name or state_name, 'state')
+                actions = [lookup(spec.action_ids, a, 'action') for a in field[:last].split('/')]
+            else:
+                next_state = lookup(spec.state_ids, field, 'state')
+
+            transitions.append((next_state, len(action_pool), len(actions)))
+            action_pool.extend(actions)
+
+    return state_info, transitions, action_pool
+
+
+def identifier(file_name):
+    return 'fsm_' + re.sub(r'[^0-9A-Za-z_]', '_', os.path.splitext(file_name)[0])
+
+
+def emit_ids(out, name, ids):
+    items = sorted(ids.items(), key=lambda kv: (kv[1], kv[0]))
+    out.append("        constexpr CompiledFSM::Id %s[] = {" % name)
+    for key, value in items or [('', 0)]:
+        out.append('            {"%s", %d},' % (key.replace('\\', '\\\\').replace('"', '\\"'), value))
+    out.append("        };")
+
+
+def emit_fsm(out, spec):
+    state_info, transitions, action_pool = compile_fsm(spec)
+    ns = identifier(spec.file_name)
+
+    out.append("    namespace %s" % ns)
+    out.append("    {")
+    emit_ids(out, "event_ids", spec.event_ids)
+    emit_ids(out, "action_ids", spec.action_ids)
+    emit_ids(out, "state_ids", spec.state_ids)
+
+    out.append("        constexpr CompiledFSM::StateInfo state_info[] = {")
+    for stable, valid in state_info or [(False, False)]:
+        out.append("            {%s, %s}," % (str(stable).lower(), str(valid).lower()))
+    out.append("        };")
+
+    out.append("        constexpr CompiledFSM::Transition transitions[] = {")
+    event_count = len(spec.event_ids)
+    for s in range(len(state_info)):
+        row = transitions[s * event_count:(s + 1) * event_count]
+        out.append("            " + " ".join("{%d, %d, %d}," % t for t in row))
+    if not transitions:
+        out.append("            {0, 0, 0},")
+    out.append("        };")
+
+    out.append("        constexpr int action_pool[] = {")
+    pool = action_pool or [0]
+    for i in range(0, len(pool), 16):
+        out.append("            " + " ".join("%d," % a for a in pool[i:i + 16]))
+    out.append("        };")
+
+    out.append("        constexpr CompiledFSM table = {")
+    out.append('            "%s", 0x%016xULL,' % (spec.file_name, spec.content_hash))
+    out.append("            %d, event_ids, %d, action_ids, %d, state_ids," %
+               (len(spec.event_ids), len(spec.action_ids), len(spec.state_ids)))
+    out.append("            %d, %d, state_info, transitions, action_pool" % (len(state_info), event_count))
+    out.append("        };")
+    out.append("    }")
+    out.append("")
+    return ns
+
+
+def main(argv):
+    parser = optparse.OptionParser(usage="%prog -o OUTPUT file.csv [file.csv ...]")
+    parser.add_option('-o', '--output', dest='output', help="generated header")
+    (options, args) = parser.parse_args(argv)
+    if not options.output:
+        parser.error("no output file given")
+
+    out = []
+    out.append("/*")
+    out.append(" * File  :      CompiledFSMTables.h")
+    out.append(" *")
+    out.append(" * Generated by utils/generate-fsm-tables.py from Protocols_FSM, do not edit.")
+    out.append(" */")
+    out.append("")
+    out.append("#ifndef _CompiledFSMTables_H")
+    out.append("#define _CompiledFSMTables_H")
+    out.append("")
+    out.append('#include "ns3/CompiledFSM.h"')
+    out.append("")
+    out.append("#include <stddef.h>")
+    out.append("")
+    out.append("namespace ns3")
+    out.append("{")
+
+    names = [emit_fsm(out, parse_csv(path)) for path in sorted(args)]
+
+    out.append("    static const CompiledFSM *const compiled_fsm_tables[] = {")
+    for ns in names:
+        out.append("        &%s::table," % ns)
+    out.append("        NULL")
+    out.append("    };")
+    out.append("}")
+    out.append("")
+    out.append("#endif /* _CompiledFSMTables_H */")
+
+    with open(options.output, 'w') as f:
+        f.write("\n".join(out) + "\n")
+    return 0
+
+
+if __name__ == '__main__':
+    sys.exit(main(sys.argv[1:]))